@@ -21,7 +21,7 @@ int timer_init(void)
 	return 0;
 }
 
-unsigned long long get_ticks(void)
+unsigned long long notrace get_ticks(void)
 {
 	ulong nowl, nowu;
 
@@ -39,11 +39,21 @@ ulong get_timer(ulong base)
 	return lldiv(get_ticks(), gd->arch.timer_rate_hz) - base;
 }
 
-ulong timer_get_boot_us(void)
+ulong notrace timer_get_boot_us(void)
 {
 	return lldiv(get_ticks(), CONFIG_SYS_HZ_CLOCK / (CONFIG_SYS_HZ * 1000));
 }
 
+/*
+ * Based on the counter alone, so that it works before timer_init(), and
+ * without lldiv(), whose helper is instrumented: the function tracer calls
+ * this on every function entry and exit.
+ */
+unsigned long notrace timer_get_us(void)
+{
+	return get_ticks() / (CONFIG_SYS_HZ_CLOCK / 1000000);
+}
+
 void __udelay(unsigned long usec)
 {
 	unsigned long long endtime;
@@ -57,7 +67,7 @@ void __udelay(unsigned long usec)
 		;
 }
 
-ulong get_tbclk(void)
+ulong notrace get_tbclk(void)
 {
 	return gd->arch.timer_rate_hz;
 }
@@ -15,6 +15,7 @@
 #define ATAG_BOOTDEV		0x54410051
 #define ATAG_DDR_MEM		0x54410052
 #define ATAG_TOS_MEM		0x54410053
+#define ATAG_BOOTSTAGE		0x54410054
 
 /* Tag size and offset */
 #define ATAGS_SIZE		(0x2000)	/* 8K */
@@ -39,6 +40,9 @@
 #define SERIAL_M_MODE_M1	0x1
 #define SERIAL_M_MODE_M2	0x2
 
+/* tag_bootstage.data, in the bootstage_stash() format */
+#define ATAG_BOOTSTAGE_SIZE	0x800
+
 struct tag_serial {
 	u32 version;
 	u32 enable;
@@ -82,6 +86,13 @@ struct tag_tos_mem {
 	u64 reserved[8];
 } __packed;
 
+struct tag_bootstage {
+	u32 version;
+	u32 size;
+	u8 data[ATAG_BOOTSTAGE_SIZE];
+	u32 reserved[4];
+} __packed;
+
 struct tag_core {
 	u32 flags;
 	u32 pagesize;
@@ -102,6 +113,7 @@ struct tag {
 		struct tag_bootdev	bootdev;
 		struct tag_ddr_mem	ddr_mem;
 		struct tag_tos_mem	tos_mem;
+		struct tag_bootstage	bootstage;
 	} u;
 } __aligned(4);
 
@@ -141,6 +153,17 @@ struct tag *atags_get_tag(u32 magic);
  */
 int atags_is_available(void);
 
+/*
+ * atags_set_bootstage - store the boot timeline for the kernel
+ *
+ * Stashes the bootstage records into the ATAG_BOOTSTAGE tag, replacing any
+ * previous copy, so that the timeline from TPL onwards is still available
+ * once the kernel is running.
+ *
+ * return: 0 on success, others failed.
+ */
+int atags_set_bootstage(void);
+
 /* Print only one tag */
 void atags_print_tag(struct tag *t);
 
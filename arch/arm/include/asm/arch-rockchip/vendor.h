@@ -19,6 +19,9 @@ struct vendor_item {
 };
 
 int vendor_storage_test(void);
+void vendor_test_reset(void);
+int vendor_test_check_order(void);
+int vendor_storage_init(void);
 int vendor_storage_read(u16 id, void *pbuf, u16 size);
 int vendor_storage_write(u16 id, void *pbuf, u16 size);
 int flash_vendor_dev_ops_register(int (*read)(struct blk_desc *dev_desc,
@@ -20,6 +20,9 @@ extern char * strchr(const char * s, int c);
 extern void * memcpy(void *, const void *, __kernel_size_t);
 
 #undef __HAVE_ARCH_MEMMOVE
+#if defined(CONFIG_ARM_NEON_MEMFUNCS) && !defined(CONFIG_SPL_BUILD)
+#define __HAVE_ARCH_MEMMOVE
+#endif
 extern void * memmove(void *, const void *, __kernel_size_t);
 
 #undef __HAVE_ARCH_MEMCHR
@@ -14,6 +14,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <console.h>
 #include <dm.h>
 #include <dm/root.h>
 #include <image.h>
@@ -27,6 +28,8 @@
 #include <linux/compiler.h>
 #include <bootm.h>
 #include <vxworks.h>
+#include <smp_job.h>
+#include <trace.h>
 
 #ifdef CONFIG_ARMV7_NONSEC
 #include <asm/armv7.h>
@@ -92,6 +95,10 @@ static void announce_and_cleanup(int fake)
 	udc_disconnect();
 #endif
 
+	console_ring_handoff();
+	trace_handoff();
+	smp_job_park();
+
 #ifdef CONFIG_ARCH_ROCKCHIP
 	/* Enable this flag, call putc to flush console(ns16550_serial_putc)*/
 	gd->flags |= GD_FLG_OS_RUN;
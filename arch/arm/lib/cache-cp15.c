@@ -6,6 +6,7 @@
  */
 
 #include <common.h>
+#include <dma_map.h>
 #include <asm/system.h>
 #include <asm/cache.h>
 #include <linux/compiler.h>
@@ -84,6 +85,37 @@ void mmu_set_region_dcache_behaviour(phys_addr_t start, size_t size,
 	mmu_page_table_flush(startpt, stoppt);
 }
 
+#ifdef CONFIG_CPU_V7
+/* Look up the sections covering the range, see set_section_dcache() */
+bool dcache_range_cached(ulong start, ulong end)
+{
+#ifdef CONFIG_ARMV7_LPAE
+	u64 *page_table = (u64 *)gd->arch.tlb_addr;
+#else
+	u32 *page_table = (u32 *)gd->arch.tlb_addr;
+#endif
+	ulong section;
+
+	if (!dcache_status())
+		return false;
+	if (end <= start)
+		return true;
+
+	for (section = start >> MMU_SECTION_SHIFT;
+	     section <= (end - 1) >> MMU_SECTION_SHIFT; section++) {
+#ifdef CONFIG_ARMV7_LPAE
+		if (page_table[section] & TTB_SECT_MAIR(7))
+			return true;
+#else
+		if (page_table[section] & TTB_SECT_C_MASK)
+			return true;
+#endif
+	}
+
+	return false;
+}
+#endif
+
 __weak void dram_bank_mmu_setup(int bank)
 {
 	bd_t *bd = gd->bd;
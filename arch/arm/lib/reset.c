@@ -22,6 +22,9 @@
  */
 
 #include <common.h>
+#include <console.h>
+#include <dm.h>
+#include <dm/root.h>
 
 __weak void reset_misc(void)
 {
@@ -31,6 +34,13 @@ int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	puts ("resetting ...\n");
 
+	/*
+	 * Let the devices which must save state before the OS runs do the
+	 * same before a reset, e.g. an FTL writing back its mapping tables.
+	 */
+	dm_remove_devices_flags(DM_REMOVE_OS_PREPARE);
+	console_ring_flush();
+
 	udelay (50000);				/* wait 50 ms */
 
 	disable_interrupts();
@@ -0,0 +1,153 @@
+/*
+ * RK3288 secondary cores as job workers
+ *
+ * The three secondary Cortex-A17 cores are powered down at reset. They are
+ * powered up through the PMU and released from the boot ROM through the
+ * mailbox at the start of the internal SRAM, like the kernel does, then
+ * switch to the boot core's page tables so that they are cache coherent
+ * with it. Before the kernel starts they leave coherency and are powered
+ * down again, so the kernel finds them as after reset.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <smp_job.h>
+#include <syscon.h>
+#include <asm/io.h>
+#include <asm/arch/clock.h>
+#include <asm/arch/cru_rk3288.h>
+#include <asm/arch/hardware.h>
+#include <asm/arch/pmu_rk3288.h>
+#include <linux/err.h>
+#include <linux/sizes.h>
+
+#define RK3288_SMP_CPUS		3
+#define RK3288_SMP_STACK_SIZE	SZ_16K
+
+/* Boot ROM mailbox: jump to the address at +8 once +4 holds the magic */
+#define RK3288_SMP_SRAM		0xff700000
+#define RK3288_SMP_MAGIC	0xdeadbeaf
+
+/* Layout shared with smp_entry.S */
+struct rk3288_smp_boot {
+	u32 ttbcr;
+	u32 ttbr0;
+	u32 dacr;
+	u32 vbar;
+	u32 stack[RK3288_SMP_CPUS];
+};
+
+struct rk3288_smp_parked {
+	u32 parked;
+} __aligned(ARCH_DMA_MINALIGN);
+
+struct rk3288_smp_boot rk3288_smp_boot __aligned(ARCH_DMA_MINALIGN);
+static struct rk3288_smp_parked rk3288_smp_parked[RK3288_SMP_CPUS];
+static u8 rk3288_smp_stack[RK3288_SMP_CPUS][RK3288_SMP_STACK_SIZE]
+	__aligned(16);
+
+void rk3288_smp_entry(void);
+void rk3288_smp_exit(u32 *parked);
+
+void rk3288_smp_main(uint cpu)
+{
+	smp_job_worker(cpu);
+	rk3288_smp_exit(&rk3288_smp_parked[cpu].parked);
+}
+
+static int rk3288_smp_power(uint core, bool on)
+{
+	struct rk3288_pmu *pmu = syscon_get_first_range(ROCKCHIP_SYSCON_PMU);
+	struct rk3288_cru *cru = rockchip_get_cru();
+	ulong start;
+
+	if (IS_ERR(pmu) || IS_ERR(cru))
+		return -ENODEV;
+
+	/* Keep the core in reset while its power changes */
+	rk_setreg(&cru->cru_softrst_con[0], 1 << core);
+	if (on)
+		clrbits_le32(&pmu->pwrdn_con, 1 << core);
+	else
+		setbits_le32(&pmu->pwrdn_con, 1 << core);
+
+	start = get_timer(0);
+	while (!(readl(&pmu->pwrdn_st) & (1 << core)) != on) {
+		if (get_timer(start) > 10)
+			return -ETIMEDOUT;
+	}
+	if (on)
+		rk_clrreg(&cru->cru_softrst_con[0], 1 << core);
+
+	return 0;
+}
+
+int arch_smp_job_cpus(void)
+{
+	return RK3288_SMP_CPUS;
+}
+
+int arch_smp_job_start(uint cpu)
+{
+	struct rk3288_smp_boot *boot = &rk3288_smp_boot;
+	struct rk3288_smp_parked *p = &rk3288_smp_parked[cpu];
+	int ret;
+
+	/* The core reads these with its MMU and caches still off */
+	asm volatile("mrc p15, 0, %0, c2, c0, 2" : "=r" (boot->ttbcr));
+	asm volatile("mrc p15, 0, %0, c2, c0, 0" : "=r" (boot->ttbr0));
+	asm volatile("mrc p15, 0, %0, c3, c0, 0" : "=r" (boot->dacr));
+	asm volatile("mrc p15, 0, %0, c12, c0, 0" : "=r" (boot->vbar));
+	boot->stack[cpu] = (ulong)rk3288_smp_stack[cpu] + RK3288_SMP_STACK_SIZE;
+	flush_dcache_range((ulong)boot,
+			   ALIGN((ulong)(boot + 1), ARCH_DMA_MINALIGN));
+	p->parked = 0;
+	flush_dcache_range((ulong)p, (ulong)(p + 1));
+
+	ret = rk3288_smp_power(cpu + 1, true);
+	if (ret)
+		return ret;
+
+	/* Give the boot ROM time to reach its wait loop */
+	mdelay(1);
+	writel((ulong)rk3288_smp_entry, RK3288_SMP_SRAM + 8);
+	writel(RK3288_SMP_MAGIC, RK3288_SMP_SRAM + 4);
+	dsb();
+	asm volatile("sev");
+
+	return 0;
+}
+
+int arch_smp_job_stop(uint cpu)
+{
+	struct rk3288_smp_parked *p = &rk3288_smp_parked[cpu];
+	ulong start = get_timer(0);
+	int ret = 0;
+
+	for (;;) {
+		invalidate_dcache_range((ulong)p, (ulong)(p + 1));
+		if (readl(&p->parked))
+			break;
+		if (get_timer(start) > 100) {
+			ret = -ETIMEDOUT;
+			break;
+		}
+	}
+
+	writel(0, RK3288_SMP_SRAM + 4);
+	rk3288_smp_power(cpu + 1, false);
+
+	return ret;
+}
+
+void arch_smp_job_idle(void)
+{
+	asm volatile("wfe");
+}
+
+void arch_smp_job_wake(void)
+{
+	dsb();
+	asm volatile("sev");
+}
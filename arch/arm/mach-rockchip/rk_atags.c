@@ -5,6 +5,7 @@
  */
 
 #include <common.h>
+#include <malloc.h>
 #include <asm/arch/rk_atags.h>
 
 #define tag_next(t)	((struct tag *)((u32 *)(t) + (t)->hdr.size))
@@ -19,7 +20,8 @@ static int inline bad_magic(u32 magic)
 		(magic != ATAG_SERIAL) &&
 		(magic != ATAG_BOOTDEV) &&
 		(magic != ATAG_DDR_MEM) &&
-		(magic != ATAG_TOS_MEM));
+		(magic != ATAG_TOS_MEM) &&
+		(magic != ATAG_BOOTSTAGE));
 }
 
 static int inline atags_size_overflow(struct tag *t, u32 tag_size)
@@ -93,6 +95,9 @@ int atags_set_tag(u32 magic, void *tagdata)
 	case ATAG_DDR_MEM:
 		size = tag_size(tag_ddr_mem);
 		break;
+	case ATAG_BOOTSTAGE:
+		size = tag_size(tag_bootstage);
+		break;
 	};
 
 	if (atags_size_overflow(t, size)) {
@@ -135,6 +140,48 @@ struct tag *atags_get_tag(u32 magic)
 	return NULL;
 }
 
+#if defined(CONFIG_ROCKCHIP_BOOTSTAGE_ATAGS) && \
+    !defined(CONFIG_SPL_BUILD) && !defined(CONFIG_TPL_BUILD)
+int atags_set_bootstage(void)
+{
+	struct tag_bootstage *bs;
+	struct tag *t;
+	int ret;
+
+	bs = calloc(1, sizeof(*bs));
+	if (!bs)
+		return -ENOMEM;
+
+	ret = bootstage_stash(bs->data, sizeof(bs->data));
+	if (ret)
+		goto out;
+	/* The total size is the third word of the stash header */
+	bs->size = ((u32 *)bs->data)[2];
+
+	/* Replace the timeline of an earlier, failed boot attempt */
+	t = atags_get_tag(ATAG_BOOTSTAGE);
+	if (t)
+		memcpy(&t->u.bootstage, bs, sizeof(*bs));
+	else
+		ret = atags_set_tag(ATAG_BOOTSTAGE, bs);
+out:
+	free(bs);
+
+	return ret;
+}
+
+void arch_preboot_os(void)
+{
+	/*
+	 * announce_and_cleanup() marks the handoff too, but only after this
+	 * point. Only the first mark is kept, so the two agree.
+	 */
+	bootstage_mark_name(BOOTSTAGE_ID_BOOTM_HANDOFF, "start_kernel");
+	if (atags_set_bootstage())
+		puts("bootstage: Failed to add to atags\n");
+}
+#endif
+
 void atags_destroy(void)
 {
 	memset((char *)ATAGS_PHYS_BASE, 0, sizeof(struct tag));
@@ -203,6 +250,13 @@ void atags_print_tag(struct tag *t)
 		for (i = 0; i < ARRAY_SIZE(t->u.ddr_mem.reserved); i++)
 			printf("    res[%d] = 0x%x\n", i, t->u.ddr_mem.reserved[i]);
 		break;
+	case ATAG_BOOTSTAGE:
+		printf("[bootstage]:\n");
+		printf("     magic = 0x%x\n", t->hdr.magic);
+		printf("      size = 0x%x\n\n", t->hdr.size << 2);
+		printf("   version = 0x%x\n", t->u.bootstage.version);
+		printf("  data len = 0x%x\n", t->u.bootstage.size);
+		break;
 	case ATAG_CORE:
 		printf("[core]:\n");
 		printf("     magic = 0x%x\n", t->hdr.magic);
@@ -5,7 +5,9 @@
  */
 
 #include <common.h>
+#include <smp_job.h>
 #include <asm/arch/rockchip_crc.h>
+#include <linux/sizes.h>
 
 #define tole(x) cpu_to_le32(x)
 
@@ -95,6 +97,90 @@ static uint32_t crc32_rk(uint32_t crc, const unsigned char *s, uint32_t len)
 
 #undef DO_CRC
 
+#define CRC_RK_POLY		0x04c10db7
+#define CRC_RK_SMP_MIN		SZ_1M
+
+/* a * b modulo the CRC polynomial */
+static u32 crc32_rk_mulmod(u32 a, u32 b)
+{
+	u32 r = 0;
+	int i;
+
+	for (i = 31; i >= 0; i--) {
+		r = (r << 1) ^ (r & 0x80000000 ? CRC_RK_POLY : 0);
+		if (b & (1U << i))
+			r ^= a;
+	}
+
+	return r;
+}
+
+/*
+ * CRC of A followed by B, from the CRCs of A and B. The CRC has no initial
+ * value or final xor, so this is crc_a * x^(8 * len_b) + crc_b.
+ */
+static u32 crc32_rk_combine(u32 crc_a, u32 crc_b, u32 len_b)
+{
+	u32 pow = 1, base = 0x100;	/* x^0 and x^8 */
+
+	while (len_b) {
+		if (len_b & 1)
+			pow = crc32_rk_mulmod(pow, base);
+		base = crc32_rk_mulmod(base, base);
+		len_b >>= 1;
+	}
+
+	return crc32_rk_mulmod(crc_a, pow) ^ crc_b;
+}
+
+struct crc32_rk_chunk {
+	struct smp_job job;
+	const unsigned char *data;
+	u32 len;
+	u32 crc;
+};
+
+static int crc32_rk_chunk(void *arg)
+{
+	struct crc32_rk_chunk *chunk = arg;
+
+	chunk->crc = crc32_rk(0, chunk->data, chunk->len);
+
+	return 0;
+}
+
+/* Split large images between the boot core and the job workers */
+static u32 crc32_rk_smp(const unsigned char *data, u32 size)
+{
+	struct crc32_rk_chunk chunks[SMP_JOB_MAX_WORKERS + 1];
+	int count = smp_job_workers() + 1;
+	u32 step, crc;
+	int i;
+
+	if (count == 1 || size < CRC_RK_SMP_MIN)
+		return crc32_rk(0, data, size);
+
+	step = ALIGN(DIV_ROUND_UP(size, count), ARCH_DMA_MINALIGN);
+	count = DIV_ROUND_UP(size, step);
+	for (i = 0; i < count; i++) {
+		struct crc32_rk_chunk *chunk = &chunks[i];
+
+		chunk->data = data + i * step;
+		chunk->len = min(step, size - i * step);
+		smp_job_init_one(&chunk->job, crc32_rk_chunk, chunk);
+		/* The last chunk finds every worker busy and runs here */
+		smp_job_submit(&chunk->job);
+	}
+
+	crc = 0;
+	for (i = 0; i < count; i++) {
+		smp_job_wait(&chunks[i].job);
+		crc = crc32_rk_combine(crc, chunks[i].crc, chunks[i].len);
+	}
+
+	return crc;
+}
+
 u32 rockchip_crc_verify(unsigned char *data, u32 size)
 {
 	u32 crc_check = 0, crc_calc = 0;
@@ -107,7 +193,7 @@ u32 rockchip_crc_verify(unsigned char *data, u32 size)
 	for (i = 3; i >= 0; i--)
 		crc_check = (crc_check << 8) + (*(data + size + i));
 
-	crc_calc = crc32_rk(0, data, size);
+	crc_calc = crc32_rk_smp(data, size);
 
 	debug("%s: crc_check=0x%x, crc_calc=0x%x\n",
 	      __func__, crc_check, crc_calc);
@@ -5,6 +5,7 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <debug_uart.h>
 #include <dm.h>
 #include <ns16550.h>
@@ -155,7 +156,9 @@ void board_init_f(ulong dummy)
 	timer_init();
 
 #if defined(CONFIG_SPL_FRAMEWORK) && !CONFIG_IS_ENABLED(TINY_FRAMEWORK)
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DRAM, "dram");
 	ret = uclass_get_device(UCLASS_RAM, 0, &dev);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DRAM);
 	if (ret) {
 		printf("DRAM init failed: %d\n", ret);
 		return;
@@ -164,6 +167,14 @@ void board_init_f(ulong dummy)
 	sdram_init();
 #endif
 
+#if defined(CONFIG_TPL_BOOTSTAGE) && defined(CONFIG_BOOTSTAGE_STASH)
+	/* DRAM is up, so hand the TPL timings over to SPL */
+	bootstage_mark_name(BOOTSTAGE_ID_END_TPL, "end_tpl");
+	if (bootstage_stash((void *)CONFIG_BOOTSTAGE_STASH_ADDR,
+			    CONFIG_BOOTSTAGE_STASH_SIZE))
+		debug("Failed to stash bootstage\n");
+#endif
+
 #if defined(CONFIG_TPL_ROCKCHIP_BACK_TO_BROM) && !defined(CONFIG_TPL_BOARD_INIT)
 	back_to_bootrom(BROM_BOOT_NEXTSTAGE);
 #endif
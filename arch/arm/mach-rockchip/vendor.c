@@ -8,6 +8,7 @@
 #include <malloc.h>
 #include <asm/arch/vendor.h>
 #include <boot_rkimg.h>
+#include <u-boot/crc.h>
 
 /* tag for vendor check */
 #define VENDOR_TAG		0x524B5644
@@ -17,6 +18,8 @@
 /* align to 64 bytes */
 #define VENDOR_BTYE_ALIGN	0x3F
 #define VENDOR_BLOCK_SIZE	512
+/* Slots in the id index, a power of two above the maximum item number */
+#define VENDOR_INDEX_SIZE	256
 
 /* --- Emmc define --- */
 /* Starting address of the Vendor in memory. */
@@ -113,6 +116,15 @@ struct vendor_info {
 static struct vendor_info vendor_info;
 /* The storage type of the device */
 static int bootdev_type;
+/* Item number + 1 of each id, hashed by id with linear probing; 0 is free */
+static u8 vendor_index[VENDOR_INDEX_SIZE];
+/*
+ * Bytes at the start of the data area which each copy on flash already
+ * holds. Items are only ever appended, so a copy which is behind only
+ * lacks the data from here to free_offset, besides the header, item table
+ * and version2.
+ */
+static u16 vendor_synced[VENDOR_PART_NUM];
 
 /* vendor private read write ops*/
 static	int (*_flash_read)(struct blk_desc *dev_desc,
@@ -219,6 +231,143 @@ static int vendor_ops(u8 *buffer, u32 addr, u32 n_sec, int write)
 	return ret;
 }
 
+static int vendor_index_find(u16 id)
+{
+	u32 h = id & (VENDOR_INDEX_SIZE - 1);
+	u8 slot;
+
+	while ((slot = vendor_index[h])) {
+		if (vendor_info.item[slot - 1].id == id)
+			return slot - 1;
+		h = (h + 1) & (VENDOR_INDEX_SIZE - 1);
+	}
+
+	return -1;
+}
+
+static void vendor_index_add(u16 i)
+{
+	u32 h = vendor_info.item[i].id & (VENDOR_INDEX_SIZE - 1);
+
+	while (vendor_index[h])
+		h = (h + 1) & (VENDOR_INDEX_SIZE - 1);
+	vendor_index[h] = i + 1;
+}
+
+static void vendor_index_build(void)
+{
+	u16 i;
+
+	memset(vendor_index, 0, sizeof(vendor_index));
+	for (i = 0; i < vendor_info.hdr->item_num; i++)
+		vendor_index_add(i);
+}
+
+/*
+ * Bring the copy @index on flash up to date with vendor_info. Only the
+ * header, item table, newly appended data and the last block (which holds
+ * version2) are written, version2 last so that a copy cut short by a power
+ * loss is seen as invalid. Spi Nor copies are a single erase block, which
+ * is cheapest to rewrite in one go.
+ */
+static int vendor_write_copy(u32 index, u16 part_size)
+{
+	u8 *buf = (u8 *)vendor_info.hdr;
+	u32 data_offset = vendor_info.data - buf;
+	u32 base = part_size * index;
+	u32 hdr_end, first, end;
+	int cnt;
+
+	if (bootdev_type == IF_TYPE_SPINOR) {
+		cnt = vendor_ops(buf, base, part_size, 1);
+		goto out;
+	}
+
+	hdr_end = DIV_ROUND_UP(data_offset, VENDOR_BLOCK_SIZE);
+	first = (data_offset + vendor_synced[index]) / VENDOR_BLOCK_SIZE;
+	end = DIV_ROUND_UP(data_offset + vendor_info.hdr->free_offset,
+			   VENDOR_BLOCK_SIZE);
+	end = min_t(u32, end, part_size - 1);
+
+	if (first > hdr_end) {
+		cnt = vendor_ops(buf, base, hdr_end, 1);
+		if (cnt != hdr_end)
+			goto out;
+		if (first < end) {
+			cnt = vendor_ops(buf + first * VENDOR_BLOCK_SIZE,
+					 base + first, end - first, 1);
+			if (cnt != end - first)
+				goto out;
+		}
+	} else {
+		end = max(end, hdr_end);
+		cnt = vendor_ops(buf, base, end, 1);
+		if (cnt != end)
+			goto out;
+	}
+	cnt = vendor_ops(buf + (part_size - 1) * VENDOR_BLOCK_SIZE,
+			 base + part_size - 1, 1, 1);
+	if (cnt == 1)
+		cnt = part_size;
+out:
+	if (cnt != part_size) {
+		vendor_synced[index] = 0;
+		return -EIO;
+	}
+	vendor_synced[index] = vendor_info.hdr->free_offset;
+
+	return 0;
+}
+
+/*
+ * Pack the data of every item but @skip, whose data is about to be
+ * replaced, to the start of the data area, dropping the old versions left
+ * behind by updates. Fails without changing anything if that would still
+ * leave less than @need bytes free.
+ */
+static int vendor_compact(int skip, u32 need)
+{
+	struct vendor_item *item = vendor_info.item;
+	u32 total = vendor_info.hdr->free_offset + vendor_info.hdr->free_size;
+	u32 used = 0;
+	u16 i;
+	u8 *tmp;
+
+	for (i = 0; i < vendor_info.hdr->item_num; i++) {
+		if (i != skip)
+			used += (item[i].size + VENDOR_BTYE_ALIGN) &
+				(~VENDOR_BTYE_ALIGN);
+	}
+	if (used + need > total)
+		return -ENOMEM;
+
+	tmp = malloc(total);
+	if (!tmp)
+		return -ENOMEM;
+
+	used = 0;
+	for (i = 0; i < vendor_info.hdr->item_num; i++) {
+		if (i == skip)
+			continue;
+		memcpy(tmp + used, vendor_info.data + item[i].offset,
+		       item[i].size);
+		item[i].offset = used;
+		used += (item[i].size + VENDOR_BTYE_ALIGN) &
+			(~VENDOR_BTYE_ALIGN);
+	}
+	memcpy(vendor_info.data, tmp, used);
+	free(tmp);
+
+	vendor_info.hdr->free_offset = used;
+	vendor_info.hdr->free_size = total - used;
+	/* The data area of every copy on flash is out of date now */
+	memset(vendor_synced, 0, sizeof(vendor_synced));
+	debug("[Vendor INFO]:Compacted, free_size=%d\n",
+	      vendor_info.hdr->free_size);
+
+	return 0;
+}
+
 /*
  * The VendorStorage partition is divided into four parts
  * (vendor 0-3) and its structure is shown in the following figure.
@@ -233,6 +382,8 @@ static int vendor_ops(u8 *buffer, u32 addr, u32 n_sec, int write)
  *      is valid (equal is valid).
  *   2. the "version" value is larger, indicating that the current
  *      verndor data is new.
+ *   3. a copy whose data area starts out the same as the latest one is
+ *      remembered, so that writing it later only appends the rest.
  */
 int vendor_storage_init(void)
 {
@@ -244,6 +395,8 @@ int vendor_storage_init(void)
 	u32 max_index = 0;
 	u16 data_offset, hash_offset, part_num;
 	u16 version2_offset, part_size;
+	u16 copy_offset[VENDOR_PART_NUM];
+	u32 copy_crc[VENDOR_PART_NUM];
 	struct blk_desc *dev_desc;
 
 	dev_desc = rockchip_get_bootdev();
@@ -292,7 +445,9 @@ int vendor_storage_init(void)
 	bootdev_type = dev_desc->if_type;
 
 	/* Always use, no need to release */
-	buffer = (u8 *)malloc(size);
+	buffer = (u8 *)vendor_info.hdr;
+	if (!buffer)
+		buffer = (u8 *)malloc(size);
 	if (!buffer) {
 		printf("[Vendor ERROR]:Malloc failed!\n");
 		return -ENOMEM;
@@ -313,12 +468,20 @@ int vendor_storage_init(void)
 			goto out;
 		}
 
+		copy_offset[i] = 0;
+		copy_crc[i] = 0;
 		if ((vendor_info.hdr->tag == VENDOR_TAG) &&
 		    (*(vendor_info.version2) == vendor_info.hdr->version)) {
 			if (max_ver < vendor_info.hdr->version) {
 				max_index = i;
 				max_ver = vendor_info.hdr->version;
 			}
+			if (vendor_info.hdr->free_offset <=
+			    hash_offset - data_offset) {
+				copy_offset[i] = vendor_info.hdr->free_offset;
+				copy_crc[i] = crc32(0, vendor_info.data,
+						    copy_offset[i]);
+			}
 		}
 	}
 
@@ -336,6 +499,14 @@ int vendor_storage_init(void)
 				goto out;
 			}
 		}
+		for (i = 0; i < part_num; i++) {
+			if (copy_offset[i] <= vendor_info.hdr->free_offset &&
+			    crc32(0, vendor_info.data, copy_offset[i]) ==
+			    copy_crc[i])
+				vendor_synced[i] = copy_offset[i];
+			else
+				vendor_synced[i] = 0;
+		}
 	} else {
 		debug("[Vendor INFO]:Reset vendor info...\n");
 		memset((u8 *)vendor_info.hdr, 0, size);
@@ -346,7 +517,9 @@ int vendor_storage_init(void)
 			((u32)(size_t)vendor_info.hash
 			- (u32)(size_t)vendor_info.data);
 		*(vendor_info.version2) = vendor_info.hdr->version;
+		memset(vendor_synced, 0, sizeof(vendor_synced));
 	}
+	vendor_index_build();
 	debug("[Vendor INFO]:ret=%d.\n", ret);
 
 out:
@@ -367,8 +540,7 @@ out:
 int vendor_storage_read(u16 id, void *pbuf, u16 size)
 {
 	int ret = 0;
-	u32 i;
-	u16 offset;
+	int i;
 	struct vendor_item *item;
 
 	/* init vendor storage */
@@ -378,21 +550,20 @@ int vendor_storage_read(u16 id, void *pbuf, u16 size)
 			return ret;
 	}
 
-	item = vendor_info.item;
-	for (i = 0; i < vendor_info.hdr->item_num; i++) {
-		if ((item + i)->id == id) {
-			debug("[Vendor INFO]:Find the matching item, id=%d\n", id);
-			/* Correct the size value */
-			if (size > (item + i)->size)
-				size = (item + i)->size;
-			offset = (item + i)->offset;
-			memcpy(pbuf, (vendor_info.data + offset), size);
-			return size;
-		}
+	i = vendor_index_find(id);
+	if (i < 0) {
+		debug("[Vendor ERROR]:No matching item, id=%d\n", id);
+		return -EINVAL;
 	}
-	debug("[Vendor ERROR]:No matching item, id=%d\n", id);
+	debug("[Vendor INFO]:Find the matching item, id=%d\n", id);
+
+	item = vendor_info.item + i;
+	/* Correct the size value */
+	if (size > item->size)
+		size = item->size;
+	memcpy(pbuf, (vendor_info.data + item->offset), size);
 
-	return -EINVAL;
+	return size;
 }
 
 /*
@@ -404,14 +575,19 @@ int vendor_storage_read(u16 id, void *pbuf, u16 size)
  * @pbuf: write data buffer;
  * @size: write bytes;
  *
+ * The data is always appended at free_offset, also when the item already
+ * exists, and the data area is only compacted once it is full. The format
+ * on flash stays the same, and the items in the table stay in the order of
+ * their data.
+ *
  * return: bytes equal to @size is success, other fail;
  */
 int vendor_storage_write(u16 id, void *pbuf, u16 size)
 {
-	int cnt, ret = 0;
-	u32 i, next_index, align_size;
-	struct vendor_item *item;
-	u16 part_size, max_item_num, offset, part_num;
+	int i, ret = 0;
+	u32 next_index, align_size;
+	struct vendor_item *item, moved;
+	u16 part_size, max_item_num, part_num;
 
 	/* init vendor storage */
 	if (!bootdev_type) {
@@ -451,58 +627,61 @@ int vendor_storage_write(u16 id, void *pbuf, u16 size)
 	if (size > align_size)
 		return -EINVAL;
 
-	item = vendor_info.item;
-	/* If item already exist, update the item data */
-	for (i = 0; i < vendor_info.hdr->item_num; i++) {
-		if ((item + i)->id == id) {
-			debug("[Vendor INFO]:Find the matching item, id=%d\n", id);
-			offset = (item + i)->offset;
-			memcpy((vendor_info.data + offset), pbuf, size);
-			(item + i)->size = size;
-			vendor_info.hdr->version++;
-			*(vendor_info.version2) = vendor_info.hdr->version;
-			vendor_info.hdr->next_index++;
-			if (vendor_info.hdr->next_index >= part_num)
-				vendor_info.hdr->next_index = 0;
-			cnt = vendor_ops((u8 *)vendor_info.hdr, part_size * next_index, part_size, 1);
-			return (cnt == part_size) ? size : -EIO;
+	i = vendor_index_find(id);
+	if (i < 0 && vendor_info.hdr->item_num >= max_item_num) {
+		debug("[Vendor ERROR]:Vendor has no item left!\n");
+		return -ENOMEM;
+	}
+	if (vendor_info.hdr->free_size < align_size) {
+		ret = vendor_compact(i, align_size);
+		if (ret) {
+			debug("[Vendor ERROR]:Vendor has no space left!\n");
+			return ret;
 		}
 	}
-	/*
-	 * If item does not exist, and free size is enough,
-	 * creat a new one
-	 */
-	if ((vendor_info.hdr->item_num < max_item_num) &&
-	    (vendor_info.hdr->free_size >= align_size)) {
-		debug("[Vendor INFO]:Create new Item, id=%d\n", id);
-		item = vendor_info.item + vendor_info.hdr->item_num;
-		item->id = id;
-		item->offset = vendor_info.hdr->free_offset;
-		item->size = size;
-
-		vendor_info.hdr->free_offset += align_size;
-		vendor_info.hdr->free_size -= align_size;
-		memcpy((vendor_info.data + item->offset), pbuf, size);
-		vendor_info.hdr->item_num++;
-		vendor_info.hdr->version++;
-		vendor_info.hdr->next_index++;
-		*(vendor_info.version2) = vendor_info.hdr->version;
-		if (vendor_info.hdr->next_index >= part_num)
-			vendor_info.hdr->next_index = 0;
 
-		cnt = vendor_ops((u8 *)vendor_info.hdr, part_size * next_index, part_size, 1);
-		return (cnt == part_size) ? size : -EIO;
+	if (i < 0) {
+		debug("[Vendor INFO]:Create new Item, id=%d\n", id);
+		i = vendor_info.hdr->item_num++;
+		vendor_info.item[i].id = id;
+		vendor_index_add(i);
+	} else if (i != vendor_info.hdr->item_num - 1) {
+		debug("[Vendor INFO]:Find the matching item, id=%d\n", id);
+		/*
+		 * The new data goes after all the others, so move the item to
+		 * the end of the table too. The kernel driver relies on the
+		 * data being in table order when it grows an item.
+		 */
+		moved = vendor_info.item[i];
+		memmove(vendor_info.item + i, vendor_info.item + i + 1,
+			(vendor_info.hdr->item_num - 1 - i) * sizeof(moved));
+		i = vendor_info.hdr->item_num - 1;
+		vendor_info.item[i] = moved;
+		vendor_index_build();
 	}
-	debug("[Vendor ERROR]:Vendor has no space left!\n");
+	item = vendor_info.item + i;
+	item->offset = vendor_info.hdr->free_offset;
+	item->size = size;
+	memcpy((vendor_info.data + item->offset), pbuf, size);
+
+	vendor_info.hdr->free_offset += align_size;
+	vendor_info.hdr->free_size -= align_size;
+	vendor_info.hdr->version++;
+	*(vendor_info.version2) = vendor_info.hdr->version;
+	vendor_info.hdr->next_index++;
+	if (vendor_info.hdr->next_index >= part_num)
+		vendor_info.hdr->next_index = 0;
+
+	ret = vendor_write_copy(next_index, part_size);
 
-	return -ENOMEM;
+	return ret ? ret : size;
 }
 
 /**********************************************************/
 /*              vendor API uinit test                      */
 /**********************************************************/
 /* Reset the vendor storage space to the initial state */
-static void vendor_test_reset(void)
+void vendor_test_reset(void)
 {
 	u16 i, part_size, part_num;
 	u32 size;
@@ -540,9 +719,37 @@ static void vendor_test_reset(void)
 	vendor_info.hdr->free_size = (unsigned long)vendor_info.hash -
 				     (unsigned long)vendor_info.data;
 	*(vendor_info.version2) = vendor_info.hdr->version;
+	vendor_index_build();
 	/* write to flash. */
-	for (i = 0; i < part_num; i++)
+	for (i = 0; i < part_num; i++) {
 		vendor_ops((u8 *)vendor_info.hdr, part_size * i, part_size, 1);
+		vendor_synced[i] = 0;
+	}
+}
+
+/* Check that the item data is in the order of the item table */
+int vendor_test_check_order(void)
+{
+	struct vendor_item *item = vendor_info.item;
+	u32 end = 0;
+	u16 i;
+
+	for (i = 0; i < vendor_info.hdr->item_num; i++) {
+		if (item[i].offset < end) {
+			printf("[Vendor Test]:Item %d(id=%d) is out of order\n",
+			       i, item[i].id);
+			return -EINVAL;
+		}
+		end = item[i].offset +
+		      ((item[i].size + VENDOR_BTYE_ALIGN) & (~VENDOR_BTYE_ALIGN));
+	}
+	if (vendor_info.hdr->free_offset < end) {
+		printf("[Vendor Test]:free_offset=%d is below the data\n",
+		       vendor_info.hdr->free_offset);
+		return -EINVAL;
+	}
+
+	return 0;
 }
 
 /*
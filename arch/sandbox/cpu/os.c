@@ -7,6 +7,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -187,6 +189,50 @@ void os_usleep(unsigned long usec)
 	usleep(usec);
 }
 
+int os_thread_create(void *(*func)(void *), void *arg)
+{
+	pthread_t thread;
+	int ret;
+
+	ret = pthread_create(&thread, NULL, func, arg);
+	if (ret)
+		return -ret;
+
+	return -pthread_detach(thread);
+}
+
+void os_thread_yield(void)
+{
+	sched_yield();
+}
+
+/*
+ * Events work like WFE/SEV on ARM: a wake counts as pending for each thread
+ * until it next waits, so one sent between a thread checking its condition
+ * and going to sleep is not lost.
+ */
+static pthread_mutex_t os_thread_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t os_thread_cond = PTHREAD_COND_INITIALIZER;
+static unsigned long os_thread_events;
+static __thread unsigned long os_thread_seen;
+
+void os_thread_wait(void)
+{
+	pthread_mutex_lock(&os_thread_lock);
+	while (os_thread_seen == os_thread_events)
+		pthread_cond_wait(&os_thread_cond, &os_thread_lock);
+	os_thread_seen = os_thread_events;
+	pthread_mutex_unlock(&os_thread_lock);
+}
+
+void os_thread_wake(void)
+{
+	pthread_mutex_lock(&os_thread_lock);
+	os_thread_events++;
+	pthread_cond_broadcast(&os_thread_cond);
+	pthread_mutex_unlock(&os_thread_lock);
+}
+
 uint64_t __attribute__((no_instrument_function)) os_get_nsec(void)
 {
 #if defined(CLOCK_MONOTONIC) && defined(_POSIX_MONOTONIC_CLOCK)
@@ -0,0 +1,60 @@
+/*
+ * Sandbox job workers, running on host threads
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <os.h>
+#include <smp_job.h>
+
+/* Match the three secondary cores of RK3288 */
+#define SANDBOX_SMP_JOB_CPUS	3
+
+static int sandbox_smp_stopped[SANDBOX_SMP_JOB_CPUS];
+
+static void *sandbox_smp_worker(void *arg)
+{
+	uint cpu = (ulong)arg;
+
+	smp_job_worker(cpu);
+	__sync_synchronize();
+	WRITE_ONCE(sandbox_smp_stopped[cpu], 1);
+
+	return NULL;
+}
+
+int arch_smp_job_cpus(void)
+{
+	return SANDBOX_SMP_JOB_CPUS;
+}
+
+int arch_smp_job_start(uint cpu)
+{
+	sandbox_smp_stopped[cpu] = 0;
+
+	return os_thread_create(sandbox_smp_worker, (void *)(ulong)cpu);
+}
+
+int arch_smp_job_stop(uint cpu)
+{
+	ulong start = get_timer(0);
+
+	while (!READ_ONCE(sandbox_smp_stopped[cpu])) {
+		if (get_timer(start) > 1000)
+			return -ETIMEDOUT;
+		os_thread_yield();
+	}
+
+	return 0;
+}
+
+void arch_smp_job_idle(void)
+{
+	os_thread_wait();
+}
+
+void arch_smp_job_wake(void)
+{
+	os_thread_wake();
+}
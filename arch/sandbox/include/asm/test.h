@@ -79,4 +79,33 @@ long sandbox_i2c_rtc_get_set_base_time(struct udevice *dev, long base_time);
 
 int sandbox_usb_keyb_add_string(struct udevice *dev, const char *str);
 
+/**
+ * sandbox_mmc_read_count() - get the number of read commands seen
+ *
+ * @dev:		MMC device
+ * @return number of single and multiple block read commands received
+ * since bind
+ */
+int sandbox_mmc_read_count(struct udevice *dev);
+
+/**
+ * sandbox_mmc_erase_count() - get the number of erase commands seen
+ *
+ * @dev:		MMC device
+ * @return number of MMC_CMD_ERASE commands received since bind
+ */
+int sandbox_mmc_erase_count(struct udevice *dev);
+
+/**
+ * sandbox_mmc_get_erase() - get the range of an erase command
+ *
+ * @dev:		MMC device
+ * @index:		Erase command to look up, 0 for the first one
+ * @start:		Returns the first sector erased
+ * @end:		Returns the last sector erased
+ * @return 0 if OK, -ENOENT if the command was not recorded
+ */
+int sandbox_mmc_get_erase(struct udevice *dev, int index, ulong *start,
+			  ulong *end);
+
 #endif
@@ -18,10 +18,15 @@ static int blkc_show(cmd_tbl_t *cmdtp, int flag,
 
 	printf("hits: %u\n"
 	       "misses: %u\n"
+	       "hit rate: %u%%\n"
+	       "page fills: %u\n"
 	       "entries: %u\n"
 	       "max blocks/entry: %u\n"
 	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
+	       stats.hits, stats.misses,
+	       stats.hits + stats.misses ?
+	       stats.hits * 100 / (stats.hits + stats.misses) : 0,
+	       stats.page_fills, stats.entries,
 	       stats.max_blocks_per_entry, stats.max_entries);
 	return 0;
 }
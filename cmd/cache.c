@@ -10,6 +10,7 @@
  */
 #include <common.h>
 #include <command.h>
+#include <dma_map.h>
 #include <linux/compiler.h>
 
 static int parse_argv(const char *);
@@ -66,6 +67,11 @@ static int do_dcache(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		case 2:
 			flush_dcache_all();
 			break;
+#if CONFIG_IS_ENABLED(DMA_MAP)
+		case 3:
+			dma_map_print_stats();
+			break;
+#endif
 		}
 		break;
 	case 1:			/* get status */
@@ -80,7 +86,9 @@ static int do_dcache(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 static int parse_argv(const char *s)
 {
-	if (strcmp(s, "flush") == 0)
+	if (strcmp(s, "stats") == 0)
+		return 3;
+	else if (strcmp(s, "flush") == 0)
 		return 2;
 	else if (strcmp(s, "on") == 0)
 		return 1;
@@ -103,4 +111,8 @@ U_BOOT_CMD(
 	"enable or disable data cache",
 	"[on, off, flush]\n"
 	"    - enable, disable, or flush data (writethrough) cache"
+#if CONFIG_IS_ENABLED(DMA_MAP)
+	"\ndcache stats\n"
+	"    - show cache maintenance done for DMA since boot"
+#endif
 );
@@ -0,0 +1,58 @@
+/*
+ * malloc pool statistics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc_pool.h>
+
+static int do_malloc_stats(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+	malloc_pool_print_stats();
+	if (argc > 1 && !strcmp(argv[1], "-r"))
+		malloc_pool_reset_stats();
+
+	return 0;
+}
+
+static int do_malloc_reset(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+	malloc_pool_reset_stats();
+
+	return 0;
+}
+
+static cmd_tbl_t cmd_malloc_sub[] = {
+	U_BOOT_CMD_MKENT(stats, 2, 1, do_malloc_stats, "", ""),
+	U_BOOT_CMD_MKENT(reset, 1, 1, do_malloc_reset, "", ""),
+};
+
+static int do_malloc(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[])
+{
+	cmd_tbl_t *c;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	/* Strip off leading 'malloc' command argument */
+	argc--;
+	argv++;
+
+	c = find_cmd_tbl(argv[0], cmd_malloc_sub, ARRAY_SIZE(cmd_malloc_sub));
+	if (c)
+		return c->cmd(cmdtp, flag, argc, argv);
+	else
+		return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(malloc, 3, 1, do_malloc,
+	"malloc pool information",
+	"stats [-r]  - show peak usage, fragmentation and hit rate per size\n"
+	"              class, -r resets the counters afterwards\n"
+	"malloc reset      - reset the counters"
+);
@@ -19,6 +19,7 @@
 #include <console.h>
 #include <hash.h>
 #include <inttypes.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <watchdog.h>
 #include <asm/io.h>
@@ -1187,6 +1188,116 @@ static int do_mem_info(cmd_tbl_t *cmdtp, int flag, int argc,
 }
 #endif
 
+#ifdef CONFIG_CMD_MEM_BENCH
+/* Bytes moved per size class and function, enough for a stable figure */
+#define MEM_BENCH_BYTES		(64 << 20)
+/* Room for memmove() to shift a block up */
+#define MEM_BENCH_SHIFT		64
+
+enum {
+	MEM_BENCH_MEMCPY,
+	MEM_BENCH_MEMMOVE,
+	MEM_BENCH_MEMSET,
+
+	MEM_BENCH_COUNT,
+};
+
+static const char *const mem_bench_name[MEM_BENCH_COUNT] = {
+	"memcpy", "memmove", "memset",
+};
+
+/* Run one function over @size bytes until MEM_BENCH_BYTES have moved */
+static ulong mem_bench_one(int func, char *dst, char *src, ulong size)
+{
+	ulong loops = max(MEM_BENCH_BYTES / size, 1UL);
+	ulong start, us, i;
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		switch (func) {
+		case MEM_BENCH_MEMCPY:
+			memcpy(dst, src, size);
+			break;
+		case MEM_BENCH_MEMMOVE:
+			/* Overlapping shift up, as memmove_wd() does */
+			memmove(src + MEM_BENCH_SHIFT, src, size);
+			break;
+		case MEM_BENCH_MEMSET:
+			memset(dst, i, size);
+			break;
+		}
+	}
+	us = max(timer_get_us() - start, 1UL);
+
+	/* bytes per microsecond is MB/s */
+	return size * loops / us;
+}
+
+static int do_mem_bench(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	ulong max_size = 4 << 20;
+	ulong size;
+	char *dst, *src;
+	int func;
+
+	if (argc > 2)
+		max_size = simple_strtoul(argv[2], NULL, 16);
+	if (max_size < 64)
+		return CMD_RET_USAGE;
+
+	dst = malloc(max_size);
+	src = malloc(max_size + MEM_BENCH_SHIFT);
+	if (!dst || !src) {
+		printf("Cannot allocate 2 x %#lx bytes\n", max_size);
+		free(dst);
+		free(src);
+		return CMD_RET_FAILURE;
+	}
+	memset(src, 0x5a, max_size + MEM_BENCH_SHIFT);
+
+#ifdef CONFIG_ARM_NEON_MEMFUNCS
+	printf("NEON, prefetch %d bytes ahead\n",
+	       CONFIG_ARM_NEON_MEM_PLD_DISTANCE);
+#endif
+	printf("%10s", "bytes");
+	for (func = 0; func < MEM_BENCH_COUNT; func++)
+		printf("%10s", mem_bench_name[func]);
+	puts("   (MB/s)\n");
+
+	for (size = 64; size <= max_size; size *= 8) {
+		printf("%10lu", size);
+		for (func = 0; func < MEM_BENCH_COUNT; func++)
+			printf("%10lu", mem_bench_one(func, dst, src, size));
+		puts("\n");
+		if (ctrlc())
+			break;
+	}
+	free(dst);
+	free(src);
+
+	return 0;
+}
+
+static cmd_tbl_t cmd_mem_sub[] = {
+	U_BOOT_CMD_MKENT(bench, 3, 1, do_mem_bench, "", ""),
+};
+
+static int do_mem(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	cmd_tbl_t *c;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	c = find_cmd_tbl(argv[1], cmd_mem_sub, ARRAY_SIZE(cmd_mem_sub));
+	if (c)
+		return c->cmd(cmdtp, flag, argc, argv);
+
+	return CMD_RET_USAGE;
+}
+#endif
+
 U_BOOT_CMD(
 	base,	2,	1,	do_mem_base,
 	"print or set address offset",
@@ -1253,3 +1364,13 @@ U_BOOT_CMD(
 	""
 );
 #endif
+
+#ifdef CONFIG_CMD_MEM_BENCH
+U_BOOT_CMD(
+	mem,	3,	1,	do_mem,
+	"memory function benchmarks",
+	"bench [max_size]\n"
+	"    - show memcpy, memmove and memset bandwidth for sizes from 64\n"
+	"      bytes up to max_size (hex, default 0x400000)"
+);
+#endif
@@ -27,7 +27,9 @@
 #include <malloc.h>
 #include <asm/byteorder.h>
 #include <jffs2/jffs2.h>
+#include <memalign.h>
 #include <nand.h>
+#include <linux/math64.h>
 
 #if defined(CONFIG_CMD_MTDPARTS)
 
@@ -371,6 +373,58 @@ static void adjust_size_for_badblocks(loff_t *size, loff_t offset, int dev)
 	}
 }
 
+#ifdef CONFIG_CMD_NAND_BENCH
+/*
+ * Read @size bytes from @off one erase block at a time, skipping bad
+ * blocks, and report the throughput. Only the reads are timed.
+ */
+static int nand_bench(struct mtd_info *mtd, loff_t off, loff_t size)
+{
+	struct mtd_ecc_stats stats = mtd->ecc_stats;
+	loff_t end = off + size;
+	u64 bytes = 0, us = 0;
+	unsigned int bad = 0;
+	size_t retlen;
+	ulong start;
+	u_char *buf;
+	int ret = 0;
+
+	buf = malloc_cache_aligned(mtd->erasesize);
+	if (!buf) {
+		puts("Cannot allocate a block buffer\n");
+		return 1;
+	}
+
+	for (off = round_down(off, mtd->erasesize); off < end;
+	     off += mtd->erasesize) {
+		if (nand_block_isbad(mtd, off)) {
+			bad++;
+			continue;
+		}
+		start = timer_get_us();
+		ret = mtd_read(mtd, off, mtd->erasesize, &retlen, buf);
+		us += timer_get_us() - start;
+		if (ret && ret != -EUCLEAN) {
+			printf("Read error %d at 0x%llx\n", ret,
+			       (unsigned long long)off);
+			break;
+		}
+		ret = 0;
+		bytes += retlen;
+	}
+	free(buf);
+
+	us = max_t(u64, us, 1);
+	printf(" %llu bytes read in %llu us, %llu KiB/s, %u bad blocks skipped\n",
+	       bytes, us, div64_u64(bytes * 1000000, us) >> 10, bad);
+	printf(" ECC: %u bitflips corrected, %u failed\n",
+	       mtd->ecc_stats.corrected - stats.corrected,
+	       mtd->ecc_stats.failed - stats.failed);
+
+	return ret ? 1 : 0;
+}
+#endif
+
 static int do_nand(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	int i, ret = 0;
@@ -699,6 +753,24 @@ static int do_nand(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	}
 #endif
 
+#ifdef CONFIG_CMD_NAND_BENCH
+	if (strcmp(cmd, "bench") == 0) {
+		if (mtd_arg_off_size(argc - 2, argv + 2, &dev, &off, &size,
+				     &maxsize, MTD_DEV_TYPE_NAND,
+				     mtd->size) < 0)
+			return 1;
+
+		if (set_dev(dev))
+			return 1;
+
+		mtd = get_nand_dev_by_index(dev);
+		printf("\nNAND bench: device %d offset 0x%llx, size 0x%llx\n",
+		       dev, (unsigned long long)off, (unsigned long long)size);
+
+		return nand_bench(mtd, off, size);
+	}
+#endif
+
 	if (strcmp(cmd, "markbad") == 0) {
 		argc -= 2;
 		argv += 2;
@@ -814,6 +886,9 @@ static char nand_help_text[] =
 #ifdef CONFIG_CMD_NAND_TORTURE
 	"nand torture off - torture one block at offset\n"
 	"nand torture off [size] - torture blocks from off to off+size\n"
+#endif
+#ifdef CONFIG_CMD_NAND_BENCH
+	"nand bench off|partition size - measure read throughput\n"
 #endif
 	"nand scrub [-y] off size | scrub.part partition | scrub.chip\n"
 	"    really clean NAND erasing bad blocks (UNSAFE)\n"
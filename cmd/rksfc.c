@@ -28,6 +28,12 @@ static int do_rksfc(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 			return ret;
 		}
+#ifdef CONFIG_RKSFC_NOR
+		if (strcmp(argv[1], "stats") == 0) {
+			rksfc_nor_print_stats();
+			return CMD_RET_SUCCESS;
+		}
+#endif
 	}
 
 	if (argc == 3) {
@@ -54,5 +60,6 @@ U_BOOT_CMD(
 	"rksfc read addr blk# cnt - read `cnt' blocks starting at block\n"
 	"     `blk#' to memory address `addr'\n"
 	"rksfc write addr blk# cnt - write `cnt' blocks starting at block\n"
-	"     `blk#' from memory address `addr'"
+	"     `blk#' from memory address `addr'\n"
+	"rksfc stats - show what spinor writes have skipped and erased"
 );
@@ -219,6 +219,7 @@ static int do_rkusb(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 	}
 
 cleanup_register:
+	fsg_print_stats();
 	g_dnl_unregister();
 cleanup_board:
 	board_usb_cleanup(controller_index, USB_INIT_DEVICE);
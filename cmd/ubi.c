@@ -85,6 +85,8 @@ static void display_ubi_info(struct ubi_device *ubi)
 	ubi_msg("number of PEBs reserved for bad PEB handling: %d",
 			ubi->beb_rsvd_pebs);
 	ubi_msg("max/mean erase counter: %d/%d", ubi->max_ec, ubi->mean_ec);
+	ubi_msg("attached by %s in %lu ms",
+		ubi->fm_attached ? "fastmap" : "scanning", ubi->attach_time);
 }
 
 static int ubi_info(int layout)
@@ -7,12 +7,74 @@
 
 #include <common.h>
 #include <command.h>
+#include <mapmem.h>
+#include <u-boot/zlib.h>
+
+#ifdef CONFIG_ZLIB_INFLATE_WIDE
+static ulong unzip_bench_one(int wide, void *dst, ulong dst_len, void *src,
+			     ulong *lenp, u32 *crcp)
+{
+	ulong start;
+
+	zlib_inflate_wide = wide;
+	*lenp = ~0UL;
+	start = timer_get_us();
+	if (gunzip(dst, dst_len, src, lenp))
+		return 0;
+	start = timer_get_us() - start;
+	*crcp = crc32(0, dst, *lenp);
+
+	return start ? start : 1;
+}
+
+static int do_unzip_bench(int argc, char * const argv[])
+{
+	ulong src, dst, dst_len = ~0UL;
+	ulong len[2], us[2];
+	u32 crc[2];
+	int wide;
+
+	if (argc < 3)
+		return CMD_RET_USAGE;
+	src = simple_strtoul(argv[1], NULL, 16);
+	dst = simple_strtoul(argv[2], NULL, 16);
+	if (argc > 3)
+		dst_len = simple_strtoul(argv[3], NULL, 16);
+
+	for (wide = 0; wide < 2; wide++) {
+		us[wide] = unzip_bench_one(wide, map_sysmem(dst, 0), dst_len,
+					   map_sysmem(src, 0), &len[wide],
+					   &crc[wide]);
+		if (!us[wide])
+			break;
+		printf("%-8s %8lu us, %4lu MB/s\n", wide ? "wide:" : "generic:",
+		       us[wide], len[wide] / us[wide]);
+	}
+	zlib_inflate_wide = 1;
+	if (wide < 2)
+		return CMD_RET_FAILURE;
+
+	printf("speedup: %lu.%02lux\n", us[0] / us[1], us[0] * 100 / us[1] % 100);
+	if (len[0] != len[1] || crc[0] != crc[1]) {
+		printf("output differs: %lu/%08x vs %lu/%08x\n", len[0], crc[0],
+		       len[1], crc[1]);
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+#endif
 
 static int do_unzip(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	unsigned long src, dst;
 	unsigned long src_len = ~0UL, dst_len = ~0UL;
 
+#ifdef CONFIG_ZLIB_INFLATE_WIDE
+	if (argc > 1 && !strcmp(argv[1], "bench"))
+		return do_unzip_bench(argc - 1, argv + 1);
+#endif
+
 	switch (argc) {
 		case 4:
 			dst_len = simple_strtoul(argv[3], NULL, 16);
@@ -25,6 +87,15 @@ static int do_unzip(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			return CMD_RET_USAGE;
 	}
 
+#ifdef CONFIG_ZSTD
+	if (zstd_is_valid_header((void *)src)) {
+		size_t size = dst_len;
+
+		if (zstd_decompress((void *)src, src_len, (void *)dst, &size))
+			return 1;
+		src_len = size;
+	} else
+#endif
 	if (gunzip((void *) dst, dst_len, (void *) src, &src_len) != 0)
 		return 1;
 
@@ -35,9 +106,13 @@ static int do_unzip(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 }
 
 U_BOOT_CMD(
-	unzip,	4,	1,	do_unzip,
-	"unzip a memory region",
+	unzip,	5,	1,	do_unzip,
+	"unzip a memory region (gzip, or zstd if enabled)",
 	"srcaddr dstaddr [dstsize]"
+#ifdef CONFIG_ZLIB_INFLATE_WIDE
+	"\nunzip bench srcaddr dstaddr [dstsize]\n"
+	"    - compare the speed of the generic and wide inflate loops"
+#endif
 );
 
 static int do_gzwrite(cmd_tbl_t *cmdtp, int flag,
@@ -230,6 +230,7 @@ static int do_usb_mass_storage(cmd_tbl_t *cmdtp, int flag,
 	}
 
 cleanup_register:
+	fsg_print_stats();
 	g_dnl_unregister();
 cleanup_board:
 	board_usb_cleanup(controller_index, USB_INIT_DEVICE);
@@ -241,6 +242,8 @@ cleanup_ums_init:
 
 U_BOOT_CMD(ums, 4, 1, do_usb_mass_storage,
 	"Use the UMS [USB Mass Storage]",
-	"<USB_controller> [<devtype>] <dev[:part]>  e.g. ums 0 mmc 0\n"
+	"<USB_controller> [<devtype>] <dev[:part]>[,<dev[:part]>...]\n"
+	"    e.g. ums 0 mmc 0 or ums 0 mmc 0:1,0:2\n"
+	"    each dev[:part] is exported as its own LUN\n"
 	"    devtype defaults to mmc"
 );
@@ -377,7 +377,11 @@ static int reserve_video(void)
 
 static int reserve_trace(void)
 {
-#ifdef CONFIG_TRACE
+#if defined(CONFIG_TRACE_EARLY) && defined(CONFIG_TRACE_HANDOFF)
+	/* Keep tracing into the early buffer, which is passed to the OS */
+	gd->trace_buff = map_sysmem(CONFIG_TRACE_EARLY_ADDR,
+				    CONFIG_TRACE_EARLY_SIZE);
+#elif defined(CONFIG_TRACE)
 	gd->relocaddr -= CONFIG_TRACE_BUFFER_SIZE;
 	gd->trace_buff = map_sysmem(gd->relocaddr, CONFIG_TRACE_BUFFER_SIZE);
 	debug("Reserving %dk for trace data at: %08lx\n",
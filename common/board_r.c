@@ -41,6 +41,7 @@
 #include <onenand_uboot.h>
 #include <scsi.h>
 #include <serial.h>
+#include <smp_job.h>
 #include <spi.h>
 #include <stdio_dev.h>
 #include <timer.h>
@@ -89,7 +90,9 @@ static int initr_secondary_cpu(void)
 
 static int initr_trace(void)
 {
-#ifdef CONFIG_TRACE
+#if defined(CONFIG_TRACE_EARLY) && defined(CONFIG_TRACE_HANDOFF)
+	trace_init(gd->trace_buff, CONFIG_TRACE_EARLY_SIZE);
+#elif defined(CONFIG_TRACE)
 	trace_init(gd->trace_buff, CONFIG_TRACE_BUFFER_SIZE);
 #endif
 
@@ -721,6 +724,9 @@ static init_fnc_t init_sequence_r[] = {
 	log_init,
 	initr_bootstage,	/* Needs malloc() but has its own timer */
 	initr_console_record,
+#ifdef CONFIG_CONSOLE_RING
+	console_ring_init,
+#endif
 #ifdef CONFIG_SYS_NONCACHED_MEMORY
 	initr_noncached,
 #endif
@@ -743,6 +749,9 @@ static init_fnc_t init_sequence_r[] = {
 #endif
 #if defined(CONFIG_ARM) || defined(CONFIG_NDS32)
 	board_init,	/* Setup chipselects */
+#endif
+#ifdef CONFIG_SMP_JOB
+	smp_job_init,
 #endif
 	/*
 	 * TODO: printing of the clock inforamtion of the board is now
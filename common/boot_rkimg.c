@@ -213,7 +213,10 @@ struct blk_desc *rockchip_get_bootdev(void)
 	dev_type = get_bootdev_type();
 	devnum = env_get_ulong("devnum", 10, 0);
 
+	/* The first lookup probes the boot storage */
+	bootstage_start(BOOTSTAGE_ID_ACCUM_STORAGE, "storage");
 	dev_desc = blk_get_devnum_by_type(dev_type, devnum);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_STORAGE);
 
 	return dev_desc;
 }
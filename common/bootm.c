@@ -356,6 +356,10 @@ int bootm_parse_comp(const unsigned char *hdr)
 	if (lz4_is_valid_header(hdr))
 		return IH_COMP_LZ4;
 #endif
+#if defined(CONFIG_ZSTD)
+	if (zstd_is_valid_header(hdr))
+		return IH_COMP_ZSTD;
+#endif
 #if defined(CONFIG_LZO)
 	if (lzop_is_valid_header(hdr))
 		return IH_COMP_LZO;
@@ -439,11 +443,20 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 	case IH_COMP_LZ4: {
 		size_t size = unc_len;
 
-		ret = ulz4fn(image_buf, image_len, load_buf, &size);
+		ret = ulz4fn_parallel(image_buf, image_len, load_buf, &size);
 		image_len = size;
 		break;
 	}
 #endif /* CONFIG_LZ4 */
+#ifdef CONFIG_ZSTD
+	case IH_COMP_ZSTD: {
+		size_t size = unc_len;
+
+		ret = zstd_decompress(image_buf, image_len, load_buf, &size);
+		image_len = size;
+		break;
+	}
+#endif /* CONFIG_ZSTD */
 	default:
 		printf("Unimplemented compression type %d\n", comp);
 		return BOOTM_ERR_UNIMPLEMENTED;
@@ -474,9 +487,11 @@ static int bootm_load_os(bootm_headers_t *images, unsigned long *load_end,
 
 	load_buf = map_sysmem(load, 0);
 	image_buf = map_sysmem(os.image_start, image_len);
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "decompress");
 	err = bootm_decomp_image(os.comp, load, os.image_start, os.type,
 				 load_buf, image_buf, image_len,
 				 CONFIG_SYS_BOOTM_LEN, load_end);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
 	if (err) {
 		bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
 		return err;
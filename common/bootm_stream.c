@@ -0,0 +1,207 @@
+/*
+ * Decompressing images as they are read
+ *
+ * bootm_decomp_image() needs the whole compressed image in memory. The
+ * functions here take it in pieces instead, so that the caller can
+ * decompress each piece while the next one is read from storage.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <bootm.h>
+#include <malloc.h>
+#include <u-boot/zlib.h>
+
+/*
+ * inflate() allocates its window on first use, which must not happen on a
+ * secondary core, so all its memory comes from an arena set up beforehand.
+ * This covers the inflate state and a 32KiB window.
+ */
+#define GZIP_STREAM_ARENA	(48 << 10)
+
+struct gzip_stream {
+	z_stream s;
+	bool done;
+	ulong used;
+	u8 arena[GZIP_STREAM_ARENA] __aligned(16);
+};
+
+static void *gzip_stream_alloc(void *opaque, unsigned items, unsigned size)
+{
+	struct gzip_stream *gz = opaque;
+	ulong len = ALIGN(items * size, 16);
+	void *ptr;
+
+	if (gz->used + len > GZIP_STREAM_ARENA)
+		return NULL;
+	ptr = gz->arena + gz->used;
+	gz->used += len;
+
+	return ptr;
+}
+
+static void gzip_stream_free(void *opaque, void *ptr, unsigned nb)
+{
+}
+
+static int gzip_stream_start(struct bootm_stream *st, void *load_buf,
+			     ulong unc_len)
+{
+	struct gzip_stream *gz;
+
+	gz = malloc(sizeof(*gz));
+	if (!gz)
+		return -ENOMEM;
+	memset(&gz->s, '\0', sizeof(gz->s));
+	gz->s.zalloc = gzip_stream_alloc;
+	gz->s.zfree = gzip_stream_free;
+	gz->s.opaque = gz;
+	gz->s.next_out = load_buf;
+	gz->s.avail_out = unc_len;
+	gz->done = false;
+	gz->used = 0;
+
+	/* Let inflate() parse the gzip header and check the trailer */
+	if (inflateInit2(&gz->s, 16 + MAX_WBITS) != Z_OK) {
+		free(gz);
+		return -EINVAL;
+	}
+	st->priv = gz;
+
+	return 0;
+}
+
+static int gzip_stream_feed(struct gzip_stream *gz, const void *buf, ulong len)
+{
+	int r;
+
+	if (gz->done)
+		return 0;
+	gz->s.next_in = (unsigned char *)buf;
+	gz->s.avail_in = len;
+	while (gz->s.avail_in) {
+		r = inflate(&gz->s, Z_NO_FLUSH);
+		if (r == Z_STREAM_END) {
+			gz->done = true;
+			break;
+		}
+		if (r == Z_BUF_ERROR && !gz->s.avail_out)
+			return -ENOBUFS;
+		if (r != Z_OK)
+			return -EPROTO;
+	}
+
+	return 0;
+}
+
+static int gzip_stream_end(struct gzip_stream *gz, ulong *unc_len)
+{
+	int ret = gz->done ? 0 : -EINVAL;
+
+	*unc_len = gz->s.total_out;
+	inflateEnd(&gz->s);
+	free(gz);
+
+	return ret;
+}
+
+bool bootm_decomp_stream_supported(int comp)
+{
+	switch (comp) {
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+		return true;
+#endif
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+int bootm_decomp_stream_start(struct bootm_stream *st, int comp,
+			      const void *head, ulong head_len,
+			      void *load_buf, ulong unc_len)
+{
+	st->comp = comp;
+	st->priv = NULL;
+
+	switch (comp) {
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+		return gzip_stream_start(st, load_buf, unc_len);
+#endif
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4: {
+		struct ulz4_stream *lz;
+		int ret;
+
+		lz = malloc(sizeof(*lz));
+		if (!lz)
+			return -ENOMEM;
+		ret = ulz4_stream_init(lz, head, head_len, load_buf, unc_len);
+		if (ret) {
+			free(lz);
+			return ret;
+		}
+		st->priv = lz;
+		return 0;
+	}
+#endif
+	default:
+		return -EPROTONOSUPPORT;
+	}
+}
+
+int bootm_decomp_stream_feed(struct bootm_stream *st, const void *buf,
+			     ulong len)
+{
+	switch (st->comp) {
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+		return gzip_stream_feed(st->priv, buf, len);
+#endif
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4:
+		return ulz4_stream_feed(st->priv, buf, len);
+#endif
+	default:
+		return -EPROTONOSUPPORT;
+	}
+}
+
+int bootm_decomp_stream_end(struct bootm_stream *st, ulong *unc_len)
+{
+	int ret;
+
+	*unc_len = 0;
+	if (!st->priv)
+		return -EINVAL;
+
+	switch (st->comp) {
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+		ret = gzip_stream_end(st->priv, unc_len);
+		break;
+#endif
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4: {
+		size_t size;
+
+		ret = ulz4_stream_end(st->priv, &size);
+		*unc_len = size;
+		free(st->priv);
+		break;
+	}
+#endif
+	default:
+		ret = -EPROTONOSUPPORT;
+		break;
+	}
+	st->priv = NULL;
+
+	return ret;
+}
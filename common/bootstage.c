@@ -196,6 +196,26 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+uint32_t bootstage_add_accum(const char *name, uint32_t start_us,
+			     uint32_t duration_us)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_record *rec;
+
+	if (data->rec_count >= RECORD_COUNT)
+		return 0;
+
+	rec = &data->record[data->rec_count++];
+	rec->id = data->next_id++;
+	rec->name = name;
+	rec->flags = 0;
+	/* A zero start time would make this look like a mark */
+	rec->start_us = start_us ? start_us : 1;
+	rec->time_us = duration_us;
+
+	return duration_us;
+}
+
 /**
  * Get a record name as a printable string
  *
@@ -291,6 +311,11 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 				rec->start_us ? "accum" : "mark",
 				rec->time_us))
 			return -EINVAL;
+
+		/* Place accumulated time on the timeline at its last start */
+		if (rec->start_us &&
+		    fdt_setprop_cell(blob, node, "start", rec->start_us))
+			return -EINVAL;
 	}
 
 	return 0;
@@ -366,7 +391,6 @@ int bootstage_stash(void *base, int size)
 	const struct bootstage_record *rec;
 	char buf[20];
 	char *ptr = base, *end = ptr + size;
-	uint32_t count;
 	int i;
 
 	if (hdr + 1 > (struct bootstage_hdr *)end) {
@@ -377,13 +401,11 @@ int bootstage_stash(void *base, int size)
 	/* Write an arbitrary version number */
 	hdr->version = BOOTSTAGE_VERSION;
 
-	/* Count the number of records, and write that value first */
-	for (rec = data->record, i = count = 0; i < data->rec_count;
-	     i++, rec++) {
-		if (rec->id != 0)
-			count++;
-	}
-	hdr->count = count;
+	/*
+	 * Write the number of records first. All of them are written below,
+	 * so the count must include every record for the names to line up.
+	 */
+	hdr->count = data->rec_count;
 	hdr->size = 0;
 	hdr->magic = BOOTSTAGE_MAGIC;
 	ptr += sizeof(*hdr);
@@ -469,12 +491,16 @@ int bootstage_unstash(const void *base, int size)
 
 	/* Read the name strings */
 	ptr += rec_size;
-	for (rec = data->record + data->next_id, i = 0; i < hdr->count;
+	for (rec = data->record + data->rec_count, i = 0; i < hdr->count;
 	     i++, rec++) {
 		rec->name = ptr;
 
 		/* Assume no data corruption here */
 		ptr += strlen(ptr) + 1;
+
+		/* Don't hand out IDs already allocated by an earlier phase */
+		if (rec->id >= data->next_id && rec->id < BOOTSTAGE_ID_ALLOC)
+			data->next_id = rec->id + 1;
 	}
 
 	/* Mark the records as read */
@@ -499,10 +525,9 @@ int bootstage_init(bool first)
 		return -ENOMEM;
 	data = gd->bootstage;
 	memset(data, '\0', size);
-	if (first) {
-		data->next_id = BOOTSTAGE_ID_USER;
+	data->next_id = BOOTSTAGE_ID_USER;
+	if (first)
 		bootstage_add_record(BOOTSTAGE_ID_AWAKE, "reset", 0, 0);
-	}
 
 	return 0;
 }
@@ -10,6 +10,7 @@
 #include <malloc.h>
 #include <errno.h>
 #include <bouncebuf.h>
+#include <dma_map.h>
 
 static int addr_aligned(struct bounce_buffer *state)
 {
@@ -31,6 +32,18 @@ static int addr_aligned(struct bounce_buffer *state)
 	return 1;
 }
 
+static enum dma_data_direction bounce_buffer_dir(struct bounce_buffer *state)
+{
+	switch (state->flags & GEN_BB_RW) {
+	case GEN_BB_READ:
+		return DMA_TO_DEVICE;
+	case GEN_BB_WRITE:
+		return DMA_FROM_DEVICE;
+	default:
+		return DMA_BIDIRECTIONAL;
+	}
+}
+
 int bounce_buffer_start(struct bounce_buffer *state, void *data,
 			size_t len, unsigned int flags)
 {
@@ -55,21 +68,17 @@ int bounce_buffer_start(struct bounce_buffer *state, void *data,
 	 * Flush data to RAM so DMA reads can pick it up,
 	 * and any CPU writebacks don't race with DMA writes
 	 */
-	flush_dcache_range((unsigned long)state->bounce_buffer,
-				(unsigned long)(state->bounce_buffer) +
-					state->len_aligned);
+	dma_map_range((ulong)state->bounce_buffer, state->len_aligned,
+		      bounce_buffer_dir(state));
 
 	return 0;
 }
 
 int bounce_buffer_stop(struct bounce_buffer *state)
 {
-	if (state->flags & GEN_BB_WRITE) {
-		/* Invalidate cache so that CPU can see any newly DMA'd data */
-		invalidate_dcache_range((unsigned long)state->bounce_buffer,
-					(unsigned long)(state->bounce_buffer) +
-						state->len_aligned);
-	}
+	/* Invalidate cache so that CPU can see any newly DMA'd data */
+	dma_unmap_range((ulong)state->bounce_buffer, state->len_aligned,
+			bounce_buffer_dir(state));
 
 	if (state->bounce_buffer == state->user_buffer)
 		return 0;
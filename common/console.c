@@ -228,6 +228,18 @@ static void console_putc(int file, const char c)
 	}
 }
 
+static void console_putc_noserial(int file, const char c)
+{
+	int i;
+	struct stdio_dev *dev;
+
+	for (i = 0; i < cd_count[file]; i++) {
+		dev = console_devices[file][i];
+		if (dev->putc != NULL && !console_dev_is_serial(dev))
+			dev->putc(dev, c);
+	}
+}
+
 static void console_puts_noserial(int file, const char *s)
 {
 	int i;
@@ -240,6 +252,18 @@ static void console_puts_noserial(int file, const char *s)
 	}
 }
 
+static bool console_has_serial(int file)
+{
+	int i;
+
+	for (i = 0; i < cd_count[file]; i++) {
+		if (console_dev_is_serial(console_devices[file][i]))
+			return true;
+	}
+
+	return false;
+}
+
 static void console_puts(int file, const char *s)
 {
 	int i;
@@ -272,12 +296,23 @@ static inline void console_putc(int file, const char c)
 	stdio_devices[file]->putc(stdio_devices[file], c);
 }
 
+static inline void console_putc_noserial(int file, const char c)
+{
+	if (!console_dev_is_serial(stdio_devices[file]))
+		stdio_devices[file]->putc(stdio_devices[file], c);
+}
+
 static inline void console_puts_noserial(int file, const char *s)
 {
 	if (!console_dev_is_serial(stdio_devices[file]))
 		stdio_devices[file]->puts(stdio_devices[file], s);
 }
 
+static inline bool console_has_serial(int file)
+{
+	return console_dev_is_serial(stdio_devices[file]);
+}
+
 static inline void console_puts(int file, const char *s)
 {
 	stdio_devices[file]->puts(stdio_devices[file], s);
@@ -349,16 +384,47 @@ int ftstc(int file)
 	return -1;
 }
 
+/*
+ * With deferred console output, serial output on stdout is queued. Anything
+ * else written to the serial port must wait for the queue to empty so that
+ * the output stays in order.
+ */
+static bool console_ring_queue(int file)
+{
+	if (!console_ring_active())
+		return false;
+	if (file == stdout && console_has_serial(file))
+		return true;
+	console_ring_flush();
+
+	return false;
+}
+
 void fputc(int file, const char c)
 {
-	if (file < MAX_FILES)
+	if (file >= MAX_FILES)
+		return;
+
+	if (console_ring_queue(file)) {
+		console_putc_noserial(file, c);
+		console_ring_putc(c);
+	} else {
 		console_putc(file, c);
+	}
 }
 
 void fputs(int file, const char *s)
 {
-	if (file < MAX_FILES)
+	if (file >= MAX_FILES)
+		return;
+
+	if (console_ring_queue(file)) {
+		console_puts_noserial(file, s);
+		while (*s)
+			console_ring_putc(*s++);
+	} else {
 		console_puts(file, s);
+	}
 }
 
 int fprintf(int file, const char *fmt, ...)
@@ -401,6 +467,9 @@ int getc(void)
 			return 1;
 	}
 #endif
+	/* Waiting for input: let the pending output out first */
+	console_ring_flush();
+
 	if (gd->flags & GD_FLG_DEVINIT) {
 		/* Get from the standard input */
 		return fgetc(stdin);
@@ -425,6 +494,8 @@ int tstc(void)
 			return 1;
 	}
 #endif
+	console_ring_drain();
+
 	if (gd->flags & GD_FLG_DEVINIT) {
 		/* Test the standard input */
 		return ftstc(stdin);
@@ -513,7 +584,10 @@ void putc(const char c)
 	} else {
 		/* Send directly to the handler */
 		pre_console_putc(c);
-		serial_putc(c);
+		if (console_ring_active())
+			console_ring_putc(c);
+		else
+			serial_putc(c);
 	}
 }
 
@@ -0,0 +1,171 @@
+/*
+ * Deferred console output
+ *
+ * Every character written to the serial console normally waits for room in
+ * the UART FIFO, so at 115200 baud each line of boot output costs several
+ * milliseconds of busy waiting. With this enabled, serial output is appended
+ * to a ring buffer and only the bytes the UART can take right away are sent
+ * from putc(); the rest goes out on later writes, while polling for input
+ * and before the OS is started.
+ *
+ * The buffer has a single producer (putc) and a single consumer (the drain
+ * below), each owning one free-running index, so no locking is needed. It is
+ * passed to the OS through /reserved-memory so that the log is not lost.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <console.h>
+#include <environment.h>
+#include <fdt_support.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <serial.h>
+#include <watchdog.h>
+#include <linux/log2.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static struct console_ring_hdr *ring;
+static char *ring_buf;
+static u32 ring_mask;
+static bool ring_sync = IS_ENABLED(CONFIG_CONSOLE_RING_SYNC);
+static bool ring_stopped;
+static bool ring_draining;
+static bool ring_cr_sent;	/* '\r' for the '\n' at the tail was sent */
+
+/*
+ * Send bytes from the tail until at most @keep bytes are pending. If @wait
+ * is false, stop as soon as the UART is full.
+ */
+static void console_ring_send(bool wait, u32 keep)
+{
+	u32 head, tail;
+	int ret;
+
+	if (ring_draining)
+		return;
+	ring_draining = true;
+
+	head = READ_ONCE(ring->head);
+	tail = ring->tail;
+	while (head - tail > keep) {
+		char c = ring_buf[tail & ring_mask];
+
+		if (c == '\n' && !ring_cr_sent) {
+			ret = serial_tryputc('\r');
+			if (!ret)
+				ring_cr_sent = true;
+		} else {
+			ret = serial_tryputc(c);
+			if (!ret) {
+				ring_cr_sent = false;
+				tail++;
+			}
+		}
+		if (ret == -EAGAIN) {
+			if (!wait)
+				break;
+			WATCHDOG_RESET();
+		} else if (ret) {
+			/* The UART is gone; drop what is left */
+			tail = head;
+		}
+	}
+	WRITE_ONCE(ring->tail, tail);
+
+	ring_draining = false;
+}
+
+int console_ring_init(void)
+{
+	ulong size = CONFIG_CONSOLE_RING_SIZE;
+	ulong total = ALIGN(sizeof(*ring) + size, SZ_4K);
+
+	if (!is_power_of_2(size)) {
+		printf("console ring: size %#lx is not a power of two\n", size);
+		return 0;
+	}
+
+	ring = memalign(SZ_4K, total);
+	if (!ring)
+		return -ENOMEM;
+	ring->magic = CONSOLE_RING_MAGIC;
+	ring->size = size;
+	ring->head = 0;
+	ring->tail = 0;
+	ring_buf = (char *)(ring + 1);
+	ring_mask = size - 1;
+
+	return 0;
+}
+
+bool console_ring_active(void)
+{
+	return ring && !ring_stopped;
+}
+
+void console_ring_putc(const char c)
+{
+	u32 head = ring->head;
+
+	/* Full: wait until a quarter of the buffer is free again */
+	if (head - READ_ONCE(ring->tail) > ring_mask) {
+		if (ring_draining)
+			return;
+		console_ring_send(true, ring->size - ring->size / 4);
+	}
+
+	ring_buf[head & ring_mask] = c;
+	barrier();
+	WRITE_ONCE(ring->head, head + 1);
+
+	console_ring_send(ring_sync, 0);
+}
+
+void console_ring_drain(void)
+{
+	if (console_ring_active())
+		console_ring_send(false, 0);
+}
+
+void console_ring_flush(void)
+{
+	if (console_ring_active())
+		console_ring_send(true, 0);
+}
+
+void console_ring_handoff(void)
+{
+	if (IS_ENABLED(CONFIG_CONSOLE_RING_FLUSH_ON_BOOT))
+		console_ring_flush();
+	ring_stopped = true;
+}
+
+int console_ring_fdt_fixup(void *blob)
+{
+	if (!ring)
+		return 0;
+
+	return fdt_add_reserved_memory_node(blob, "console-ring",
+					    "u-boot,console-ring",
+					    map_to_sysmem(ring),
+					    ALIGN(sizeof(*ring) + ring->size,
+						  SZ_4K));
+}
+
+static int on_consolesync(const char *name, const char *value,
+			  enum env_op op, int flags)
+{
+	if (op == env_op_delete)
+		ring_sync = IS_ENABLED(CONFIG_CONSOLE_RING_SYNC);
+	else
+		ring_sync = value && (*value == '1' || *value == 'y');
+	if (ring_sync)
+		console_ring_flush();
+
+	return 0;
+}
+U_BOOT_ENV_CALLBACK(consolesync, on_consolesync);
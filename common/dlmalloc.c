@@ -5,6 +5,7 @@
 #endif
 
 #include <malloc.h>
+#include <malloc_pool.h>
 #include <asm/io.h>
 
 #ifdef DEBUG
@@ -1251,6 +1252,7 @@ Void_t* mALLOc(bytes) size_t bytes;
   mchunkptr fwd;                     /* misc temp for linking */
   mchunkptr bck;                     /* misc temp for linking */
   mbinptr q;                         /* misc temp */
+  Void_t*   pool_mem;                /* buffer from the size-class pool */
 
   INTERNAL_SIZE_T nb;
 
@@ -1267,6 +1269,10 @@ Void_t* mALLOc(bytes) size_t bytes;
 
   if ((long)bytes < 0) return NULL;
 
+  pool_mem = malloc_pool_alloc(bytes, 0);
+  if (pool_mem)
+    return pool_mem;
+
   nb = request2size(bytes);  /* padded request size; */
 
   /* Check for exact match in a bin */
@@ -1531,6 +1537,9 @@ void fREe(mem) Void_t* mem;
   if (mem == NULL)                              /* free(0) has no effect */
     return;
 
+  if (malloc_pool_free(mem))
+    return;
+
   p = mem2chunk(mem);
   hd = p->size;
 
@@ -1689,6 +1698,9 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 	}
 #endif
 
+  if (malloc_pool_usable_size(oldmem))
+    return malloc_pool_realloc(oldmem, bytes);
+
   newp    = oldp    = mem2chunk(oldmem);
   newsize = oldsize = chunksize(oldp);
 
@@ -1895,6 +1907,10 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
 
   if (alignment <= MALLOC_ALIGNMENT) return mALLOc(bytes);
 
+  m = malloc_pool_alloc(bytes, alignment);
+  if (m)
+    return m;
+
   /* Otherwise, ensure that it is at least a minimum chunk size */
 
   if (alignment <  MINSIZE) alignment = MINSIZE;
@@ -2084,6 +2100,10 @@ Void_t* cALLOc(n, elem_size) size_t n; size_t elem_size;
 		return mem;
 	}
 #endif
+    if (malloc_pool_usable_size(mem)) {
+      MALLOC_ZERO(mem, sz);
+      return mem;
+    }
     p = mem2chunk(mem);
 
     /* Two optional cases in which clearing not necessary */
@@ -2229,8 +2249,13 @@ size_t malloc_usable_size(mem) Void_t* mem;
 #endif
 {
   mchunkptr p;
+  size_t pool_size;
+
   if (mem == NULL)
     return 0;
+  pool_size = malloc_pool_usable_size(mem);
+  if (pool_size)
+    return pool_size;
   else
   {
     p = mem2chunk(mem);
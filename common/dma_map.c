@@ -0,0 +1,106 @@
+/*
+ * Cache maintenance for DMA buffers
+ *
+ * Drivers call dma_map_range() before starting a transfer and
+ * dma_unmap_range() when it is done, instead of flushing and invalidating
+ * by hand. This lets the maintenance be skipped when the memory is not
+ * cached and done by set/way when a range is larger than walking it line
+ * by line is worth.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dma_map.h>
+#include <smp_job.h>
+
+static struct dma_map_stats dma_stats;
+
+__weak bool dcache_range_cached(ulong start, ulong end)
+{
+	return dcache_status();
+}
+
+static void dma_map_do(ulong start, ulong end, bool flush)
+{
+	ulong len = end - start;
+
+	/*
+	 * Cleaning every set and way costs the same whatever the range, so
+	 * it wins for large ranges. Cleaning and invalidating is also right
+	 * for an invalidate, since the CPU must not have written to the
+	 * buffer. Set/way operations do not reach the other cores' L1
+	 * caches though, so not while they are running jobs.
+	 */
+	if (CONFIG_DMA_MAP_SETWAY_SIZE && len >= CONFIG_DMA_MAP_SETWAY_SIZE &&
+	    !smp_job_workers()) {
+		flush_dcache_all();
+		dma_stats.setway_ops++;
+	} else if (flush) {
+		flush_dcache_range(start, end);
+		dma_stats.flush_ops++;
+	} else {
+		invalidate_dcache_range(start, end);
+		dma_stats.inval_ops++;
+	}
+	if (flush)
+		dma_stats.flush_bytes += len;
+	else
+		dma_stats.inval_bytes += len;
+}
+
+void dma_map_range(ulong start, size_t len, enum dma_data_direction dir)
+{
+	ulong end = roundup(start + len, ARCH_DMA_MINALIGN);
+	bool flush;
+
+	if (!len)
+		return;
+	/*
+	 * A buffer for the device to fill only needs invalidating, unless
+	 * it shares a cache line with something else, which must be written
+	 * back first.
+	 */
+	flush = dir != DMA_FROM_DEVICE ||
+		(start | len) & (ARCH_DMA_MINALIGN - 1);
+	start = rounddown(start, ARCH_DMA_MINALIGN);
+
+	if (!dcache_range_cached(start, end)) {
+		dma_stats.skip_bytes += end - start;
+		return;
+	}
+	dma_map_do(start, end, flush);
+}
+
+void dma_unmap_range(ulong start, size_t len, enum dma_data_direction dir)
+{
+	ulong end = roundup(start + len, ARCH_DMA_MINALIGN);
+
+	if (!len || dir == DMA_TO_DEVICE)
+		return;
+	start = rounddown(start, ARCH_DMA_MINALIGN);
+
+	if (!dcache_range_cached(start, end)) {
+		dma_stats.skip_bytes += end - start;
+		return;
+	}
+	dma_map_do(start, end, false);
+}
+
+const struct dma_map_stats *dma_map_get_stats(void)
+{
+	return &dma_stats;
+}
+
+void dma_map_print_stats(void)
+{
+	const struct dma_map_stats *s = &dma_stats;
+
+	printf("DMA cache maintenance since boot:\n");
+	printf("  flushed:     %llu bytes, %lu ops by address\n",
+	       s->flush_bytes, s->flush_ops);
+	printf("  invalidated: %llu bytes, %lu ops by address\n",
+	       s->inval_bytes, s->inval_ops);
+	printf("  set/way:     %lu ops\n", s->setway_ops);
+	printf("  skipped:     %llu bytes (not cached)\n", s->skip_bytes);
+}
@@ -573,6 +573,58 @@ int fdt_update_reserved_memory(void *blob, char *name, u64 start, u64 size)
 	return nodeoffset;
 }
 
+int fdt_add_reserved_memory_node(void *blob, const char *name,
+				 const char *compatible, u64 addr, u64 size)
+{
+	fdt32_t reg[4];
+	char node_name[32];
+	int parent, node, ac, sc, len = 0;
+	int ret;
+
+	parent = fdt_path_offset(blob, "/reserved-memory");
+	if (parent < 0) {
+		/* The OS ignores the node unless its cells match the root */
+		ac = fdt_address_cells(blob, 0);
+		sc = fdt_size_cells(blob, 0);
+		if (ac < 0 || sc < 0)
+			return ac < 0 ? ac : sc;
+		parent = fdt_add_subnode(blob, 0, "reserved-memory");
+		if (parent < 0)
+			return parent;
+		ret = fdt_setprop_u32(blob, parent, "#address-cells", ac);
+		if (!ret)
+			ret = fdt_setprop_u32(blob, parent, "#size-cells", sc);
+		if (!ret)
+			ret = fdt_setprop_empty(blob, parent, "ranges");
+		if (ret)
+			return ret;
+	}
+	ac = fdt_address_cells(blob, parent);
+	sc = fdt_size_cells(blob, parent);
+
+	if (ac == 2)
+		reg[len++] = cpu_to_fdt32(upper_32_bits(addr));
+	reg[len++] = cpu_to_fdt32(lower_32_bits(addr));
+	if (sc == 2)
+		reg[len++] = cpu_to_fdt32(upper_32_bits(size));
+	reg[len++] = cpu_to_fdt32(lower_32_bits(size));
+
+	snprintf(node_name, sizeof(node_name), "%s@%llx", name, addr);
+	node = fdt_add_subnode(blob, parent, node_name);
+	if (node == -FDT_ERR_EXISTS)
+		node = fdt_subnode_offset(blob, parent, node_name);
+	if (node < 0)
+		return node;
+
+	ret = fdt_setprop_string(blob, node, "compatible", compatible);
+	if (!ret)
+		ret = fdt_setprop(blob, node, "reg", reg, len * sizeof(*reg));
+	if (!ret)
+		ret = fdt_setprop_empty(blob, node, "no-map");
+
+	return ret;
+}
+
 void fdt_fixup_ethernet(void *fdt)
 {
 	int i = 0, j, prop;
@@ -5,11 +5,13 @@
  */
 
 #include <common.h>
+#include <bootm.h>
 #include <image.h>
 #include <android_image.h>
 #include <malloc.h>
 #include <mapmem.h>
 #include <errno.h>
+#include <smp_job.h>
 #ifdef CONFIG_RKIMG_BOOTLOADER
 #include <asm/arch/resource_img.h>
 #endif
@@ -19,8 +21,25 @@ DECLARE_GLOBAL_DATA_PTR;
 #define ANDROID_IMAGE_DEFAULT_KERNEL_ADDR	0x10008000
 #define ANDROID_ARG_FDT_FILENAME "rk-kernel.dtb"
 
+#ifndef CONFIG_SYS_BOOTM_LEN
+#define CONFIG_SYS_BOOTM_LEN	0x800000
+#endif
+
 static char andr_tmp_str[ANDR_BOOT_ARGS_SIZE + 1];
 static u32 android_kernel_comp_type = IH_COMP_NONE;
+/*
+ * Size of the kernel decompressed by android_image_load(), 0 if none, and
+ * the header of the image it came from
+ */
+static ulong android_kernel_stream_len;
+static struct andr_img_hdr android_kernel_stream_hdr;
+
+/* Check whether @hdr is the image whose kernel was decompressed on load */
+static bool android_kernel_streamed(const struct andr_img_hdr *hdr)
+{
+	return android_kernel_stream_len &&
+	       !memcmp(hdr, &android_kernel_stream_hdr, sizeof(*hdr));
+}
 
 static ulong android_image_get_kernel_addr(const struct andr_img_hdr *hdr)
 {
@@ -116,6 +135,15 @@ int android_image_get_kernel(const struct andr_img_hdr *hdr, int verify,
 
 	env_set("bootargs", newbootargs);
 
+	/* Already decompressed in place while it was loaded */
+	if (android_kernel_streamed(hdr)) {
+		if (os_data)
+			*os_data = kernel_addr;
+		if (os_len)
+			*os_len = android_kernel_stream_len;
+		return 0;
+	}
+
 	if (os_data) {
 		*os_data = (ulong)hdr;
 		*os_data += hdr->page_size;
@@ -216,6 +244,168 @@ int android_image_get_fdt(const struct andr_img_hdr *hdr,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(ANDROID_IMAGE_STREAM)
+struct android_stream_chunk {
+	struct smp_job job;
+	struct bootm_stream *st;
+	void *buf;
+	const void *data;
+	ulong len;
+};
+
+static int android_stream_feed(void *arg)
+{
+	struct android_stream_chunk *chunk = arg;
+
+	return bootm_decomp_stream_feed(chunk->st, chunk->data, chunk->len);
+}
+
+/*
+ * Read the kernel part of a boot image in chunks and decompress it to
+ * @kload. Each chunk is handed to the decompressor, on another core if there
+ * is one, while the next chunk is read into the other buffer.
+ */
+static int android_image_stream_kernel(struct blk_desc *dev_desc,
+				       lbaint_t start,
+				       const struct andr_img_hdr *hdr,
+				       int comp, ulong kload)
+{
+	struct android_stream_chunk chunks[2], *chunk, *prev = NULL;
+	ulong blksz = dev_desc->blksz;
+	ulong koff = hdr->page_size;
+	ulong kend = koff + hdr->kernel_size;
+	lbaint_t blk = koff / blksz;
+	lbaint_t end_blk = DIV_ROUND_UP(kend, blksz);
+	lbaint_t chunk_blks = max(CONFIG_ANDROID_IMAGE_STREAM_CHUNK / blksz,
+				  1UL);
+	struct bootm_stream st;
+	ulong unc_len;
+	bool started = false;
+	void *bounce;
+	int i, ret = 0;
+
+	bounce = memalign(ARCH_DMA_MINALIGN, 2 * chunk_blks * blksz);
+	if (!bounce)
+		return -ENOMEM;
+	for (i = 0; i < 2; i++) {
+		chunks[i].st = &st;
+		chunks[i].buf = bounce + i * chunk_blks * blksz;
+	}
+
+	for (i = 0; blk < end_blk; i++) {
+		lbaint_t n = min(chunk_blks, end_blk - blk);
+		ulong pos = blk * blksz;
+
+		/* This buffer's previous job was waited for last time round */
+		chunk = &chunks[i & 1];
+		bootstage_start(BOOTSTAGE_ID_ACCUM_KERNEL_READ, "kernel read");
+		if (blk_dread(dev_desc, start + blk, n, chunk->buf) != n)
+			ret = -EIO;
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_KERNEL_READ);
+		if (ret)
+			break;
+
+		chunk->data = chunk->buf;
+		chunk->len = n * blksz;
+		if (pos < koff) {
+			chunk->data += koff - pos;
+			chunk->len -= koff - pos;
+		}
+		if (pos + n * blksz > kend)
+			chunk->len -= pos + n * blksz - kend;
+
+		if (!started) {
+			ret = bootm_decomp_stream_start(&st, comp, chunk->data,
+							chunk->len,
+							map_sysmem(kload, 0),
+							CONFIG_SYS_BOOTM_LEN);
+			if (ret)
+				break;
+			started = true;
+		}
+
+		bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "decompress");
+		if (prev)
+			ret = smp_job_wait(&prev->job);
+		if (!ret) {
+			smp_job_init_one(&chunk->job, android_stream_feed,
+					 chunk);
+			smp_job_submit(&chunk->job);
+			prev = chunk;
+		}
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
+		if (ret)
+			break;
+		blk += n;
+	}
+
+	if (prev) {
+		bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "decompress");
+		i = smp_job_wait(&prev->job);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
+		if (!ret)
+			ret = i;
+	}
+	if (started) {
+		i = bootm_decomp_stream_end(&st, &unc_len);
+		if (!ret)
+			ret = i;
+	}
+	free(bounce);
+	if (ret) {
+		printf("Kernel decompression failed: %d\n", ret);
+		return ret;
+	}
+
+	android_kernel_stream_len = unc_len;
+	flush_cache(kload, ALIGN(unc_len, ARCH_DMA_MINALIGN));
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, "android_kernel_streamed");
+	debug("Kernel decompressed to 0x%lx, %lu bytes\n", kload, unc_len);
+
+	return 0;
+}
+
+/*
+ * Load a boot image whose kernel is streamed: everything but the kernel goes
+ * to @buf as usual, the kernel is decompressed straight to @kload.
+ */
+static long android_image_load_stream(struct blk_desc *dev_desc,
+				      const disk_partition_t *part_info,
+				      void *buf, long blk_cnt, int comp,
+				      ulong kload)
+{
+	struct andr_img_hdr *hdr = buf;
+	ulong blksz = part_info->blksz;
+	lbaint_t hdr_blks, rest_blk;
+	int ret;
+
+	/* Only the header page goes to @buf before the kernel */
+	if (blk_dread(dev_desc, part_info->start, 1, buf) != 1)
+		return -1;
+	hdr_blks = DIV_ROUND_UP(hdr->page_size, blksz);
+	if (hdr_blks > 1 &&
+	    blk_dread(dev_desc, part_info->start + 1, hdr_blks - 1,
+		      buf + blksz) != hdr_blks - 1)
+		return -1;
+
+	ret = android_image_stream_kernel(dev_desc, part_info->start, hdr,
+					  comp, kload);
+	if (ret)
+		return -1;
+
+	/* Ramdisk, second stage and DTBO keep their offsets in the image */
+	rest_blk = (hdr->page_size + ALIGN(hdr->kernel_size, hdr->page_size)) /
+		   blksz;
+	if (rest_blk >= blk_cnt)
+		return blk_cnt;
+	if (blk_dread(dev_desc, part_info->start + rest_blk, blk_cnt - rest_blk,
+		      buf + rest_blk * blksz) != blk_cnt - rest_blk)
+		return -1;
+
+	return blk_cnt;
+}
+#endif
+
 long android_image_load(struct blk_desc *dev_desc,
 			const disk_partition_t *part_info,
 			unsigned long load_address,
@@ -225,6 +415,9 @@ long android_image_load(struct blk_desc *dev_desc,
 	long blk_read = 0;
 	u32 comp;
 	u32 kload_addr;
+	bool stream = false;
+
+	android_kernel_stream_len = 0;
 
 	if (max_size < part_info->blksz)
 		return -1;
@@ -260,6 +453,10 @@ long android_image_load(struct blk_desc *dev_desc,
 			unmap_sysmem(buf);
 			buf = map_sysmem(load_address, 0 /* size */);
 		}
+#if CONFIG_IS_ENABLED(ANDROID_IMAGE_STREAM)
+		stream = bootm_decomp_stream_supported(comp);
+#endif
+		kload_addr = env_get_ulong("kernel_addr_r", 16, 0x02080000);
 
 		if (blk_cnt * part_info->blksz > max_size) {
 			debug("Android Image too big (%lu bytes, max %lu)\n",
@@ -269,6 +466,13 @@ long android_image_load(struct blk_desc *dev_desc,
 		} else {
 			debug("Loading Android Image (%lu blocks) to 0x%lx... ",
 			      blk_cnt, load_address);
+#if CONFIG_IS_ENABLED(ANDROID_IMAGE_STREAM)
+			if (stream)
+				blk_read = android_image_load_stream(dev_desc,
+						part_info, buf, blk_cnt, comp,
+						kload_addr);
+			else
+#endif
 			blk_read = blk_dread(dev_desc, part_info->start,
 					     blk_cnt, buf);
 		}
@@ -277,8 +481,14 @@ long android_image_load(struct blk_desc *dev_desc,
 		 * zImage is not need to decompress
 		 * kernel will handle decompress itself
 		 */
-		if (comp != IH_COMP_NONE && comp != IH_COMP_ZIMAGE) {
-			kload_addr = env_get_ulong("kernel_addr_r", 16, 0x02080000);
+		if (stream) {
+			/* The kernel is already in place */
+			android_image_set_kload(buf, kload_addr);
+			android_image_set_comp(buf, IH_COMP_NONE);
+			/* Remember the header as bootm will be given it */
+			memcpy(&android_kernel_stream_hdr, buf,
+			       sizeof(android_kernel_stream_hdr));
+		} else if (comp != IH_COMP_NONE && comp != IH_COMP_ZIMAGE) {
 			android_image_set_kload(buf, kload_addr);
 			android_image_set_comp(buf, comp);
 		} else {
@@ -291,8 +501,10 @@ long android_image_load(struct blk_desc *dev_desc,
 
 	debug("%lu blocks read: %s\n",
 	      blk_read, (blk_read == blk_cnt) ? "OK" : "ERROR");
-	if (blk_read != blk_cnt)
+	if (blk_read != blk_cnt) {
+		android_kernel_stream_len = 0;
 		return -1;
+	}
 
 	return load_address;
 }
@@ -10,12 +10,14 @@
  */
 
 #include <common.h>
+#include <console.h>
 #include <fdtdec.h>
 #include <fdt_support.h>
 #include <errno.h>
 #include <image.h>
 #include <libfdt.h>
 #include <mapmem.h>
+#include <trace.h>
 #include <asm/io.h>
 
 #ifndef CONFIG_SYS_FDT_PAD
@@ -503,6 +505,14 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 	}
 	/* Update ethernet nodes */
 	fdt_fixup_ethernet(blob);
+	fdt_ret = console_ring_fdt_fixup(blob);
+	if (fdt_ret)
+		printf("WARNING: could not hand over console log: %s\n",
+		       fdt_strerror(fdt_ret));
+	fdt_ret = trace_fdt_fixup(blob);
+	if (fdt_ret)
+		printf("WARNING: could not hand over function trace: %s\n",
+		       fdt_strerror(fdt_ret));
 	if (IMAGE_OF_BOARD_SETUP) {
 		fdt_ret = ft_board_setup(blob, gd->bd);
 		if (fdt_ret) {
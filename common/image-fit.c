@@ -1608,8 +1608,13 @@ static int fit_image_select(const void *fit, int rd_noffset, int verify)
 	fit_image_print(fit, rd_noffset, "   ");
 
 	if (verify) {
+		int ok;
+
 		puts("   Verifying Hash Integrity ... ");
-		if (!fit_image_verify(fit, rd_noffset)) {
+		bootstage_start(BOOTSTAGE_ID_ACCUM_VERIFY, "verify");
+		ok = fit_image_verify(fit, rd_noffset);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_VERIFY);
+		if (!ok) {
 			puts("Bad Data Hash\n");
 			return -EACCES;
 		}
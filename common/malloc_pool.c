@@ -0,0 +1,300 @@
+/*
+ * Fixed size-class pool allocator in front of dlmalloc
+ *
+ * Block-sized DMA buffers (sector and page buffers, blkcache nodes, AVB and
+ * OP-TEE bounce buffers) are allocated and freed over and over during long
+ * fastboot and rockusb sessions. Going through dlmalloc with memalign() each
+ * time splits and fragments the heap. This file sets aside one region at the
+ * first allocation after relocation and carves it into power-of-two slots
+ * from 512 bytes to 64KiB, each class with its own free list, so that these
+ * requests are served in constant time and never touch the dlmalloc bins.
+ *
+ * Every class owns the same number of bytes and every class region starts on
+ * a 64KiB boundary, so each slot is aligned to its own size. That covers any
+ * memalign() whose alignment is not larger than the slot.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <malloc_pool.h>
+#include <div64.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define POOL_MIN_SIZE	(1UL << MALLOC_POOL_MIN_SHIFT)
+#define POOL_MAX_SIZE	(1UL << MALLOC_POOL_MAX_SHIFT)
+
+struct pool_slot {
+	struct pool_slot *next;
+};
+
+struct pool_class {
+	ulong base;
+	struct pool_slot *free;
+	u32 *req;		/* requested size of each slot, 0 if free */
+	struct malloc_pool_class_stats stats;
+};
+
+enum pool_state {
+	POOL_UNINIT,
+	POOL_READY,
+	POOL_FAILED,
+};
+
+static enum pool_state pool_state;
+static ulong pool_start, pool_end, pool_class_bytes;
+static struct pool_class pool_classes[MALLOC_POOL_CLASSES];
+
+static int malloc_pool_init(void)
+{
+	ulong size = CONFIG_SYS_MALLOC_POOL_SIZE;
+	uint total_slots = 0;
+	u32 *req;
+	int i, j;
+
+	/* Stop the allocations below from coming back into the pool */
+	pool_state = POOL_FAILED;
+
+	pool_class_bytes = round_down(size / MALLOC_POOL_CLASSES,
+				      POOL_MAX_SIZE);
+	if (!pool_class_bytes) {
+		printf("malloc pool: size %#lx too small\n", size);
+		return -EINVAL;
+	}
+	size = pool_class_bytes * MALLOC_POOL_CLASSES;
+
+	for (i = 0; i < MALLOC_POOL_CLASSES; i++)
+		total_slots += pool_class_bytes >> (MALLOC_POOL_MIN_SHIFT + i);
+
+	pool_start = (ulong)memalign(POOL_MAX_SIZE, size);
+	req = calloc(total_slots, sizeof(*req));
+	if (!pool_start || !req) {
+		free((void *)pool_start);
+		free(req);
+		printf("malloc pool: cannot reserve %#lx bytes\n", size);
+		return -ENOMEM;
+	}
+	pool_end = pool_start + size;
+
+	for (i = 0; i < MALLOC_POOL_CLASSES; i++) {
+		struct pool_class *pc = &pool_classes[i];
+		ulong slot_size = POOL_MIN_SIZE << i;
+		uint slots = pool_class_bytes / slot_size;
+
+		pc->base = pool_start + i * pool_class_bytes;
+		pc->req = req;
+		req += slots;
+		pc->stats.size = slot_size;
+		pc->stats.slots = slots;
+
+		/* Chain the slots so that the lowest address is used first */
+		pc->free = NULL;
+		for (j = slots - 1; j >= 0; j--) {
+			struct pool_slot *slot;
+
+			slot = (struct pool_slot *)(pc->base + j * slot_size);
+			slot->next = pc->free;
+			pc->free = slot;
+		}
+	}
+	pool_state = POOL_READY;
+	debug("malloc pool: %#lx bytes at %#lx, %u slots\n", size, pool_start,
+	      total_slots);
+
+	return 0;
+}
+
+static bool malloc_pool_ready(void)
+{
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return false;
+	if (pool_state == POOL_UNINIT)
+		malloc_pool_init();
+
+	return pool_state == POOL_READY;
+}
+
+static bool malloc_pool_contains(void *mem)
+{
+	return (ulong)mem >= pool_start && (ulong)mem < pool_end;
+}
+
+static struct pool_class *malloc_pool_lookup(void *mem, uint *slotp)
+{
+	ulong addr = (ulong)mem;
+	struct pool_class *pc;
+	ulong offset;
+	int idx;
+
+	if (!malloc_pool_contains(mem))
+		return NULL;
+	idx = (addr - pool_start) / pool_class_bytes;
+	pc = &pool_classes[idx];
+	offset = addr - pc->base;
+	if (offset & (pc->stats.size - 1)) {
+		printf("malloc pool: bad pointer %p\n", mem);
+		return NULL;
+	}
+	*slotp = offset >> (MALLOC_POOL_MIN_SHIFT + idx);
+
+	return pc;
+}
+
+void *malloc_pool_alloc(size_t bytes, size_t align)
+{
+	struct malloc_pool_class_stats *st;
+	struct pool_slot *slot;
+	struct pool_class *pc;
+	int shift, idx;
+
+	/* Only take requests that waste less than half of a slot */
+	if (bytes <= POOL_MIN_SIZE / 2 || bytes > POOL_MAX_SIZE)
+		return NULL;
+	if (!malloc_pool_ready())
+		return NULL;
+
+	shift = max(fls(bytes - 1), MALLOC_POOL_MIN_SHIFT);
+	if (align > (1UL << shift))
+		return NULL;
+	idx = shift - MALLOC_POOL_MIN_SHIFT;
+	pc = &pool_classes[idx];
+	st = &pc->stats;
+
+	slot = pc->free;
+	if (!slot) {
+		st->misses++;
+		return NULL;
+	}
+	pc->free = slot->next;
+	pc->req[((ulong)slot - pc->base) >> shift] = bytes;
+	st->hits++;
+	st->req_bytes += bytes;
+	if (++st->used > st->peak)
+		st->peak = st->used;
+
+	return slot;
+}
+
+bool malloc_pool_free(void *mem)
+{
+	struct pool_slot *slot = mem;
+	struct pool_class *pc;
+	uint idx;
+
+	if (!malloc_pool_contains(mem))
+		return false;
+	/* Not the start of a slot: reported, but dlmalloc must not see it */
+	pc = malloc_pool_lookup(mem, &idx);
+	if (!pc)
+		return true;
+	if (!pc->req[idx]) {
+		printf("malloc pool: double free of %p\n", mem);
+		return true;
+	}
+
+	pc->stats.req_bytes -= pc->req[idx];
+	pc->stats.used--;
+	pc->req[idx] = 0;
+	slot->next = pc->free;
+	pc->free = slot;
+
+	return true;
+}
+
+size_t malloc_pool_usable_size(void *mem)
+{
+	struct pool_class *pc;
+	uint idx;
+
+	pc = malloc_pool_lookup(mem, &idx);
+	if (!pc || !pc->req[idx])
+		return 0;
+
+	return pc->stats.size;
+}
+
+void *malloc_pool_realloc(void *mem, size_t bytes)
+{
+	struct pool_class *pc;
+	void *new;
+	uint idx;
+
+	pc = malloc_pool_lookup(mem, &idx);
+	if (!pc)
+		return NULL;
+
+	if (bytes <= pc->stats.size) {
+		pc->stats.req_bytes += bytes;
+		pc->stats.req_bytes -= pc->req[idx];
+		pc->req[idx] = bytes;
+		return mem;
+	}
+
+	new = malloc(bytes);
+	if (!new)
+		return NULL;
+	memcpy(new, mem, pc->req[idx]);
+	malloc_pool_free(mem);
+
+	return new;
+}
+
+int malloc_pool_get_stats(int idx, struct malloc_pool_class_stats *stats)
+{
+	if (idx < 0 || idx >= MALLOC_POOL_CLASSES)
+		return -EINVAL;
+	if (pool_state != POOL_READY)
+		return -ENOENT;
+	*stats = pool_classes[idx].stats;
+
+	return 0;
+}
+
+void malloc_pool_print_stats(void)
+{
+	ulong hits = 0, misses = 0;
+	int i;
+
+	if (pool_state != POOL_READY) {
+		printf("malloc pool: not in use\n");
+		return;
+	}
+
+	printf("malloc pool: %lu KiB at %08lx, %lu KiB per class\n",
+	       (pool_end - pool_start) >> 10, pool_start,
+	       pool_class_bytes >> 10);
+	printf("   size slots  used  peak      hits    misses  hit%%  frag%%\n");
+	for (i = 0; i < MALLOC_POOL_CLASSES; i++) {
+		struct malloc_pool_class_stats *st = &pool_classes[i].stats;
+		ulong total = st->hits + st->misses;
+		u64 held = (u64)st->used * st->size;
+		uint hit_pct, frag_pct = 0;
+
+		hit_pct = total ? (uint)lldiv((u64)st->hits * 100, total) :
+			  100;
+		if (held)
+			frag_pct = (uint)lldiv((held - st->req_bytes) * 100,
+					       held);
+		printf("%7lu %5u %5u %5u %9lu %9lu %4u%% %5u%%\n", st->size,
+		       st->slots, st->used, st->peak, st->hits, st->misses,
+		       hit_pct, frag_pct);
+		hits += st->hits;
+		misses += st->misses;
+	}
+	printf("total: %lu hits, %lu fell back to dlmalloc\n", hits, misses);
+}
+
+void malloc_pool_reset_stats(void)
+{
+	int i;
+
+	for (i = 0; i < MALLOC_POOL_CLASSES; i++) {
+		struct malloc_pool_class_stats *st = &pool_classes[i].stats;
+
+		st->hits = 0;
+		st->misses = 0;
+		st->peak = st->used;
+	}
+}
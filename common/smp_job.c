@@ -0,0 +1,182 @@
+/*
+ * Running boot-time jobs on secondary cores
+ *
+ * U-Boot runs on the boot core only. Some boot phases (decompression, hash
+ * and CRC checks, image decoding) work on large independent chunks of data
+ * and can be split across the other cores, which otherwise sit unused until
+ * the OS starts them.
+ *
+ * Each worker has a mailbox written by the boot core and read by the
+ * worker, so no atomic operations are needed: the boot core only hands a
+ * job to a worker in the idle state, and only the worker moves itself back
+ * to idle.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <smp_job.h>
+
+enum smp_worker_state {
+	SMP_WORKER_OFF,
+	SMP_WORKER_IDLE,
+	SMP_WORKER_BUSY,
+	SMP_WORKER_STOP,
+};
+
+struct smp_worker {
+	int state;
+	struct smp_job *job;
+	ulong count;
+} __aligned(ARCH_DMA_MINALIGN);
+
+static struct smp_worker smp_workers[SMP_JOB_MAX_WORKERS];
+static int smp_num_workers;
+
+__weak int arch_smp_job_cpus(void)
+{
+	return 0;
+}
+
+__weak int arch_smp_job_start(uint cpu)
+{
+	return -ENOSYS;
+}
+
+__weak int arch_smp_job_stop(uint cpu)
+{
+	return 0;
+}
+
+__weak void arch_smp_job_idle(void)
+{
+}
+
+__weak void arch_smp_job_wake(void)
+{
+}
+
+void smp_job_worker(uint cpu)
+{
+	struct smp_worker *w = &smp_workers[cpu];
+	struct smp_job *job;
+
+	WRITE_ONCE(w->state, SMP_WORKER_IDLE);
+	__sync_synchronize();
+	arch_smp_job_wake();
+
+	for (;;) {
+		switch (READ_ONCE(w->state)) {
+		case SMP_WORKER_BUSY:
+			__sync_synchronize();
+			job = w->job;
+			job->ret = job->fn(job->arg);
+			w->job = NULL;
+			w->count++;
+			__sync_synchronize();
+			WRITE_ONCE(job->done, 1);
+			WRITE_ONCE(w->state, SMP_WORKER_IDLE);
+			__sync_synchronize();
+			arch_smp_job_wake();
+			break;
+		case SMP_WORKER_STOP:
+			return;
+		default:
+			arch_smp_job_idle();
+			break;
+		}
+	}
+}
+
+int smp_job_init(void)
+{
+	int cpus = min(arch_smp_job_cpus(), SMP_JOB_MAX_WORKERS);
+	ulong start;
+	int cpu, ret;
+
+	for (cpu = 0; cpu < cpus; cpu++) {
+		struct smp_worker *w = &smp_workers[cpu];
+
+		ret = arch_smp_job_start(cpu);
+		if (ret) {
+			debug("%s: cpu %d failed to start: %d\n", __func__,
+			      cpu, ret);
+			continue;
+		}
+
+		start = get_timer(0);
+		while (READ_ONCE(w->state) != SMP_WORKER_IDLE) {
+			if (get_timer(start) > 100) {
+				printf("SMP: worker %d did not start\n", cpu);
+				arch_smp_job_stop(cpu);
+				break;
+			}
+			arch_smp_job_idle();
+		}
+		if (w->state == SMP_WORKER_IDLE)
+			smp_num_workers++;
+	}
+	debug("SMP: %d job workers\n", smp_num_workers);
+
+	return 0;
+}
+
+int smp_job_workers(void)
+{
+	return smp_num_workers;
+}
+
+void smp_job_submit(struct smp_job *job)
+{
+	int cpu;
+
+	job->done = 0;
+	for (cpu = 0; cpu < SMP_JOB_MAX_WORKERS; cpu++) {
+		struct smp_worker *w = &smp_workers[cpu];
+
+		if (READ_ONCE(w->state) != SMP_WORKER_IDLE)
+			continue;
+		w->job = job;
+		__sync_synchronize();
+		WRITE_ONCE(w->state, SMP_WORKER_BUSY);
+		__sync_synchronize();
+		arch_smp_job_wake();
+		return;
+	}
+
+	/* Every worker is busy, so do it here */
+	job->ret = job->fn(job->arg);
+	job->done = 1;
+}
+
+int smp_job_wait(struct smp_job *job)
+{
+	while (!READ_ONCE(job->done))
+		arch_smp_job_idle();
+	__sync_synchronize();
+
+	return job->ret;
+}
+
+void smp_job_park(void)
+{
+	int cpu;
+
+	for (cpu = 0; cpu < SMP_JOB_MAX_WORKERS; cpu++) {
+		struct smp_worker *w = &smp_workers[cpu];
+
+		if (w->state == SMP_WORKER_OFF)
+			continue;
+		while (READ_ONCE(w->state) == SMP_WORKER_BUSY)
+			arch_smp_job_idle();
+		WRITE_ONCE(w->state, SMP_WORKER_STOP);
+		__sync_synchronize();
+		arch_smp_job_wake();
+		if (arch_smp_job_stop(cpu))
+			printf("SMP: worker %d did not stop\n", cpu);
+		debug("SMP: worker %d ran %lu jobs\n", cpu, w->count);
+		w->state = SMP_WORKER_OFF;
+		w->count = 0;
+	}
+	smp_num_workers = 0;
+}
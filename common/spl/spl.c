@@ -19,6 +19,7 @@
 #include <dm/root.h>
 #include <linux/compiler.h>
 #include <fdt_support.h>
+#include <mapmem.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -215,6 +216,45 @@ __weak void __noreturn jump_to_image_no_args(struct spl_image_info *spl_image)
 	image_entry();
 }
 
+/*
+ * Start the bootstage timeline for this phase. TPL starts it afresh. When TPL
+ * records its own timings SPL continues from TPL's stash, so that SPL and
+ * U-Boot proper add to a single timeline. This relies on the timer not being
+ * reset between TPL and SPL.
+ */
+static int spl_bootstage_init(void)
+{
+	bool from_tpl = !IS_ENABLED(CONFIG_TPL_BUILD) &&
+			IS_ENABLED(CONFIG_TPL_BOOTSTAGE) &&
+			IS_ENABLED(CONFIG_BOOTSTAGE_STASH);
+	int ret;
+
+	ret = bootstage_init(!from_tpl);
+	if (ret)
+		return ret;
+#ifdef CONFIG_BOOTSTAGE_STASH
+	if (from_tpl) {
+		const void *stash = map_sysmem(CONFIG_BOOTSTAGE_STASH_ADDR,
+					       CONFIG_BOOTSTAGE_STASH_SIZE);
+
+		ret = bootstage_unstash(stash, CONFIG_BOOTSTAGE_STASH_SIZE);
+		if (ret && ret != -ENOENT)
+			debug("Failed to unstash bootstage: err=%d\n", ret);
+		/*
+		 * The names still point into the stash, which SPL overwrites
+		 * with its own stash before jumping to U-Boot
+		 */
+		bootstage_relocate();
+	}
+#endif
+	if (IS_ENABLED(CONFIG_TPL_BUILD))
+		bootstage_mark_name(BOOTSTAGE_ID_START_TPL, "tpl");
+	else
+		bootstage_mark_name(BOOTSTAGE_ID_START_SPL, "spl");
+
+	return 0;
+}
+
 static int spl_common_init(bool setup_malloc)
 {
 	int ret;
@@ -230,13 +270,12 @@ static int spl_common_init(bool setup_malloc)
 		gd->malloc_ptr = 0;
 	}
 #endif
-	ret = bootstage_init(true);
+	ret = spl_bootstage_init();
 	if (ret) {
 		debug("%s: Failed to set up bootstage: ret=%d\n", __func__,
 		      ret);
 		return ret;
 	}
-	bootstage_mark_name(BOOTSTAGE_ID_START_SPL, "spl");
 	if (CONFIG_IS_ENABLED(OF_CONTROL) && !CONFIG_IS_ENABLED(OF_PLATDATA)) {
 		ret = fdtdec_setup();
 		if (ret) {
@@ -322,11 +361,17 @@ static int spl_load_image(struct spl_image_info *spl_image,
 			  struct spl_image_loader *loader)
 {
 	struct spl_boot_device bootdev;
+	int ret;
 
 	bootdev.boot_device = loader->boot_device;
 	bootdev.boot_device_name = NULL;
 
-	return loader->load_image(spl_image, &bootdev);
+	/* Covers probing the boot device as well as reading the image */
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SPL_LOAD, "spl_load");
+	ret = loader->load_image(spl_image, &bootdev);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SPL_LOAD);
+
+	return ret;
 }
 
 /**
@@ -6,10 +6,16 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
+#include <div64.h>
 #include <errno.h>
+#include <hash.h>
 #include <image.h>
 #include <libfdt.h>
+#include <mapmem.h>
 #include <spl.h>
+#include <asm/unaligned.h>
+#include <linux/sizes.h>
 
 #ifndef CONFIG_SYS_BOOTM_LEN
 #define CONFIG_SYS_BOOTM_LEN	(64 << 20)
@@ -141,6 +147,518 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
 	return (data_size + info->bl_len - 1) / info->bl_len;
 }
 
+#ifdef CONFIG_SPL_FIT_READ_PLAN
+/* Most sub-images one plan can hold */
+#define SPL_FIT_PLAN_MAX	8
+/* Largest hole read between two images, and largest move after reading */
+#define SPL_FIT_PLAN_GAP	SZ_4K
+/* How much spl_fit_append_fdt() lets the device tree grow by */
+#define SPL_FIT_FDT_GROWTH	8192
+/* Load address for images which must have a "load" property */
+#define SPL_FIT_NO_LOAD		(~0UL)
+
+/**
+ * struct spl_fit_load - a sub-image in the read plan
+ *
+ * @node:	offset of the image node in the FIT
+ * @offset:	offset of the image data from the start of the FIT
+ * @size:	size of the image data
+ * @load_addr:	address the image is loaded to
+ * @extent:	bytes from @load_addr that belong to the image once loaded
+ * @buf:	address the image data is read to, before it is moved to
+ *		@load_addr
+ * @algo:	hash algorithm that checks the image, NULL if none
+ * @ctx:	hash context while the image is being read
+ * @value:	expected hash value, from the FIT
+ * @hashed:	number of bytes hashed so far
+ * @reads:	number of reads that carried part of the image
+ * @start_us:	time the first read of the image started
+ * @time_us:	time spent reading and hashing the image
+ */
+struct spl_fit_load {
+	int node;
+	ulong offset;
+	ulong size;
+	ulong load_addr;
+	ulong extent;
+	ulong buf;
+#ifdef CONFIG_SPL_HASH_SUPPORT
+	struct hash_algo *algo;
+	void *ctx;
+	const uint8_t *value;
+	ulong hashed;
+#endif
+	uint reads;
+	ulong start_us;
+	ulong time_us;
+};
+
+/**
+ * struct spl_fit_run - images read together from the boot device
+ *
+ * @first:	index of the first image of the run in spl_fit_plan.order
+ * @count:	number of images in the run
+ * @start:	first block (or byte, for a file) to read, relative to the FIT
+ * @units:	number of blocks (or bytes) to read
+ * @buf:	address the run is read to
+ */
+struct spl_fit_run {
+	int first;
+	int count;
+	ulong start;
+	ulong units;
+	ulong buf;
+};
+
+/**
+ * struct spl_fit_plan - every sub-image SPL loads from the FIT
+ *
+ * @count:	number of images
+ * @runs:	number of runs of reads
+ * @loaded:	true once all the images are loaded and checked
+ * @load:	the images, in the order spl_load_simple_fit() finds them
+ * @order:	indexes into @load, sorted by offset in the FIT
+ * @run:	the runs of reads, sorted by offset in the FIT
+ */
+struct spl_fit_plan {
+	int count;
+	int runs;
+	bool loaded;
+	struct spl_fit_load load[SPL_FIT_PLAN_MAX];
+	int order[SPL_FIT_PLAN_MAX];
+	struct spl_fit_run run[SPL_FIT_PLAN_MAX];
+};
+
+/**
+ * spl_fit_plan_find(): look up an image which the plan has already loaded
+ * @plan:	read plan, or NULL
+ * @node:	offset of the image node in the FIT
+ * @load_addr:	address the caller wants the image at
+ * @lengthp:	returns the size of the image
+ *
+ * Return:	true if the image is already at @load_addr
+ */
+static bool spl_fit_plan_find(struct spl_fit_plan *plan, int node,
+			      ulong load_addr, size_t *lengthp)
+{
+	int i;
+
+	if (!plan || !plan->loaded)
+		return false;
+
+	for (i = 0; i < plan->count; i++) {
+		struct spl_fit_load *load = &plan->load[i];
+
+		if (load->node == node && load->load_addr == load_addr) {
+			*lengthp = load->size;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * spl_fit_plan_add(): add an image to the read plan
+ * @plan:	read plan
+ * @fit:	pointer to the FIT header
+ * @base_offset: offset of the external data from the start of the FIT
+ * @node:	offset of the image node in the FIT
+ * @load_addr:	load address to use if the image has no "load" property,
+ *		or SPL_FIT_NO_LOAD
+ * @is_fdt:	true if the image is the device tree for the one before it
+ *
+ * Only external, uncompressed data can be read by the plan.
+ *
+ * Return:	0 on success or a negative error number.
+ */
+static int spl_fit_plan_add(struct spl_fit_plan *plan, const void *fit,
+			    ulong base_offset, int node, ulong load_addr,
+			    bool is_fdt)
+{
+	struct spl_fit_load *load;
+	int offset, len;
+	uint8_t comp;
+	ulong addr;
+
+	if (plan->count == SPL_FIT_PLAN_MAX)
+		return -ENOSPC;
+
+	if (fit_image_get_data_offset(fit, node, &offset) ||
+	    fit_image_get_data_size(fit, node, &len))
+		return -ENOENT;
+	if (IS_ENABLED(CONFIG_SPL_OS_BOOT) && IS_ENABLED(CONFIG_SPL_GZIP) &&
+	    !fit_image_get_comp(fit, node, &comp) && comp == IH_COMP_GZIP)
+		return -ENOTSUPP;
+	if (!fit_image_get_load(fit, node, &addr))
+		load_addr = addr;
+	if (load_addr == SPL_FIT_NO_LOAD)
+		return -ENOENT;
+
+	load = &plan->load[plan->count++];
+	memset(load, '\0', sizeof(*load));
+	load->node = node;
+	load->offset = base_offset + offset;
+	load->size = len;
+	load->load_addr = load_addr;
+	load->extent = len;
+	if (is_fdt && !CONFIG_IS_ENABLED(FIT_IMAGE_TINY))
+		load->extent += SPL_FIT_FDT_GROWTH;
+
+	return 0;
+}
+
+static bool spl_fit_overlap(ulong a, ulong alen, ulong b, ulong blen)
+{
+	return a < b + blen && b < a + alen;
+}
+
+/**
+ * spl_fit_plan_prepare(): group the planned images into runs of reads
+ * @plan:	read plan
+ * @info:	points to information about the device to load data from
+ * @fit:	pointer to the FIT header
+ * @fit_size:	size of the FIT header
+ *
+ * Images which follow each other in the FIT, with at most
+ * SPL_FIT_PLAN_GAP bytes between them, are read together if each one
+ * lands at most SPL_FIT_PLAN_GAP bytes after its load address. The data
+ * is then moved down into place after the run is read.
+ *
+ * Return:	0 if the plan is safe to use, or -EINVAL if a read or a move
+ *		would overwrite the FIT header or another image.
+ */
+static int spl_fit_plan_prepare(struct spl_fit_plan *plan,
+				struct spl_load_info *info, const void *fit,
+				ulong fit_size)
+{
+	ulong align_len = ARCH_DMA_MINALIGN - 1;
+	ulong unit = info->filename ? 1 : info->bl_len;
+	struct spl_fit_run *run = NULL;
+	struct spl_fit_load *load, *other;
+	ulong first_offset = 0, end = 0;
+	int i, j, k, r;
+
+	/* Sort by offset in the FIT; there are only a handful of images */
+	for (i = 0; i < plan->count; i++) {
+		for (j = i; j > 0 &&
+		     plan->load[plan->order[j - 1]].offset > plan->load[i].offset;
+		     j--)
+			plan->order[j] = plan->order[j - 1];
+		plan->order[j] = i;
+	}
+
+	plan->runs = 0;
+	for (i = 0; i < plan->count; i++) {
+		load = &plan->load[plan->order[i]];
+		if (run && load->offset >= end &&
+		    load->offset - end <= SPL_FIT_PLAN_GAP) {
+			ulong buf = run->buf + (load->offset - first_offset) +
+				get_aligned_image_overhead(info, first_offset);
+
+			if (buf >= load->load_addr &&
+			    buf - load->load_addr <= SPL_FIT_PLAN_GAP) {
+				load->buf = buf;
+				run->count++;
+				end = load->offset + load->size;
+				continue;
+			}
+		}
+		if (run)
+			run->units = get_aligned_image_size(info,
+					end - first_offset, first_offset);
+
+		run = &plan->run[plan->runs++];
+		run->first = i;
+		run->count = 1;
+		run->start = get_aligned_image_offset(info, load->offset);
+		run->buf = (load->load_addr + align_len) & ~align_len;
+		load->buf = run->buf +
+			get_aligned_image_overhead(info, load->offset);
+		first_offset = load->offset;
+		end = load->offset + load->size;
+	}
+	if (run)
+		run->units = get_aligned_image_size(info, end - first_offset,
+						    first_offset);
+
+	for (i = 0; i < plan->count; i++) {
+		load = &plan->load[i];
+		if (spl_fit_overlap(load->load_addr, load->extent,
+				    map_to_sysmem(fit), fit_size))
+			return -EINVAL;
+		for (j = i + 1; j < plan->count; j++) {
+			other = &plan->load[j];
+			if (spl_fit_overlap(load->load_addr, load->extent,
+					    other->load_addr, other->extent))
+				return -EINVAL;
+		}
+	}
+
+	for (r = 0; r < plan->runs; r++) {
+		ulong win_len;
+
+		run = &plan->run[r];
+		win_len = run->units * unit;
+		if (spl_fit_overlap(run->buf, win_len, map_to_sysmem(fit),
+				    fit_size))
+			return -EINVAL;
+
+		/* The read must not hit images loaded by earlier runs */
+		for (i = 0; i < run->first; i++) {
+			load = &plan->load[plan->order[i]];
+			if (spl_fit_overlap(run->buf, win_len, load->load_addr,
+					    load->extent))
+				return -EINVAL;
+		}
+
+		/* Moving an image must not hit data yet to be moved */
+		for (j = run->first; j < run->first + run->count; j++) {
+			load = &plan->load[plan->order[j]];
+			for (k = j + 1; k < run->first + run->count; k++) {
+				other = &plan->load[plan->order[k]];
+				if (spl_fit_overlap(load->load_addr,
+						    load->extent, other->buf,
+						    other->size))
+					return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_SPL_HASH_SUPPORT
+/*
+ * Set up hashing for the first hash node of the image whose algorithm is
+ * available for progressive hashing. Images without one are not checked.
+ */
+static int spl_fit_plan_hash_init(const void *fit, struct spl_fit_load *load)
+{
+	struct hash_algo *algo;
+	uint8_t *value;
+	int noffset, len;
+	char *name;
+
+	fdt_for_each_subnode(noffset, fit, load->node) {
+		if (strncmp(fit_get_name(fit, noffset, NULL),
+			    FIT_HASH_NODENAME, strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (fit_image_hash_get_algo(fit, noffset, &name) ||
+		    hash_progressive_lookup_algo(name, &algo))
+			continue;
+		if (fit_image_hash_get_value(fit, noffset, &value, &len) ||
+		    len != algo->digest_size)
+			return -EBADMSG;
+		if (algo->hash_init(algo, &load->ctx))
+			return -ENOMEM;
+		load->algo = algo;
+		load->value = value;
+		break;
+	}
+
+	return 0;
+}
+
+static int spl_fit_plan_hash_check(const void *fit, struct spl_fit_load *load)
+{
+	uint8_t value[HASH_MAX_DIGEST_SIZE];
+	struct hash_algo *algo = load->algo;
+
+	if (!algo)
+		return 0;
+
+	load->algo = NULL;
+	if (algo->hash_finish(algo, load->ctx, value, sizeof(value)))
+		return -EIO;
+	/* FIT stores CRC32 values big-endian */
+	if (!strcmp(algo->name, "crc32"))
+		put_unaligned_be32(get_unaligned((u32 *)value), value);
+	if (memcmp(value, load->value, algo->digest_size)) {
+		printf("FIT image '%s': bad %s hash\n",
+		       fit_get_name(fit, load->node, NULL), algo->name);
+		return -EBADMSG;
+	}
+
+	return 0;
+}
+
+/*
+ * Check an image loaded without the plan against the same hash the plan
+ * would have used, so that falling back does not skip the check.
+ */
+static int spl_fit_check_hash(const void *fit, int node, const void *data,
+			      ulong size)
+{
+	struct spl_fit_load load;
+	int ret;
+
+	memset(&load, '\0', sizeof(load));
+	load.node = node;
+	ret = spl_fit_plan_hash_init(fit, &load);
+	if (ret || !load.algo)
+		return ret;
+	if (load.algo->hash_update(load.algo, load.ctx, data, size, true))
+		return -EIO;
+
+	return spl_fit_plan_hash_check(fit, &load);
+}
+#else
+static inline int spl_fit_check_hash(const void *fit, int node,
+				     const void *data, ulong size)
+{
+	return 0;
+}
+#endif
+
+/*
+ * Account for a read of @len bytes at @dst which took @read_us, and hash
+ * the parts of the images it completed.
+ */
+static int spl_fit_plan_chunk(struct spl_fit_plan *plan,
+			      struct spl_fit_run *run, ulong dst, ulong len,
+			      ulong start_us, ulong read_us)
+{
+	int i;
+
+	for (i = run->first; i < run->first + run->count; i++) {
+		struct spl_fit_load *load = &plan->load[plan->order[i]];
+		ulong from = max(load->buf, dst);
+		ulong to = min(load->buf + load->size, dst + len);
+		__maybe_unused ulong hash_start;
+
+		if (from >= to)
+			continue;
+		if (!load->reads++)
+			load->start_us = start_us;
+		/* Share the read time out by the bytes each image got */
+		load->time_us += lldiv((u64)read_us * (to - from), len);
+
+#ifdef CONFIG_SPL_HASH_SUPPORT
+		if (!load->algo)
+			continue;
+		hash_start = timer_get_us();
+		if (load->algo->hash_update(load->algo, load->ctx,
+					    map_sysmem(load->buf + load->hashed,
+						       0),
+					    to - load->buf - load->hashed,
+					    to == load->buf + load->size)) {
+			load->algo = NULL;
+			return -EIO;
+		}
+		load->hashed = to - load->buf;
+		load->time_us += timer_get_us() - hash_start;
+#endif
+	}
+
+	return 0;
+}
+
+static void spl_fit_plan_record(const void *fit, struct spl_fit_load *load)
+{
+	const char *name = fit_get_name(fit, load->node, NULL);
+
+	debug("%s: %lx bytes at %lx, %u reads, %lu us\n", name, load->size,
+	      load->load_addr, load->reads, load->time_us);
+#if CONFIG_IS_ENABLED(BOOTSTAGE)
+	{
+		char buf[40];
+
+		snprintf(buf, sizeof(buf), "fit %s (%u reads)", name,
+			 load->reads);
+		bootstage_add_accum(strdup(buf), load->start_us,
+				    load->time_us);
+	}
+#endif
+}
+
+/**
+ * spl_fit_plan_load(): read and check all the images in the read plan
+ * @plan:	read plan, set up by spl_fit_plan_prepare()
+ * @info:	points to information about the device to load data from
+ * @sector:	the start sector of the FIT image on the device
+ * @fit:	pointer to the FIT header
+ *
+ * Return:	0 on success or a negative error number.
+ */
+static int spl_fit_plan_load(struct spl_fit_plan *plan,
+			     struct spl_load_info *info, ulong sector,
+			     const void *fit)
+{
+	ulong unit = info->filename ? 1 : info->bl_len;
+	int i, r, ret;
+
+#ifdef CONFIG_SPL_HASH_SUPPORT
+	for (i = 0; i < plan->count; i++) {
+		ret = spl_fit_plan_hash_init(fit, &plan->load[i]);
+		if (ret)
+			return ret;
+	}
+#endif
+
+	for (r = 0; r < plan->runs; r++) {
+		struct spl_fit_run *run = &plan->run[r];
+		ulong chunk = run->units;
+		ulong done, count;
+
+#ifdef CONFIG_SPL_HASH_SUPPORT
+		/* Split the read up only if there is something to hash */
+		for (i = run->first; i < run->first + run->count; i++) {
+			if (plan->load[plan->order[i]].algo)
+				chunk = max(CONFIG_SPL_FIT_READ_CHUNK / unit, 1UL);
+		}
+#endif
+		for (done = 0; done < run->units; done += count) {
+			ulong dst = run->buf + done * unit;
+			ulong start_us;
+
+			count = min(chunk, run->units - done);
+			start_us = timer_get_us();
+			if (info->read(info, sector + run->start + done, count,
+				       map_sysmem(dst, count * unit)) != count)
+				return -EIO;
+			ret = spl_fit_plan_chunk(plan, run, dst, count * unit,
+						 start_us,
+						 timer_get_us() - start_us);
+			if (ret)
+				return ret;
+		}
+
+		for (i = run->first; i < run->first + run->count; i++) {
+			struct spl_fit_load *load = &plan->load[plan->order[i]];
+
+			if (load->buf != load->load_addr)
+				memmove(map_sysmem(load->load_addr, load->size),
+					map_sysmem(load->buf, load->size),
+					load->size);
+#ifdef CONFIG_SPL_HASH_SUPPORT
+			ret = spl_fit_plan_hash_check(fit, load);
+			if (ret)
+				return ret;
+#endif
+			spl_fit_plan_record(fit, load);
+		}
+	}
+	plan->loaded = true;
+
+	return 0;
+}
+#else
+struct spl_fit_plan;
+
+static inline bool spl_fit_plan_find(struct spl_fit_plan *plan, int node,
+				     ulong load_addr, size_t *lengthp)
+{
+	return false;
+}
+
+static inline int spl_fit_check_hash(const void *fit, int node,
+				     const void *data, ulong size)
+{
+	return 0;
+}
+#endif /* CONFIG_SPL_FIT_READ_PLAN */
+
 /**
  * spl_load_fit_image(): load the image described in a certain FIT node
  * @info:	points to information about the device to load data from
@@ -155,12 +673,14 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
  *		If the FIT node does not contain a "load" (address) property,
  *		the image gets loaded to the address pointed to by the
  *		load_addr member in this struct.
+ * @plan:	read plan holding images which are already loaded, or NULL
  *
  * Return:	0 on success or a negative error number.
  */
 static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 			      void *fit, ulong base_offset, int node,
-			      struct spl_image_info *image_info)
+			      struct spl_image_info *image_info,
+			      struct spl_fit_plan *plan)
 {
 	int offset;
 	size_t length;
@@ -173,6 +693,7 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	int align_len = ARCH_DMA_MINALIGN - 1;
 	uint8_t image_comp = -1, type = -1;
 	const void *data;
+	int ret;
 
 	if (IS_ENABLED(CONFIG_SPL_OS_BOOT) && IS_ENABLED(CONFIG_SPL_GZIP)) {
 		if (fit_image_get_comp(fit, node, &image_comp))
@@ -189,6 +710,12 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	if (fit_image_get_load(fit, node, &load_addr))
 		load_addr = image_info->load_addr;
 
+	if (spl_fit_plan_find(plan, node, load_addr, &length)) {
+		debug("Planned data: dst=%lx, size=%lx\n", load_addr,
+		      (unsigned long)length);
+		goto out;
+	}
+
 	if (!fit_image_get_data_offset(fit, node, &offset)) {
 		/* External data */
 		offset += base_offset;
@@ -203,12 +730,13 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 
 		if (info->read(info,
 			       sector + get_aligned_image_offset(info, offset),
-			       nr_sectors, (void *)load_ptr) != nr_sectors)
+			       nr_sectors,
+			       map_sysmem(load_ptr, 0)) != nr_sectors)
 			return -EIO;
 
 		debug("External data: dst=%lx, offset=%x, size=%lx\n",
 		      load_ptr, offset, (unsigned long)length);
-		src = (void *)load_ptr + overhead;
+		src = map_sysmem(load_ptr + overhead, length);
 	} else {
 		/* Embedded data */
 		if (fit_image_get_data(fit, node, &data, &length)) {
@@ -220,6 +748,11 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 		src = (void *)data;
 	}
 
+	/* The image is checked as stored, before it is processed */
+	ret = spl_fit_check_hash(fit, node, src, length);
+	if (ret)
+		return ret;
+
 #ifdef CONFIG_SPL_FIT_IMAGE_POST_PROCESS
 	board_fit_image_post_process(&src, &length);
 #endif
@@ -229,16 +762,17 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	    image_comp == IH_COMP_GZIP		&&
 	    type == IH_TYPE_KERNEL) {
 		size = length;
-		if (gunzip((void *)load_addr, CONFIG_SYS_BOOTM_LEN,
+		if (gunzip(map_sysmem(load_addr, 0), CONFIG_SYS_BOOTM_LEN,
 			   src, &size)) {
 			puts("Uncompressing error\n");
 			return -EIO;
 		}
 		length = size;
 	} else {
-		memcpy((void *)load_addr, src, length);
+		memcpy(map_sysmem(load_addr, length), src, length);
 	}
 
+out:
 	if (image_info) {
 		image_info->load_addr = load_addr;
 		image_info->size = length;
@@ -250,7 +784,8 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 
 static int spl_fit_append_fdt(struct spl_image_info *spl_image,
 			      struct spl_load_info *info, ulong sector,
-			      void *fit, int images, ulong base_offset)
+			      void *fit, int images, ulong base_offset,
+			      struct spl_fit_plan *plan)
 {
 	struct spl_image_info image_info;
 	int node, ret;
@@ -268,13 +803,13 @@ static int spl_fit_append_fdt(struct spl_image_info *spl_image,
 	 */
 	image_info.load_addr = spl_image->load_addr + spl_image->size;
 	ret = spl_load_fit_image(info, sector, fit, base_offset, node,
-				 &image_info);
+				 &image_info, plan);
 
 	if (ret < 0)
 		return ret;
 
 	/* Make the load-address of the FDT available for the SPL framework */
-	spl_image->fdt_addr = (void *)image_info.load_addr;
+	spl_image->fdt_addr = map_sysmem(image_info.load_addr, 0);
 #if !CONFIG_IS_ENABLED(FIT_IMAGE_TINY)
 	/* Try to make space, so we can inject details on the loadables */
 	ret = fdt_shrink_to_minimum(spl_image->fdt_addr, 8192);
@@ -315,6 +850,131 @@ static int spl_fit_image_get_os(const void *fit, int noffset, uint8_t *os)
 #endif
 }
 
+#ifdef CONFIG_SPL_FIT_READ_PLAN
+static int spl_fit_plan_add_fdt(struct spl_fit_plan *plan, const void *fit,
+				int images, ulong base_offset,
+				const struct spl_fit_load *prev)
+{
+	int node;
+
+	/* spl_fit_append_fdt() lets the device tree be missing */
+	node = spl_fit_get_image_node(fit, images, FIT_FDT_PROP, 0);
+	if (node < 0)
+		return 0;
+
+	return spl_fit_plan_add(plan, fit, base_offset, node,
+				prev->load_addr + prev->size, true);
+}
+
+/**
+ * spl_fit_plan_build(): list the images that spl_load_simple_fit() loads
+ * @plan:	read plan to fill in
+ * @fit:	pointer to the FIT header
+ * @images:	offset of the /images node
+ * @base_offset: offset of the external data from the start of the FIT
+ * @node:	offset of the firmware image node
+ * @index:	index of the first loadable after the firmware image
+ * @spl_image:	image description passed to spl_load_simple_fit()
+ *
+ * This takes the same steps as spl_load_simple_fit() to find each image
+ * and work out where it goes, without reading anything.
+ *
+ * Return:	0 if every image can be read by the plan, else a negative
+ *		error number.
+ */
+static int spl_fit_plan_build(struct spl_fit_plan *plan, const void *fit,
+			      int images, ulong base_offset, int node,
+			      int index, struct spl_image_info *spl_image)
+{
+	uint8_t os = spl_image->os;
+	int ret;
+
+	ret = spl_fit_plan_add(plan, fit, base_offset, node,
+			       spl_image->load_addr, false);
+	if (ret)
+		return ret;
+
+	if (spl_fit_image_get_os(fit, node, &os) &&
+	    !IS_ENABLED(CONFIG_SPL_OS_BOOT))
+		os = IH_OS_U_BOOT;
+	if (os == IH_OS_U_BOOT) {
+		ret = spl_fit_plan_add_fdt(plan, fit, images, base_offset,
+					   &plan->load[plan->count - 1]);
+		if (ret)
+			return ret;
+	}
+
+	for (; ; index++) {
+		node = spl_fit_get_image_node(fit, images, "loadables", index);
+		if (node < 0)
+			break;
+
+		ret = spl_fit_plan_add(plan, fit, base_offset, node,
+				       SPL_FIT_NO_LOAD, false);
+		if (ret)
+			return ret;
+
+		os = IH_OS_INVALID;
+		spl_fit_image_get_os(fit, node, &os);
+		if (os == IH_OS_U_BOOT) {
+			ret = spl_fit_plan_add_fdt(plan, fit, images,
+						   base_offset,
+						   &plan->load[plan->count - 1]);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Load every image through the read plan if possible. If the plan cannot
+ * be used, the images are left for spl_load_fit_image() to load one by one.
+ */
+static int spl_fit_plan_run(struct spl_fit_plan *plan,
+			    struct spl_load_info *info, ulong sector,
+			    const void *fit, ulong fit_size, int images,
+			    ulong base_offset, int node, int index,
+			    struct spl_image_info *spl_image)
+{
+	int ret;
+
+	plan->count = 0;
+	plan->loaded = false;
+	ret = spl_fit_plan_build(plan, fit, images, base_offset, node, index,
+				 spl_image);
+	if (!ret)
+		ret = spl_fit_plan_prepare(plan, info, fit, fit_size);
+	if (ret) {
+		debug("%s: loading images one by one: %d\n", __func__, ret);
+		return 0;
+	}
+	debug("%s: %d images in %d runs\n", __func__, plan->count,
+	      plan->runs);
+
+	return spl_fit_plan_load(plan, info, sector, fit);
+}
+#else
+static inline int spl_fit_plan_run(struct spl_fit_plan *plan,
+				   struct spl_load_info *info, ulong sector,
+				   const void *fit, ulong fit_size, int images,
+				   ulong base_offset, int node, int index,
+				   struct spl_image_info *spl_image)
+{
+	return 0;
+}
+#endif /* CONFIG_SPL_FIT_READ_PLAN */
+
+__weak ulong board_spl_fit_buffer_end(void)
+{
+	/*
+	 * In fact the FIT has its own load address, but we assume it cannot
+	 * be before CONFIG_SYS_TEXT_BASE.
+	 */
+	return CONFIG_SYS_TEXT_BASE;
+}
+
 int spl_load_simple_fit(struct spl_image_info *spl_image,
 			struct spl_load_info *info, ulong sector, void *fit)
 {
@@ -326,6 +986,12 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 	int images, ret;
 	int base_offset, align_len = ARCH_DMA_MINALIGN - 1;
 	int index = 0;
+#ifdef CONFIG_SPL_FIT_READ_PLAN
+	struct spl_fit_plan plan_data;
+	struct spl_fit_plan *plan = &plan_data;
+#else
+	struct spl_fit_plan *plan = NULL;
+#endif
 
 	/*
 	 * For FIT with external data, figure out where the external images
@@ -347,14 +1013,11 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 	 * address. So take account of that here by subtracting an addition
 	 * block length from the FIT start position.
 	 *
-	 * In fact the FIT has its own load address, but we assume it cannot
-	 * be before CONFIG_SYS_TEXT_BASE.
-	 *
 	 * For FIT with data embedded, data is loaded as part of FIT image.
 	 * For FIT with external data, data is not loaded in this step.
 	 */
-	fit = (void *)((CONFIG_SYS_TEXT_BASE - size - info->bl_len -
-			align_len) & ~align_len);
+	fit = map_sysmem((board_spl_fit_buffer_end() - size - info->bl_len -
+			  align_len) & ~align_len, size + info->bl_len);
 	sectors = get_aligned_image_size(info, size, 0);
 	count = info->read(info, sector, sectors, fit);
 	debug("fit read sector %lx, sectors=%d, dst=%p, count=%lu\n",
@@ -396,9 +1059,15 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 		return -1;
 	}
 
+	/* Read all the images in as few reads as possible */
+	ret = spl_fit_plan_run(plan, info, sector, fit, size, images,
+			       base_offset, node, index, spl_image);
+	if (ret)
+		return ret;
+
 	/* Load the image and set up the spl_image structure */
 	ret = spl_load_fit_image(info, sector, fit, base_offset, node,
-				 spl_image);
+				 spl_image, plan);
 	if (ret)
 		return ret;
 
@@ -415,11 +1084,15 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 
 	/*
 	 * Booting a next-stage U-Boot may require us to append the FDT.
-	 * We allow this to fail, as the U-Boot image might embed its FDT.
+	 * We allow this to fail, as the U-Boot image might embed its FDT,
+	 * but not if the FDT is there and fails its hash check.
 	 */
-	if (spl_image->os == IH_OS_U_BOOT)
-		spl_fit_append_fdt(spl_image, info, sector, fit,
-				   images, base_offset);
+	if (spl_image->os == IH_OS_U_BOOT) {
+		ret = spl_fit_append_fdt(spl_image, info, sector, fit,
+					 images, base_offset, plan);
+		if (ret == -EBADMSG)
+			return ret;
+	}
 
 	/* Now check if there are more images for us to load */
 	for (; ; index++) {
@@ -430,7 +1103,9 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 			break;
 
 		ret = spl_load_fit_image(info, sector, fit, base_offset, node,
-					 &image_info);
+					 &image_info, plan);
+		if (ret == -EBADMSG)
+			return ret;
 		if (ret < 0)
 			continue;
 
@@ -438,8 +1113,11 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 			debug("Loadable is %s\n", genimg_get_os_name(os_type));
 
 		if (os_type == IH_OS_U_BOOT) {
-			spl_fit_append_fdt(&image_info, info, sector,
-					   fit, images, base_offset);
+			ret = spl_fit_append_fdt(&image_info, info, sector,
+						 fit, images, base_offset,
+						 plan);
+			if (ret == -EBADMSG)
+				return ret;
 			spl_image->fdt_addr = image_info.fdt_addr;
 		}
 
@@ -60,9 +60,12 @@ ifdef	BOARD
 sinclude $(srctree)/board/$(BOARDDIR)/config.mk	# include board specific rules
 endif
 
+# Only U-Boot proper can trace, so keep SPL and TPL small
 ifdef FTRACE
+ifndef CONFIG_SPL_BUILD
 PLATFORM_CPPFLAGS += -finstrument-functions -DFTRACE
 endif
+endif
 
 # Allow use of stdint.h if available
 ifneq ($(USE_STDINT),)
@@ -11,6 +11,8 @@
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/uclass-internal.h>
+#include <malloc.h>
+#include <memalign.h>
 
 static const char *if_typename_str[IF_TYPE_COUNT] = {
 	[IF_TYPE_IDE]		= "ide",
@@ -408,6 +410,45 @@ int blk_get_device(int if_type, int devnum, struct udevice **devp)
 	return device_probe(*devp);
 }
 
+/*
+ * Read a request smaller than a page of the device as the whole pages
+ * around it and keep those in the block cache. The device has to read the
+ * full pages anyway, and the small reads which usually follow (partition
+ * tables, image headers) are then served from the cache.
+ */
+static ulong blk_dread_pages(struct blk_desc *block_dev, lbaint_t start,
+			     lbaint_t blkcnt, void *buffer)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	lbaint_t mask = block_dev->page_blks - 1;
+	lbaint_t first = start & ~mask;
+	lbaint_t end = min((start + blkcnt + mask) & ~mask, block_dev->lba);
+	lbaint_t count = end - first;
+	void *buf;
+
+	/* Let the device report a read past its end */
+	if (start + blkcnt > block_dev->lba)
+		return ops->read(dev, start, blkcnt, buffer);
+
+	buf = malloc_cache_aligned(count * block_dev->blksz);
+	if (!buf)
+		return ops->read(dev, start, blkcnt, buffer);
+
+	if (ops->read(dev, first, count, buf) != count) {
+		free(buf);
+		return ops->read(dev, start, blkcnt, buffer);
+	}
+
+	memcpy(buffer, buf + (start - first) * block_dev->blksz,
+	       blkcnt * block_dev->blksz);
+	blkcache_fill_pages(block_dev->if_type, block_dev->devnum,
+			    first, count, block_dev->blksz, buf);
+	free(buf);
+
+	return blkcnt;
+}
+
 unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			lbaint_t blkcnt, void *buffer)
 {
@@ -421,6 +462,8 @@ unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
 			  start, blkcnt, block_dev->blksz, buffer))
 		return blkcnt;
+	if (IS_ENABLED(CONFIG_BLOCK_CACHE) && blkcnt < block_dev->page_blks)
+		return blk_dread_pages(block_dev, start, blkcnt, buffer);
 	blks_read = ops->read(dev, start, blkcnt, buffer);
 	if (blks_read == blkcnt)
 		blkcache_fill(block_dev->if_type, block_dev->devnum,
@@ -72,17 +72,13 @@ int blkcache_read(int iftype, int devnum,
 	return 0;
 }
 
-void blkcache_fill(int iftype, int devnum,
-		   lbaint_t start, lbaint_t blkcnt,
-		   unsigned long blksz, void const *buffer)
+static void cache_fill(int iftype, int devnum,
+		       lbaint_t start, lbaint_t blkcnt,
+		       unsigned long blksz, void const *buffer)
 {
 	lbaint_t bytes;
 	struct block_cache_node *node;
 
-	/* don't cache big stuff */
-	if (blkcnt > _stats.max_blocks_per_entry)
-		return;
-
 	if (_stats.max_entries == 0)
 		return;
 
@@ -126,6 +122,25 @@ void blkcache_fill(int iftype, int devnum,
 	_stats.entries++;
 }
 
+void blkcache_fill(int iftype, int devnum,
+		   lbaint_t start, lbaint_t blkcnt,
+		   unsigned long blksz, void const *buffer)
+{
+	/* don't cache big stuff */
+	if (blkcnt > _stats.max_blocks_per_entry)
+		return;
+
+	cache_fill(iftype, devnum, start, blkcnt, blksz, buffer);
+}
+
+void blkcache_fill_pages(int iftype, int devnum,
+			 lbaint_t start, lbaint_t blkcnt,
+			 unsigned long blksz, void const *buffer)
+{
+	++_stats.page_fills;
+	cache_fill(iftype, devnum, start, blkcnt, blksz, buffer);
+}
+
 void blkcache_invalidate(int iftype, int devnum)
 {
 	struct list_head *entry, *n;
@@ -163,6 +178,7 @@ void blkcache_configure(unsigned blocks, unsigned entries)
 
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.page_fills = 0;
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
@@ -170,4 +186,5 @@ void blkcache_stats(struct block_cache_stats *stats)
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.page_fills = 0;
 }
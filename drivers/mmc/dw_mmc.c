@@ -8,6 +8,7 @@
 
 #include <bouncebuf.h>
 #include <common.h>
+#include <dma_map.h>
 #include <errno.h>
 #include <malloc.h>
 #include <memalign.h>
@@ -139,8 +140,8 @@ static void dwmci_prepare_data(struct dwmci_host *host,
 		i++;
 	} while(1);
 
-	data_end = (ulong)cur_idmac;
-	flush_dcache_range(data_start, data_end + ARCH_DMA_MINALIGN);
+	data_end = (ulong)cur_idmac + sizeof(*cur_idmac);
+	dma_map_range(data_start, data_end - data_start, DMA_TO_DEVICE);
 
 	ctrl = dwmci_readl(host, DWMCI_CTRL);
 	ctrl |= DWMCI_IDMAC_EN | DWMCI_DMA_EN;
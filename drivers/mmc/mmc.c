@@ -1793,6 +1793,8 @@ static int mmc_startup(struct mmc *mmc)
 			/* Read out group size from ext_csd */
 			mmc->erase_grp_size =
 				ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE] * 1024;
+			mmc->esr.erase_timeout =
+				ext_csd[EXT_CSD_ERASE_TIMEOUT_MULT] * 300;
 			/*
 			 * if high capacity and partition setting completed
 			 * SEC_COUNT is valid even if it is smaller than 2 GiB
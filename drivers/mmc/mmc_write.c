@@ -15,12 +15,18 @@
 #include <linux/math64.h>
 #include "mmc_private.h"
 
-static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt)
+/* Largest range handed to a single ERASE command, in 512-byte sectors */
+#define MMC_ERASE_BATCH_SIZE	(SZ_512M >> 9)
+
+/* Assumed busy time per erase group when the card does not report one */
+#define MMC_ERASE_GRP_TIMEOUT	300
+
+static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt,
+			 uint erase_mode)
 {
 	struct mmc_cmd cmd;
 	ulong end;
 	int err, start_cmd, end_cmd;
-	uint erase_mode;
 
 	if (mmc->high_capacity) {
 		end = start + blkcnt - 1;
@@ -29,24 +35,12 @@ static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt)
 		start *= mmc->write_bl_len;
 	}
 
-	/*
-	 * The SD card have just one erase mode, the erase command
-	 * perform an erase on the sector(s).
-	 * The Emmc have four erase mode. We use the trim mode with
-	 * cmd.cmdarg equal to MMC_TRIM_ARG which command performs an
-	 * erase on the sector(s).
-	 */
 	if (IS_SD(mmc)) {
 		start_cmd = SD_CMD_ERASE_WR_BLK_START;
 		end_cmd = SD_CMD_ERASE_WR_BLK_END;
-		erase_mode = MMC_ERASE_ARG;
 	} else {
 		start_cmd = MMC_CMD_ERASE_GROUP_START;
 		end_cmd = MMC_CMD_ERASE_GROUP_END;
-		if (mmc->esr.mmc_can_trim)
-			erase_mode = MMC_TRIM_ARG;
-		else
-			erase_mode = MMC_ERASE_ARG;
 	}
 
 	cmd.cmdidx = start_cmd;
@@ -79,6 +73,76 @@ err_out:
 	return err;
 }
 
+/*
+ * Erase @blkcnt sectors from @start, the hardware partition must already be
+ * selected. Whole erase groups (allocation units on SD) are erased in
+ * batches of up to MMC_ERASE_BATCH_SIZE with one command each. The SD card
+ * has just one erase mode which works on sectors; the eMMC trims the
+ * unaligned head and tail when it can, and otherwise erases the whole
+ * groups containing them.
+ *
+ * @return number of sectors erased
+ */
+static lbaint_t mmc_erase_range(struct mmc *mmc, lbaint_t start,
+				lbaint_t blkcnt)
+{
+	lbaint_t blk = start, end = start + blkcnt, n;
+	uint grp, grp_ms, partial_mode, erase_mode;
+	u32 rem, start_rem, blkcnt_rem;
+	int timeout;
+
+	if (IS_SD(mmc)) {
+		grp = mmc->ssr.au ? mmc->ssr.au : mmc->erase_grp_size;
+		grp_ms = mmc->ssr.erase_timeout + mmc->ssr.erase_offset;
+		partial_mode = MMC_ERASE_ARG;
+	} else {
+		grp = mmc->erase_grp_size;
+		grp_ms = mmc->esr.erase_timeout;
+		partial_mode = mmc->esr.mmc_can_trim ? MMC_TRIM_ARG :
+						       MMC_ERASE_ARG;
+	}
+	if (!grp_ms)
+		grp_ms = MMC_ERASE_GRP_TIMEOUT;
+
+	div_u64_rem(start, grp, &start_rem);
+	div_u64_rem(blkcnt, grp, &blkcnt_rem);
+	if (!IS_SD(mmc) && partial_mode == MMC_ERASE_ARG &&
+	    (start_rem || blkcnt_rem))
+		printf("\n\nCaution! Your devices Erase group is 0x%x\n"
+		       "The erase range would be change to "
+		       "0x" LBAF "~0x" LBAF "\n\n",
+		       grp, start & ~(grp - 1),
+		       ((start + blkcnt + grp) & ~(grp - 1)) - 1);
+
+	while (blk < end) {
+		div_u64_rem(blk, grp, &rem);
+		if (rem || end - blk < grp) {
+			/* Partial group at either end of the range */
+			n = min_t(lbaint_t, grp - rem, end - blk);
+			erase_mode = partial_mode;
+			timeout = grp_ms;
+		} else {
+			n = min_t(lbaint_t, end - blk,
+				  max_t(lbaint_t, grp, MMC_ERASE_BATCH_SIZE));
+			div_u64_rem(n, grp, &rem);
+			n -= rem;
+			erase_mode = MMC_ERASE_ARG;
+			timeout = div_u64(n, grp) * grp_ms;
+		}
+
+		if (mmc_erase_t(mmc, blk, n, erase_mode))
+			break;
+
+		/* Waiting for the ready status */
+		if (mmc_send_status(mmc, max(timeout, 1000)))
+			break;
+
+		blk += n;
+	}
+
+	return blk - start;
+}
+
 #ifdef CONFIG_BLK
 ulong mmc_berase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
 #else
@@ -89,12 +153,8 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
 #endif
 	int dev_num = block_dev->devnum;
-	int err = 0;
-	u32 start_rem, blkcnt_rem;
 	struct mmc *mmc = find_mmc_device(dev_num);
-	lbaint_t blk = 0, blk_r = 0;
-	int timeout = 1000;
-	int mode = 0;
+	int err;
 
 	if (!mmc)
 		return -1;
@@ -108,55 +168,7 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 	if (err < 0)
 		return -1;
 
-	if (!IS_SD(mmc)) {
-		if (mmc->esr.mmc_can_trim)
-			mode = 1;
-	}
-
-	if (mode) {
-		err = mmc_erase_t(mmc, start, blkcnt);
-		if (err)
-			return err;
-		if (mmc_send_status(mmc, timeout))
-			return 0;
-
-		return blkcnt;
-	} else {
-		/*
-		 * We want to see if the requested start or total block
-		 * count are unaligned.  We discard the whole numbers and
-		 * only care about the remainder.
-		 */
-		err = div_u64_rem(start, mmc->erase_grp_size, &start_rem);
-		err = div_u64_rem(blkcnt, mmc->erase_grp_size, &blkcnt_rem);
-		if (start_rem || blkcnt_rem)
-			printf("\n\nCaution! Your devices Erase group is 0x%x\n"
-			       "The erase range would be change to "
-			       "0x" LBAF "~0x" LBAF "\n\n",
-			       mmc->erase_grp_size,
-			       start & ~(mmc->erase_grp_size - 1),
-			       ((start + blkcnt + mmc->erase_grp_size)
-			       & ~(mmc->erase_grp_size - 1)) - 1);
-		while (blk < blkcnt) {
-			if (IS_SD(mmc) && mmc->ssr.au) {
-				blk_r = ((blkcnt - blk) > mmc->ssr.au) ?
-				mmc->ssr.au : (blkcnt - blk);
-			} else {
-				blk_r = ((blkcnt - blk) > mmc->erase_grp_size) ?
-					mmc->erase_grp_size : (blkcnt - blk);
-			}
-			err = mmc_erase_t(mmc, start + blk, blk_r);
-			if (err)
-				break;
-
-			blk += blk_r;
-
-			/* Waiting for the ready status */
-			if (mmc_send_status(mmc, timeout))
-				return 0;
-		}
-		return blk;
-	}
+	return mmc_erase_range(mmc, start, blkcnt);
 }
 
 static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
@@ -14,20 +14,40 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#define SANDBOX_MMC_MAX_ERASES	16
+
+/* Allocation unit reported in the SD status, 7 means 1 MiB */
+#define SANDBOX_MMC_AU		7
+
 struct sandbox_mmc_plat {
 	struct mmc_config cfg;
 	struct mmc mmc;
+
+	/* Read commands seen so far, for tests */
+	int read_count;
+
+	/* Erase commands seen so far, for tests */
+	ulong erase_start;
+	ulong erase_end;
+	int erase_count;
+	struct {
+		ulong start;
+		ulong end;
+	} erases[SANDBOX_MMC_MAX_ERASES];
 };
 
 /**
  * sandbox_mmc_send_cmd() - Emulate SD commands
  *
  * This emulate an SD card version 2. Single-block reads result in zero data.
- * Multiple-block reads return a test string.
+ * Multiple-block reads return a test string. Read commands are counted and
+ * erase commands are recorded.
  */
 static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 				struct mmc_data *data)
 {
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
 	switch (cmd->cmdidx) {
 	case MMC_CMD_ALL_SEND_CID:
 		break;
@@ -39,8 +59,30 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		cmd->response[0] = 0xaa;
 		break;
 	case MMC_CMD_SEND_STATUS:
+		if (data) {
+			/* SD_CMD_APP_SD_STATUS */
+			u32 *ssr = (u32 *)data->dest;
+
+			memset(ssr, '\0', data->blocksize);
+			ssr[2] = cpu_to_be32(SANDBOX_MMC_AU << 12);
+			break;
+		}
 		cmd->response[0] = MMC_STATUS_RDY_FOR_DATA;
 		break;
+	case SD_CMD_ERASE_WR_BLK_START:
+		plat->erase_start = cmd->cmdarg;
+		break;
+	case SD_CMD_ERASE_WR_BLK_END:
+		plat->erase_end = cmd->cmdarg;
+		break;
+	case MMC_CMD_ERASE:
+		if (plat->erase_count < SANDBOX_MMC_MAX_ERASES) {
+			plat->erases[plat->erase_count].start =
+				plat->erase_start;
+			plat->erases[plat->erase_count].end = plat->erase_end;
+		}
+		plat->erase_count++;
+		break;
 	case MMC_CMD_SELECT_CARD:
 		break;
 	case MMC_CMD_SEND_CSD:
@@ -55,9 +97,11 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	}
 	case MMC_CMD_READ_SINGLE_BLOCK:
 		memset(data->dest, '\0', data->blocksize);
+		plat->read_count++;
 		break;
 	case MMC_CMD_READ_MULTIPLE_BLOCK:
 		strcpy(data->dest, "this is a test");
+		plat->read_count++;
 		break;
 	case MMC_CMD_STOP_TRANSMISSION:
 		break;
@@ -95,6 +139,34 @@ static int sandbox_mmc_get_cd(struct udevice *dev)
 	return 1;
 }
 
+int sandbox_mmc_read_count(struct udevice *dev)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	return plat->read_count;
+}
+
+int sandbox_mmc_erase_count(struct udevice *dev)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	return plat->erase_count;
+}
+
+int sandbox_mmc_get_erase(struct udevice *dev, int index, ulong *start,
+			  ulong *end)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	if (index < 0 || index >= plat->erase_count ||
+	    index >= SANDBOX_MMC_MAX_ERASES)
+		return -ENOENT;
+	*start = plat->erases[index].start;
+	*end = plat->erases[index].end;
+
+	return 0;
+}
+
 static const struct dm_mmc_ops sandbox_mmc_ops = {
 	.send_cmd = sandbox_mmc_send_cmd,
 	.set_ios = sandbox_mmc_set_ios,
@@ -8,7 +8,10 @@
 #include <common.h>
 #include <fdtdec.h>
 #include <inttypes.h>
+#include <malloc.h>
 #include <nand.h>
+#include <watchdog.h>
+#include <asm/cache.h>
 #include <linux/kernel.h>
 #include <linux/mtd/mtd.h>
 #include <linux/mtd/nand.h>
@@ -22,6 +25,10 @@ DECLARE_GLOBAL_DATA_PTR;
 #define NANDC_V6_DEF_TIMEOUT	20000
 #define NANDC_V6_READ		0
 #define NANDC_V6_WRITE		1
+/* 1KB ECC steps in the largest page the DMA engine handles */
+#define NANDC_V6_MAX_STEPS	16
+/* Stride of the spare bytes of each ECC step in the DMA spare buffer */
+#define NANDC_V6_DMA_SPARE	64
 
 #define	NANDC_REG_V6_FMCTL	0x00
 #define	NANDC_REG_V6_FMWAIT	0x04
@@ -62,6 +69,19 @@ DECLARE_GLOBAL_DATA_PTR;
 #define NANDC_V6_FL_XFER_COUNT	BIT(5)
 #define NANDC_V6_FL_ACORRECT	BIT(10)
 #define NANDC_V6_FL_XFER_READY	BIT(20)
+#define NANDC_V6_FL_PAGE_NUM_S	22
+#define NANDC_V6_FL_TOG_MIX	BIT(29)
+
+/* DMA_CFG */
+#define NANDC_V6_DMA_START	BIT(0)
+#define NANDC_V6_DMA_WR_S	0x1
+#define NANDC_V6_DMA_EN		BIT(2)
+#define NANDC_V6_DMA_HSIZE_S	0x3
+#define NANDC_V6_DMA_BURST_S	0x6
+#define NANDC_V6_DMA_INCR_S	0x9
+
+/* DMA_ST */
+#define NANDC_V6_DMA_CNT(x)	(((x) >> 16) & 0x1F)
 
 /* BCHCTL */
 #define NAND_V6_BCH_REGION_S	0x5
@@ -83,6 +103,13 @@ struct rk_nand {
 	bool bootromblocks;
 	void __iomem *regs;
 	int selected_bank;
+	/* DMA page engine: two page buffers and the spare buffer */
+	u8 *dma_buf;
+	u8 *dma_spare;
+	u32 dma_page_size;
+	/* nand_base read, for what the page engine does not stream */
+	int (*nand_read)(struct mtd_info *mtd, loff_t from, size_t len,
+			 size_t *retlen, u_char *buf);
 };
 
 static struct nand_ecclayout nand_oob_fix = {
@@ -440,6 +467,392 @@ static int rockchip_nand_hw_syndrome_pio_write_page(struct mtd_info *mtd,
 	return 0;
 }
 
+static void rockchip_nand_dma_xfer_start(struct rk_nand *rknand,
+					 u8 dir,
+					 u8 steps,
+					 u8 *data)
+{
+	u32 reg;
+
+	reg = readl(rknand->regs + NANDC_REG_V6_BCHCTL);
+	reg = (reg & (~(NAND_V6_BCH_REGION_M << NAND_V6_BCH_REGION_S))) |
+	      (rknand->selected_bank << NAND_V6_BCH_REGION_S);
+	writel(reg, rknand->regs + NANDC_REG_V6_BCHCTL);
+
+	/* The controller writes memory when reading the flash */
+	reg = NANDC_V6_DMA_START | ((!dir) << NANDC_V6_DMA_WR_S) |
+	      NANDC_V6_DMA_EN | (2 << NANDC_V6_DMA_HSIZE_S) |
+	      (7 << NANDC_V6_DMA_BURST_S) | (16 << NANDC_V6_DMA_INCR_S);
+	writel(reg, rknand->regs + NANDC_REG_V6_DMA_CFG);
+	writel((u32)(ulong)data, rknand->regs + NANDC_REG_V6_DMA_BUF0);
+	writel((u32)(ulong)rknand->dma_spare,
+	       rknand->regs + NANDC_REG_V6_DMA_BUF1);
+
+	reg = (dir << NANDC_V6_FL_DIR_S) | NANDC_V6_FL_XFER_EN |
+	      NANDC_V6_FL_XFER_COUNT | NANDC_V6_FL_ACORRECT |
+	      NANDC_V6_FL_TOG_MIX | (steps << NANDC_V6_FL_PAGE_NUM_S);
+	writel(reg, rknand->regs + NANDC_REG_V6_FLCTL);
+
+	reg |= NANDC_V6_FL_XFER_START;
+	writel(reg, rknand->regs + NANDC_REG_V6_FLCTL);
+}
+
+static int rockchip_nand_wait_dma_xfer_done(struct rk_nand *rknand,
+					    u8 dir,
+					    u8 steps)
+{
+	int timeout = NANDC_V6_DEF_TIMEOUT;
+	bool done;
+
+	while (timeout--) {
+		/* A read is done once every step has reached memory */
+		if (dir == NANDC_V6_READ)
+			done = NANDC_V6_DMA_CNT(readl(rknand->regs +
+					NANDC_REG_V6_DMA_ST)) >= steps;
+		else
+			done = readl(rknand->regs + NANDC_REG_V6_FLCTL) &
+			       NANDC_V6_FL_XFER_READY;
+		if (done)
+			break;
+
+		udelay(1);
+	}
+	writel(0, rknand->regs + NANDC_REG_V6_DMA_CFG);
+
+	if (timeout < 0)
+		return -ETIMEDOUT;
+
+	return 0;
+}
+
+/*
+ * Collect the BCH status of the page just transferred, two steps per
+ * register. Returns the max bitflips per step, or -EBADMSG if a step
+ * could not be corrected.
+ */
+static int rockchip_nand_dma_bch_status(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	struct rk_nand *rknand = to_rknand(chip->controller);
+	unsigned int max_bitflips = 0;
+	bool failed = false;
+	int step, bch_st, ret;
+
+	for (step = 0; step < chip->ecc.steps; step++) {
+		bch_st = readl(rknand->regs + NANDC_REG_V6_BCHST +
+			       (step / 2) * 4);
+
+		if (bch_st & ((step & 1) ? NANDC_V6_BCH1_ST_ERR :
+					   NANDC_V6_BCH0_ST_ERR)) {
+			failed = true;
+			continue;
+		}
+		ret = (step & 1) ? NANDC_V6_ECC_ERR_CNT1(bch_st) :
+				   NANDC_V6_ECC_ERR_CNT0(bch_st);
+		mtd->ecc_stats.corrected += ret;
+		max_bitflips = max_t(unsigned int, max_bitflips, ret);
+	}
+
+	return failed ? -EBADMSG : max_bitflips;
+}
+
+static int rockchip_nand_hw_syndrome_dma_read_page(struct mtd_info *mtd,
+						   struct nand_chip *chip,
+						   uint8_t *buf,
+						   int oob_required,
+						   int page)
+{
+	struct rk_nand *rknand = to_rknand(chip->controller);
+	struct nand_ecc_ctrl *ecc = &chip->ecc;
+	ulong data = (ulong)rknand->dma_buf;
+	ulong spare = (ulong)rknand->dma_spare;
+	int offset = page * mtd->writesize;
+	int ret, step;
+
+	if (rknand->bootromblocks && (offset < (7 * mtd->erasesize)))
+		rockchip_nand_hw_ecc_setup(mtd, ecc, NANDC_V6_BOOTROM_ECC);
+
+	flush_dcache_range(data, data + mtd->writesize);
+	flush_dcache_range(spare, spare + ecc->steps * NANDC_V6_DMA_SPARE);
+	rockchip_nand_dma_xfer_start(rknand, NANDC_V6_READ, ecc->steps,
+				     rknand->dma_buf);
+	ret = rockchip_nand_wait_dma_xfer_done(rknand, NANDC_V6_READ,
+					       ecc->steps);
+	if (ret)
+		return ret;
+	invalidate_dcache_range(data, data + mtd->writesize);
+	invalidate_dcache_range(spare, spare + ecc->steps * NANDC_V6_DMA_SPARE);
+
+	ret = rockchip_nand_dma_bch_status(mtd);
+	if (ret < 0) {
+		mtd->ecc_stats.failed++;
+		ret = 0;
+	}
+
+	memcpy(buf, rknand->dma_buf, mtd->writesize);
+	for (step = 0; step < ecc->steps; step++)
+		memcpy(chip->oob_poi + step * (ecc->bytes + ecc->prepad),
+		       rknand->dma_spare + step * NANDC_V6_DMA_SPARE,
+		       ecc->prepad);
+
+	rockchip_nand_read_extra_oob(mtd, chip->oob_poi);
+
+	if (rknand->bootromblocks)
+		rockchip_nand_hw_ecc_setup(mtd, ecc, rknand->ecc_strength);
+
+	return ret;
+}
+
+static int rockchip_nand_hw_syndrome_dma_write_page(struct mtd_info *mtd,
+						    struct nand_chip *chip,
+						    const uint8_t *buf,
+						    int oob_required,
+						    int page)
+{
+	struct rk_nand *rknand = to_rknand(chip->controller);
+	struct nand_ecc_ctrl *ecc = &chip->ecc;
+	ulong data = (ulong)rknand->dma_buf;
+	ulong spare = (ulong)rknand->dma_spare;
+	int offset = page * mtd->writesize;
+	int ret, index, step;
+
+	if (rknand->bootromblocks && (offset < (7 * mtd->erasesize)))
+		rockchip_nand_hw_ecc_setup(mtd, ecc, NANDC_V6_BOOTROM_ECC);
+
+	index = rockchip_nand_make_bootrom_compat(mtd, page, chip->oob_poi,
+						  rknand->bootromblocks);
+
+	memcpy(rknand->dma_buf, buf, mtd->writesize);
+	memcpy(rknand->dma_spare, &index, ecc->prepad);
+	for (step = 1; step < ecc->steps; step++)
+		memcpy(rknand->dma_spare + step * NANDC_V6_DMA_SPARE,
+		       chip->oob_poi + step * (ecc->bytes + ecc->prepad),
+		       ecc->prepad);
+	flush_dcache_range(data, data + mtd->writesize);
+	flush_dcache_range(spare, spare + ecc->steps * NANDC_V6_DMA_SPARE);
+
+	rockchip_nand_dma_xfer_start(rknand, NANDC_V6_WRITE, ecc->steps,
+				     rknand->dma_buf);
+	ret = rockchip_nand_wait_dma_xfer_done(rknand, NANDC_V6_WRITE,
+					       ecc->steps);
+	if (ret)
+		return ret;
+
+	rockchip_nand_write_extra_oob(mtd, chip->oob_poi);
+
+	rockchip_nand_hw_ecc_setup(mtd, ecc, rknand->ecc_strength);
+
+	return 0;
+}
+
+static bool rockchip_nand_has_read_cache(struct nand_chip *chip)
+{
+#ifdef CONFIG_SYS_NAND_ONFI_DETECTION
+	if (chip->onfi_version)
+		return le16_to_cpu(chip->onfi_params.opt_cmd) &
+		       ONFI_OPT_CMD_READ_CACHE;
+#endif
+	return false;
+}
+
+/* Send a page read to the array, without waiting for it to complete */
+static void rockchip_nand_read_cmd(struct mtd_info *mtd, int page)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	unsigned int ctrl = NAND_NCE | NAND_ALE;
+
+	chip->cmd_ctrl(mtd, NAND_CMD_READ0,
+		       NAND_NCE | NAND_CLE | NAND_CTRL_CHANGE);
+	chip->cmd_ctrl(mtd, 0, ctrl | NAND_CTRL_CHANGE);
+	chip->cmd_ctrl(mtd, 0, ctrl);
+	chip->cmd_ctrl(mtd, page & 0xff, ctrl);
+	chip->cmd_ctrl(mtd, (page >> 8) & 0xff, ctrl);
+	if (chip->chipsize > (128 << 20))
+		chip->cmd_ctrl(mtd, (page >> 16) & 0xff, ctrl);
+	chip->cmd_ctrl(mtd, NAND_CMD_READSTART,
+		       NAND_NCE | NAND_CLE | NAND_CTRL_CHANGE);
+	chip->cmd_ctrl(mtd, NAND_CMD_NONE, NAND_NCE | NAND_CTRL_CHANGE);
+}
+
+static void rockchip_nand_cache_cmd(struct mtd_info *mtd, int cmd)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+
+	chip->cmd_ctrl(mtd, cmd, NAND_NCE | NAND_CLE | NAND_CTRL_CHANGE);
+	chip->cmd_ctrl(mtd, NAND_CMD_NONE, NAND_NCE | NAND_CTRL_CHANGE);
+}
+
+static void rockchip_nand_wait_array(struct mtd_info *mtd)
+{
+	/* tWB: the chip takes a moment to report busy */
+	ndelay(100);
+	nand_wait_ready(mtd);
+}
+
+static void rockchip_nand_copy_page(struct mtd_info *mtd, u8 *buf, int i)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	struct rk_nand *rknand = to_rknand(chip->controller);
+
+	memcpy(buf + i * mtd->writesize,
+	       rknand->dma_buf + (i & 1) * mtd->writesize, mtd->writesize);
+}
+
+/*
+ * Read @count whole pages from @page on into @buf, keeping the bus busy.
+ * Pages are DMAed into two bounce buffers in turn, and page N is copied
+ * out while the array loads page N + 1. With ONFI read cache that load
+ * happens while page N is still being transferred, otherwise while page
+ * N is copied out. The BCH status of each page is collected as soon as
+ * its transfer is done. Returns the max bitflips per step; *@bad_first
+ * and *@bad_last give the range of pages which could not be corrected,
+ * both -1 if there are none.
+ */
+static int rockchip_nand_read_pages(struct mtd_info *mtd, int page,
+				    int count, u8 *buf, int *bad_first,
+				    int *bad_last)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	struct rk_nand *rknand = to_rknand(chip->controller);
+	struct nand_ecc_ctrl *ecc = &chip->ecc;
+	bool cache = count > 1 && rockchip_nand_has_read_cache(chip);
+	ulong spare = (ulong)rknand->dma_spare;
+	unsigned int max_bitflips = 0;
+	ulong data;
+	int i, ret;
+
+	*bad_first = -1;
+	*bad_last = -1;
+	for (i = 0; i < count; i++) {
+		WATCHDOG_RESET();
+		data = (ulong)rknand->dma_buf + (i & 1) * mtd->writesize;
+
+		if (!cache || !i)
+			rockchip_nand_read_cmd(mtd, page + i);
+		if (!cache && i)
+			rockchip_nand_copy_page(mtd, buf, i - 1);
+		rockchip_nand_wait_array(mtd);
+		if (cache) {
+			/* Move page i to the cache register, load the next */
+			rockchip_nand_cache_cmd(mtd, i + 1 < count ?
+						NAND_CMD_READCACHESEQ :
+						NAND_CMD_READCACHEEND);
+			rockchip_nand_wait_array(mtd);
+		}
+
+		flush_dcache_range(data, data + mtd->writesize);
+		flush_dcache_range(spare, spare +
+				   ecc->steps * NANDC_V6_DMA_SPARE);
+		rockchip_nand_dma_xfer_start(rknand, NANDC_V6_READ, ecc->steps,
+					     (u8 *)data);
+		if (cache && i)
+			rockchip_nand_copy_page(mtd, buf, i - 1);
+		ret = rockchip_nand_wait_dma_xfer_done(rknand, NANDC_V6_READ,
+						       ecc->steps);
+		if (ret) {
+			if (cache)
+				chip->cmdfunc(mtd, NAND_CMD_RESET, -1, -1);
+			return ret;
+		}
+		invalidate_dcache_range(data, data + mtd->writesize);
+
+		ret = rockchip_nand_dma_bch_status(mtd);
+		if (ret < 0) {
+			if (*bad_first < 0)
+				*bad_first = page + i;
+			*bad_last = page + i;
+		} else {
+			max_bitflips = max_t(unsigned int, max_bitflips, ret);
+		}
+	}
+	rockchip_nand_copy_page(mtd, buf, count - 1);
+
+	return max_bitflips;
+}
+
+/*
+ * mtd->_read: whole-page reads of two pages or more go through the page
+ * engine, anything else (and the bootrom blocks, which use another ECC
+ * strength) through nand_base. Pages which the engine could not correct
+ * are read again through nand_base, for its read retries and ECC stats.
+ */
+static int rockchip_nand_read(struct mtd_info *mtd, loff_t from, size_t len,
+			      size_t *retlen, u_char *buf)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	struct rk_nand *rknand = to_rknand(chip->controller);
+	int chipnr = (int)(from >> chip->chip_shift);
+	int realpage = (int)(from >> chip->page_shift);
+	int count = len >> chip->page_shift;
+	int bad_first, bad_last, ret, ret2;
+	size_t fixed;
+
+	if (((from | len) & (mtd->writesize - 1)) || count < 2 ||
+	    ((from + len - 1) >> chip->chip_shift) != chipnr ||
+	    (rknand->bootromblocks && from < 7 * mtd->erasesize))
+		return rknand->nand_read(mtd, from, len, retlen, buf);
+
+	chip->state = FL_READING;
+	chip->select_chip(mtd, chipnr);
+	ret = rockchip_nand_read_pages(mtd, realpage & chip->pagemask, count,
+				       buf, &bad_first, &bad_last);
+	chip->select_chip(mtd, -1);
+	chip->state = FL_READY;
+	if (ret < 0) {
+		*retlen = 0;
+		return ret;
+	}
+	*retlen = len;
+
+	if (bad_first >= 0) {
+		bad_first -= realpage & chip->pagemask;
+		bad_last -= realpage & chip->pagemask;
+		ret2 = rknand->nand_read(mtd, from +
+				((loff_t)bad_first << chip->page_shift),
+				(bad_last - bad_first + 1) << chip->page_shift,
+				&fixed, buf + (bad_first << chip->page_shift));
+		if (ret2 < 0)
+			return ret2;
+		ret = max(ret, ret2);
+	}
+
+	return ret;
+}
+
+/* Set up the DMA page engine, for 1KB ECC steps only */
+static int rockchip_nand_dma_init(struct mtd_info *mtd)
+{
+	struct nand_chip *chip = mtd_to_nand(mtd);
+	struct rk_nand *rknand = to_rknand(chip->controller);
+	struct nand_ecc_ctrl *ecc = &chip->ecc;
+
+	if (ecc->size != NANDC_REG_V6_SRAM_SIZE ||
+	    ecc->steps > NANDC_V6_MAX_STEPS)
+		return -EINVAL;
+
+	/* All chips on the controller share the buffers */
+	if (!rknand->dma_buf) {
+		rknand->dma_buf = memalign(ARCH_DMA_MINALIGN,
+					   2 * mtd->writesize);
+		rknand->dma_spare = memalign(ARCH_DMA_MINALIGN,
+					     NANDC_V6_MAX_STEPS *
+					     NANDC_V6_DMA_SPARE);
+		if (!rknand->dma_buf || !rknand->dma_spare) {
+			free(rknand->dma_buf);
+			free(rknand->dma_spare);
+			rknand->dma_buf = NULL;
+			rknand->dma_spare = NULL;
+			return -ENOMEM;
+		}
+		rknand->dma_page_size = mtd->writesize;
+	}
+
+	if (mtd->writesize > rknand->dma_page_size)
+		return -EINVAL;
+
+	return 0;
+}
+
 static const u8 strengths[] = {60, 40, 24, 16};
 
 static int rockchip_nand_ecc_max_strength(struct mtd_info *mtd,
@@ -521,6 +934,13 @@ static int rockchip_nand_ecc_init(struct mtd_info *mtd,
 		ret = rockchip_nand_hw_ecc_ctrl_init(mtd, ecc);
 		if (ret)
 			return ret;
+		if (IS_ENABLED(CONFIG_NAND_ROCKCHIP_DMA) &&
+		    !rockchip_nand_dma_init(mtd)) {
+			ecc->read_page = rockchip_nand_hw_syndrome_dma_read_page;
+			ecc->write_page =
+				rockchip_nand_hw_syndrome_dma_write_page;
+			break;
+		}
 		ecc->read_page =  rockchip_nand_hw_syndrome_pio_read_page;
 		ecc->write_page = rockchip_nand_hw_syndrome_pio_write_page;
 		break;
@@ -578,6 +998,11 @@ static int rockchip_nand_chip_init(int node, struct rk_nand *rknand, int devnum)
 		return ret;
 	}
 
+	if (chip->ecc.read_page == rockchip_nand_hw_syndrome_dma_read_page) {
+		rknand->nand_read = mtd->_read;
+		mtd->_read = rockchip_nand_read;
+	}
+
 	ret = nand_register(devnum, mtd);
 	if (ret) {
 		debug("Failed to register mtd device: %d\n", ret);
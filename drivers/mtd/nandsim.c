@@ -0,0 +1,199 @@
+/*
+ * RAM-backed NAND flash simulator
+ *
+ * This gives tests a raw NAND to put UBI on without any hardware. It keeps
+ * the parts of NAND behaviour that the layers above rely on: whole-page
+ * writes which can only clear bits, block erase, bad blocks and read
+ * errors reported through the ECC return codes.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <nandsim.h>
+#include <linux/errno.h>
+#include <linux/mtd/mtd.h>
+
+/**
+ * struct nandsim - a simulated NAND
+ *
+ * @mtd:	MTD device, must be first
+ * @name:	MTD device name
+ * @data:	Contents of the flash
+ * @bad:	Per-block bad marker
+ * @read_err:	Per-block error to return from reads
+ * @stats:	Operations seen since creation
+ */
+struct nandsim {
+	struct mtd_info mtd;
+	char name[16];
+	u8 *data;
+	u8 *bad;
+	int *read_err;
+	struct nandsim_stats stats;
+};
+
+static struct nandsim *mtd_to_nandsim(struct mtd_info *mtd)
+{
+	return container_of(mtd, struct nandsim, mtd);
+}
+
+static int nandsim_erase(struct mtd_info *mtd, struct erase_info *instr)
+{
+	struct nandsim *ns = mtd_to_nandsim(mtd);
+	int block = instr->addr >> mtd->erasesize_shift;
+	int end = (instr->addr + instr->len) >> mtd->erasesize_shift;
+
+	if ((instr->addr | instr->len) & mtd->erasesize_mask)
+		return -EINVAL;
+
+	instr->state = MTD_ERASING;
+	for (; block < end; block++) {
+		if (ns->bad[block]) {
+			instr->state = MTD_ERASE_FAILED;
+			instr->fail_addr = (loff_t)block << mtd->erasesize_shift;
+			return -EIO;
+		}
+		memset(ns->data + ((ulong)block << mtd->erasesize_shift), 0xff,
+		       mtd->erasesize);
+		ns->read_err[block] = 0;
+		ns->stats.erases++;
+	}
+
+	instr->state = MTD_ERASE_DONE;
+	mtd_erase_callback(instr);
+
+	return 0;
+}
+
+static int nandsim_read(struct mtd_info *mtd, loff_t from, size_t len,
+			size_t *retlen, u_char *buf)
+{
+	struct nandsim *ns = mtd_to_nandsim(mtd);
+	int block = from >> mtd->erasesize_shift;
+	int end = (from + len - 1) >> mtd->erasesize_shift;
+	int bitflips = 0;
+
+	ns->stats.reads++;
+	ns->stats.read_bytes += len;
+	memcpy(buf, ns->data + from, len);
+	*retlen = len;
+
+	/* Report the worst error of the blocks read */
+	for (; block <= end; block++) {
+		if (ns->read_err[block] == -EBADMSG)
+			return -EBADMSG;
+		if (ns->read_err[block] == -EUCLEAN)
+			bitflips = mtd->ecc_strength;
+	}
+
+	return bitflips;
+}
+
+static int nandsim_write(struct mtd_info *mtd, loff_t to, size_t len,
+			 size_t *retlen, const u_char *buf)
+{
+	struct nandsim *ns = mtd_to_nandsim(mtd);
+	u8 *p = ns->data + to;
+	size_t i;
+
+	if ((to | len) & mtd->writesize_mask)
+		return -EINVAL;
+
+	ns->stats.writes++;
+	for (i = 0; i < len; i++)
+		p[i] &= buf[i];
+	*retlen = len;
+
+	return 0;
+}
+
+static int nandsim_block_isbad(struct mtd_info *mtd, loff_t ofs)
+{
+	struct nandsim *ns = mtd_to_nandsim(mtd);
+
+	return ns->bad[ofs >> mtd->erasesize_shift];
+}
+
+static int nandsim_block_markbad(struct mtd_info *mtd, loff_t ofs)
+{
+	struct nandsim *ns = mtd_to_nandsim(mtd);
+	int block = ofs >> mtd->erasesize_shift;
+
+	if (!ns->bad[block]) {
+		ns->bad[block] = 1;
+		mtd->ecc_stats.badblocks++;
+	}
+
+	return 0;
+}
+
+static void nandsim_free(struct nandsim *ns)
+{
+	free(ns->data);
+	free(ns->bad);
+	free(ns->read_err);
+	free(ns);
+}
+
+struct mtd_info *nandsim_create(const char *name, uint size, uint erasesize,
+				uint writesize)
+{
+	struct nandsim *ns;
+	struct mtd_info *mtd;
+	uint blocks = size / erasesize;
+
+	ns = calloc(1, sizeof(*ns));
+	if (!ns)
+		return NULL;
+	ns->data = malloc(size);
+	ns->bad = calloc(blocks, sizeof(*ns->bad));
+	ns->read_err = calloc(blocks, sizeof(*ns->read_err));
+	if (!ns->data || !ns->bad || !ns->read_err) {
+		nandsim_free(ns);
+		return NULL;
+	}
+	memset(ns->data, 0xff, size);
+	strlcpy(ns->name, name, sizeof(ns->name));
+
+	mtd = &ns->mtd;
+	mtd->name = ns->name;
+	mtd->type = MTD_NANDFLASH;
+	mtd->flags = MTD_CAP_NANDFLASH;
+	mtd->size = size;
+	mtd->erasesize = erasesize;
+	mtd->writesize = writesize;
+	mtd->writebufsize = writesize;
+	mtd->ecc_strength = 1;
+	mtd->bitflip_threshold = 1;
+	mtd->_erase = nandsim_erase;
+	mtd->_read = nandsim_read;
+	mtd->_write = nandsim_write;
+	mtd->_block_isbad = nandsim_block_isbad;
+	mtd->_block_markbad = nandsim_block_markbad;
+	mtd->priv = ns;
+
+	if (add_mtd_device(mtd)) {
+		nandsim_free(ns);
+		return NULL;
+	}
+
+	return mtd;
+}
+
+void nandsim_destroy(struct mtd_info *mtd)
+{
+	del_mtd_device(mtd);
+	nandsim_free(mtd_to_nandsim(mtd));
+}
+
+void nandsim_set_read_error(struct mtd_info *mtd, int block, int err)
+{
+	mtd_to_nandsim(mtd)->read_err[block] = err;
+}
+
+const struct nandsim_stats *nandsim_get_stats(struct mtd_info *mtd)
+{
+	return &mtd_to_nandsim(mtd)->stats;
+}
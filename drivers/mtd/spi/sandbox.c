@@ -11,6 +11,7 @@
 #include <common.h>
 #include <dm.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <spi.h>
 #include <os.h>
 
@@ -91,6 +92,11 @@ struct sandbox_spi_flash {
 	const struct spi_flash_info *data;
 	/* The file on disk to serv up data from */
 	int fd;
+	/* Direct-read window kept in step with the file, or NULL */
+	u8 *map;
+	uint map_size;
+	/* Number of read commands seen */
+	uint reads;
 };
 
 struct sandbox_spi_flash_plat_data {
@@ -98,8 +104,47 @@ struct sandbox_spi_flash_plat_data {
 	const char *device_name;
 	int bus;
 	int cs;
+	fdt_addr_t map_addr;
+	fdt_size_t map_size;
 };
 
+/*
+ * Fill the direct-read window from the backing file. Anything past the end
+ * of the file reads as erased.
+ */
+static int sandbox_sf_load_map(struct sandbox_spi_flash *sbsf,
+			       struct sandbox_spi_flash_plat_data *pdata)
+{
+	uint size = sbsf->data->sector_size * sbsf->data->n_sectors;
+	ssize_t ret;
+
+	if (pdata->map_size < size) {
+		printf("%s: memory map must cover entire device\n", __func__);
+		return -EINVAL;
+	}
+	sbsf->map = map_sysmem(pdata->map_addr, pdata->map_size);
+	sbsf->map_size = size;
+	memset(sbsf->map, 0xff, size);
+	if (os_lseek(sbsf->fd, 0, OS_SEEK_SET) < 0)
+		return -EIO;
+	ret = os_read(sbsf->fd, sbsf->map, size);
+
+	return ret < 0 ? -EIO : 0;
+}
+
+/* Make a change to the backing file show up in the window too */
+static void sandbox_sf_update_map(struct sandbox_spi_flash *sbsf, uint off,
+				  const u8 *buf, uint len)
+{
+	if (!sbsf->map || off >= sbsf->map_size)
+		return;
+	len = min(len, sbsf->map_size - off);
+	if (buf)
+		memcpy(sbsf->map + off, buf, len);
+	else
+		memset(sbsf->map + off, 0xff, len);
+}
+
 /**
  * This is a very strange probe function. If it has platform data (which may
  * have come from the device tree) then this function gets the filename and
@@ -196,6 +241,14 @@ static int sandbox_sf_probe(struct udevice *dev)
 	sbsf->data = data;
 	sbsf->cs = cs;
 
+	if (pdata->map_size) {
+		ret = sandbox_sf_load_map(sbsf, pdata);
+		if (ret) {
+			os_close(sbsf->fd);
+			goto error;
+		}
+	}
+
 	return 0;
 
  error:
@@ -396,6 +449,7 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 			case CMD_READ_ARRAY_FAST:
 			case CMD_READ_ARRAY_SLOW:
 				sbsf->state = SF_READ;
+				sbsf->reads++;
 				break;
 			case CMD_PAGE_PROGRAM:
 				sbsf->state = SF_WRITE;
@@ -461,6 +515,8 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 				puts("sandbox_spi: os_write() failed\n");
 				return -EIO;
 			}
+			sandbox_sf_update_map(sbsf, sbsf->off, rx + pos, ret);
+			sbsf->off += ret;
 			pos += ret;
 			sbsf->status &= ~STAT_WEL;
 			break;
@@ -493,6 +549,8 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 			 * delay before clearing it ?
 			 */
 			ret = sandbox_erase_part(sbsf, sbsf->erase_size);
+			sandbox_sf_update_map(sbsf, sbsf->off, NULL,
+					      sbsf->erase_size);
 			sbsf->status &= ~STAT_WEL;
 			if (ret) {
 				debug("sandbox_sf: Erase failed\n");
@@ -523,10 +581,22 @@ int sandbox_sf_ofdata_to_platdata(struct udevice *dev)
 		      __func__, pdata->filename, pdata->device_name);
 		return -EINVAL;
 	}
+	/* A direct-read window, as a controller with one would have */
+	pdata->map_addr = dev_read_addr_size(dev, "memory-map",
+					     &pdata->map_size);
+	if (pdata->map_addr == FDT_ADDR_T_NONE)
+		pdata->map_size = 0;
 
 	return 0;
 }
 
+uint sandbox_sf_get_reads(struct udevice *emul)
+{
+	struct sandbox_spi_flash *sbsf = dev_get_priv(emul);
+
+	return sbsf->reads;
+}
+
 static const struct dm_spi_emul_ops sandbox_sf_emul_ops = {
 	.xfer          = sandbox_sf_xfer,
 };
@@ -9,9 +9,11 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <dm.h>
 #include <errno.h>
 #include <malloc.h>
+#include <part.h>
 #include <spi.h>
 #include <spi_flash.h>
 
@@ -143,17 +145,91 @@ static int spi_flash_std_erase(struct udevice *dev, u32 offset, size_t len)
 	return spi_flash_cmd_erase_ops(flash, offset, len);
 }
 
+#ifdef CONFIG_SPI_FLASH_BLK
+static ulong spi_flash_blk_read(struct udevice *dev, lbaint_t start,
+				lbaint_t blkcnt, void *buf)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+	struct spi_flash *flash = dev_get_uclass_priv(dev->parent);
+	int ret;
+
+	if (start + blkcnt > desc->lba)
+		return 0;
+
+	/* This is a single copy when the flash is memory-mapped */
+	ret = spi_flash_cmd_read_ops(flash, start << desc->log2blksz,
+				     blkcnt << desc->log2blksz, buf);
+
+	return ret ? 0 : blkcnt;
+}
+
+static int spi_flash_blk_probe(struct udevice *dev)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+	struct spi_flash *flash = dev_get_uclass_priv(dev->parent);
+
+	desc->lba = flash->size / desc->blksz;
+	desc->log2blksz = LOG2(desc->blksz);
+	snprintf(desc->vendor, BLK_VEN_SIZE, "%s", flash->name);
+	snprintf(desc->product, BLK_PRD_SIZE, "%s",
+		 flash->memory_map ? "SPI Nor (mapped)" : "SPI Nor");
+	part_init(desc);
+
+	return 0;
+}
+
+static const struct blk_ops spi_flash_blk_ops = {
+	.read	= spi_flash_blk_read,
+};
+
+U_BOOT_DRIVER(spi_flash_blk) = {
+	.name		= "spi_flash_blk",
+	.id		= UCLASS_BLK,
+	.ops		= &spi_flash_blk_ops,
+	.probe		= spi_flash_blk_probe,
+};
+
+/*
+ * The block device is only added once the flash has been probed, so the
+ * size is known and flashes nobody uses do not show up as block devices
+ */
+static int spi_flash_std_bind_blk(struct udevice *dev)
+{
+	struct spi_flash *flash = dev_get_uclass_priv(dev);
+	struct udevice *bdev;
+
+	device_find_first_child(dev, &bdev);
+	if (bdev)
+		return 0;
+
+	return blk_create_devicef(dev, "spi_flash_blk", "blk", IF_TYPE_SPINOR,
+				  -1, 512, 0, &bdev);
+}
+#endif
+
 static int spi_flash_std_probe(struct udevice *dev)
 {
 	struct spi_slave *slave = dev_get_parent_priv(dev);
 	struct dm_spi_slave_platdata *plat = dev_get_parent_platdata(dev);
 	struct spi_flash *flash;
+	int ret;
 
 	flash = dev_get_uclass_priv(dev);
 	flash->dev = dev;
 	flash->spi = slave;
 	debug("%s: slave=%p, cs=%d\n", __func__, slave, plat->cs);
-	return spi_flash_probe_slave(flash);
+	ret = spi_flash_probe_slave(flash);
+	if (ret)
+		return ret;
+
+#ifdef CONFIG_SPI_FLASH_BLK
+	ret = spi_flash_std_bind_blk(dev);
+	if (ret)
+		debug("%s: cannot create block device (err=%d)\n", __func__,
+		      ret);
+#endif
+
+	return 0;
 }
 
 static const struct dm_spi_flash_ops spi_flash_std_ops = {
@@ -803,7 +803,9 @@ out_unlock:
  * scan_peb - scan and process UBI headers of a PEB.
  * @ubi: UBI device description object
  * @ai: attaching information
- * @pnum: the physical eraseblock number
+ * @pnum: the physical eraseblock number, which must not be bad
+ * @hdrs: the headers of the PEB as read by 'ubi_io_read_hdrs()', or %NULL to
+ *        read them here
  * @vid: The volume ID of the found volume will be stored in this pointer
  * @sqnum: The sqnum of the found volume will be stored in this pointer
  *
@@ -813,23 +815,20 @@ out_unlock:
  * successfully handled and a negative error code in case of failure.
  */
 static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
-		    int pnum, int *vid, unsigned long long *sqnum)
+		    int pnum, const void *hdrs, int *vid,
+		    unsigned long long *sqnum)
 {
 	long long uninitialized_var(ec);
 	int err, bitflips = 0, vol_id = -1, ec_err = 0;
 
 	dbg_bld("scan PEB %d", pnum);
 
-	/* Skip bad physical eraseblocks */
-	err = ubi_io_is_bad(ubi, pnum);
-	if (err < 0)
-		return err;
-	else if (err) {
-		ai->bad_peb_count += 1;
-		return 0;
+	if (hdrs) {
+		memcpy(ech, hdrs, UBI_EC_HDR_SIZE);
+		err = ubi_io_check_ec_hdr(ubi, pnum, ech, 0, 0);
+	} else {
+		err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
 	}
-
-	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
 	if (err < 0)
 		return err;
 	switch (err) {
@@ -912,7 +911,12 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 
 	/* OK, we've done with the EC header, let's look at the VID header */
 
-	err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
+	if (hdrs) {
+		memcpy(vidh, hdrs + ubi->vid_hdr_offset, UBI_VID_HDR_SIZE);
+		err = ubi_io_check_vid_hdr(ubi, pnum, vidh, 0, 0);
+	} else {
+		err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
+	}
 	if (err < 0)
 		return err;
 	switch (err) {
@@ -1211,6 +1215,102 @@ static void destroy_ai(struct ubi_attach_info *ai)
 	kfree(ai);
 }
 
+/* What the first pass of 'scan_pebs()' found out about a PEB */
+enum {
+	SCAN_HDRS_READ,
+	SCAN_HDRS_REREAD,
+	SCAN_BAD,
+};
+
+/**
+ * scan_pebs - scan a range of PEBs in groups.
+ * @ubi: UBI device description object
+ * @ai: attaching information
+ * @start: the first PEB to scan
+ * @end: the PEB to stop at
+ * @fm_anchor: if not %NULL, the newest fastmap anchor found is stored here
+ *
+ * This function scans PEBs @start to @end - 1 in groups of
+ * %CONFIG_MTD_UBI_SCAN_BATCH. For each group it first finds the bad PEBs and
+ * reads the headers of the others back to back, with one flash read per PEB
+ * covering both the EC and the VID header, and then processes them. Headers
+ * which could not be read cleanly that way are read again one at a time, so
+ * that bit-flips and ECC errors are put down to the right header. Returns
+ * zero in case of success and a negative error code in case of failure.
+ */
+static int scan_pebs(struct ubi_device *ubi, struct ubi_attach_info *ai,
+		     int start, int end, int *fm_anchor)
+{
+	int hdrs_size = ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize;
+	int batch = min(CONFIG_MTD_UBI_SCAN_BATCH, end - start);
+	unsigned long long max_sqnum = 0;
+	int err = -ENOMEM, pnum, i, n;
+	u8 *state;
+	void *hdrs;
+
+	if (batch <= 0)
+		return 0;
+
+	state = kmalloc(batch, GFP_KERNEL);
+	if (!state)
+		return err;
+
+	hdrs = vmalloc(batch * hdrs_size);
+	if (!hdrs)
+		goto out_state;
+
+	for (pnum = start; pnum < end; pnum += n) {
+		n = min(batch, end - pnum);
+
+		for (i = 0; i < n; i++) {
+			cond_resched();
+
+			err = ubi_io_is_bad(ubi, pnum + i);
+			if (err < 0)
+				goto out_hdrs;
+			if (err) {
+				state[i] = SCAN_BAD;
+				continue;
+			}
+
+			err = ubi_io_read_hdrs(ubi, hdrs + i * hdrs_size,
+					       pnum + i);
+			state[i] = err ? SCAN_HDRS_REREAD : SCAN_HDRS_READ;
+		}
+
+		for (i = 0; i < n; i++) {
+			unsigned long long sqnum = 0;
+			int vol_id = -1;
+
+			if (state[i] == SCAN_BAD) {
+				ai->bad_peb_count += 1;
+				continue;
+			}
+
+			dbg_gen("process PEB %d", pnum + i);
+			err = scan_peb(ubi, ai, pnum + i,
+				       state[i] == SCAN_HDRS_READ ?
+				       hdrs + i * hdrs_size : NULL,
+				       &vol_id, &sqnum);
+			if (err < 0)
+				goto out_hdrs;
+
+			if (fm_anchor && vol_id == UBI_FM_SB_VOLUME_ID &&
+			    sqnum > max_sqnum) {
+				max_sqnum = sqnum;
+				*fm_anchor = pnum + i;
+			}
+		}
+	}
+	err = 0;
+
+out_hdrs:
+	vfree(hdrs);
+out_state:
+	kfree(state);
+	return err;
+}
+
 /**
  * scan_all - scan entire MTD device.
  * @ubi: UBI device description object
@@ -1224,7 +1324,7 @@ static void destroy_ai(struct ubi_attach_info *ai)
 static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		    int start)
 {
-	int err, pnum;
+	int err;
 	struct rb_node *rb1, *rb2;
 	struct ubi_ainf_volume *av;
 	struct ubi_ainf_peb *aeb;
@@ -1239,14 +1339,9 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	if (!vidh)
 		goto out_ech;
 
-	for (pnum = start; pnum < ubi->peb_count; pnum++) {
-		cond_resched();
-
-		dbg_gen("process PEB %d", pnum);
-		err = scan_peb(ubi, ai, pnum, NULL, NULL);
-		if (err < 0)
-			goto out_vidh;
-	}
+	err = scan_pebs(ubi, ai, start, ubi->peb_count, NULL);
+	if (err < 0)
+		goto out_vidh;
 
 	ubi_msg(ubi, "scanning is finished");
 
@@ -1335,8 +1430,7 @@ static struct ubi_attach_info *alloc_ai(void)
  */
 static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 {
-	int err, pnum, fm_anchor = -1;
-	unsigned long long max_sqnum = 0;
+	int err, fm_anchor = -1;
 
 	err = -ENOMEM;
 
@@ -1348,21 +1442,9 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 	if (!vidh)
 		goto out_ech;
 
-	for (pnum = 0; pnum < UBI_FM_MAX_START; pnum++) {
-		int vol_id = -1;
-		unsigned long long sqnum = -1;
-		cond_resched();
-
-		dbg_gen("process PEB %d", pnum);
-		err = scan_peb(ubi, *ai, pnum, &vol_id, &sqnum);
-		if (err < 0)
-			goto out_vidh;
-
-		if (vol_id == UBI_FM_SB_VOLUME_ID && sqnum > max_sqnum) {
-			max_sqnum = sqnum;
-			fm_anchor = pnum;
-		}
-	}
+	err = scan_pebs(ubi, *ai, 0, UBI_FM_MAX_START, &fm_anchor);
+	if (err < 0)
+		goto out_vidh;
 
 	ubi_free_vid_hdr(ubi, vidh);
 	kfree(ech);
@@ -1399,6 +1481,7 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 {
 	int err;
 	struct ubi_attach_info *ai;
+	unsigned long start = get_timer(0);
 
 	ai = alloc_ai();
 	if (!ai)
@@ -1478,6 +1561,11 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 #endif
 
 	destroy_ai(ai);
+
+	ubi->attach_time = get_timer(start);
+	ubi_msg(ubi, "attached by %s in %lu ms",
+		ubi->fm_attached ? "fastmap" : "scanning", ubi->attach_time);
+
 	return 0;
 
 out_wl:
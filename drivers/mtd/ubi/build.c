@@ -1062,12 +1062,15 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 #else
 	/*
 	 * U-Boot special: We have no bgt_thread in U-Boot!
-	 * So just call do_work() here directly.
+	 * So do the works queued while attaching here directly.
 	 */
-	err = do_work(ubi);
-	if (err) {
-		ubi_err(ubi, "%s: work failed with error code %d",
-			ubi->bgt_name, err);
+	while (ubi->works_count) {
+		err = do_work(ubi);
+		if (err) {
+			ubi_err(ubi, "%s: work failed with error code %d",
+				ubi->bgt_name, err);
+			break;
+		}
 	}
 #endif
 
@@ -340,7 +340,11 @@ static void ubi_fastmap_close(struct ubi_device *ubi)
 #ifndef __UBOOT__
 	flush_work(&ubi->fm_work);
 #else
-	update_fastmap_work_fn(ubi);
+	/*
+	 * The fastmap work is never deferred in U-Boot, so there is nothing
+	 * to flush. Writing a fastmap here instead would lose the user
+	 * volumes, which uif_close() has already freed.
+	 */
 #endif
 	return_unused_pool_pebs(ubi, &ubi->fm_pool);
 	return_unused_pool_pebs(ubi, &ubi->fm_wl_pool);
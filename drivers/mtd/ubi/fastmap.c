@@ -169,6 +169,52 @@ static int add_aeb(struct ubi_attach_info *ai, struct list_head *list,
 	return 0;
 }
 
+/**
+ * add_fm_ec - add a PEB listed in a fastmap to ubi_attach_info.
+ * @ubi: UBI device object
+ * @ai: ubi_attach_info object
+ * @list: the list to add the PEB to
+ * @fmec: the fastmap entry of the PEB
+ * @scrub: scrub this PEB after attaching
+ * @listed: per-PEB flags of the PEBs listed so far
+ * @used_tbl: if not NULL, the new ubi_ainf_peb is stored here by PEB number
+ *
+ * The fastmap comes from the flash, so its PEB numbers and erase counters
+ * are checked before they are used as indexes or trusted by wear-leveling.
+ *
+ * Returns 0 on success, UBI_BAD_FASTMAP if the entry is invalid or lists a
+ * PEB twice, < 0 indicates an internal error.
+ */
+static int add_fm_ec(struct ubi_device *ubi, struct ubi_attach_info *ai,
+		     struct list_head *list, struct ubi_fm_ec *fmec, int scrub,
+		     u8 *listed, struct ubi_ainf_peb **used_tbl)
+{
+	int pnum = be32_to_cpu(fmec->pnum);
+	int ec = be32_to_cpu(fmec->ec);
+	int ret;
+
+	if (pnum < 0 || pnum >= ubi->peb_count || listed[pnum]) {
+		ubi_err(ubi, "bad or repeated PEB %i in fastmap", pnum);
+		return UBI_BAD_FASTMAP;
+	}
+	if (ec < 0 || ec > UBI_MAX_ERASECOUNTER) {
+		ubi_err(ubi, "bad erase counter %i of PEB %i in fastmap",
+			ec, pnum);
+		return UBI_BAD_FASTMAP;
+	}
+	listed[pnum] = 1;
+
+	ret = add_aeb(ai, list, pnum, ec, scrub);
+	if (ret)
+		return ret;
+
+	if (used_tbl)
+		used_tbl[pnum] = list_last_entry(list, struct ubi_ainf_peb,
+						 u.list);
+
+	return 0;
+}
+
 /**
  * add_vol - create and add a new volume to ubi_attach_info.
  * @ai: ubi_attach_info object
@@ -443,8 +489,8 @@ static void unmap_peb(struct ubi_attach_info *ai, int pnum)
  * scan_pool - scans a pool for changed (no longer empty PEBs).
  * @ubi: UBI device object
  * @ai: attach info object
- * @pebs: an array of all PEB numbers in the to be scanned pool
- * @pool_size: size of the pool (number of entries in @pebs)
+ * @fmpl: the fastmap pool to be scanned
+ * @pool_size: size of the pool (number of entries in @fmpl->pebs)
  * @max_sqnum: pointer to the maximal sequence number
  * @free: list of PEBs which are most likely free (and go into @ai->free)
  *
@@ -453,12 +499,12 @@ static void unmap_peb(struct ubi_attach_info *ai, int pnum)
  */
 #ifndef __UBOOT__
 static int scan_pool(struct ubi_device *ubi, struct ubi_attach_info *ai,
-		     __be32 *pebs, int pool_size, unsigned long long *max_sqnum,
-		     struct list_head *free)
+		     struct ubi_fm_scan_pool *fmpl, int pool_size,
+		     unsigned long long *max_sqnum, struct list_head *free)
 #else
 static int scan_pool(struct ubi_device *ubi, struct ubi_attach_info *ai,
-		     __be32 *pebs, int pool_size, unsigned long long *max_sqnum,
-		     struct list_head *free)
+		     struct ubi_fm_scan_pool *fmpl, int pool_size,
+		     unsigned long long *max_sqnum, struct list_head *free)
 #endif
 {
 	struct ubi_vid_hdr *vh;
@@ -486,7 +532,14 @@ static int scan_pool(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		int scrub = 0;
 		int image_seq;
 
-		pnum = be32_to_cpu(pebs[i]);
+		/* @fmpl is packed, so read the entry through it */
+		pnum = be32_to_cpu(fmpl->pebs[i]);
+
+		if (pnum < 0 || pnum >= ubi->peb_count) {
+			ubi_err(ubi, "bad PEB %i in fastmap pool!", pnum);
+			ret = UBI_BAD_FASTMAP;
+			goto out;
+		}
 
 		if (ubi_io_is_bad(ubi, pnum)) {
 			ubi_err(ubi, "bad PEB in fastmap pool!");
@@ -615,15 +668,24 @@ static int ubi_attach_fastmap(struct ubi_device *ubi,
 	struct ubi_fm_ec *fmec;
 	struct ubi_fm_volhdr *fmvhdr;
 	struct ubi_fm_eba *fm_eba;
-	int ret, i, j, pool_size, wl_pool_size;
+	struct ubi_ainf_peb **used_tbl;
+	int ret, i, j, pool_size, wl_pool_size, vol_id;
 	size_t fm_pos = 0, fm_size = ubi->fm_size;
 	unsigned long long max_sqnum = 0;
 	void *fm_raw = ubi->fm_buf;
+	u8 *listed;
 
 	INIT_LIST_HEAD(&used);
 	INIT_LIST_HEAD(&free);
 	ai->min_ec = UBI_MAX_ERASECOUNTER;
 
+	listed = kzalloc(ubi->peb_count, GFP_KERNEL);
+	used_tbl = kcalloc(ubi->peb_count, sizeof(*used_tbl), GFP_KERNEL);
+	if (!listed || !used_tbl) {
+		ret = -ENOMEM;
+		goto fail;
+	}
+
 	fmsb = (struct ubi_fm_sb *)(fm_raw);
 	ai->max_sqnum = fmsb->sqnum;
 	fm_pos += sizeof(struct ubi_fm_sb);
@@ -697,8 +759,9 @@ static int ubi_attach_fastmap(struct ubi_device *ubi,
 		if (fm_pos >= fm_size)
 			goto fail_bad;
 
-		add_aeb(ai, &ai->free, be32_to_cpu(fmec->pnum),
-			be32_to_cpu(fmec->ec), 0);
+		ret = add_fm_ec(ubi, ai, &ai->free, fmec, 0, listed, NULL);
+		if (ret)
+			goto fail;
 	}
 
 	/* read EC values from used list */
@@ -708,8 +771,9 @@ static int ubi_attach_fastmap(struct ubi_device *ubi,
 		if (fm_pos >= fm_size)
 			goto fail_bad;
 
-		add_aeb(ai, &used, be32_to_cpu(fmec->pnum),
-			be32_to_cpu(fmec->ec), 0);
+		ret = add_fm_ec(ubi, ai, &used, fmec, 0, listed, used_tbl);
+		if (ret)
+			goto fail;
 	}
 
 	/* read EC values from scrub list */
@@ -719,8 +783,9 @@ static int ubi_attach_fastmap(struct ubi_device *ubi,
 		if (fm_pos >= fm_size)
 			goto fail_bad;
 
-		add_aeb(ai, &used, be32_to_cpu(fmec->pnum),
-			be32_to_cpu(fmec->ec), 1);
+		ret = add_fm_ec(ubi, ai, &used, fmec, 1, listed, used_tbl);
+		if (ret)
+			goto fail;
 	}
 
 	/* read EC values from erase list */
@@ -730,11 +795,13 @@ static int ubi_attach_fastmap(struct ubi_device *ubi,
 		if (fm_pos >= fm_size)
 			goto fail_bad;
 
-		add_aeb(ai, &ai->erase, be32_to_cpu(fmec->pnum),
-			be32_to_cpu(fmec->ec), 1);
+		ret = add_fm_ec(ubi, ai, &ai->erase, fmec, 1, listed, NULL);
+		if (ret)
+			goto fail;
 	}
 
-	ai->mean_ec = div_u64(ai->ec_sum, ai->ec_count);
+	if (ai->ec_count)
+		ai->mean_ec = div_u64(ai->ec_sum, ai->ec_count);
 	ai->bad_peb_count = be32_to_cpu(fmhdr->bad_peb_count);
 
 	/* Iterate over all volumes and read their EBA table */
@@ -750,8 +817,20 @@ static int ubi_attach_fastmap(struct ubi_device *ubi,
 			goto fail_bad;
 		}
 
-		av = add_vol(ai, be32_to_cpu(fmvhdr->vol_id),
-			     be32_to_cpu(fmvhdr->used_ebs),
+		vol_id = be32_to_cpu(fmvhdr->vol_id);
+		if ((vol_id < 0 || vol_id >= UBI_MAX_VOLUMES) &&
+		    vol_id != UBI_LAYOUT_VOLUME_ID) {
+			ubi_err(ubi, "bad volume ID %i in fastmap", vol_id);
+			goto fail_bad;
+		}
+		if (fmvhdr->vol_type != UBI_DYNAMIC_VOLUME &&
+		    fmvhdr->vol_type != UBI_STATIC_VOLUME) {
+			ubi_err(ubi, "bad type %i of volume %i in fastmap",
+				fmvhdr->vol_type, vol_id);
+			goto fail_bad;
+		}
+
+		av = add_vol(ai, vol_id, be32_to_cpu(fmvhdr->used_ebs),
 			     be32_to_cpu(fmvhdr->data_pad),
 			     fmvhdr->vol_type,
 			     be32_to_cpu(fmvhdr->last_eb_bytes));
@@ -770,6 +849,15 @@ static int ubi_attach_fastmap(struct ubi_device *ubi,
 
 		fm_eba = (struct ubi_fm_eba *)(fm_raw + fm_pos);
 		fm_pos += sizeof(*fm_eba);
+		if (fm_pos >= fm_size)
+			goto fail_bad;
+
+		/* Bound the count before it can overflow the position */
+		if (be32_to_cpu(fm_eba->reserved_pebs) > ubi->peb_count) {
+			ubi_err(ubi, "bad number of reserved PEBs %u of volume %i",
+				be32_to_cpu(fm_eba->reserved_pebs), vol_id);
+			goto fail_bad;
+		}
 		fm_pos += (sizeof(__be32) * be32_to_cpu(fm_eba->reserved_pebs));
 		if (fm_pos >= fm_size)
 			goto fail_bad;
@@ -783,21 +871,21 @@ static int ubi_attach_fastmap(struct ubi_device *ubi,
 		for (j = 0; j < be32_to_cpu(fm_eba->reserved_pebs); j++) {
 			int pnum = be32_to_cpu(fm_eba->pnum[j]);
 
-			if ((int)be32_to_cpu(fm_eba->pnum[j]) < 0)
+			if (pnum < 0)
 				continue;
 
-			aeb = NULL;
-			list_for_each_entry(tmp_aeb, &used, u.list) {
-				if (tmp_aeb->pnum == pnum) {
-					aeb = tmp_aeb;
-					break;
-				}
-			}
-
+			/*
+			 * Look the PEB up by number rather than walking the
+			 * used list, which is quadratic on large devices. It
+			 * is taken out of the table so it can only be mapped
+			 * once.
+			 */
+			aeb = pnum < ubi->peb_count ? used_tbl[pnum] : NULL;
 			if (!aeb) {
 				ubi_err(ubi, "PEB %i is in EBA but not in used list", pnum);
 				goto fail_bad;
 			}
+			used_tbl[pnum] = NULL;
 
 			aeb->lnum = j;
 
@@ -811,11 +899,11 @@ static int ubi_attach_fastmap(struct ubi_device *ubi,
 		}
 	}
 
-	ret = scan_pool(ubi, ai, fmpl->pebs, pool_size, &max_sqnum, &free);
+	ret = scan_pool(ubi, ai, fmpl, pool_size, &max_sqnum, &free);
 	if (ret)
 		goto fail;
 
-	ret = scan_pool(ubi, ai, fmpl_wl->pebs, wl_pool_size, &max_sqnum, &free);
+	ret = scan_pool(ubi, ai, fmpl_wl, wl_pool_size, &max_sqnum, &free);
 	if (ret)
 		goto fail;
 
@@ -848,11 +936,15 @@ static int ubi_attach_fastmap(struct ubi_device *ubi,
 	}
 #endif
 
+	kfree(used_tbl);
+	kfree(listed);
 	return 0;
 
 fail_bad:
 	ret = UBI_BAD_FASTMAP;
 fail:
+	kfree(used_tbl);
+	kfree(listed);
 	list_for_each_entry_safe(tmp_aeb, _tmp_aeb, &used, u.list) {
 		list_del(&tmp_aeb->u.list);
 		kmem_cache_free(ai->aeb_slab_cache, tmp_aeb);
@@ -956,6 +1048,13 @@ int ubi_scan_fastmap(struct ubi_device *ubi, struct ubi_attach_info *ai,
 
 		pnum = be32_to_cpu(fmsb->block_loc[i]);
 
+		if (pnum < 0 || pnum >= ubi->peb_count) {
+			ubi_err(ubi, "bad location %i of fastmap block# %i",
+				pnum, i);
+			ret = UBI_BAD_FASTMAP;
+			goto free_hdr;
+		}
+
 		if (ubi_io_is_bad(ubi, pnum)) {
 			ret = UBI_BAD_FASTMAP;
 			goto free_hdr;
@@ -1069,7 +1168,7 @@ int ubi_scan_fastmap(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	ubi->fm = fm;
 	ubi->fm_pool.max_size = ubi->fm->max_pool_size;
 	ubi->fm_wl_pool.max_size = ubi->fm->max_wl_pool_size;
-	ubi_msg(ubi, "attached by fastmap");
+	ubi->fm_attached = 1;
 	ubi_msg(ubi, "fastmap pool size: %d", ubi->fm_pool.max_size);
 	ubi_msg(ubi, "fastmap WL pool size: %d",
 		ubi->fm_wl_pool.max_size);
@@ -724,8 +724,7 @@ bad:
 int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 		       struct ubi_ec_hdr *ec_hdr, int verbose)
 {
-	int err, read_err;
-	uint32_t crc, magic, hdr_crc;
+	int read_err;
 
 	dbg_io("read EC header from PEB %d", pnum);
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
@@ -746,6 +745,28 @@ int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 		 */
 	}
 
+	return ubi_io_check_ec_hdr(ubi, pnum, ec_hdr, read_err, verbose);
+}
+
+/**
+ * ubi_io_check_ec_hdr - check an erase counter header which has been read.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock the header was read from
+ * @ec_hdr: the erase counter header
+ * @read_err: what reading the header returned: %0, %UBI_IO_BITFLIPS or an
+ * ECC error
+ * @verbose: be verbose if the header is corrupted or was not found
+ *
+ * This function does the checks of 'ubi_io_read_ec_hdr()' on a header which
+ * the caller has read itself, and returns the same codes apart from read
+ * failures.
+ */
+int ubi_io_check_ec_hdr(struct ubi_device *ubi, int pnum,
+			struct ubi_ec_hdr *ec_hdr, int read_err, int verbose)
+{
+	int err;
+	uint32_t crc, magic, hdr_crc;
+
 	magic = be32_to_cpu(ec_hdr->magic);
 	if (magic != UBI_EC_HDR_MAGIC) {
 		if (mtd_is_eccerr(read_err))
@@ -997,8 +1018,7 @@ bad:
 int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 			struct ubi_vid_hdr *vid_hdr, int verbose)
 {
-	int err, read_err;
-	uint32_t crc, magic, hdr_crc;
+	int read_err;
 	void *p;
 
 	dbg_io("read VID header from PEB %d", pnum);
@@ -1010,6 +1030,26 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 	if (read_err && read_err != UBI_IO_BITFLIPS && !mtd_is_eccerr(read_err))
 		return read_err;
 
+	return ubi_io_check_vid_hdr(ubi, pnum, vid_hdr, read_err, verbose);
+}
+
+/**
+ * ubi_io_check_vid_hdr - check a volume identifier header which has been read.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock the header was read from
+ * @vid_hdr: the volume identifier header
+ * @read_err: what reading the header returned: %0, %UBI_IO_BITFLIPS or an
+ * ECC error
+ * @verbose: be verbose if the header is corrupted or wasn't found
+ *
+ * This is the counterpart of 'ubi_io_check_ec_hdr()' for VID headers.
+ */
+int ubi_io_check_vid_hdr(struct ubi_device *ubi, int pnum,
+			 struct ubi_vid_hdr *vid_hdr, int read_err, int verbose)
+{
+	int err;
+	uint32_t crc, magic, hdr_crc;
+
 	magic = be32_to_cpu(vid_hdr->magic);
 	if (magic != UBI_VID_HDR_MAGIC) {
 		if (mtd_is_eccerr(read_err))
@@ -1063,6 +1103,36 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 	return read_err ? UBI_IO_BITFLIPS : 0;
 }
 
+/**
+ * ubi_io_read_hdrs - read both headers of a physical eraseblock at once.
+ * @ubi: UBI device description object
+ * @buf: buffer of @ubi->vid_hdr_aloffset + @ubi->vid_hdr_alsize bytes
+ * @pnum: physical eraseblock to read from
+ *
+ * This function reads physical eraseblock @pnum from the start to the end of
+ * the VID header with a single flash read instead of one per header. The EC
+ * header is then at the start of @buf and the VID header at
+ * @ubi->vid_hdr_offset. Unlike 'ubi_io_read()' it neither retries nor reports
+ * errors, since callers fall back to 'ubi_io_read_ec_hdr()' and
+ * 'ubi_io_read_vid_hdr()' when anything went wrong. Returns zero if all the
+ * data was read without bit-flips or errors, and non-zero otherwise.
+ */
+int ubi_io_read_hdrs(const struct ubi_device *ubi, void *buf, int pnum)
+{
+	size_t len = ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize;
+	size_t read;
+	int err;
+
+	dbg_io("read EC and VID headers from PEB %d", pnum);
+	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
+
+	err = mtd_read(ubi->mtd, (loff_t)pnum * ubi->peb_size, len, &read, buf);
+	if (!err && read != len)
+		err = -EIO;
+
+	return err;
+}
+
 /**
  * ubi_io_write_vid_hdr - write a volume identifier header.
  * @ubi: UBI device description object
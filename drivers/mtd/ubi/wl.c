@@ -549,12 +549,16 @@ static void __schedule_ubi_work(struct ubi_device *ubi, struct ubi_work *wrk)
 	int err;
 	/*
 	 * U-Boot special: We have no bgt_thread in U-Boot!
-	 * So just call do_work() here directly.
+	 * So just call do_work() here directly. Like the thread, wait until
+	 * attaching is done: a scrub found while attaching cannot move a LEB
+	 * before the EBA tables exist.
 	 */
-	err = do_work(ubi);
-	if (err) {
-		ubi_err(ubi, "%s: work failed with error code %d",
-			ubi->bgt_name, err);
+	if (ubi->thread_enabled) {
+		err = do_work(ubi);
+		if (err) {
+			ubi_err(ubi, "%s: work failed with error code %d",
+				ubi->bgt_name, err);
+		}
 	}
 #endif
 	spin_unlock(&ubi->wl_lock);
@@ -11,6 +11,7 @@
 
 #include <common.h>
 #include <dm.h>
+#include <dma_map.h>
 #include <errno.h>
 #include <miiphy.h>
 #include <malloc.h>
@@ -372,7 +373,7 @@ static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 	memcpy((void *)data_start, packet, length);
 
 	/* Flush data to be sent */
-	flush_dcache_range(data_start, data_end);
+	dma_map_range(data_start, data_end - data_start, DMA_TO_DEVICE);
 
 #if defined(CONFIG_DW_ALTDESCRIPTOR)
 	desc_p->txrx_status |= DESC_TXSTS_TXFIRST | DESC_TXSTS_TXLAST;
@@ -390,7 +391,7 @@ static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 #endif
 
 	/* Flush modified buffer descriptor */
-	flush_dcache_range(desc_start, desc_end);
+	dma_map_range(desc_start, desc_end - desc_start, DMA_TO_DEVICE);
 
 	/* Test the wrap-around condition. */
 	if (++desc_num >= CONFIG_TX_DESCR_NUM)
@@ -428,7 +429,8 @@ static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
 
 		/* Invalidate received data */
 		data_end = data_start + roundup(length, ARCH_DMA_MINALIGN);
-		invalidate_dcache_range(data_start, data_end);
+		dma_unmap_range(data_start, data_end - data_start,
+				DMA_FROM_DEVICE);
 		*packetp = (uchar *)(ulong)desc_p->dmamac_addr;
 	}
 
@@ -450,7 +452,7 @@ static int _dw_free_pkt(struct dw_eth_dev *priv)
 	desc_p->txrx_status |= DESC_RXSTS_OWNBYDMA;
 
 	/* Flush only status field - others weren't changed */
-	flush_dcache_range(desc_start, desc_end);
+	dma_map_range(desc_start, desc_end - desc_start, DMA_TO_DEVICE);
 
 	/* Test the wrap-around condition. */
 	if (++desc_num >= CONFIG_RX_DESCR_NUM)
@@ -6,7 +6,10 @@
 
 #include <common.h>
 #include <dm.h>
+#include <rksfc.h>
+#include <linux/log2.h>
 
+#include "flash_com.h"
 #include "rkflash_api.h"
 #include "rkflash_blk.h"
 
@@ -125,18 +128,52 @@ int rksfc_nor_vendor_write(struct blk_desc *dev_desc,
 	return snor_write(p_dev, sec, n_sec, p_data);
 }
 
+void rksfc_nor_print_stats(void)
+{
+	snor_print_write_stats();
+}
+
+#endif
+
+#if defined(CONFIG_RKSFC_NAND) || defined(CONFIG_RKNANDC_NAND)
+/*
+ * Device the FTL runs on. The vendor storage ops are handed the boot
+ * device, which need not be this one, so they mark it dirty through this.
+ */
+static struct rkflash_info *sftl_priv;
 #endif
 
 #ifdef CONFIG_RKSFC_NAND
 int rksfc_nand_init(struct udevice *udev)
 {
+	struct rkflash_info *priv = dev_get_priv(udev);
 	int ret;
+	ulong start;
 
 	ret = sfc_nand_init();
 	if (ret)
 		return ret;
-	else
-		return sftl_init();
+
+	start = get_timer(0);
+	ret = sftl_init();
+	if (ret)
+		return ret;
+
+	printf("rksfc: FTL init took %lu ms\n", get_timer(start));
+	sftl_priv = priv;
+	/*
+	 * The FTL reads whole pages, let the block layer make use of them.
+	 * It can only align reads to a power-of-two page.
+	 */
+	if (is_power_of_2(g_nand_phy_info.sec_per_page))
+		priv->page_blks = g_nand_phy_info.sec_per_page;
+
+	return 0;
+}
+
+int rksfc_nand_deinit(struct udevice *udev)
+{
+	return sftl_deinit();
 }
 
 int rksfc_nand_read(struct udevice *udev, u32 index, u32 count, void *buf)
@@ -190,6 +227,8 @@ int rksfc_nand_vendor_write(struct blk_desc *dev_desc,
 {
 	int ret;
 
+	if (sftl_priv)
+		sftl_priv->dirty = true;
 	ret = sftl_vendor_write(sec, n_sec, (u8 *)p_data);
 	if (!ret)
 		return n_sec;
@@ -202,7 +241,29 @@ int rksfc_nand_vendor_write(struct blk_desc *dev_desc,
 #ifdef CONFIG_RKNANDC_NAND
 int rknand_flash_init(struct udevice *udev)
 {
-	return sftl_init();
+	struct rkflash_info *priv = dev_get_priv(udev);
+	int ret;
+	ulong start = get_timer(0);
+
+	ret = sftl_init();
+	if (ret)
+		return ret;
+
+	printf("rknand: FTL init took %lu ms\n", get_timer(start));
+	sftl_priv = priv;
+	/*
+	 * The FTL reads whole pages, let the block layer make use of them.
+	 * It can only align reads to a power-of-two page.
+	 */
+	if (is_power_of_2(g_nand_phy_info.sec_per_page))
+		priv->page_blks = g_nand_phy_info.sec_per_page;
+
+	return 0;
+}
+
+int rknand_flash_deinit(struct udevice *udev)
+{
+	return sftl_deinit();
 }
 
 int rknand_flash_read(struct udevice *udev, u32 index, u32 count, void *buf)
@@ -256,6 +317,8 @@ int rknand_flash_vendor_write(struct blk_desc *dev_desc,
 {
 	int ret;
 
+	if (sftl_priv)
+		sftl_priv->dirty = true;
 	ret = sftl_vendor_write(sec, n_sec, (u8 *)p_data);
 	if (!ret)
 		return n_sec;
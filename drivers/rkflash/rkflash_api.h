@@ -37,6 +37,7 @@ int rksfc_nor_vendor_write(struct blk_desc *dev_desc,
 #include "sfc.h"
 #include "rk_sftl.h"
 int rksfc_nand_init(struct udevice *udev);
+int rksfc_nand_deinit(struct udevice *udev);
 u32 rksfc_nand_get_density(struct udevice *udev);
 int rksfc_nand_read(struct udevice *udev, u32 index, u32 count, void *buf);
 int rksfc_nand_write(struct udevice *udev,
@@ -57,6 +58,7 @@ int rksfc_nand_vendor_write(struct blk_desc *dev_desc,
 #include "flash.h"
 #include "rk_sftl.h"
 int rknand_flash_init(struct udevice *udev);
+int rknand_flash_deinit(struct udevice *udev);
 u32 rknand_flash_get_density(struct udevice *udev);
 int rknand_flash_read(struct udevice *udev, u32 index, u32 count, void *buf);
 int rknand_flash_write(struct udevice *udev,
@@ -47,6 +47,7 @@ ulong rkflash_bwrite(struct udevice *udev, lbaint_t start,
 	if (!priv->write)
 		return -EINVAL;
 
+	priv->dirty = true;
 	return (ulong)priv->write(udev->parent, (u32)start, (u32)blkcnt, src);
 }
 
@@ -65,6 +66,7 @@ ulong rkflash_berase(struct udevice *udev, lbaint_t start,
 	if (!priv->erase)
 		return -EINVAL;
 
+	priv->dirty = true;
 	return (ulong)priv->erase(udev->parent, (u32)start, (u32)blkcnt);
 }
 
@@ -96,6 +98,7 @@ static int rkflash_blk_probe(struct udevice *udev)
 	priv->child_dev = udev;
 	desc->lba = priv->density;
 	desc->log2blksz = 9;
+	desc->page_blks = priv->page_blks;
 	desc->bdev = udev;
 	sprintf(desc->vendor, "0x%.4x", 0x0308);
 	memcpy(desc->product, product, strlen(product));
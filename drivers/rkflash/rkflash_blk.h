@@ -43,6 +43,7 @@ struct flash_operation {
 			    u32 start,
 			    u32 blkcnt,
 			    void *buffer);
+	int (*flash_deinit)(struct udevice *udev);
 };
 
 struct rkflash_dev {
@@ -54,6 +55,10 @@ struct rkflash_info {
 	u32 flash_con_type;
 	u32 freq;
 	u32 density;
+	/* Written since init, so deinit() must run before reset or boot */
+	bool dirty;
+	/* Sectors the FTL reads at once, 0 if it reads any sector alone */
+	u32 page_blks;
 	struct udevice *child_dev;
 	struct rkflash_dev flash_dev_info;
 	/*
@@ -92,6 +97,13 @@ struct rkflash_info {
 	int (*erase)(struct udevice *udev,
 		     u32 start,
 		     u32 blkcnt);
+	/*
+	 * deinit() - write the FTL state back to the flash
+	 *
+	 * @dev:	Device to deinit
+	 * @return 0 is OK, -1 is error.
+	 */
+	int (*deinit)(struct udevice *udev);
 };
 
 struct rkflash_uclass_priv {
@@ -24,8 +24,9 @@ static struct flash_operation nandc_flash_op = {
 	NULL,
 	rknand_flash_vendor_read,
 	rknand_flash_vendor_write,
+	rknand_flash_deinit,
 #else
-	-1, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+	-1, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
 #endif
 };
 
@@ -93,6 +94,7 @@ static int rockchip_nand_probe(struct udevice *udev)
 		priv->read = nandc_flash_op.flash_read;
 		priv->write = nandc_flash_op.flash_write;
 		priv->erase = nandc_flash_op.flash_erase;
+		priv->deinit = nandc_flash_op.flash_deinit;
 #ifdef CONFIG_ROCKCHIP_VENDOR_PARTITION
 		flash_vendor_dev_ops_register(nandc_flash_op.vendor_read,
 					      nandc_flash_op.vendor_write);
@@ -103,6 +105,19 @@ static int rockchip_nand_probe(struct udevice *udev)
 	return ret;
 }
 
+/* Let the FTL save its mapping tables, so the next init need not scan */
+static int rockchip_nand_remove(struct udevice *udev)
+{
+	struct rkflash_info *priv = dev_get_priv(udev);
+
+	if (!priv->dirty || !priv->deinit)
+		return 0;
+
+	priv->dirty = false;
+
+	return priv->deinit(udev);
+}
+
 UCLASS_DRIVER(rknand) = {
 	.id		= UCLASS_RKNAND,
 	.name		= "rknand",
@@ -120,7 +135,9 @@ U_BOOT_DRIVER(rknand) = {
 	.of_match	= rockchip_nand_ids,
 	.bind		= rknand_blk_bind,
 	.probe		= rockchip_nand_probe,
+	.remove		= rockchip_nand_remove,
 	.priv_auto_alloc_size = sizeof(struct rkflash_info),
 	.ofdata_to_platdata = rockchip_nand_ofdata_to_platdata,
+	.flags		= DM_FLAG_OS_PREPARE,
 };
 
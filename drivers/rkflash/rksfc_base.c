@@ -25,8 +25,9 @@ static struct flash_operation sfc_nor_op = {
 	NULL,
 	rksfc_nor_vendor_read,
 	rksfc_nor_vendor_write,
+	NULL,
 #else
-	-1, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+	-1, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
 #endif
 };
 
@@ -40,8 +41,9 @@ static struct flash_operation sfc_nand_op = {
 	NULL,
 	rksfc_nand_vendor_read,
 	rksfc_nand_vendor_write,
+	rksfc_nand_deinit,
 #else
-	-1, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+	-1, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
 #endif
 };
 
@@ -121,6 +123,7 @@ static int rockchip_rksfc_probe(struct udevice *udev)
 				spi_flash_op[i]->flash_get_capacity(udev);
 			priv->read = spi_flash_op[i]->flash_read;
 			priv->write = spi_flash_op[i]->flash_write;
+			priv->deinit = spi_flash_op[i]->flash_deinit;
 #ifdef CONFIG_ROCKCHIP_VENDOR_PARTITION
 			flash_vendor_dev_ops_register(spi_flash_op[i]->vendor_read,
 						      spi_flash_op[i]->vendor_write);
@@ -133,6 +136,19 @@ static int rockchip_rksfc_probe(struct udevice *udev)
 	return ret;
 }
 
+/* Let the FTL save its mapping tables, so the next init need not scan */
+static int rockchip_rksfc_remove(struct udevice *udev)
+{
+	struct rkflash_info *priv = dev_get_priv(udev);
+
+	if (!priv->dirty || !priv->deinit)
+		return 0;
+
+	priv->dirty = false;
+
+	return priv->deinit(udev);
+}
+
 UCLASS_DRIVER(rksfc) = {
 	.id		= UCLASS_SPI_FLASH,
 	.name		= "rksfc",
@@ -150,7 +166,9 @@ U_BOOT_DRIVER(rksfc) = {
 	.of_match	= rockchip_sfc_ids,
 	.bind		= rksfc_blk_bind,
 	.probe		= rockchip_rksfc_probe,
+	.remove		= rockchip_rksfc_remove,
 	.priv_auto_alloc_size = sizeof(struct rkflash_info),
 	.ofdata_to_platdata = rockchip_rksfc_ofdata_to_platdata,
+	.flags		= DM_FLAG_OS_PREPARE,
 };
 
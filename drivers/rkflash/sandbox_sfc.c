@@ -0,0 +1,738 @@
+/*
+ * Register model of the Rockchip SFC with a SPI NOR or SPI Nand attached,
+ * for sandbox
+ *
+ * sfc.c calls sandbox_sfc_readl() and sandbox_sfc_writel() instead of
+ * touching MMIO. A command starts once SFC_CMD (and SFC_ADDR, when the
+ * command has an address) is written. Read data is then served from
+ * SFC_DATA or copied to SFC_DMA_ADDR when SFC_DMA_TRIGGER is written; write
+ * data is collected from either and applied once complete. The flash is
+ * never busy.
+ *
+ * Each command is checked against what the flash expects in its current
+ * state: address width, dummy cycles, data lines, and the QE bit for quad
+ * transfers. A mismatch is counted in the stats and the data is garbled, as
+ * a real part would garble it.
+ *
+ * The SPI Nand has a data register and a cache register, like the real
+ * parts. A page read (13h) loads a page into both; a cache read (31h) moves
+ * the data register to the cache and loads the next page of the block into
+ * the data register, and 3Fh moves it without loading another. Each page
+ * can be given an ECC status to report when it reaches the cache.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <os.h>
+#include <linux/compat.h>
+
+#include "sfc_nor.h"
+#include "flash_com.h"
+#include "rk_sftl.h"
+#include "sfc_nand.h"
+
+#define SANDBOX_SFC_BUF_SIZE	0x4000
+
+#define CMD_CHIP_ERASE_60	0x60
+
+#define SR_WEL			BIT(1)
+
+#define NAND_PAGES_PER_BLK	64
+#define NAND_FEA_PROTECT	0xA0
+#define NAND_FEA_CONFIG		0xB0
+#define NAND_FEA_STATUS		0xC0
+#define NAND_STATUS_ECC_SHIFT	4
+
+static struct sandbox_sfc {
+	u32 ctrl;
+	u32 cmd;
+	u32 addr;
+	u32 dma_addr;
+
+	/* Command in progress */
+	bool started;
+	u32 pos;
+	u32 len;
+	u8 buf[SANDBOX_SFC_BUF_SIZE];
+
+	/* Flash state */
+	u8 *flash;
+	u32 size;
+	u32 id;
+	int qe_bit;
+	u8 sr[3];
+	bool addr4;
+
+	/* SPI Nand state */
+	bool nand;
+	u32 n_pages;
+	u8 *ecc;
+	u8 cache[SFC_NAND_PAGE_MAX_SIZE];
+	u8 data_reg[SFC_NAND_PAGE_MAX_SIZE];
+	u32 data_page;
+	bool cache_seq;
+	u8 feature_protect;
+	u8 feature_config;
+	u8 feature_status;
+
+	struct sandbox_sfc_stats stats;
+} sfc_model;
+
+/* Provided by the prebuilt FTL on real boards */
+struct nand_phy_info g_nand_phy_info;
+struct nand_ops g_nand_ops;
+
+void *ftl_malloc(int n_size)
+{
+	return malloc(n_size);
+}
+
+void ftl_free(void *p)
+{
+	free(p);
+}
+
+static u8 *sfc_model_alloc(struct sandbox_sfc *m, u32 size)
+{
+	if (m->size != size) {
+		os_free(m->flash);
+		m->flash = os_malloc(size);
+		if (!m->flash) {
+			m->size = 0;
+			return NULL;
+		}
+	}
+	memset(m->flash, 0xff, size);
+	m->size = size;
+	m->started = false;
+	memset(&m->stats, 0, sizeof(m->stats));
+
+	return m->flash;
+}
+
+u8 *sandbox_sfc_set_chip(u32 id, u32 size, int qe_bit)
+{
+	struct sandbox_sfc *m = &sfc_model;
+
+	if (!sfc_model_alloc(m, size))
+		return NULL;
+	m->nand = false;
+	m->id = id;
+	m->qe_bit = qe_bit;
+	memset(m->sr, 0, sizeof(m->sr));
+	m->addr4 = false;
+
+	return m->flash;
+}
+
+u8 *sandbox_sfc_set_nand(u32 id, u32 blocks, int qe_bit)
+{
+	struct sandbox_sfc *m = &sfc_model;
+	u32 n_pages = blocks * NAND_PAGES_PER_BLK;
+
+	os_free(m->ecc);
+	m->ecc = os_malloc(n_pages);
+	if (!m->ecc || !sfc_model_alloc(m, n_pages * SFC_NAND_PAGE_MAX_SIZE))
+		return NULL;
+	memset(m->ecc, 0, n_pages);
+	m->nand = true;
+	m->n_pages = n_pages;
+	m->id = id;
+	m->qe_bit = qe_bit;
+	m->data_page = INVALID_UINT32;
+	m->cache_seq = false;
+	m->feature_protect = 0x38;
+	m->feature_config = 0;
+	m->feature_status = 0;
+
+	return m->flash;
+}
+
+void sandbox_sfc_nand_set_ecc(u32 page, u8 ecc)
+{
+	struct sandbox_sfc *m = &sfc_model;
+
+	if (page < m->n_pages)
+		m->ecc[page] = ecc;
+}
+
+struct sandbox_sfc_stats *sandbox_sfc_get_stats(void)
+{
+	return &sfc_model.stats;
+}
+
+static bool sfc_model_quad_enabled(struct sandbox_sfc *m)
+{
+	return m->sr[m->qe_bit >> 3] & BIT(m->qe_bit & 7);
+}
+
+static bool sfc_model_is_4b_cmd(u8 cmd)
+{
+	switch (cmd) {
+	case CMD_READ_DATA_4B:
+	case CMD_FAST_4READ_X4:
+	case CMD_PAGE_PROG_4B:
+	case CMD_PAGE_PROG_X4_4B:
+	case CMD_SECTOR_ERASE_4B:
+	case CMD_BLK32K_ERASE_4B:
+	case CMD_BLK64K_ERASE_4B:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Check the dummy cycles and data lines of a command and its address width,
+ * and return the flash offset it addresses
+ */
+static u32 sfc_model_check(struct sandbox_sfc *m, bool *ok)
+{
+	union SFCCMD_DATA cmd = { .d32 = m->cmd };
+	union SFCCTRL_DATA ctrl = { .d32 = m->ctrl };
+	u32 addr = m->addr;
+	uint dummy = 0, lines = SFC_1BITS_LINE, addrbits = SFC_ADDR_24BITS;
+	bool quad = false;
+
+	switch (cmd.b.cmd) {
+	case CMD_FAST_READ_X1:
+	case CMD_READ_PARAMETER:
+		dummy = 8;
+		break;
+	case CMD_FAST_READ_X2:
+		dummy = 8;
+		lines = SFC_2BITS_LINE;
+		break;
+	case CMD_FAST_READ_X4:
+	case CMD_FAST_4READ_X4:
+		dummy = 8;
+		lines = SFC_4BITS_LINE;
+		quad = true;
+		break;
+	case CMD_FAST_READ_A4:
+		/* Address and mode byte go out on four lines as 32 bits */
+		dummy = 4;
+		lines = SFC_4BITS_LINE;
+		quad = true;
+		if (!m->addr4) {
+			addrbits = SFC_ADDR_32BITS;
+			addr >>= 8;
+		}
+		break;
+	case CMD_PAGE_PROG_X4:
+	case CMD_PAGE_PROG_A4:
+	case CMD_PAGE_PROG_X4_4B:
+		lines = SFC_4BITS_LINE;
+		quad = true;
+		break;
+	}
+	if (m->addr4 || sfc_model_is_4b_cmd(cmd.b.cmd))
+		addrbits = SFC_ADDR_32BITS;
+
+	*ok = cmd.b.dummybits == dummy && ctrl.b.addrbits == 0 &&
+	      cmd.b.addrbits == addrbits &&
+	      (!cmd.b.datasize || ctrl.b.datalines == lines) &&
+	      (!quad || sfc_model_quad_enabled(m));
+	if (!*ok)
+		m->stats.errors++;
+
+	/* A 3-byte address only reaches the bottom 16MB */
+	if (addrbits == SFC_ADDR_24BITS)
+		addr &= 0xffffff;
+
+	return addr & (m->size - 1);
+}
+
+static bool sfc_model_write_enabled(struct sandbox_sfc *m)
+{
+	if (!(m->sr[0] & SR_WEL)) {
+		m->stats.errors++;
+		return false;
+	}
+	m->sr[0] &= ~SR_WEL;
+
+	return true;
+}
+
+static void sfc_model_erase(struct sandbox_sfc *m, u32 size)
+{
+	union SFCCMD_DATA cmd = { .d32 = m->cmd };
+	u32 offset;
+	bool ok;
+
+	if (cmd.b.addrbits)
+		offset = sfc_model_check(m, &ok) & ~(size - 1);
+	else
+		offset = 0;
+	if (sfc_model_write_enabled(m))
+		memset(m->flash + offset, 0xff, size);
+}
+
+static bool sfc_model_nand_check(struct sandbox_sfc *m, uint addrbits,
+				 uint xbits, uint lines)
+{
+	union SFCCMD_DATA cmd = { .d32 = m->cmd };
+	union SFCCTRL_DATA ctrl = { .d32 = m->ctrl };
+	bool quad = lines == SFC_4BITS_LINE && m->qe_bit >= 0;
+	bool ok;
+
+	ok = !cmd.b.dummybits && cmd.b.addrbits == addrbits &&
+	     (addrbits != SFC_ADDR_XBITS || ctrl.b.addrbits == xbits) &&
+	     (!cmd.b.datasize || ctrl.b.datalines == lines) &&
+	     (!quad || m->feature_config & BIT(m->qe_bit));
+	if (!ok)
+		m->stats.errors++;
+
+	return ok;
+}
+
+static u8 *sfc_model_nand_feature(struct sandbox_sfc *m, u32 addr)
+{
+	switch (addr) {
+	case NAND_FEA_PROTECT:
+		return &m->feature_protect;
+	case NAND_FEA_CONFIG:
+		return &m->feature_config;
+	case NAND_FEA_STATUS:
+		return &m->feature_status;
+	default:
+		return NULL;
+	}
+}
+
+static bool sfc_model_nand_row(struct sandbox_sfc *m, u32 *row)
+{
+	bool ok = sfc_model_nand_check(m, SFC_ADDR_24BITS, 0, 0);
+
+	*row = m->addr;
+	if (*row >= m->n_pages) {
+		m->stats.errors++;
+		ok = false;
+	}
+
+	return ok;
+}
+
+static bool sfc_model_nand_write_enabled(struct sandbox_sfc *m)
+{
+	if (!(m->feature_status & SR_WEL)) {
+		m->stats.errors++;
+		return false;
+	}
+	m->feature_status &= ~SR_WEL;
+
+	return true;
+}
+
+/* Read a page from the array into the data register */
+static void sfc_model_nand_load(struct sandbox_sfc *m, u32 page)
+{
+	memcpy(m->data_reg, m->flash + page * SFC_NAND_PAGE_MAX_SIZE,
+	       SFC_NAND_PAGE_MAX_SIZE);
+	m->data_page = page;
+}
+
+/* The array is busy with a sequential cache read until 3Fh ends it */
+static void sfc_model_nand_idle(struct sandbox_sfc *m)
+{
+	if (m->cache_seq)
+		m->stats.errors++;
+}
+
+/* Move the data register into the cache register and latch its ECC status */
+static void sfc_model_nand_to_cache(struct sandbox_sfc *m)
+{
+	memcpy(m->cache, m->data_reg, SFC_NAND_PAGE_MAX_SIZE);
+	m->feature_status &= ~(3 << NAND_STATUS_ECC_SHIFT);
+	m->feature_status |= m->ecc[m->data_page] << NAND_STATUS_ECC_SHIFT;
+}
+
+static void sfc_model_nand_start(struct sandbox_sfc *m)
+{
+	union SFCCMD_DATA cmd = { .d32 = m->cmd };
+	u32 row, col, i;
+	uint lines;
+	u8 *fea;
+	bool ok = true;
+
+	switch (cmd.b.cmd) {
+	case CMD_RESET_NAND:
+		m->data_page = INVALID_UINT32;
+		m->cache_seq = false;
+		m->feature_status = 0;
+		break;
+	case CMD_WRITE_EN:
+		m->feature_status |= SR_WEL;
+		break;
+	case CMD_WRITE_DIS:
+		m->feature_status &= ~SR_WEL;
+		break;
+	case CMD_READ_JEDECID:
+		ok = sfc_model_nand_check(m, SFC_ADDR_XBITS, 8, 0);
+		for (i = 0; i < m->len; i++)
+			m->buf[i] = i < 2 ? m->id >> (8 - i * 8) : 0;
+		break;
+	case CMD_GET_FEATURE:
+		ok = sfc_model_nand_check(m, SFC_ADDR_XBITS, 8, 0);
+		fea = sfc_model_nand_feature(m, m->addr);
+		memset(m->buf, fea ? *fea : 0, m->len);
+		break;
+	case CMD_PAGE_READ:
+		sfc_model_nand_idle(m);
+		if (sfc_model_nand_row(m, &row)) {
+			sfc_model_nand_load(m, row);
+			sfc_model_nand_to_cache(m);
+		}
+		m->stats.nand_page_reads++;
+		break;
+	case CMD_READ_CACHE_SEQ:
+	case CMD_READ_CACHE_END:
+		if (m->data_page == INVALID_UINT32) {
+			m->stats.errors++;
+			break;
+		}
+		sfc_model_nand_to_cache(m);
+		row = m->data_page + 1;
+		m->data_page = INVALID_UINT32;
+		m->cache_seq = false;
+		if (cmd.b.cmd == CMD_READ_CACHE_SEQ) {
+			/* Sequential cache reads stop at the block end */
+			if (row % NAND_PAGES_PER_BLK) {
+				sfc_model_nand_load(m, row);
+				m->cache_seq = true;
+			} else {
+				m->stats.errors++;
+			}
+		}
+		m->stats.nand_cache_reads++;
+		break;
+	case CMD_BLOCK_ERASE:
+		sfc_model_nand_idle(m);
+		if (sfc_model_nand_row(m, &row) &&
+		    sfc_model_nand_write_enabled(m)) {
+			row -= row % NAND_PAGES_PER_BLK;
+			memset(m->flash + row * SFC_NAND_PAGE_MAX_SIZE, 0xff,
+			       NAND_PAGES_PER_BLK * SFC_NAND_PAGE_MAX_SIZE);
+		}
+		break;
+	case CMD_PROG_EXEC:
+		sfc_model_nand_idle(m);
+		if (sfc_model_nand_row(m, &row) &&
+		    sfc_model_nand_write_enabled(m)) {
+			for (i = 0; i < SFC_NAND_PAGE_MAX_SIZE; i++)
+				m->flash[row * SFC_NAND_PAGE_MAX_SIZE + i] &=
+					m->cache[i];
+		}
+		break;
+	case CMD_READ_DATA:
+	case CMD_FAST_READ_X1:
+	case CMD_FAST_READ_X2:
+	case CMD_FAST_READ_X4:
+		/* A 16-bit column and a dummy byte */
+		lines = cmd.b.cmd == CMD_FAST_READ_X4 ? SFC_4BITS_LINE :
+			cmd.b.cmd == CMD_FAST_READ_X2 ? SFC_2BITS_LINE :
+			SFC_1BITS_LINE;
+		ok = sfc_model_nand_check(m, SFC_ADDR_24BITS, 0, lines);
+		col = (m->addr >> 8) & 0xffff;
+		for (i = 0; i < m->len; i++)
+			m->buf[i] = col + i < SFC_NAND_PAGE_MAX_SIZE ?
+				    m->cache[col + i] : 0xff;
+		break;
+	default:
+		printf("sandbox_sfc: unknown command %#x\n", cmd.b.cmd);
+		m->stats.errors++;
+		memset(m->buf, 0xff, m->len);
+		break;
+	}
+	if (!ok) {
+		for (i = 0; i < m->len; i++)
+			m->buf[i] = ~m->buf[i];
+	}
+}
+
+static void sfc_model_nand_finish_write(struct sandbox_sfc *m)
+{
+	union SFCCMD_DATA cmd = { .d32 = m->cmd };
+	u32 col;
+	u8 *fea;
+
+	switch (cmd.b.cmd) {
+	case CMD_SET_FEATURE:
+		fea = sfc_model_nand_feature(m, m->addr);
+		if (sfc_model_nand_check(m, SFC_ADDR_XBITS, 8, 0) && fea &&
+		    fea != &m->feature_status)
+			*fea = m->buf[0];
+		break;
+	case CMD_PROG_LOAD:
+	case CMD_PROG_LOAD_X4:
+		sfc_model_nand_idle(m);
+		if (!sfc_model_nand_check(m, SFC_ADDR_XBITS, 16,
+					  cmd.b.cmd == CMD_PROG_LOAD_X4 ?
+					  SFC_4BITS_LINE : SFC_1BITS_LINE))
+			break;
+		/* Program load starts from an all-ones cache */
+		col = m->addr & 0xffff;
+		memset(m->cache, 0xff, sizeof(m->cache));
+		if (col < SFC_NAND_PAGE_MAX_SIZE)
+			memcpy(m->cache + col, m->buf,
+			       min(m->len, SFC_NAND_PAGE_MAX_SIZE - col));
+		break;
+	default:
+		printf("sandbox_sfc: unknown command %#x\n", cmd.b.cmd);
+		m->stats.errors++;
+		break;
+	}
+	m->started = false;
+}
+
+/* Fill the response of a read command or run one without data */
+static void sfc_model_start(struct sandbox_sfc *m)
+{
+	union SFCCMD_DATA cmd = { .d32 = m->cmd };
+	u32 offset, i;
+	bool ok = true;
+
+	m->started = true;
+	m->pos = 0;
+	m->len = cmd.b.datasize;
+	/* Writes with data are applied once the data has arrived */
+	if (cmd.b.rw == SFC_WRITE && m->len)
+		return;
+	if (m->nand) {
+		sfc_model_nand_start(m);
+		return;
+	}
+
+	switch (cmd.b.cmd) {
+	case CMD_WRITE_EN:
+		m->sr[0] |= SR_WEL;
+		break;
+	case CMD_WRITE_DIS:
+		m->sr[0] &= ~SR_WEL;
+		break;
+	case CMD_ENTER_4BYTE_MODE:
+		m->addr4 = true;
+		break;
+	case CMD_EXIT_4BYTE_MODE:
+		m->addr4 = false;
+		break;
+	case CMD_SECTOR_ERASE:
+	case CMD_SECTOR_ERASE_4B:
+		sfc_model_erase(m, 0x1000);
+		break;
+	case CMD_BLK32K_ERASE:
+	case CMD_BLK32K_ERASE_4B:
+		sfc_model_erase(m, 0x8000);
+		break;
+	case CMD_BLK64K_ERASE:
+	case CMD_BLK64K_ERASE_4B:
+		sfc_model_erase(m, 0x10000);
+		break;
+	case CMD_CHIP_ERASE:
+	case CMD_CHIP_ERASE_60:
+		sfc_model_erase(m, m->size);
+		break;
+	case CMD_READ_JEDECID:
+		for (i = 0; i < m->len; i++)
+			m->buf[i] = i < 3 ? m->id >> (16 - i * 8) : 0;
+		break;
+	case CMD_READ_STATUS:
+		memset(m->buf, m->sr[0], m->len);
+		break;
+	case CMD_READ_STATUS2:
+		memset(m->buf, m->sr[1], m->len);
+		break;
+	case CMD_READ_STATUS3:
+		memset(m->buf, m->sr[2], m->len);
+		break;
+	case CMD_READ_PARAMETER:
+		sfc_model_check(m, &ok);
+		memset(m->buf, 0xff, m->len);
+		break;
+	case CMD_READ_DATA:
+	case CMD_READ_DATA_4B:
+	case CMD_FAST_READ_X1:
+	case CMD_FAST_READ_X2:
+	case CMD_FAST_READ_X4:
+	case CMD_FAST_4READ_X4:
+	case CMD_FAST_READ_A4:
+		offset = sfc_model_check(m, &ok);
+		for (i = 0; i < m->len; i++)
+			m->buf[i] = m->flash[(offset + i) & (m->size - 1)];
+		break;
+	default:
+		printf("sandbox_sfc: unknown command %#x\n", cmd.b.cmd);
+		m->stats.errors++;
+		memset(m->buf, 0xff, m->len);
+		break;
+	}
+	if (!ok) {
+		for (i = 0; i < m->len; i++)
+			m->buf[i] = ~m->buf[i];
+	}
+}
+
+/* Apply a write command once all its data has arrived */
+static void sfc_model_finish_write(struct sandbox_sfc *m)
+{
+	union SFCCMD_DATA cmd = { .d32 = m->cmd };
+	u32 offset, page, i;
+	bool ok;
+
+	if (m->nand) {
+		sfc_model_nand_finish_write(m);
+		return;
+	}
+
+	switch (cmd.b.cmd) {
+	case CMD_WRITE_STATUS:
+		if (sfc_model_write_enabled(m)) {
+			m->sr[0] = m->buf[0] & ~SR_WEL;
+			if (m->len > 1)
+				m->sr[1] = m->buf[1];
+		}
+		break;
+	case CMD_WRITE_STATUS2:
+		if (sfc_model_write_enabled(m))
+			m->sr[1] = m->buf[0];
+		break;
+	case CMD_WRITE_STATUS3:
+		if (sfc_model_write_enabled(m))
+			m->sr[2] = m->buf[0];
+		break;
+	case CMD_PAGE_PROG:
+	case CMD_PAGE_PROG_4B:
+	case CMD_PAGE_PROG_X4:
+	case CMD_PAGE_PROG_X4_4B:
+	case CMD_PAGE_PROG_A4:
+		offset = sfc_model_check(m, &ok);
+		if (!sfc_model_write_enabled(m) || !ok)
+			break;
+		/* Programming wraps within the page and only clears bits */
+		page = offset & ~(NOR_PAGE_SIZE - 1);
+		for (i = 0; i < m->len; i++)
+			m->flash[page + ((offset + i) & (NOR_PAGE_SIZE - 1))] &=
+				m->buf[i];
+		break;
+	default:
+		printf("sandbox_sfc: unknown command %#x\n", cmd.b.cmd);
+		m->stats.errors++;
+		break;
+	}
+	m->started = false;
+}
+
+static void sfc_model_dma(struct sandbox_sfc *m)
+{
+	union SFCCMD_DATA cmd = { .d32 = m->cmd };
+	void *ptr;
+
+	if (!m->started || !m->len)
+		return;
+	ptr = map_sysmem(m->dma_addr, m->len);
+	if (cmd.b.rw == SFC_WRITE) {
+		memcpy(m->buf, ptr, m->len);
+		sfc_model_finish_write(m);
+	} else {
+		memcpy(ptr, m->buf, m->len);
+		m->started = false;
+	}
+	unmap_sysmem(ptr);
+	m->stats.dma_xfers++;
+	m->stats.dma_bytes += m->len;
+	m->stats.last_dma_addr = m->dma_addr;
+}
+
+static u32 sfc_model_rx_words(struct sandbox_sfc *m)
+{
+	union SFCCMD_DATA cmd = { .d32 = m->cmd };
+
+	if (!m->started || cmd.b.rw == SFC_WRITE)
+		return 0;
+
+	return DIV_ROUND_UP(m->len - m->pos, 4);
+}
+
+u32 sandbox_sfc_readl(u32 reg)
+{
+	struct sandbox_sfc *m = &sfc_model;
+	u32 val, words, i;
+
+	switch (reg) {
+	case SFC_CTRL:
+		return m->ctrl;
+	case SFC_FSR:
+		words = sfc_model_rx_words(m);
+		val = SFC_TXEMPTY | SFC_FIFO_DEPTH << 8;
+		val |= min_t(u32, words, SFC_FIFO_DEPTH) << 16;
+		if (!words)
+			val |= SFC_RXEMPTY;
+		return val;
+	case SFC_VER:
+		return SFC_VER_3;
+	case SFC_DATA:
+		if (!sfc_model_rx_words(m)) {
+			m->stats.errors++;
+			return 0;
+		}
+		val = 0;
+		for (i = 0; i < 4 && m->pos < m->len; i++)
+			val |= m->buf[m->pos++] << (i * 8);
+		if (m->pos == m->len)
+			m->started = false;
+		m->stats.pio_words++;
+		return val;
+	default:
+		/* Never busy, never reset */
+		return 0;
+	}
+}
+
+void sandbox_sfc_writel(u32 val, u32 reg)
+{
+	struct sandbox_sfc *m = &sfc_model;
+	union SFCCMD_DATA cmd;
+	int i;
+
+	switch (reg) {
+	case SFC_RCVR:
+		if (val & SFC_RESET)
+			m->started = false;
+		break;
+	case SFC_CTRL:
+		m->ctrl = val;
+		break;
+	case SFC_CMD:
+		m->cmd = val;
+		cmd.d32 = val;
+		if (!cmd.b.addrbits)
+			sfc_model_start(m);
+		break;
+	case SFC_ADDR:
+		m->addr = val;
+		sfc_model_start(m);
+		break;
+	case SFC_DMA_ADDR:
+		m->dma_addr = val;
+		break;
+	case SFC_DMA_TRIGGER:
+		if (val & SFC_DMA_START)
+			sfc_model_dma(m);
+		break;
+	case SFC_DATA:
+		cmd.d32 = m->cmd;
+		if (!m->started || cmd.b.rw != SFC_WRITE) {
+			m->stats.errors++;
+			break;
+		}
+		for (i = 0; i < 4 && m->pos < m->len; i++)
+			m->buf[m->pos++] = val >> (i * 8);
+		m->stats.pio_words++;
+		if (m->pos == m->len)
+			sfc_model_finish_write(m);
+		break;
+	}
+}
@@ -7,42 +7,52 @@
 #include <common.h>
 #include <linux/delay.h>
 #include <bouncebuf.h>
+#include <mapmem.h>
 #include <asm/io.h>
 
 #include "sfc.h"
 
 static void __iomem *g_sfc_reg;
 
+#ifdef CONFIG_SANDBOX
+/* Sandbox cannot trap MMIO, so the register model is called instead */
+#define sfc_readl(off)		sandbox_sfc_readl(off)
+#define sfc_writel(val, off)	sandbox_sfc_writel(val, off)
+#else
+#define sfc_readl(off)		readl(g_sfc_reg + (off))
+#define sfc_writel(val, off)	writel(val, g_sfc_reg + (off))
+#endif
+
 static void sfc_reset(void)
 {
 	int timeout = 10000;
 
-	writel(SFC_RESET, g_sfc_reg + SFC_RCVR);
-	while ((readl(g_sfc_reg + SFC_RCVR) == SFC_RESET) && (timeout > 0)) {
+	sfc_writel(SFC_RESET, SFC_RCVR);
+	while ((sfc_readl(SFC_RCVR) == SFC_RESET) && (timeout > 0)) {
 		sfc_delay(1);
 		timeout--;
 	}
-	writel(0xFFFFFFFF, g_sfc_reg + SFC_ICLR);
+	sfc_writel(0xFFFFFFFF, SFC_ICLR);
 }
 
 u16 sfc_get_version(void)
 {
-	return  (u32)(readl(g_sfc_reg + SFC_VER) & 0xffff);
+	return  (u32)(sfc_readl(SFC_VER) & 0xffff);
 }
 
 int sfc_init(void __iomem *reg_addr)
 {
 	g_sfc_reg = reg_addr;
 	sfc_reset();
-	writel(0, g_sfc_reg + SFC_CTRL);
+	sfc_writel(0, SFC_CTRL);
 
 	return SFC_OK;
 }
 
 void sfc_clean_irq(void)
 {
-	writel(0xFFFFFFFF, g_sfc_reg + SFC_ICLR);
-	writel(0xFFFFFFFF, g_sfc_reg + SFC_IMR);
+	sfc_writel(0xFFFFFFFF, SFC_ICLR);
+	sfc_writel(0xFFFFFFFF, SFC_IMR);
 }
 
 int sfc_request(u32 sfcmd, u32 sfctrl, u32 addr, void *data)
@@ -52,9 +62,9 @@ int sfc_request(u32 sfcmd, u32 sfctrl, u32 addr, void *data)
 	int reg;
 	int timeout = 0;
 
-	reg = readl(g_sfc_reg + SFC_FSR);
+	reg = sfc_readl(SFC_FSR);
 	if (!(reg & SFC_TXEMPTY) || !(reg & SFC_RXEMPTY) ||
-	    (readl(g_sfc_reg + SFC_SR) & SFC_BUSY))
+	    (sfc_readl(SFC_SR) & SFC_BUSY))
 		sfc_reset();
 
 	cmd.d32 = sfcmd;
@@ -65,15 +75,15 @@ int sfc_request(u32 sfcmd, u32 sfctrl, u32 addr, void *data)
 		if (!ctrl.b.addrbits)
 			return SFC_PARAM_ERR;
 		/* Controller plus 1 automatically */
-		writel(ctrl.b.addrbits - 1, g_sfc_reg + SFC_ABIT);
+		sfc_writel(ctrl.b.addrbits - 1, SFC_ABIT);
 	}
 	/* shift in the data at negedge sclk_out */
 	sfctrl |= 0x2;
 
-	writel(sfctrl, g_sfc_reg + SFC_CTRL);
-	writel(sfcmd, g_sfc_reg + SFC_CMD);
+	sfc_writel(sfctrl, SFC_CTRL);
+	sfc_writel(sfcmd, SFC_CMD);
 	if (cmd.b.addrbits)
-		writel(addr, g_sfc_reg + SFC_ADDR);
+		sfc_writel(addr, SFC_ADDR);
 	if (!cmd.b.datasize)
 		goto exit_wait;
 	if (SFC_ENABLE_DMA & sfctrl) {
@@ -85,20 +95,24 @@ int sfc_request(u32 sfcmd, u32 sfctrl, u32 addr, void *data)
 		else
 			bb_flags = GEN_BB_WRITE;
 
+		/*
+		 * A cache-line aligned buffer is handed to the controller as
+		 * it is; only unaligned ones are copied through a bounce buffer
+		 */
 		ret = bounce_buffer_start(&bb, data, cmd.b.datasize, bb_flags);
 		if (ret)
 			return ret;
 
-		writel(0xFFFFFFFF, g_sfc_reg + SFC_ICLR);
-		writel(~((u32)FINISH_INT), g_sfc_reg + SFC_IMR);
-		writel((unsigned long)bb.bounce_buffer, g_sfc_reg + SFC_DMA_ADDR);
-		writel(SFC_DMA_START, g_sfc_reg + SFC_DMA_TRIGGER);
+		sfc_writel(0xFFFFFFFF, SFC_ICLR);
+		sfc_writel(~((u32)FINISH_INT), SFC_IMR);
+		sfc_writel(map_to_sysmem(bb.bounce_buffer), SFC_DMA_ADDR);
+		sfc_writel(SFC_DMA_START, SFC_DMA_TRIGGER);
 
 		timeout = cmd.b.datasize * 10;
-		while ((readl(g_sfc_reg + SFC_SR) & SFC_BUSY) &&
+		while ((sfc_readl(SFC_SR) & SFC_BUSY) &&
 		       (timeout-- > 0))
 			sfc_delay(1);
-		writel(0xFFFFFFFF, g_sfc_reg + SFC_ICLR);
+		sfc_writel(0xFFFFFFFF, SFC_ICLR);
 		if (timeout <= 0)
 			ret = SFC_WAIT_TIMEOUT;
 		bounce_buffer_stop(&bb);
@@ -110,13 +124,12 @@ int sfc_request(u32 sfcmd, u32 sfctrl, u32 addr, void *data)
 		if (cmd.b.rw == SFC_WRITE) {
 			words  = (cmd.b.datasize + 3) >> 2;
 			while (words) {
-				fifostat.d32 = readl(g_sfc_reg + SFC_FSR);
+				fifostat.d32 = sfc_readl(SFC_FSR);
 				if (fifostat.b.txlevel > 0) {
 					count = words < fifostat.b.txlevel ?
 						words : fifostat.b.txlevel;
 					for (i = 0; i < count; i++) {
-						writel(*p_data++,
-						       g_sfc_reg + SFC_DATA);
+						sfc_writel(*p_data++, SFC_DATA);
 						words--;
 					}
 					if (words == 0)
@@ -135,7 +148,7 @@ int sfc_request(u32 sfcmd, u32 sfctrl, u32 addr, void *data)
 			bytes = cmd.b.datasize & 0x3;
 			words = cmd.b.datasize >> 2;
 			while (words) {
-				fifostat.d32 = readl(g_sfc_reg + SFC_FSR);
+				fifostat.d32 = sfc_readl(SFC_FSR);
 				if (fifostat.b.rxlevel > 0) {
 					u32 count;
 
@@ -143,8 +156,7 @@ int sfc_request(u32 sfcmd, u32 sfctrl, u32 addr, void *data)
 						words : fifostat.b.rxlevel;
 
 					for (i = 0; i < count; i++) {
-						*p_data++ = readl(g_sfc_reg +
-								  SFC_DATA);
+						*p_data++ = sfc_readl(SFC_DATA);
 						words--;
 					}
 					if (words == 0)
@@ -161,11 +173,11 @@ int sfc_request(u32 sfcmd, u32 sfctrl, u32 addr, void *data)
 
 			timeout = 0;
 			while (bytes) {
-				fifostat.d32 = readl(g_sfc_reg + SFC_FSR);
+				fifostat.d32 = sfc_readl(SFC_FSR);
 				if (fifostat.b.rxlevel > 0) {
 					u8 *p_data1 = (u8 *)p_data;
 
-					words = readl(g_sfc_reg + SFC_DATA);
+					words = sfc_readl(SFC_DATA);
 					for (i = 0; i < bytes; i++)
 						p_data1[i] =
 						(u8)((words >> (i * 8)) & 0xFF);
@@ -183,7 +195,7 @@ int sfc_request(u32 sfcmd, u32 sfctrl, u32 addr, void *data)
 
 exit_wait:
 	timeout = 0;    /* wait cmd or data send complete */
-	while (!(readl(g_sfc_reg + SFC_FSR) & SFC_TXEMPTY)) {
+	while (!(sfc_readl(SFC_FSR) & SFC_TXEMPTY)) {
 		sfc_delay(1);
 		if (timeout++ > 100000) {         /* wait 100ms */
 			ret = SFC_TX_TIMEOUT;
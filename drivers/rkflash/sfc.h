@@ -10,6 +10,8 @@
 #define SFC_VER_3		0x3 /* ver 3, else ver 1 */
 
 #define SFC_MAX_IOSIZE		(1024 * 8)    /* 8K byte */
+/* Largest whole-sector transfer the 14-bit SFC_CMD datasize can describe */
+#define SFC_MAX_XFER_SIZE	(0x3FFF & ~511)	/* 15.5K byte */
 #define SFC_EN_INT		(0)         /* enable interrupt */
 #define SFC_EN_DMA		(1)         /* enable dma */
 #define SFC_FIFO_DEPTH		(0x10)      /* 16 words */
@@ -174,4 +176,67 @@ u16 sfc_get_version(void);
 void sfc_clean_irq(void);
 int rksfc_get_reg_addr(unsigned long *p_sfc_addr);
 
+#ifdef CONFIG_SANDBOX
+/**
+ * struct sandbox_sfc_stats - what the sandbox SFC model has seen
+ *
+ * @dma_xfers:		Number of transfers started with SFC_DMA_TRIGGER
+ * @dma_bytes:		Bytes moved by those transfers
+ * @pio_words:		Words moved through SFC_DATA
+ * @last_dma_addr:	SFC_DMA_ADDR of the last DMA transfer
+ * @errors:		Commands sent with the wrong address bits, dummy
+ *			cycles or data lines for the flash state
+ * @nand_page_reads:	SPI Nand page reads (13h)
+ * @nand_cache_reads:	SPI Nand cache reads (31h and 3Fh)
+ */
+struct sandbox_sfc_stats {
+	ulong dma_xfers;
+	ulong dma_bytes;
+	ulong pio_words;
+	ulong last_dma_addr;
+	ulong errors;
+	ulong nand_page_reads;
+	ulong nand_cache_reads;
+};
+
+u32 sandbox_sfc_readl(u32 reg);
+void sandbox_sfc_writel(u32 val, u32 reg);
+
+/**
+ * sandbox_sfc_set_chip() - attach an emulated SPI NOR to the sandbox SFC
+ *
+ * The flash starts erased, in 3-byte address mode with QE clear.
+ *
+ * @id:		JEDEC ID returned by 0x9F
+ * @size:	Size in bytes, a power of two
+ * @qe_bit:	Quad enable bit, as bit number across status registers 1-3
+ * @return pointer to the flash contents, NULL if out of memory
+ */
+u8 *sandbox_sfc_set_chip(u32 id, u32 size, int qe_bit);
+
+/**
+ * sandbox_sfc_set_nand() - attach an emulated SPI Nand to the sandbox SFC
+ *
+ * Pages are 2048 bytes of data and 64 of spare, stored one after the other
+ * in the returned buffer; blocks are 64 pages. The flash starts erased,
+ * with QE clear and every page reporting no bit errors.
+ *
+ * @id:		Manufacturer and device ID returned by 0x9F
+ * @blocks:	Number of blocks
+ * @qe_bit:	Quad enable bit in feature register B0h, -1 if none
+ * @return pointer to the flash contents, NULL if out of memory
+ */
+u8 *sandbox_sfc_set_nand(u32 id, u32 blocks, int qe_bit);
+
+/**
+ * sandbox_sfc_nand_set_ecc() - set the ECC status reported for a page
+ *
+ * @page:	Page address
+ * @ecc:	Value of the ECC bits in feature register C0h
+ */
+void sandbox_sfc_nand_set_ecc(u32 page, u8 ecc);
+
+struct sandbox_sfc_stats *sandbox_sfc_get_stats(void);
+#endif
+
 #endif
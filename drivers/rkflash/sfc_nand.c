@@ -28,7 +28,7 @@ static struct nand_info spi_nand_tbl[] = {
 	/* GD5F1GQ4UAYIG */
 	{0xC8F1, 4, 64, 1, 1024, 0x13, 0x10, 0x03, 0x02, 0x6B, 0x32, 0xD8, 0x0C, 18, 8, 0xB0, 0, 4, 8, NULL},
 	/* MT29F1G01ZAC */
-	{0x2C12, 4, 64, 1, 1024, 0x13, 0x10, 0x03, 0x02, 0x6B, 0x32, 0xD8, 0x00, 18, 1, 0xB0, 0, 4, 8, &sfc_nand_ecc_status_sp1},
+	{0x2C12, 4, 64, 1, 1024, 0x13, 0x10, 0x03, 0x02, 0x6B, 0x32, 0xD8, 0x40, 18, 1, 0xB0, 0, 4, 8, &sfc_nand_ecc_status_sp1},
 	/* GD5F2GQ40BY2GR */
 	{0xC8D2, 4, 64, 2, 1024, 0x13, 0x10, 0x03, 0x02, 0x6B, 0x32, 0xD8, 0x0C, 19, 8, 0xB0, 0, 4, 8, &sfc_nand_ecc_status_sp3},
 	/* GD5F1GQ4U */
@@ -59,6 +59,10 @@ static u8 id_byte[8];
 static struct nand_info *p_nand_info;
 static u32 gp_page_buf[SFC_NAND_PAGE_MAX_SIZE / 4];
 static struct SFNAND_DEV sfc_nand_dev;
+/* Page the flash is loading into its data register after a cache read */
+static u32 sfc_nand_seq_page = INVALID_UINT32;
+/* Last page read through the FTL hook */
+static u32 sfc_nand_last_page = INVALID_UINT32;
 
 static struct nand_info *spi_nand_get_info(u8 *nand_id)
 {
@@ -271,12 +275,42 @@ u32 sfc_nand_ecc_status_sp3(void)
 	return ret;
 }
 
+static int sfc_nand_read_cmd(u8 cmd, u32 addrbits, u32 addr)
+{
+	union SFCCMD_DATA sfcmd;
+
+	sfcmd.d32 = 0;
+	sfcmd.b.cmd = cmd;
+	sfcmd.b.datasize = 0;
+	sfcmd.b.addrbits = addrbits;
+
+	return sfc_request(sfcmd.d32, 0, addr, NULL);
+}
+
+/*
+ * A sequential cache read (31h) keeps the array busy loading the next page,
+ * so it has to be ended with 3Fh before any other page read, program or
+ * erase is sent.
+ */
+static int sfc_nand_end_seq(void)
+{
+	u8 status;
+
+	if (sfc_nand_seq_page == INVALID_UINT32)
+		return SFC_OK;
+	sfc_nand_seq_page = INVALID_UINT32;
+	sfc_nand_read_cmd(CMD_READ_CACHE_END, SFC_ADDR_0BITS, 0);
+
+	return sfc_nand_wait_busy(&status, 1000 * 1000);
+}
+
 static u32 sfc_nand_erase_block(u8 cs, u32 addr)
 {
 	int ret;
 	union SFCCMD_DATA sfcmd;
 	u8 status;
 
+	sfc_nand_end_seq();
 	sfcmd.d32 = 0;
 	sfcmd.b.cmd = p_nand_info->block_erase_cmd;
 	sfcmd.b.addrbits = SFC_ADDR_24BITS;
@@ -300,6 +334,7 @@ static u32 sfc_nand_prog_page(u8 cs, u32 addr, u32 *p_data, u32 *p_spare)
 	u32 spare_offs_1 = p_nand_info->spare_offs_1;
 	u32 spare_offs_2 = p_nand_info->spare_offs_2;
 
+	sfc_nand_end_seq();
 	memcpy(gp_page_buf, p_data, data_sz);
 	gp_page_buf[(data_sz + spare_offs_1) / 4] = p_spare[0];
 	gp_page_buf[(data_sz + spare_offs_2) / 4] = p_spare[1];
@@ -335,27 +370,57 @@ static u32 sfc_nand_prog_page(u8 cs, u32 addr, u32 *p_data, u32 *p_spare)
 	return ret;
 }
 
-static u32 sfc_nand_read_page(u8 cs, u32 addr, u32 *p_data, u32 *p_spare)
+static u32 sfc_nand_get_ecc(void)
+{
+	if (p_nand_info->ecc_status)
+		return p_nand_info->ecc_status();
+
+	return sfc_nand_ecc_status();
+}
+
+/*
+ * Bring page @addr into the cache register and return its ECC status.
+ *
+ * With @more set, and when the flash can read the cache sequentially, the
+ * flash is also told to load the next page of the block into its data
+ * register while this one is clocked out, so that a following load of that
+ * page only has to move it across to the cache.
+ */
+static u32 sfc_nand_load_page(u32 addr, bool more)
+{
+	u8 status;
+	u8 cmd;
+
+	more = more && (p_nand_info->feature & FEA_CACHE_READ) &&
+	       (addr + 1) % p_nand_info->page_per_blk;
+
+	if (addr != sfc_nand_seq_page) {
+		sfc_nand_end_seq();
+		sfc_nand_read_cmd(p_nand_info->page_read_cmd, SFC_ADDR_24BITS,
+				  addr);
+		if (!more)
+			return sfc_nand_get_ecc();
+		if (sfc_nand_wait_busy(&status, 1000 * 1000))
+			return SFC_NAND_ECC_ERROR;
+	}
+	cmd = more ? CMD_READ_CACHE_SEQ : CMD_READ_CACHE_END;
+	sfc_nand_read_cmd(cmd, SFC_ADDR_0BITS, 0);
+	sfc_nand_seq_page = more ? addr + 1 : INVALID_UINT32;
+
+	return sfc_nand_get_ecc();
+}
+
+/* Clock the page in the cache register out to @p_data and @p_spare */
+static u32 sfc_nand_read_cache(u32 addr, u32 *p_data, u32 *p_spare,
+			       u32 ecc_result)
 {
 	int ret;
 	union SFCCMD_DATA sfcmd;
 	union SFCCTRL_DATA sfctrl;
-	u32 ecc_result;
 	u32 data_sz = 2048;
 	u32 spare_offs_1 = p_nand_info->spare_offs_1;
 	u32 spare_offs_2 = p_nand_info->spare_offs_2;
 
-	sfcmd.d32 = 0;
-	sfcmd.b.cmd = p_nand_info->page_read_cmd;
-	sfcmd.b.datasize = 0;
-	sfcmd.b.addrbits = SFC_ADDR_24BITS;
-	sfc_request(sfcmd.d32, 0, addr, p_data);
-
-	if (p_nand_info->ecc_status)
-		ecc_result = p_nand_info->ecc_status();
-	else
-		ecc_result = sfc_nand_ecc_status();
-
 	if (sfc_nand_dev.read_lines == DATA_LINES_X4 &&
 	    p_nand_info->QE_address == 0xFF &&
 	    sfc_get_version() != SFC_VER_3)
@@ -372,8 +437,10 @@ static u32 sfc_nand_read_page(u8 cs, u32 addr, u32 *p_data, u32 *p_spare)
 	ret = sfc_request(sfcmd.d32, sfctrl.d32, 0, gp_page_buf);
 
 	memcpy(p_data, gp_page_buf, data_sz);
-	p_spare[0] = gp_page_buf[(data_sz + spare_offs_1) / 4];
-	p_spare[1] = gp_page_buf[(data_sz + spare_offs_2) / 4];
+	if (p_spare) {
+		p_spare[0] = gp_page_buf[(data_sz + spare_offs_1) / 4];
+		p_spare[1] = gp_page_buf[(data_sz + spare_offs_2) / 4];
+	}
 	if (ret != SFC_OK)
 		return SFC_NAND_ECC_ERROR;
 
@@ -387,6 +454,56 @@ static u32 sfc_nand_read_page(u8 cs, u32 addr, u32 *p_data, u32 *p_spare)
 	return ecc_result;
 }
 
+/*
+ * The FTL reads one page at a time, so a page read straight after the one
+ * before it is taken as the start of a sequential run and the next page is
+ * loaded ahead.
+ */
+static u32 sfc_nand_read_page(u8 cs, u32 addr, u32 *p_data, u32 *p_spare)
+{
+	u32 ecc_result;
+	bool more;
+
+	more = addr == sfc_nand_seq_page ||
+	       (sfc_nand_last_page != INVALID_UINT32 &&
+		addr == sfc_nand_last_page + 1);
+	sfc_nand_last_page = addr;
+	ecc_result = sfc_nand_load_page(addr, more);
+
+	return sfc_nand_read_cache(addr, p_data, p_spare, ecc_result);
+}
+
+u32 sfc_nand_read_pages(u32 addr, u32 n_pages, u32 *p_data, u32 *p_spare,
+			struct sfc_nand_batch_ecc *ecc)
+{
+	u32 ecc_result, ret = SFC_NAND_ECC_OK;
+	u32 i;
+
+	ecc->refresh = 0;
+	ecc->failed = 0;
+	ecc->first_failed = INVALID_UINT32;
+	if (!n_pages)
+		return ret;
+	for (i = 0; i < n_pages; i++) {
+		ecc_result = sfc_nand_load_page(addr + i, i + 1 < n_pages);
+		ecc_result = sfc_nand_read_cache(addr + i, p_data + i * 512,
+						 p_spare ? p_spare + i * 2 :
+						 NULL, ecc_result);
+		if (ecc_result == SFC_NAND_ECC_REFRESH) {
+			ecc->refresh++;
+			if (ret == SFC_NAND_ECC_OK)
+				ret = SFC_NAND_ECC_REFRESH;
+		} else if (ecc_result != SFC_NAND_ECC_OK) {
+			if (!ecc->failed++)
+				ecc->first_failed = addr + i;
+			ret = SFC_NAND_ECC_ERROR;
+		}
+	}
+	sfc_nand_last_page = addr + n_pages - 1;
+
+	return ret;
+}
+
 static int sfc_nand_read_id_raw(u8 *data)
 {
 	int ret;
@@ -580,6 +697,8 @@ u32 sfc_nand_init(void)
 	if (!p_nand_info)
 		return FTL_UNSUPPORTED_FLASH;
 
+	sfc_nand_seq_page = INVALID_UINT32;
+	sfc_nand_last_page = INVALID_UINT32;
 	sfc_nand_dev.manufacturer = id_byte[0];
 	sfc_nand_dev.mem_type = id_byte[1];
 
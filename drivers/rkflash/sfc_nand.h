@@ -24,6 +24,8 @@
 #define FEA_4BIT_PROG           BIT(3)
 #define FEA_4BYTE_ADDR          BIT(4)
 #define FEA_4BYTE_ADDR_MODE	BIT(5)
+/* Page read cache sequential (31h) and page read cache end (3Fh) */
+#define FEA_CACHE_READ		BIT(6)
 
 #define MID_WINBOND             0xEF
 #define MID_GIGADEV             0xC8
@@ -46,6 +48,8 @@
 #define CMD_WRITE_EN            (0x06)
 #define CMD_WRITE_DIS           (0x04)
 #define CMD_PAGE_READ           (0x13)
+#define CMD_READ_CACHE_SEQ      (0x31)
+#define CMD_READ_CACHE_END      (0x3F)
 #define CMD_GET_FEATURE         (0x0F)
 #define CMD_SET_FEATURE         (0x1F)
 #define CMD_PROG_LOAD           (0x02)
@@ -117,6 +121,20 @@ struct nand_info {
 	u32 (*ecc_status)(void);
 };
 
+/**
+ * struct sfc_nand_batch_ecc - ECC results of a sfc_nand_read_pages() call
+ *
+ * @refresh:		Pages corrected with enough bit flips to need rewriting
+ * @failed:		Pages which could not be corrected
+ * @first_failed:	Address of the first page which could not be
+ *			corrected, INVALID_UINT32 if none
+ */
+struct sfc_nand_batch_ecc {
+	u32 refresh;
+	u32 failed;
+	u32 first_failed;
+};
+
 extern struct nand_phy_info	g_nand_phy_info;
 extern struct nand_ops		g_nand_ops;
 
@@ -126,4 +144,22 @@ int sfc_nand_read_id(u8 *buf);
 u32 sfc_nand_ecc_status_sp1(void);
 u32 sfc_nand_ecc_status_sp3(void);
 
+/**
+ * sfc_nand_read_pages() - read a run of pages
+ *
+ * On flashes with FEA_CACHE_READ each page after the first is loaded while
+ * the one before it is clocked out. A run may cross blocks; the pipeline is
+ * restarted at each block boundary.
+ *
+ * @addr:	Address of the first page
+ * @n_pages:	Number of pages
+ * @p_data:	Buffer for n_pages * 2048 bytes of data
+ * @p_spare:	Buffer for two spare words per page, or NULL
+ * @ecc:	Returns the ECC results of the whole run
+ * @return SFC_NAND_ECC_OK, SFC_NAND_ECC_REFRESH if a page needs
+ * rewriting, or SFC_NAND_ECC_ERROR if a page could not be read
+ */
+u32 sfc_nand_read_pages(u32 addr, u32 n_pages, u32 *p_data, u32 *p_spare,
+			struct sfc_nand_batch_ecc *ecc);
+
 #endif
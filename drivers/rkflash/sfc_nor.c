@@ -3,6 +3,7 @@
  *
  * SPDX-License-Identifier:	GPL-2.0
  */
+#include <malloc.h>
 #include <linux/compat.h>
 #include <linux/delay.h>
 #include <linux/kernel.h>
@@ -34,7 +35,7 @@ static struct flash_info spi_flash_tbl[] = {
 	/* XT25F128A */
 	{0x207018, 128, 8, 0x03, 0x02, 0x6B, 0x32, 0x20, 0xD8, 0x00, 15, 0, 0},
 	/* MX25L25635E/F */
-	{0xc22019, 128, 8, 0x03, 0x02, 0x6B, 0x38, 0x20, 0xD8, 0x30, 16, 6, 0},
+	{0xc22019, 128, 8, 0x03, 0x02, 0x6B, 0x38, 0x20, 0xD8, 0x34, 16, 6, 0},
 	/* XM25QH64A */
 	{0x207017, 128, 8, 0x03, 0x02, 0x6B, 0x32, 0x20, 0xD8, 0x0C, 14, 0, 0},
 	/* XM25QH128A */
@@ -68,6 +69,9 @@ static const u32 sfnor_capacity[] = {
 };
 
 static struct flash_info *g_spi_flash_info;
+static struct snor_write_stats g_snor_write_stats;
+/* One 64K block of flash contents, for snor_write() to compare against */
+static u8 *g_snor_blk_buf;
 
 static int snor_write_en(void)
 {
@@ -191,7 +195,7 @@ static int snor_erase(struct SFNOR_DEV *p_dev,
 {
 	int ret;
 	union SFCCMD_DATA sfcmd;
-	int timeout[] = {400, 2000, 40000};   /* ms */
+	int timeout[] = {400, 1600, 2000, 40000};   /* ms */
 
 	if (erase_type > ERASE_CHIP)
 		return SFC_PARAM_ERR;
@@ -199,6 +203,9 @@ static int snor_erase(struct SFNOR_DEV *p_dev,
 	sfcmd.d32 = 0;
 	if (erase_type == ERASE_BLOCK64K)
 		sfcmd.b.cmd = p_dev->blk_erase_cmd;
+	else if (erase_type == ERASE_BLOCK32K)
+		sfcmd.b.cmd = p_dev->blk_erase_cmd == CMD_BLK64K_ERASE_4B ?
+			      CMD_BLK32K_ERASE_4B : CMD_BLK32K_ERASE;
 	else if (erase_type == ERASE_SECTOR)
 		sfcmd.b.cmd = p_dev->sec_erase_cmd;
 	else
@@ -262,7 +269,9 @@ static int snor_prog(struct SFNOR_DEV *p_dev, u32 addr, void *p_data, u32 size)
 
 	page_size = NOR_PAGE_SIZE;
 	while (size) {
-		len = page_size < size ? page_size : size;
+		/* A page program wraps at the end of the page */
+		len = page_size - (addr & (page_size - 1));
+		len = len < size ? len : size;
 		ret = snor_prog_page(p_dev, addr, p_buf, len);
 		if (ret != SFC_OK)
 			return ret;
@@ -283,7 +292,8 @@ static int snor_enable_QE(struct SFNOR_DEV *p_dev)
 	u8 status;
 
 	if (p_dev->manufacturer == MID_GIGADEV ||
-	    p_dev->manufacturer == MID_WINBOND) {
+	    p_dev->manufacturer == MID_WINBOND ||
+	    p_dev->manufacturer == MID_MACRONIX) {
 		reg_index = p_dev->QE_bits >> 3;
 		bit_offset = p_dev->QE_bits & 0x7;
 		ret = snor_read_status(reg_index, &status);
@@ -351,8 +361,8 @@ static int snor_read_data(struct SFNOR_DEV *p_dev,
 
 	sfctrl.d32 = 0;
 	sfctrl.b.datalines = p_dev->read_lines;
-	if (!(size & 0x3) && size >= 4)
-		sfctrl.b.enbledma = 0;
+	if (SFC_EN_DMA && !(size & 0x3) && size >= 4)
+		sfctrl.b.enbledma = 1;
 
 	if (p_dev->read_cmd == CMD_FAST_READ_X1 ||
 	    p_dev->read_cmd == CMD_FAST_READ_X4 ||
@@ -374,32 +384,40 @@ static int snor_read_data(struct SFNOR_DEV *p_dev,
 	return ret;
 }
 
-int snor_read(struct SFNOR_DEV *p_dev, u32 sec, u32 n_sec, void *p_data)
+static int snor_read_bytes(struct SFNOR_DEV *p_dev,
+			   u32 addr,
+			   u8 *p_buf,
+			   u32 size)
 {
 	int ret = SFC_OK;
-	u32 addr, size, len;
-	u8 *p_buf =  (u8 *)p_data;
+	u32 len;
 
-	if ((sec + n_sec) > p_dev->capacity)
-		return SFC_PARAM_ERR;
-
-	mutex_lock(&p_dev->lock);
-	addr = sec << 9;
-	size = n_sec << 9;
 	while (size) {
-		len = size < SFC_MAX_IOSIZE ? size : SFC_MAX_IOSIZE;
+		len = size < SFC_MAX_XFER_SIZE ? size : SFC_MAX_XFER_SIZE;
 		ret = snor_read_data(p_dev, addr, p_buf, len);
 		if (ret != SFC_OK) {
 			PRINT_SFC_E("snor_read_data %x ret= %x\n",
 				    addr >> 9, ret);
-			goto out;
+			return ret;
 		}
 
 		size -= len;
 		addr += len;
 		p_buf += len;
 	}
-out:
+
+	return ret;
+}
+
+int snor_read(struct SFNOR_DEV *p_dev, u32 sec, u32 n_sec, void *p_data)
+{
+	int ret;
+
+	if ((sec + n_sec) > p_dev->capacity)
+		return SFC_PARAM_ERR;
+
+	mutex_lock(&p_dev->lock);
+	ret = snor_read_bytes(p_dev, sec << 9, p_data, n_sec << 9);
 	mutex_unlock(&p_dev->lock);
 	if (!ret)
 		ret = n_sec;
@@ -407,52 +425,198 @@ out:
 	return ret;
 }
 
+/* Check whether writing @new over @old needs a bit set that @old has clear */
+static bool snor_need_erase(const u8 *old, const u8 *new, u32 size)
+{
+	u32 i;
+
+	for (i = 0; i < size; i++) {
+		if ((old[i] & new[i]) != new[i])
+			return true;
+	}
+
+	return false;
+}
+
+static bool snor_page_same(const u8 *old, const u8 *new, u32 len)
+{
+	u32 i;
+
+	if (old)
+		return !memcmp(old, new, len);
+	for (i = 0; i < len; i++) {
+		if (new[i] != 0xFF)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Program the pages of [addr, addr + size) whose data differs from @old,
+ * or from erased flash if @old is NULL
+ */
+static int snor_prog_changed(struct SFNOR_DEV *p_dev,
+			     u32 addr,
+			     const u8 *new,
+			     const u8 *old,
+			     u32 size)
+{
+	int ret;
+	u32 len;
+
+	while (size) {
+		len = NOR_PAGE_SIZE - (addr & (NOR_PAGE_SIZE - 1));
+		len = len < size ? len : size;
+		if (!snor_page_same(old, new, len)) {
+			ret = snor_prog(p_dev, addr, (void *)new, len);
+			if (ret != SFC_OK)
+				return ret;
+			g_snor_write_stats.prog_bytes += len;
+		} else if (old) {
+			g_snor_write_stats.skip_bytes += len;
+		}
+
+		size -= len;
+		addr += len;
+		new += len;
+		if (old)
+			old += len;
+	}
+
+	return SFC_OK;
+}
+
+/*
+ * Write [addr, addr + size), which lies within one 64K block. The 4K
+ * sectors it covers are read first. Where the new data only clears bits,
+ * the pages which change are programmed in place. The other sectors are
+ * erased, 64K or 32K at a time when a whole aligned run of them needs it,
+ * and programmed back with the new data merged into the old.
+ */
+static int snor_write_block(struct SFNOR_DEV *p_dev,
+			    u32 addr,
+			    const u8 *p_data,
+			    u32 size)
+{
+	struct snor_write_stats *stats = &g_snor_write_stats;
+	u32 blk = rounddown(addr, NOR_BLOCK_SIZE);
+	u32 start = rounddown(addr, NOR_SECTOR_SIZE);
+	u32 end = roundup(addr + size, NOR_SECTOR_SIZE);
+	u32 sec_addr, ws, we, i, run;
+	u32 erase = 0;
+	enum NOR_ERASE_TYPE type;
+	const u8 *new;
+	u8 *old;
+	int ret;
+
+	ret = snor_read_bytes(p_dev, start, g_snor_blk_buf + (start - blk),
+			      end - start);
+	if (ret != SFC_OK)
+		return ret;
+
+	for (sec_addr = start; sec_addr < end; sec_addr += NOR_SECTOR_SIZE) {
+		ws = max(addr, sec_addr);
+		we = min(addr + size, sec_addr + NOR_SECTOR_SIZE);
+		old = g_snor_blk_buf + (ws - blk);
+		new = p_data + (ws - addr);
+		if (snor_need_erase(old, new, we - ws)) {
+			erase |= BIT((sec_addr - blk) / NOR_SECTOR_SIZE);
+			memcpy(old, new, we - ws);
+			continue;
+		}
+		ret = snor_prog_changed(p_dev, ws, new, old, we - ws);
+		if (ret != SFC_OK)
+			return ret;
+	}
+
+	for (i = 0; i < NOR_SECTORS_BLK; i += run) {
+		run = 1;
+		if (!(erase & BIT(i)))
+			continue;
+		if (erase == BIT(NOR_SECTORS_BLK) - 1) {
+			run = NOR_SECTORS_BLK;
+			type = ERASE_BLOCK64K;
+			stats->erase_64k++;
+		} else if (!(i % 8) && ((erase >> i) & 0xff) == 0xff) {
+			run = 8;
+			type = ERASE_BLOCK32K;
+			stats->erase_32k++;
+		} else {
+			type = ERASE_SECTOR;
+			stats->erase_4k++;
+		}
+		ret = snor_erase(p_dev, blk + i * NOR_SECTOR_SIZE, type);
+		if (ret != SFC_OK)
+			return ret;
+		ret = snor_prog_changed(p_dev, blk + i * NOR_SECTOR_SIZE,
+					g_snor_blk_buf + i * NOR_SECTOR_SIZE,
+					NULL, run * NOR_SECTOR_SIZE);
+		if (ret != SFC_OK)
+			return ret;
+	}
+
+	return SFC_OK;
+}
+
 int snor_write(struct SFNOR_DEV *p_dev, u32 sec, u32 n_sec, const void *p_data)
 {
 	int ret = SFC_OK;
-	u32 len, blk_size, offset;
-	u8 *p_buf =  (u8 *)p_data;
-	u32 total_sec = n_sec;
+	u32 addr, size, len;
+	const u8 *p_buf = p_data;
 
 	if ((sec + n_sec) > p_dev->capacity)
 		return SFC_PARAM_ERR;
 
+	if (!g_snor_blk_buf) {
+		g_snor_blk_buf = memalign(ARCH_DMA_MINALIGN, NOR_BLOCK_SIZE);
+		if (!g_snor_blk_buf)
+			return SFC_ERROR;
+	}
+
 	mutex_lock(&p_dev->lock);
-	while (n_sec) {
-		if (sec < 512 || sec >= p_dev->capacity  - 512)
-			blk_size = 8;
-		else
-			blk_size = p_dev->blk_size;
-
-		offset = (sec & (blk_size - 1));
-		if (!offset) {
-			ret = snor_erase(p_dev, sec << 9, (blk_size == 8) ?
-				ERASE_SECTOR : ERASE_BLOCK64K);
-			if (ret != SFC_OK) {
-				PRINT_SFC_E("snor_erase %x ret= %x\n",
-					    sec, ret);
-				goto out;
-			}
-		}
-		len = (blk_size - offset) < n_sec ?
-		      (blk_size - offset) : n_sec;
-		ret = snor_prog(p_dev, sec << 9, p_buf, len << 9);
+	addr = sec << 9;
+	size = n_sec << 9;
+	g_snor_write_stats.write_bytes += size;
+	while (size) {
+		len = NOR_BLOCK_SIZE - (addr & (NOR_BLOCK_SIZE - 1));
+		len = len < size ? len : size;
+		ret = snor_write_block(p_dev, addr, p_buf, len);
 		if (ret != SFC_OK) {
-			PRINT_SFC_E("snor_prog %x ret= %x\n", sec, ret);
+			PRINT_SFC_E("snor_write_block %x ret= %x\n",
+				    addr >> 9, ret);
 			goto out;
 		}
-		n_sec -= len;
-		sec += len;
-		p_buf += len << 9;
+
+		size -= len;
+		addr += len;
+		p_buf += len;
 	}
 out:
 	mutex_unlock(&p_dev->lock);
 	if (!ret)
-		ret = total_sec;
+		ret = n_sec;
 
 	return ret;
 }
 
+const struct snor_write_stats *snor_get_write_stats(void)
+{
+	return &g_snor_write_stats;
+}
+
+void snor_print_write_stats(void)
+{
+	const struct snor_write_stats *s = &g_snor_write_stats;
+
+	printf("SPI Nor writes since boot:\n");
+	printf("  requested:  %llu bytes\n", s->write_bytes);
+	printf("  unchanged:  %llu bytes\n", s->skip_bytes);
+	printf("  programmed: %llu bytes\n", s->prog_bytes);
+	printf("  erased:     %u x 4K, %u x 32K, %u x 64K\n",
+	       s->erase_4k, s->erase_32k, s->erase_64k);
+}
+
 static int snor_read_id(u8 *data)
 {
 	int ret;
@@ -13,9 +13,12 @@
 #define SNOR_4BIT_DATA_DETECT_EN	0
 
 #define NOR_PAGE_SIZE		256
+#define NOR_SECTOR_SIZE		(4 * 1024)
 #define NOR_BLOCK_SIZE		(64 * 1024)
 #define NOR_SECS_BLK		(NOR_BLOCK_SIZE / 512)
 #define NOR_SECS_PAGE		4
+/* 4K erase sectors per 64K block */
+#define NOR_SECTORS_BLK		(NOR_BLOCK_SIZE / NOR_SECTOR_SIZE)
 
 #define FEA_READ_STATUE_MASK	(0x3 << 0)
 #define FEA_STATUE_MODE1	0
@@ -79,9 +82,17 @@
 #define CMD_ENABLE_RESER	(0x66)
 #define CMD_RESET_DEVICE	(0x99)
 #define CMD_READ_PARAMETER	(0x5A)
+/* 4-byte address versions, for parts which are not put in 4-byte mode */
+#define CMD_READ_DATA_4B	(0x13)
+#define CMD_PAGE_PROG_4B	(0x12)
+#define CMD_PAGE_PROG_X4_4B	(0x3E)
+#define CMD_SECTOR_ERASE_4B	(0x21)
+#define CMD_BLK32K_ERASE_4B	(0x5C)
+#define CMD_BLK64K_ERASE_4B	(0xDC)
 
 enum NOR_ERASE_TYPE {
 	ERASE_SECTOR = 0,
+	ERASE_BLOCK32K,
 	ERASE_BLOCK64K,
 	ERASE_CHIP
 };
@@ -146,9 +157,31 @@ struct flash_info {
 	u8 reserved2;
 };
 
+/**
+ * struct snor_write_stats - what snor_write() has done since boot
+ *
+ * @write_bytes:	Bytes passed to snor_write()
+ * @skip_bytes:		Bytes which already held the data being written
+ * @prog_bytes:		Bytes page-programmed, including data put back after
+ *			an erase
+ * @erase_4k:		Number of 4K sector erases
+ * @erase_32k:		Number of 32K block erases
+ * @erase_64k:		Number of 64K block erases
+ */
+struct snor_write_stats {
+	u64 write_bytes;
+	u64 skip_bytes;
+	u64 prog_bytes;
+	u32 erase_4k;
+	u32 erase_32k;
+	u32 erase_64k;
+};
+
 int snor_init(struct SFNOR_DEV *p_dev);
 u32 snor_get_capacity(struct SFNOR_DEV *p_dev);
 int snor_read(struct SFNOR_DEV *p_dev, u32 sec, u32 n_sec, void *p_data);
 int snor_write(struct SFNOR_DEV *p_dev, u32 sec, u32 n_sec, const void *p_data);
+const struct snor_write_stats *snor_get_write_stats(void);
+void snor_print_write_stats(void);
 
 #endif
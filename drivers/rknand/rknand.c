@@ -9,6 +9,7 @@
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/root.h>
+#include <linux/log2.h>
 #include "rknand.h"
 
 struct blk_desc *rknand_get_blk_desc(struct rknand_dev *ndev)
@@ -63,6 +64,7 @@ ulong rknand_bwrite(struct udevice *udev, lbaint_t start,
 	if (ndev->write == NULL)
 		return 0;
 
+	ndev->dirty = true;
 	err = ndev->write(0, (u32)start, (u32)blkcnt, src);
 	if (err)
 		return err;
@@ -86,6 +88,7 @@ ulong rknand_berase(struct udevice *udev, lbaint_t start,
 	if (ndev->erase == NULL)
 		return 0;
 
+	ndev->dirty = true;
 	err = ndev->erase(0, (u32)start, (u32)blkcnt);
 	if (err)
 		return err;
@@ -141,6 +144,11 @@ static int rknand_blk_probe(struct udevice *udev)
 	desc->lba = ndev->density;
 	desc->log2blksz = 9;
 	desc->blksz = 512;
+#ifndef CONFIG_ZFTL
+	/* The FTL reads whole pages, let the block layer make use of them */
+	if (is_power_of_2(c_ftl_nand_sec_pre_page))
+		desc->page_blks = c_ftl_nand_sec_pre_page;
+#endif
 	desc->bdev = udev;
 	desc->devnum = 0;
 	sprintf(desc->vendor, "0x%.4x", 0x2207);
@@ -153,6 +161,7 @@ static int rknand_blk_probe(struct udevice *udev)
 static int rockchip_nand_probe(struct udevice *udev)
 {
 	int ret;
+	ulong start = get_timer(0);
 	struct rknand_dev *ndev = dev_get_priv(udev);
 
 	ndev->ioaddr = dev_read_addr_ptr(udev);
@@ -162,11 +171,31 @@ static int rockchip_nand_probe(struct udevice *udev)
 		ndev->read = ftl_read;
 		ndev->write = ftl_write;
 		ndev->erase = ftl_discard;
+		printf("rknand: FTL init took %lu ms\n", get_timer(start));
 	}
 
 	return ret;
 }
 
+/*
+ * The FTL only writes its mapping tables and system info back to the flash
+ * in rk_ftl_de_init(). If that is skipped after a write, the next init
+ * takes the power-lost recovery path and rebuilds the map by scanning the
+ * blocks which were open, so do it before the OS takes over or the board
+ * is reset.
+ */
+static int rockchip_nand_remove(struct udevice *udev)
+{
+	struct rknand_dev *ndev = dev_get_priv(udev);
+
+	if (!ndev->dirty)
+		return 0;
+
+	ndev->dirty = false;
+
+	return rk_ftl_de_init();
+}
+
 static const struct blk_ops rknand_blk_ops = {
 	.read	= rknand_bread,
 #ifndef CONFIG_SPL_BUILD
@@ -200,6 +229,8 @@ U_BOOT_DRIVER(rknand) = {
 	.of_match	= rockchip_nand_ids,
 	.bind		= rknand_blk_bind,
 	.probe		= rockchip_nand_probe,
+	.remove		= rockchip_nand_remove,
 	.priv_auto_alloc_size = sizeof(struct rknand_dev),
+	.flags		= DM_FLAG_OS_PREPARE,
 };
 
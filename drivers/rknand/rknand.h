@@ -9,7 +9,9 @@
 
 #include <asm/io.h>
 #include <clk.h>
+#ifndef CONFIG_SANDBOX
 #include <asm/arch/clock.h>
+#endif
 
 /* Represents an NVM Express device. Each nvme_dev is a PCI function. */
 struct rknand_dev {
@@ -18,6 +20,8 @@ struct rknand_dev {
 	struct clk nandc_hclk;
 	u32 density;
 	struct udevice *dev;
+	/* The FTL has been written since init and needs rk_ftl_de_init() */
+	bool dirty;
 
 	/*
 	 * read() - read from a block device
@@ -58,5 +62,13 @@ u32 ftl_read(u8 lun, u32 start, u32 blkcnt, void *buffer);
 u32 ftl_discard(u8 lun, u32 start, u32 blkcnt);
 u32 ftl_get_density(u8 lun);
 int rk_ftl_init(u32 *reg_base);
+int rk_ftl_de_init(void);
+/* Sectors per FTL page, set up by rk_ftl_init() */
+extern u16 c_ftl_nand_sec_pre_page;
+
+#ifdef CONFIG_SANDBOX
+/* Number of times the sandbox FTL has been told to write its tables back */
+int sandbox_ftl_get_deinits(void);
+#endif
 
 #endif /* __DRIVER_RKNAND_H__ */
@@ -0,0 +1,69 @@
+/*
+ * Stand-in for the prebuilt Rockchip FTL, for sandbox
+ *
+ * The sectors are kept in memory. Only what the rknand driver relies on is
+ * modelled: the FTL has to be told with rk_ftl_de_init() to write its
+ * tables back, and the number of times that happens is counted.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include "rknand.h"
+
+#define SANDBOX_FTL_SECTORS	2048
+
+u16 c_ftl_nand_sec_pre_page = 4;
+
+static u8 *sandbox_ftl_data;
+static int sandbox_ftl_deinits;
+
+int rk_ftl_init(u32 *reg_base)
+{
+	if (!sandbox_ftl_data) {
+		sandbox_ftl_data = calloc(SANDBOX_FTL_SECTORS, 512);
+		if (!sandbox_ftl_data)
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
+int rk_ftl_de_init(void)
+{
+	sandbox_ftl_deinits++;
+
+	return 0;
+}
+
+u32 ftl_get_density(u8 lun)
+{
+	return SANDBOX_FTL_SECTORS;
+}
+
+u32 ftl_read(u8 lun, u32 start, u32 blkcnt, void *buffer)
+{
+	memcpy(buffer, sandbox_ftl_data + start * 512, blkcnt * 512);
+
+	return 0;
+}
+
+u32 ftl_write(u8 lun, u32 start, u32 blkcnt, const void *buffer)
+{
+	memcpy(sandbox_ftl_data + start * 512, buffer, blkcnt * 512);
+
+	return 0;
+}
+
+u32 ftl_discard(u8 lun, u32 start, u32 blkcnt)
+{
+	memset(sandbox_ftl_data + start * 512, 0xff, blkcnt * 512);
+
+	return 0;
+}
+
+int sandbox_ftl_get_deinits(void)
+{
+	return sandbox_ftl_deinits;
+}
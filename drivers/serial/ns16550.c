@@ -326,8 +326,8 @@ static int ns16550_serial_putc(struct udevice *dev, const char ch)
 	 *	0 = Transmit FIFO is full;
 	 *	1 = Transmit FIFO is not full;
 	 */
-	while (!(serial_in(&com_port->rbr + 0x1f) & 0x02))
-		;
+	if (!(serial_in(&com_port->rbr + 0x1f) & 0x02))
+		return -EAGAIN;
 #else
 	if (!(serial_in(&com_port->lsr) & UART_LSR_THRE))
 		return -EAGAIN;
@@ -228,6 +228,17 @@ void serial_putc(char ch)
 		_serial_putc(gd->cur_serial_dev, ch);
 }
 
+int serial_tryputc(char ch)
+{
+	struct dm_serial_ops *ops;
+
+	if (!gd->cur_serial_dev)
+		return 0;
+	ops = serial_get_ops(gd->cur_serial_dev);
+
+	return ops->putc(gd->cur_serial_dev, ch);
+}
+
 void serial_puts(const char *str)
 {
 	if (gd->cur_serial_dev)
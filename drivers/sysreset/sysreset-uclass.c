@@ -6,6 +6,7 @@
  */
 
 #include <common.h>
+#include <console.h>
 #include <sysreset.h>
 #include <dm.h>
 #include <errno.h>
@@ -70,6 +71,7 @@ void reset_cpu(ulong addr)
 
 int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
+	console_ring_flush();
 	sysreset_walk_halt(SYSRESET_COLD);
 
 	return 0;
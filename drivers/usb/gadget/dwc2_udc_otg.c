@@ -19,6 +19,7 @@
  */
 #undef DEBUG
 #include <common.h>
+#include <dma_map.h>
 #include <linux/errno.h>
 #include <linux/list.h>
 #include <malloc.h>
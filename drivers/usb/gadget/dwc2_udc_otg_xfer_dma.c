@@ -110,9 +110,9 @@ static int setdma_rx(struct dwc2_ep *ep, struct dwc2_request *req)
 
 	ctrl =  readl(&reg->out_endp[ep_num].doepctl);
 
-	invalidate_dcache_range((unsigned long) ep->dma_buf,
-				(unsigned long) ep->dma_buf +
-				ROUND(ep->len, CONFIG_SYS_CACHELINE_SIZE));
+	dma_map_range((ulong)ep->dma_buf,
+		      ROUND(ep->len, CONFIG_SYS_CACHELINE_SIZE),
+		      DMA_FROM_DEVICE);
 
 	writel((unsigned int)(unsigned long)ep->dma_buf,
 	       &reg->out_endp[ep_num].doepdma);
@@ -148,9 +148,8 @@ static int setdma_tx(struct dwc2_ep *ep, struct dwc2_request *req)
 	ep->len = length;
 	ep->dma_buf = buf;
 
-	flush_dcache_range((unsigned long) ep->dma_buf,
-			   (unsigned long) ep->dma_buf +
-			   ROUND(ep->len, CONFIG_SYS_CACHELINE_SIZE));
+	dma_map_range((ulong)ep->dma_buf,
+		      ROUND(ep->len, CONFIG_SYS_CACHELINE_SIZE), DMA_TO_DEVICE);
 
 	if (length == 0)
 		pktcnt = 1;
@@ -229,9 +228,9 @@ static void complete_rx(struct dwc2_udc *dev, u8 ep_num)
 	 * For armv7, the cache_v7.c provides proper code to emit "ERROR"
 	 * message to warn users.
 	 */
-	invalidate_dcache_range((unsigned long) ep->dma_buf,
-				(unsigned long) ep->dma_buf +
-				ROUND(xfer_size, CONFIG_SYS_CACHELINE_SIZE));
+	dma_unmap_range((ulong)ep->dma_buf,
+			ROUND(xfer_size, CONFIG_SYS_CACHELINE_SIZE),
+			DMA_FROM_DEVICE);
 
 	req->req.actual += min(xfer_size, req->req.length - req->req.actual);
 	is_short = !!(xfer_size % ep->ep.maxpacket);
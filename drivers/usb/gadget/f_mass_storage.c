@@ -244,6 +244,7 @@
 #include <malloc.h>
 #include <common.h>
 #include <console.h>
+#include <div64.h>
 #include <g_dnl.h>
 
 #include <linux/err.h>
@@ -319,6 +320,29 @@ struct fsg_common {
 	struct fsg_buffhd	*next_buffhd_to_fill;
 	struct fsg_buffhd	*next_buffhd_to_drain;
 	struct fsg_buffhd	buffhds[FSG_NUM_BUFFERS];
+	void			*buf_pool;	/* Backing store of buffhds */
+
+#ifdef CONFIG_USB_GADGET_UMS_READAHEAD
+	/* Blocks already read ahead of the host */
+	void			*ra_buf;
+	unsigned int		ra_lun;
+	u32			ra_start;
+	u32			ra_blkcnt;
+	/* Blocks to read ahead once the next CBW has been queued */
+	unsigned int		ra_next_lun;
+	u32			ra_next_start;
+	u32			ra_next_blkcnt;
+#endif
+
+#ifdef CONFIG_ROCKUSB_WRITE_BEHIND
+	/* Data of the last WRITE, acknowledged but not yet on storage */
+	unsigned int		write_behind:1;
+	struct fsg_buffhd	*wb_bh;
+	unsigned int		wb_nbufs;
+	unsigned int		wb_lun;
+	u32			wb_start;
+	u32			wb_blkcnt;
+#endif
 
 	int			cmnd_size;
 	u8			cmnd[MAX_COMMAND_SIZE];
@@ -448,6 +472,250 @@ static void set_bulk_out_req_length(struct fsg_common *common,
 static struct ums *ums;
 static int ums_count;
 static struct fsg_common *the_fsg_common;
+static struct ums_stats fsg_stats;
+
+static int fsg_dev_write(struct fsg_common *common, unsigned int lun,
+			 u32 start, u32 blkcnt, const void *buf)
+{
+	struct ums *ums_dev = &ums[lun];
+	unsigned long ts;
+	int rc;
+
+#ifdef CONFIG_USB_GADGET_UMS_READAHEAD
+	/* Whatever was read ahead may be stale now */
+	common->ra_blkcnt = 0;
+	common->ra_next_blkcnt = 0;
+#endif
+
+	ts = timer_get_us();
+	rc = ums_dev->write_sector(ums_dev, start, blkcnt, buf);
+	fsg_stats.dev_write_us += timer_get_us() - ts;
+	fsg_stats.dev_writes++;
+
+	return rc;
+}
+
+#ifdef CONFIG_ROCKUSB_WRITE_BEHIND
+/*
+ * Write out the data held back by fsg_write_defer() and give its buffers
+ * back. A failure is reported through the sense data of the LUN it was
+ * written to, as the host has already seen the command succeed.
+ */
+static int fsg_write_flush(struct fsg_common *common)
+{
+	struct fsg_buffhd *bh = common->wb_bh;
+	unsigned int i;
+	int rc;
+
+	if (!common->wb_blkcnt)
+		return 0;
+
+	rc = fsg_dev_write(common, common->wb_lun, common->wb_start,
+			   common->wb_blkcnt, bh->buf);
+
+	for (i = 0; i < common->wb_nbufs; i++, bh = bh->next)
+		bh->state = BUF_STATE_EMPTY;
+
+	if (rc != common->wb_blkcnt) {
+		struct fsg_lun *lun = &common->luns[common->wb_lun];
+
+		printf("deferred write of %u blocks @ %u failed: %d\n",
+		       common->wb_blkcnt, common->wb_start, rc);
+		lun->sense_data = SS_WRITE_ERROR;
+		lun->sense_data_info = common->wb_start;
+		lun->info_valid = 1;
+		rc = -EIO;
+	} else {
+		rc = 0;
+	}
+	common->wb_blkcnt = 0;
+
+	return rc;
+}
+
+/*
+ * Hold the last chunk of a WRITE in its buffers so the CSW goes out now
+ * and the storage write overlaps the host sending the next command and
+ * its data. At least two buffers stay free for the CSW and the next CBW.
+ */
+static int fsg_write_defer(struct fsg_common *common, struct fsg_buffhd *bh,
+			   unsigned int nbufs, u32 start, u32 blkcnt)
+{
+	unsigned int i;
+
+	if (!common->write_behind || nbufs > FSG_NUM_BUFFERS - 2)
+		return 0;
+
+	if (fsg_write_flush(common))
+		return 0;
+
+#ifdef CONFIG_USB_GADGET_UMS_READAHEAD
+	common->ra_blkcnt = 0;
+	common->ra_next_blkcnt = 0;
+#endif
+	common->wb_bh = bh;
+	common->wb_nbufs = nbufs;
+	common->wb_lun = common->lun;
+	common->wb_start = start;
+	common->wb_blkcnt = blkcnt;
+	for (i = 0; i < nbufs; i++, bh = bh->next)
+		bh->state = BUF_STATE_BUSY;
+	fsg_stats.wb_deferred++;
+
+	return blkcnt;
+}
+#else
+static inline int fsg_write_flush(struct fsg_common *common)
+{
+	return 0;
+}
+
+static inline int fsg_write_defer(struct fsg_common *common,
+				  struct fsg_buffhd *bh, unsigned int nbufs,
+				  u32 start, u32 blkcnt)
+{
+	return 0;
+}
+#endif
+
+static int fsg_write_sectors(struct fsg_common *common, u32 start,
+			     u32 blkcnt, const void *buf)
+{
+	if (fsg_write_flush(common))
+		return 0;
+
+	return fsg_dev_write(common, common->lun, start, blkcnt, buf);
+}
+
+static int fsg_read_sectors(struct fsg_common *common, u32 start,
+			    u32 blkcnt, void *buf)
+{
+	struct ums *ums_dev = &ums[common->lun];
+	unsigned long ts;
+	int rc, done = 0;
+
+	if (fsg_write_flush(common))
+		return 0;
+
+#ifdef CONFIG_USB_GADGET_UMS_READAHEAD
+	if (common->ra_blkcnt) {
+		if (common->ra_lun == common->lun &&
+		    common->ra_start == start) {
+			done = min(blkcnt, common->ra_blkcnt);
+			memcpy(buf, common->ra_buf, done * SECTOR_SIZE);
+			fsg_stats.ra_hits++;
+		} else {
+			fsg_stats.ra_misses++;
+		}
+		common->ra_blkcnt = 0;
+
+		if (done == blkcnt)
+			return done;
+		start += done;
+		blkcnt -= done;
+		buf += done * SECTOR_SIZE;
+	}
+#endif
+
+	ts = timer_get_us();
+	rc = ums_dev->read_sector(ums_dev, start, blkcnt, buf);
+	fsg_stats.dev_read_us += timer_get_us() - ts;
+	fsg_stats.dev_reads++;
+
+	return rc > 0 ? done + rc : done;
+}
+
+#ifdef CONFIG_USB_GADGET_UMS_READAHEAD
+/* Remember where a sequential READ following this one would start */
+static void fsg_readahead_schedule(struct fsg_common *common,
+				   u32 start, u32 blkcnt)
+{
+	struct fsg_lun *curlun = &common->luns[common->lun];
+
+	if (start >= curlun->num_sectors)
+		return;
+
+	common->ra_next_lun = common->lun;
+	common->ra_next_start = start;
+	common->ra_next_blkcnt = min3(blkcnt, FSG_BUFLEN / SECTOR_SIZE,
+				      (u32)curlun->num_sectors - start);
+}
+
+/*
+ * Called with the next CBW already queued, so the storage read overlaps
+ * the outstanding bulk-in data, the CSW and the host's next command.
+ */
+static void fsg_readahead(struct fsg_common *common)
+{
+	struct ums *ums_dev = &ums[common->ra_next_lun];
+	unsigned long ts;
+	int rc;
+
+	if (!common->ra_next_blkcnt)
+		return;
+
+	ts = timer_get_us();
+	rc = ums_dev->read_sector(ums_dev, common->ra_next_start,
+				  common->ra_next_blkcnt, common->ra_buf);
+	fsg_stats.dev_read_us += timer_get_us() - ts;
+	fsg_stats.dev_reads++;
+
+	if (rc > 0) {
+		common->ra_lun = common->ra_next_lun;
+		common->ra_start = common->ra_next_start;
+		common->ra_blkcnt = min_t(u32, rc, common->ra_next_blkcnt);
+	}
+	common->ra_next_blkcnt = 0;
+}
+#endif
+
+static void fsg_show_rate(const char *name, u64 bytes, u64 us)
+{
+	u32 ms = lldiv(us, 1000);
+	u32 rate;	/* 0.01 MB/s units */
+
+	rate = ms ? lldiv(bytes, ms * 10) : 0;
+	printf("%s ", name);
+	print_size(bytes, "");
+	printf(" in %u.%03u s, %u.%02u MB/s\n", ms / 1000, ms % 1000,
+	       rate / 100, rate % 100);
+}
+
+void fsg_get_stats(struct ums_stats *stats)
+{
+	*stats = fsg_stats;
+}
+
+void fsg_print_stats(void)
+{
+	if (fsg_stats.read_bytes) {
+		fsg_show_rate("UMS: read ", fsg_stats.read_bytes,
+			      fsg_stats.read_us);
+		fsg_show_rate("     (dev)", fsg_stats.read_bytes,
+			      fsg_stats.dev_read_us);
+	}
+	if (fsg_stats.write_bytes) {
+		fsg_show_rate("UMS: write", fsg_stats.write_bytes,
+			      fsg_stats.write_us);
+		fsg_show_rate("     (dev)", fsg_stats.write_bytes,
+			      fsg_stats.dev_write_us);
+	}
+	if (fsg_stats.erase_bytes)
+		fsg_show_rate("UMS: erase", fsg_stats.erase_bytes,
+			      fsg_stats.erase_us);
+	printf("UMS: %u storage reads, %u storage writes, read-ahead %u hit, %u miss\n",
+	       fsg_stats.dev_reads, fsg_stats.dev_writes,
+	       fsg_stats.ra_hits, fsg_stats.ra_misses);
+#ifdef CONFIG_ROCKUSB_WRITE_BEHIND
+	printf("UMS: %u writes overlapped with the next transfer\n",
+	       fsg_stats.wb_deferred);
+#endif
+}
+
+void fsg_reset_stats(void)
+{
+	memset(&fsg_stats, 0, sizeof(fsg_stats));
+}
 
 static int fsg_set_halt(struct fsg_dev *fsg, struct usb_ep *ep)
 {
@@ -774,8 +1042,7 @@ static int do_read(struct fsg_common *common)
 		}
 
 		/* Perform the read */
-		rc = ums[common->lun].read_sector(&ums[common->lun],
-				      file_offset / SECTOR_SIZE,
+		rc = fsg_read_sectors(common, file_offset / SECTOR_SIZE,
 				      amount / SECTOR_SIZE,
 				      (char __user *)bh->buf);
 		if (!rc)
@@ -799,6 +1066,7 @@ static int do_read(struct fsg_common *common)
 		file_offset  += nread;
 		amount_left  -= nread;
 		common->residue -= nread;
+		fsg_stats.read_bytes += nread;
 		bh->inreq->length = nread;
 		bh->state = BUF_STATE_FULL;
 
@@ -809,8 +1077,15 @@ static int do_read(struct fsg_common *common)
 			break;
 		}
 
-		if (amount_left == 0)
+		if (amount_left == 0) {
+#ifdef CONFIG_USB_GADGET_UMS_READAHEAD
+			fsg_readahead_schedule(common,
+					       file_offset / SECTOR_SIZE,
+					       common->data_size_from_cmnd /
+					       SECTOR_SIZE);
+#endif
 			break;		/* No more left to read */
+		}
 
 		/* Send this buffer and go read some more */
 		bh->inreq->zero = 0;
@@ -935,6 +1210,10 @@ static int do_write(struct fsg_common *common)
 		if (bh->state == BUF_STATE_EMPTY && !get_some_more)
 			break;			/* We stopped early */
 		if (bh->state == BUF_STATE_FULL) {
+			struct fsg_buffhd *first = bh;
+			unsigned int nbufs = 1;
+			void *buf = bh->buf;
+
 			common->next_buffhd_to_drain = bh->next;
 			bh->state = BUF_STATE_EMPTY;
 
@@ -947,11 +1226,34 @@ static int do_write(struct fsg_common *common)
 
 			amount = bh->outreq->actual;
 
-			/* Perform the write */
-			rc = ums[common->lun].write_sector(&ums[common->lun],
-					       file_offset / SECTOR_SIZE,
-					       amount / SECTOR_SIZE,
-					       (char __user *)bh->buf);
+			/*
+			 * Buffers are carved out of one block, so complete
+			 * ones that follow this one in memory can go to the
+			 * storage in the same write.
+			 */
+			while (bh->outreq->actual == bh->outreq->length &&
+			       bh->next->state == BUF_STATE_FULL &&
+			       bh->next->buf == buf + amount &&
+			       bh->next->outreq->status == 0) {
+				bh = bh->next;
+				common->next_buffhd_to_drain = bh->next;
+				bh->state = BUF_STATE_EMPTY;
+				amount += bh->outreq->actual;
+				nbufs++;
+			}
+
+			/* Perform the write, or defer it if it is the last */
+			rc = 0;
+			if (amount == amount_left_to_write &&
+			    bh->outreq->actual == bh->outreq->length)
+				rc = fsg_write_defer(common, first, nbufs,
+						     file_offset / SECTOR_SIZE,
+						     amount / SECTOR_SIZE);
+			if (!rc)
+				rc = fsg_write_sectors(common,
+						       file_offset / SECTOR_SIZE,
+						       amount / SECTOR_SIZE,
+						       (char __user *)buf);
 			if (!rc)
 				return -EIO;
 			nwritten = rc * SECTOR_SIZE;
@@ -973,6 +1275,7 @@ static int do_write(struct fsg_common *common)
 			file_offset += nwritten;
 			amount_left_to_write -= nwritten;
 			common->residue -= nwritten;
+			fsg_stats.write_bytes += nwritten;
 
 			/* If an error occurred, report it and its position */
 			if (nwritten < amount) {
@@ -991,6 +1294,13 @@ static int do_write(struct fsg_common *common)
 			continue;
 		}
 
+		/*
+		 * The bulk-out requests are queued; write out the previous
+		 * command's data while the host is sending this one.
+		 */
+		if (fsg_write_flush(common))
+			return -EIO;
+
 		/* Wait for something to happen */
 		rc = sleep_thread(common);
 		if (rc)
@@ -2164,6 +2474,10 @@ static int get_next_command(struct fsg_common *common)
 	 * can reuse it for the next filling.  No need to advance
 	 * next_buffhd_to_fill. */
 
+#ifdef CONFIG_USB_GADGET_UMS_READAHEAD
+	fsg_readahead(common);
+#endif
+
 	/* Wait for the CBW to arrive */
 	while (bh->state != BUF_STATE_FULL) {
 		rc = sleep_thread(common);
@@ -2245,6 +2559,10 @@ reset:
 	}
 
 	common->running = 0;
+#ifdef CONFIG_USB_GADGET_UMS_READAHEAD
+	common->ra_blkcnt = 0;
+	common->ra_next_blkcnt = 0;
+#endif
 	if (!new_fsg || rc)
 		return rc;
 
@@ -2319,6 +2637,9 @@ static void handle_exception(struct fsg_common *common)
 	struct fsg_lun		*curlun;
 	unsigned int		exception_req_tag;
 
+	/* Data the host was told is written must reach the storage */
+	fsg_write_flush(common);
+
 	/* Cancel all the pending transfers */
 	if (common->fsg) {
 		for (i = 0; i < FSG_NUM_BUFFERS; ++i) {
@@ -2419,9 +2740,26 @@ static void handle_exception(struct fsg_common *common)
 
 /*-------------------------------------------------------------------------*/
 
+static void fsg_account_cmd(struct fsg_common *common, unsigned long ts)
+{
+	switch (common->cmnd[0]) {
+	case SC_READ_6:
+	case SC_READ_10:
+	case SC_READ_12:
+		fsg_stats.read_us += timer_get_us() - ts;
+		break;
+	case SC_WRITE_6:
+	case SC_WRITE_10:
+	case SC_WRITE_12:
+		fsg_stats.write_us += timer_get_us() - ts;
+		break;
+	}
+}
+
 int fsg_main_thread(void *common_)
 {
 	int ret;
+	unsigned long ts;
 	struct fsg_common	*common = the_fsg_common;
 	/* The main loop */
 	do {
@@ -2439,12 +2777,15 @@ int fsg_main_thread(void *common_)
 		}
 
 		ret = get_next_command(common);
-		if (ret)
+		if (ret) {
+			fsg_write_flush(common);
 			return ret;
+		}
 
 		if (!exception_in_progress(common))
 			common->state = FSG_STATE_DATA_PHASE;
 
+		ts = timer_get_us();
 		if (do_scsi_command(common) || finish_reply(common))
 			continue;
 
@@ -2454,6 +2795,8 @@ int fsg_main_thread(void *common_)
 		if (send_status(common))
 			continue;
 
+		fsg_account_cmd(common, ts);
+
 		if (!exception_in_progress(common))
 			common->state = FSG_STATE_IDLE;
 	} while (0);
@@ -2525,7 +2868,17 @@ static struct fsg_common *fsg_common_init(struct fsg_common *common,
 	}
 	common->lun = 0;
 
-	/* Data buffers cyclic list */
+	/*
+	 * Data buffers cyclic list, backed by a single allocation so that
+	 * adjacent buffers can be handed to the storage in one request.
+	 */
+	common->buf_pool = memalign(CONFIG_SYS_CACHELINE_SIZE,
+				    FSG_NUM_BUFFERS * FSG_BUFLEN);
+	if (unlikely(!common->buf_pool)) {
+		rc = -ENOMEM;
+		goto error_release;
+	}
+
 	bh = common->buffhds;
 
 	i = FSG_NUM_BUFFERS;
@@ -2536,14 +2889,19 @@ static struct fsg_common *fsg_common_init(struct fsg_common *common,
 buffhds_first_it:
 		bh->inreq_busy = 0;
 		bh->outreq_busy = 0;
-		bh->buf = memalign(CONFIG_SYS_CACHELINE_SIZE, FSG_BUFLEN);
-		if (unlikely(!bh->buf)) {
-			rc = -ENOMEM;
-			goto error_release;
-		}
+		bh->buf = common->buf_pool +
+			  (bh - common->buffhds) * FSG_BUFLEN;
 	} while (--i);
 	bh->next = common->buffhds;
 
+#ifdef CONFIG_USB_GADGET_UMS_READAHEAD
+	common->ra_buf = memalign(CONFIG_SYS_CACHELINE_SIZE, FSG_BUFLEN);
+	if (unlikely(!common->ra_buf)) {
+		rc = -ENOMEM;
+		goto error_release;
+	}
+#endif
+
 	snprintf(common->inquiry_string, sizeof common->inquiry_string,
 		 "%-8s%-16s%04x",
 		 "Linux   ",
@@ -2602,13 +2960,10 @@ static void fsg_common_release(struct kref *ref)
 		kfree(common->luns);
 	}
 
-	{
-		struct fsg_buffhd *bh = common->buffhds;
-		unsigned i = FSG_NUM_BUFFERS;
-		do {
-			kfree(bh->buf);
-		} while (++bh, --i);
-	}
+	kfree(common->buf_pool);
+#ifdef CONFIG_USB_GADGET_UMS_READAHEAD
+	kfree(common->ra_buf);
+#endif
 
 	if (common->free_storage_on_release)
 		kfree(common);
@@ -2806,6 +3161,7 @@ int fsg_init(struct ums *ums_devs, int count)
 {
 	ums = ums_devs;
 	ums_count = count;
+	fsg_reset_stats();
 
 	return 0;
 }
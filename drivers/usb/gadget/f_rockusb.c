@@ -55,6 +55,23 @@ struct rk_flash_info {
 	u8	flash_mask;
 } __packed;
 
+/* Reply to RKUSB_XFER_STATS, times in milliseconds */
+struct rk_xfer_stats {
+	u64	read_bytes;
+	u64	write_bytes;
+	u32	read_time;
+	u32	write_time;
+	u32	dev_read_time;
+	u32	dev_write_time;
+	u32	dev_reads;
+	u32	dev_writes;
+	u32	ra_hits;
+	u32	ra_misses;
+	u32	wb_deferred;
+	u64	erase_bytes;
+	u32	erase_time;
+} __packed;
+
 static int rkusb_rst_code; /* The subcode in reset command (0xFF) */
 
 int g_dnl_bind_fixup(struct usb_device_descriptor *dev, const char *name)
@@ -247,6 +264,7 @@ static int rkusb_do_lba_erase(struct fsg_common *common,
 	struct fsg_lun *curlun = &common->luns[common->lun];
 	u32 lba, amount;
 	loff_t file_offset;
+	unsigned long ts;
 	int rc;
 
 	lba = get_unaligned_be32(&common->cmnd[2]);
@@ -263,14 +281,31 @@ static int rkusb_do_lba_erase(struct fsg_common *common,
 		rc = -EIO;
 		goto out;
 	}
+	if (lba + amount / SECTOR_SIZE > curlun->num_sectors) {
+		curlun->sense_data = SS_LOGICAL_BLOCK_ADDRESS_OUT_OF_RANGE;
+		rc = -EINVAL;
+		goto out;
+	}
+
+#ifdef CONFIG_USB_GADGET_UMS_READAHEAD
+	common->ra_blkcnt = 0;
+	common->ra_next_blkcnt = 0;
+#endif
 
-	/* Perform the erase */
+	/*
+	 * Perform the erase. The device splits it into erase groups itself
+	 * (see mmc_berase()), so hand it the whole range in one call.
+	 */
+	ts = timer_get_us();
 	rc = ums[common->lun].erase_sector(&ums[common->lun],
 			       file_offset / SECTOR_SIZE,
 			       amount / SECTOR_SIZE);
+	fsg_stats.erase_us += timer_get_us() - ts;
 	if (!rc) {
 		curlun->sense_data = SS_MEDIUM_NOT_PRESENT;
 		rc = -EIO;
+	} else {
+		fsg_stats.erase_bytes += amount;
 	}
 
 out:
@@ -280,6 +315,43 @@ out:
 	return rc;
 }
 
+static int rkusb_do_xfer_stats(struct fsg_common *common,
+			       struct fsg_buffhd *bh)
+{
+	u8 *buf = (u8 *)bh->buf;
+	u32 len = sizeof(struct rk_xfer_stats);
+	struct rk_xfer_stats xstats;
+	struct ums_stats stats;
+
+	fsg_get_stats(&stats);
+	xstats.read_bytes = stats.read_bytes;
+	xstats.write_bytes = stats.write_bytes;
+	xstats.read_time = lldiv(stats.read_us, 1000);
+	xstats.write_time = lldiv(stats.write_us, 1000);
+	xstats.dev_read_time = lldiv(stats.dev_read_us, 1000);
+	xstats.dev_write_time = lldiv(stats.dev_write_us, 1000);
+	xstats.dev_reads = stats.dev_reads;
+	xstats.dev_writes = stats.dev_writes;
+	xstats.ra_hits = stats.ra_hits;
+	xstats.ra_misses = stats.ra_misses;
+	xstats.wb_deferred = stats.wb_deferred;
+	xstats.erase_bytes = stats.erase_bytes;
+	xstats.erase_time = lldiv(stats.erase_us, 1000);
+
+	/* SubCode bit 0: clear the counters once they are read */
+	if (common->cmnd[1] & BIT(0))
+		fsg_reset_stats();
+
+	memset((void *)&buf[0], 0, len);
+	memcpy((void *)&buf[0], (void *)&xstats, len);
+
+	/* Set data xfer size */
+	common->residue = common->data_size_from_cmnd = len;
+	common->data_size = len;
+
+	return len;
+}
+
 #ifdef CONFIG_ROCKCHIP_VENDOR_PARTITION
 static int rkusb_do_vs_write(struct fsg_common *common)
 {
@@ -504,6 +576,18 @@ static int rkusb_cmd_process(struct fsg_common *common,
 		return RKUSB_RC_ERROR;
 	}
 
+	/*
+	 * LBA writes may leave their data in flight past the CSW, anything
+	 * else has to see it on the storage first.
+	 */
+#ifdef CONFIG_ROCKUSB_WRITE_BEHIND
+	common->write_behind = common->cmnd[0] == RKUSB_LBA_WRITE_10;
+#endif
+	if (common->cmnd[0] != RKUSB_LBA_WRITE_10 && fsg_write_flush(common)) {
+		*reply = -EIO;
+		return RKUSB_RC_ERROR;
+	}
+
 	switch (common->cmnd[0]) {
 	case RKUSB_TEST_UNIT_READY:
 		*reply = rkusb_do_test_unit_ready(common, bh);
@@ -566,6 +650,11 @@ static int rkusb_cmd_process(struct fsg_common *common,
 		rc = RKUSB_RC_FINISHED;
 		break;
 
+	case RKUSB_XFER_STATS:
+		*reply = rkusb_do_xfer_stats(common, bh);
+		rc = RKUSB_RC_FINISHED;
+		break;
+
 	case RKUSB_RESET:
 		*reply = rkusb_do_reset(common, bh);
 		rc = RKUSB_RC_FINISHED;
@@ -305,8 +305,15 @@ static struct fsg_lun *fsg_lun_from_dev(struct device *dev)
 #define EP0_BUFSIZE	256
 #define DELAYED_STATUS	(EP0_BUFSIZE + 999)	/* An impossibly large value */
 
-/* Number of buffers we will use.  2 is enough for double-buffering */
+/*
+ * Number of buffers we will use.  2 is enough for double-buffering, more
+ * lets bulk-out data queue up behind a slow storage write.
+ */
+#ifdef CONFIG_USB_GADGET_UMS_BUFFERS
+#define FSG_NUM_BUFFERS	CONFIG_USB_GADGET_UMS_BUFFERS
+#else
 #define FSG_NUM_BUFFERS	2
+#endif
 
 /* Default size of buffer length. */
 #define FSG_BUFLEN	((u32)131072)
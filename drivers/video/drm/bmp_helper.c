@@ -7,14 +7,34 @@
 #include <config.h>
 #include <common.h>
 #include <malloc.h>
+#include <smp_job.h>
 #include <asm/unaligned.h>
 #include <bmp_layout.h>
+#include <linux/sizes.h>
 
 #define BMP_RLE8_ESCAPE		0
 #define BMP_RLE8_EOL		0
 #define BMP_RLE8_EOBMP		1
 #define BMP_RLE8_DELTA		2
 
+/* Smaller bitmaps are not worth handing to the other cores */
+#define BMP_SMP_MIN_PIXELS	SZ_256K
+
+/*
+ * A band of rows of an uncompressed bitmap. With @cmap each 8-bit index is
+ * looked up as RGB565, otherwise 24-bit rows are copied as they are.
+ */
+struct bmp_rows {
+	struct smp_job job;
+	const uint8_t *src;
+	uint8_t *dst;
+	int src_step;
+	int dst_step;
+	int rows;
+	int width;
+	const uint16_t *cmap;
+};
+
 static void draw_unencoded_bitmap(uint16_t **dst, uint8_t *bmap, uint16_t *cmap,
 				  uint32_t cnt)
 {
@@ -141,6 +161,58 @@ static void decode_rle8_bitmap(void *psrc, void *pdst, uint16_t *cmap,
 	}
 }
 
+static int bmp_convert_rows(void *arg)
+{
+	struct bmp_rows *band = arg;
+	const uint8_t *src = band->src;
+	uint8_t *dst = band->dst;
+	int i, j;
+
+	for (i = 0; i < band->rows; i++) {
+		if (band->cmap) {
+			for (j = 0; j < band->width; j++)
+				((uint16_t *)dst)[j] = band->cmap[src[j]];
+		} else {
+			memcpy(dst, src, 3 * band->width);
+		}
+		src += band->src_step;
+		dst += band->dst_step;
+	}
+
+	return 0;
+}
+
+/* Split the rows between the boot core and the job workers */
+static void bmp_convert(const uint8_t *src, uint8_t *dst, int src_step,
+			int dst_step, int height, int width,
+			const uint16_t *cmap)
+{
+	struct bmp_rows bands[SMP_JOB_MAX_WORKERS + 1];
+	int count = smp_job_workers() + 1;
+	int step, i;
+
+	if (width * height < BMP_SMP_MIN_PIXELS)
+		count = 1;
+	step = DIV_ROUND_UP(height, count);
+	count = step ? DIV_ROUND_UP(height, step) : 0;
+	for (i = 0; i < count; i++) {
+		struct bmp_rows *band = &bands[i];
+
+		band->src = src + i * step * src_step;
+		band->dst = dst + i * step * dst_step;
+		band->src_step = src_step;
+		band->dst_step = dst_step;
+		band->rows = min(step, height - i * step);
+		band->width = width;
+		band->cmap = cmap;
+		smp_job_init_one(&band->job, bmp_convert_rows, band);
+		/* The last band finds every worker busy and runs here */
+		smp_job_submit(&band->job);
+	}
+	for (i = 0; i < count; i++)
+		smp_job_wait(&bands[i].job);
+}
+
 int bmpdecoder(void *bmp_addr, void *pdst, int dst_bpp)
 {
 	int stride, padded_width, bpp, i, width, height;
@@ -193,21 +265,14 @@ int bmpdecoder(void *bmp_addr, void *pdst, int dst_bpp)
 			decode_rle8_bitmap(src, dst, cmap, width, height,
 					   bpp, 0, 0, flip);
 		} else {
-			int j;
 			stride = width * 2;
 
-			if (flip)
+			if (flip) {
 				dst += stride * (height - 1);
-
-			for (i = 0; i < height; ++i) {
-				for (j = 0; j < width; j++) {
-					*(uint16_t *)dst = cmap[*(src++)];
-					dst += sizeof(uint16_t) / sizeof(*dst);
-				}
-				src += (padded_width - width);
-				if (flip)
-					dst -= stride * 2;
+				stride = -stride;
 			}
+			bmp_convert(src, dst, padded_width, stride, height,
+				    width, cmap);
 		}
 		free(cmap);
 		break;
@@ -219,14 +284,8 @@ int bmpdecoder(void *bmp_addr, void *pdst, int dst_bpp)
 		stride = ALIGN(width * 3, 4);
 		if (flip)
 			src += stride * (height - 1);
-
-		for (i = 0; i < height; i++) {
-			memcpy(dst, src, 3 * width);
-			dst += stride;
-			src += stride;
-			if (flip)
-				src -= stride * 2;
-		}
+		bmp_convert(src, dst, flip ? -stride : stride, stride, height,
+			    width, NULL);
 		break;
 	case 16:
 	case 32:
@@ -407,6 +407,40 @@ static int tnc_read_node_nm(struct ubifs_info *c, struct ubifs_zbranch *zbr,
 	return err;
 }
 
+#ifdef __UBOOT__
+/**
+ * tnc_read_node_ino - read an inode node.
+ * @c: UBIFS file-system description object
+ * @zbr: key and position of the node
+ * @node: node is returned here
+ *
+ * U-Boot mounts read-only, so once the TNC has been replayed the index does
+ * not change and inode nodes can be kept in the leaf node cache like
+ * directory entries. Every command looks its file up again from the root,
+ * so this saves re-reading the inodes of the path each time. Returns zero in
+ * case of success or a negative error code in case of failure.
+ */
+static int tnc_read_node_ino(struct ubifs_info *c, struct ubifs_zbranch *zbr,
+			     void *node)
+{
+	int err;
+
+	if (zbr->leaf) {
+		/* Read from the leaf node cache */
+		memcpy(node, zbr->leaf, zbr->len);
+		return 0;
+	}
+
+	err = ubifs_tnc_read_node(c, zbr, node);
+	if (err)
+		return err;
+
+	/* We don't have to have the cache, so no error */
+	zbr->leaf = kmemdup(node, zbr->len, GFP_NOFS);
+	return 0;
+}
+#endif
+
 /**
  * try_read_node - read a node if it is a node.
  * @c: UBIFS file-system description object
@@ -1456,6 +1490,12 @@ again:
 		err = tnc_read_node_nm(c, zt, node);
 		goto out;
 	}
+#ifdef __UBOOT__
+	if (key_type(c, key) == UBIFS_INO_KEY) {
+		err = tnc_read_node_ino(c, zt, node);
+		goto out;
+	}
+#endif
 	if (safely) {
 		err = ubifs_tnc_read_node(c, zt, node);
 		goto out;
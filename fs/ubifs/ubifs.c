@@ -385,93 +385,40 @@ out:
 	return 0;
 }
 
+/*
+ * Look a name up in a directory by its hash, like ubifs_lookup() does in
+ * Linux, rather than reading every entry of the directory until it matches
+ */
 static int ubifs_finddir(struct super_block *sb, char *dirname,
 			 unsigned long root_inum, unsigned long *inum)
 {
-	int err;
-	struct qstr nm;
-	union ubifs_key key;
+	struct ubifs_info *c = sb->s_fs_info;
 	struct ubifs_dent_node *dent;
-	struct ubifs_info *c;
-	struct file *file;
-	struct dentry *dentry;
-	struct inode *dir;
-	int ret = 0;
-
-	file = kzalloc(sizeof(struct file), 0);
-	dentry = kzalloc(sizeof(struct dentry), 0);
-	dir = kzalloc(sizeof(struct inode), 0);
-	if (!file || !dentry || !dir) {
-		printf("%s: Error, no memory for malloc!\n", __func__);
-		err = -ENOMEM;
-		goto out;
-	}
-
-	dir->i_sb = sb;
-	file->f_path.dentry = dentry;
-	file->f_path.dentry->d_parent = dentry;
-	file->f_path.dentry->d_inode = dir;
-	file->f_path.dentry->d_inode->i_ino = root_inum;
-	c = sb->s_fs_info;
-
-	dbg_gen("dir ino %lu, f_pos %#llx", dir->i_ino, file->f_pos);
-
-	/* Find the first entry in TNC and save it */
-	lowest_dent_key(c, &key, dir->i_ino);
-	nm.name = NULL;
-	dent = ubifs_tnc_next_ent(c, &key, &nm);
-	if (IS_ERR(dent)) {
-		err = PTR_ERR(dent);
-		goto out;
-	}
-
-	file->f_pos = key_hash_flash(c, &dent->key);
-	file->private_data = dent;
-
-	while (1) {
-		dbg_gen("feed '%s', ino %llu, new f_pos %#x",
-			dent->name, (unsigned long long)le64_to_cpu(dent->inum),
-			key_hash_flash(c, &dent->key));
-		ubifs_assert(le64_to_cpu(dent->ch.sqnum) > ubifs_inode(dir)->creat_sqnum);
-
-		nm.len = le16_to_cpu(dent->nlen);
-		if ((strncmp(dirname, (char *)dent->name, nm.len) == 0) &&
-		    (strlen(dirname) == nm.len)) {
-			*inum = le64_to_cpu(dent->inum);
-			ret = 1;
-			goto out_free;
-		}
+	union ubifs_key key;
+	struct qstr nm;
+	int err;
 
-		/* Switch to the next entry */
-		key_read(c, &dent->key, &key);
-		nm.name = (char *)dent->name;
-		dent = ubifs_tnc_next_ent(c, &key, &nm);
-		if (IS_ERR(dent)) {
-			err = PTR_ERR(dent);
-			goto out;
-		}
+	nm.name = dirname;
+	nm.len = strlen(dirname);
+	if (nm.len > UBIFS_MAX_NLEN)
+		return 0;
 
-		kfree(file->private_data);
-		file->f_pos = key_hash_flash(c, &dent->key);
-		file->private_data = dent;
-		cond_resched();
+	dent = kmalloc(UBIFS_MAX_DENT_NODE_SZ, GFP_NOFS);
+	if (!dent) {
+		printf("%s: Error, no memory for malloc!\n", __func__);
+		return 0;
 	}
 
-out:
-	if (err != -ENOENT)
-		dbg_gen("cannot find next direntry, error %d", err);
+	dbg_gen("'%s' in dir ino %lu", dirname, root_inum);
+	dent_key_init(c, &key, root_inum, &nm);
+	err = ubifs_tnc_lookup_nm(c, &key, dent, &nm);
+	if (!err)
+		*inum = le64_to_cpu(dent->inum);
+	else if (err != -ENOENT)
+		dbg_gen("cannot find '%s', error %d", dirname, err);
+	kfree(dent);
 
-out_free:
-	if (file->private_data)
-		kfree(file->private_data);
-	if (file)
-		free(file);
-	if (dentry)
-		free(dentry);
-	if (dir)
-		free(dir);
-
-	return ret;
+	return !err;
 }
 
 static unsigned long ubifs_findfile(struct super_block *sb, char *filename)
@@ -839,6 +786,83 @@ error:
 	return err;
 }
 
+/**
+ * do_bulk_read - read whole blocks of a file with bulk-read.
+ * @c: UBIFS file-system description object
+ * @inode: inode of the file
+ * @addr: where to put the data
+ * @block: first block to read
+ * @count: number of blocks to read, which must all be whole
+ *
+ * This function finds the data nodes from @block on which sit next to each
+ * other in one LEB, reads them with a single flash read and then decompresses
+ * them one after the other straight into @addr. Blocks without a data node
+ * are holes and are zeroed. Returns the number of blocks done, which may be
+ * less than @count, or a negative error code in case of failure.
+ */
+static int do_bulk_read(struct ubifs_info *c, struct inode *inode, void *addr,
+			unsigned int block, int count)
+{
+	struct bu_info *bu = &c->bu;
+	struct ubifs_data_node *dn = NULL;
+	int err, i, nn = 0, offs, len, dlen, out_len, blk_cnt;
+
+	data_key_init(c, &bu->key, inode->i_ino, block);
+	bu->buf_len = c->max_bu_buf_len;
+	err = ubifs_tnc_get_bu_keys(c, bu);
+	if (err)
+		return err;
+
+	/* There are only holes after the last data node of the file */
+	blk_cnt = bu->eof ? count : min(bu->blk_cnt, count);
+	if (!blk_cnt)
+		return -EINVAL;
+
+	if (bu->cnt) {
+		err = ubifs_tnc_bulk_read(c, bu);
+		if (err)
+			return err;
+	}
+
+	offs = bu->zbranch[0].offs;
+	for (i = 0; i < blk_cnt; i++, addr += UBIFS_BLOCK_SIZE) {
+		while (nn < bu->cnt &&
+		       key_block(c, &bu->zbranch[nn].key) < block + i)
+			nn++;
+		if (nn >= bu->cnt ||
+		    key_block(c, &bu->zbranch[nn].key) != block + i) {
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+			continue;
+		}
+
+		dn = bu->buf + (bu->zbranch[nn++].offs - offs);
+		ubifs_assert(le64_to_cpu(dn->ch.sqnum) >
+			     ubifs_inode(inode)->creat_sqnum);
+
+		len = le32_to_cpu(dn->size);
+		if (len <= 0 || len > UBIFS_BLOCK_SIZE)
+			goto dump;
+
+		dlen = le32_to_cpu(dn->ch.len) - UBIFS_DATA_NODE_SZ;
+		out_len = UBIFS_BLOCK_SIZE;
+		err = ubifs_decompress(c, &dn->data, dlen, addr, &out_len,
+				       le16_to_cpu(dn->compr_type));
+		if (err || len != out_len)
+			goto dump;
+
+		if (len < UBIFS_BLOCK_SIZE)
+			memset(addr + len, 0, UBIFS_BLOCK_SIZE - len);
+	}
+
+	return blk_cnt;
+
+dump:
+	ubifs_err(c, "bad data node (block %u, inode %lu)",
+		  block + i, inode->i_ino);
+	ubifs_dump_node(c, dn);
+	return -EINVAL;
+}
+
 int ubifs_read(const char *filename, void *buf, loff_t offset,
 	       loff_t size, loff_t *actread)
 {
@@ -847,7 +871,7 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 	struct inode *inode;
 	struct page page;
 	int err = 0;
-	int i;
+	int i, n;
 	int count;
 	int last_block_size = 0;
 
@@ -897,19 +921,31 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 	page.addr = buf;
 	page.index = offset / PAGE_SIZE;
 	page.inode = inode;
-	for (i = 0; i < count; i++) {
+	for (i = 0; i < count; i += n) {
 		/*
-		 * Make sure to not read beyond the requested size
+		 * Bulk-read all but the last block, which may have to be
+		 * copied short, and fall back to one page at a time
 		 */
-		if (((i + 1) == count) && (size < inode->i_size))
-			last_block_size = size - (i * PAGE_SIZE);
+		n = 0;
+		if (c->bulk_read && i + 1 < count)
+			n = do_bulk_read(c, inode, page.addr,
+					 page.index << UBIFS_BLOCKS_PER_PAGE_SHIFT,
+					 count - 1 - i);
+		if (n <= 0) {
+			/*
+			 * Make sure to not read beyond the requested size
+			 */
+			if (((i + 1) == count) && (size < inode->i_size))
+				last_block_size = size - (i * PAGE_SIZE);
 
-		err = do_readpage(c, inode, &page, last_block_size);
-		if (err)
-			break;
+			err = do_readpage(c, inode, &page, last_block_size);
+			if (err)
+				break;
+			n = 1;
+		}
 
-		page.addr += PAGE_SIZE;
-		page.index++;
+		page.addr += n * PAGE_SIZE;
+		page.index += n;
 	}
 
 	if (err) {
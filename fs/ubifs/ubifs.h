@@ -2094,8 +2094,17 @@ int ubifs_read_node(const struct ubifs_info *c, void *buf, int type, int len,
 		    int lnum, int offs);
 int ubifs_read_node_wbuf(struct ubifs_wbuf *wbuf, void *buf, int type, int len,
 			 int lnum, int offs);
+#ifndef __UBOOT__
 int ubifs_write_node(struct ubifs_info *c, void *node, int len, int lnum,
 		     int offs);
+#else
+/* U-Boot mounts read-only, nothing is ever written */
+static inline int ubifs_write_node(struct ubifs_info *c, void *node, int len,
+				   int lnum, int offs)
+{
+	return -EROFS;
+}
+#endif
 int ubifs_check_node(const struct ubifs_info *c, const void *buf, int lnum,
 		     int offs, int quiet, int must_chk_crc);
 void ubifs_prepare_node(struct ubifs_info *c, void *buf, int len, int pad);
@@ -2243,8 +2252,13 @@ unsigned long ubifs_shrink_count(struct shrinker *shrink,
 
 /* commit.c */
 int ubifs_bg_thread(void *info);
+#ifndef __UBOOT__
 void ubifs_commit_required(struct ubifs_info *c);
 void ubifs_request_bg_commit(struct ubifs_info *c);
+#else
+static inline void ubifs_commit_required(struct ubifs_info *c) {}
+static inline void ubifs_request_bg_commit(struct ubifs_info *c) {}
+#endif
 int ubifs_run_commit(struct ubifs_info *c);
 void ubifs_recovery_commit(struct ubifs_info *c);
 int ubifs_gc_should_commit(struct ubifs_info *c);
@@ -2252,7 +2266,14 @@ void ubifs_wait_for_commit(struct ubifs_info *c);
 
 /* master.c */
 int ubifs_read_master(struct ubifs_info *c);
+#ifndef __UBOOT__
 int ubifs_write_master(struct ubifs_info *c);
+#else
+static inline int ubifs_write_master(struct ubifs_info *c)
+{
+	return -EROFS;
+}
+#endif
 
 /* sb.c */
 int ubifs_read_superblock(struct ubifs_info *c);
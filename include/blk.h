@@ -80,6 +80,12 @@ struct blk_desc {
 	lbaint_t	lba;		/* number of blocks */
 	unsigned long	blksz;		/* block size */
 	int		log2blksz;	/* for convenience: log2(blksz) */
+	/*
+	 * Number of blocks the device reads at the cost of one, e.g. a NAND
+	 * page behind an FTL; a power of two, or 0 if reads cost per block.
+	 * With the block cache, smaller reads are widened to whole pages.
+	 */
+	unsigned int	page_blks;
 	char		vendor[BLK_VEN_SIZE + 1]; /* device vendor string */
 	char		product[BLK_PRD_SIZE + 1]; /* device product number */
 	char		revision[BLK_REV_SIZE + 1]; /* firmware revision */
@@ -148,6 +154,23 @@ void blkcache_fill(int iftype, int dev,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer);
 
+/**
+ * blkcache_fill_pages() - keep whole pages read for a smaller request
+ *
+ * Like blkcache_fill(), but the entry is kept whatever its size, since it
+ * was read to serve the small requests around it.
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number, aligned to the page
+ * @param blkcnt - number of blocks available
+ * @param blksz - size in bytes of each block
+ * @param buf - buffer containing data to cache
+ */
+void blkcache_fill_pages(int iftype, int dev,
+			 lbaint_t start, lbaint_t blkcnt,
+			 unsigned long blksz, void const *buffer);
+
 /**
  * blkcache_invalidate() - discard the cache for a set of blocks
  * because of a write or device (re)initialization.
@@ -171,6 +194,7 @@ void blkcache_configure(unsigned blocks, unsigned entries);
 struct block_cache_stats {
 	unsigned hits;
 	unsigned misses;
+	unsigned page_fills; /* misses widened to whole pages */
 	unsigned entries; /* current entry count */
 	unsigned max_blocks_per_entry;
 	unsigned max_entries;
@@ -196,6 +220,11 @@ static inline void blkcache_fill(int iftype, int dev,
 				 lbaint_t start, lbaint_t blkcnt,
 				 unsigned long blksz, void const *buffer) {}
 
+static inline void blkcache_fill_pages(int iftype, int dev,
+				       lbaint_t start, lbaint_t blkcnt,
+				       unsigned long blksz,
+				       void const *buffer) {}
+
 static inline void blkcache_invalidate(int iftype, int dev) {}
 
 #endif
@@ -73,4 +73,64 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 		       void *load_buf, void *image_buf, ulong image_len,
 		       uint unc_len, ulong *load_end);
 
+/**
+ * struct bootm_stream - decompression of an image that arrives in pieces
+ *
+ * @comp:	Compression algorithm (IH_COMP_...)
+ * @priv:	Decompressor state
+ */
+struct bootm_stream {
+	int comp;
+	void *priv;
+};
+
+/**
+ * bootm_decomp_stream_supported() - check if an algorithm can be streamed
+ *
+ * @comp:	Compression algorithm (IH_COMP_...)
+ * @return true if bootm_decomp_stream_start() accepts @comp
+ */
+bool bootm_decomp_stream_supported(int comp);
+
+/**
+ * bootm_decomp_stream_start() - start decompressing an image in pieces
+ *
+ * This allocates the decompressor state up front so that
+ * bootm_decomp_stream_feed() can run on a secondary core (see smp_job.h).
+ *
+ * @st:		Stream to set up
+ * @comp:	Compression algorithm (IH_COMP_GZIP or IH_COMP_LZ4)
+ * @head:	First bytes of the compressed image
+ * @head_len:	Number of bytes at @head
+ * @load_buf:	Place to decompress to
+ * @unc_len:	Available space for decompression
+ * @return 0 if OK, -ve on error
+ */
+int bootm_decomp_stream_start(struct bootm_stream *st, int comp,
+			      const void *head, ulong head_len,
+			      void *load_buf, ulong unc_len);
+
+/**
+ * bootm_decomp_stream_feed() - decompress the next piece of an image
+ *
+ * Pieces must be passed in order but can have any size. Data after the end
+ * of the compressed stream is ignored.
+ *
+ * @st:		Stream
+ * @buf:	Next piece of the compressed image
+ * @len:	Number of bytes at @buf
+ * @return 0 if OK, -ve on error
+ */
+int bootm_decomp_stream_feed(struct bootm_stream *st, const void *buf,
+			     ulong len);
+
+/**
+ * bootm_decomp_stream_end() - finish decompressing and free the stream
+ *
+ * @st:		Stream
+ * @unc_len:	Returns the number of bytes decompressed
+ * @return 0 if the whole compressed stream was decoded, -ve on error
+ */
+int bootm_decomp_stream_end(struct bootm_stream *st, ulong *unc_len);
+
 #endif
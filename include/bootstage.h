@@ -205,6 +205,13 @@ enum bootstage_id {
 	BOOTSTATE_ID_ACCUM_DM_SPL,
 	BOOTSTATE_ID_ACCUM_DM_F,
 	BOOTSTATE_ID_ACCUM_DM_R,
+	BOOTSTAGE_ID_ACCUM_KERNEL_READ,
+	BOOTSTAGE_ID_START_TPL,
+	BOOTSTAGE_ID_END_TPL,
+	BOOTSTAGE_ID_ACCUM_DRAM,
+	BOOTSTAGE_ID_ACCUM_SPL_LOAD,
+	BOOTSTAGE_ID_ACCUM_STORAGE,
+	BOOTSTAGE_ID_ACCUM_VERIFY,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -311,6 +318,22 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name);
  */
 uint32_t bootstage_accum(enum bootstage_id id);
 
+/**
+ * Add a finished activity as a new accumulator record
+ *
+ * This is for activities which are not known in advance, such as each image
+ * loaded from a FIT, so have no bootstage id of their own. A new id is
+ * allocated for each call.
+ *
+ * @param name		Name of the activity. This must stay valid until the
+ *			records are stashed, reported or relocated.
+ * @param start_us	Time the activity started, in microseconds
+ * @param duration_us	Time spent in the activity, in microseconds
+ * @return duration_us, or 0 if there is no space for another record
+ */
+uint32_t bootstage_add_accum(const char *name, uint32_t start_us,
+			     uint32_t duration_us);
+
 /* Print a report about boot time */
 void bootstage_report(void);
 
@@ -410,6 +433,13 @@ static inline uint32_t bootstage_accum(enum bootstage_id id)
 	return 0;
 }
 
+static inline uint32_t bootstage_add_accum(const char *name,
+					   uint32_t start_us,
+					   uint32_t duration_us)
+{
+	return 0;
+}
+
 static inline int bootstage_stash(void *base, int size)
 {
 	return 0;	/* Pretend to succeed */
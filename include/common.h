@@ -668,6 +668,93 @@ int gzwrite(unsigned char *src, int len,
 bool lz4_is_valid_header(const unsigned char *h);
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
 
+/**
+ * ulz4fn_parallel() - decompress an LZ4 frame using all cores
+ *
+ * The independent blocks of the frame are split between the boot core and
+ * the SMP job workers, each writing to its block's place in @dst. This falls
+ * back to ulz4fn() when there are no workers, when @src and @dst overlap, or
+ * when the blocks are not all of the maximum size except the last.
+ *
+ * Arguments and return value are as for ulz4fn().
+ */
+int ulz4fn_parallel(const void *src, size_t srcn, void *dst, size_t *dstn);
+
+/**
+ * struct ulz4_stream - LZ4 frame decompression fed in pieces
+ *
+ * Blocks are decompressed straight from the input where they are complete,
+ * and gathered in @carry where they straddle two pieces.
+ */
+struct ulz4_stream {
+	u8 *dst;
+	u8 *out;
+	u8 *end;
+	u8 *carry;
+	size_t carry_size;
+	size_t have;
+	size_t need;
+	u32 block;
+	int state;
+	bool has_block_checksum;
+};
+
+/**
+ * ulz4_stream_init() - start decompressing an LZ4 frame in pieces
+ *
+ * This allocates memory, so it must be called from the boot core.
+ *
+ * @s:		Stream to set up
+ * @head:	Start of the frame, used to size the carry buffer (or NULL)
+ * @headn:	Number of bytes at @head
+ * @dst:	Destination buffer
+ * @dstn:	Size of @dst
+ * @return 0 if OK, -ENOMEM if out of memory
+ */
+int ulz4_stream_init(struct ulz4_stream *s, const void *head, size_t headn,
+		     void *dst, size_t dstn);
+
+/**
+ * ulz4_stream_feed() - decompress the next piece of an LZ4 frame
+ *
+ * This does not allocate memory or print, so it can run as an SMP job.
+ *
+ * @s:		Stream
+ * @src:	Next piece of input
+ * @srcn:	Size of @src
+ * @return 0 if OK, -ve on error
+ */
+int ulz4_stream_feed(struct ulz4_stream *s, const void *src, size_t srcn);
+
+/**
+ * ulz4_stream_end() - finish decompressing and free the stream
+ *
+ * @s:		Stream
+ * @dstn:	Returns the number of bytes decompressed
+ * @return 0 if the whole frame was seen, -EINVAL if it was cut short
+ */
+int ulz4_stream_end(struct ulz4_stream *s, size_t *dstn);
+
+/* lib/zstd.c */
+bool zstd_is_valid_header(const unsigned char *h);
+
+/**
+ * zstd_decompress() - decompress Zstandard frames
+ *
+ * Frames are decompressed one after another until the input ends or stops
+ * starting with a frame (or skippable frame) magic number.
+ *
+ * @src:	Compressed data
+ * @srcn:	Size of @src, may be larger than the data
+ * @dst:	Destination buffer
+ * @dstn:	Size of @dst on entry, number of bytes written on exit
+ * @return 0 if OK, -EPROTONOSUPPORT if not Zstandard or a dictionary is
+ *	needed, -EINVAL if the input is cut short, -ENOBUFS if @dst is too
+ *	small (it is then filled), -EPROTO if the data is corrupt, -ENOMEM
+ *	if out of memory
+ */
+int zstd_decompress(const void *src, size_t srcn, void *dst, size_t *dstn);
+
 /* lib/qsort.c */
 void qsort(void *base, size_t nmemb, size_t size,
 	   int(*compar)(const void *, const void *));
@@ -31,6 +31,15 @@
 #define CONFIG_SPL_STACK		0xff718000
 
 #define CONFIG_SYS_BOOTM_LEN		(64 << 20)	/*  64M */
+
+#ifdef FTRACE
+#define CONFIG_TRACE
+#define CONFIG_TRACE_BUFFER_SIZE	(16 << 20)
+#define CONFIG_TRACE_EARLY_SIZE		(16 << 20)
+#define CONFIG_TRACE_EARLY
+/* Above the kernel, FDT and ramdisk load addresses */
+#define CONFIG_TRACE_EARLY_ADDR		0x08000000
+#endif
 #define GICD_BASE			0xffc01000
 #define GICC_BASE			0xffc02000
 
@@ -24,6 +24,7 @@
 #endif
 
 #define CONFIG_LMB
+#define CONFIG_BOUNCE_BUFFER
 
 #define CONFIG_FS_EXT4
 #define CONFIG_EXT4_WRITE
@@ -49,6 +50,12 @@
 
 #define CONFIG_I2C_EDID
 
+/* UBI on the simulated NAND */
+#ifdef CONFIG_CMD_UBI
+#define CONFIG_MTD_DEVICE
+#define CONFIG_MTD_PARTITIONS
+#endif
+
 /* Memory things - we don't really want a memory test */
 #define CONFIG_SYS_LOAD_ADDR		0x00000000
 #define CONFIG_SYS_MEMTEST_START	0x00100000
@@ -54,6 +54,113 @@ void console_record_reset_enable(void);
  */
 int console_announce_r(void);
 
+/**
+ * struct console_ring_hdr - header of the deferred console output buffer
+ *
+ * The buffer is handed to the OS through a reserved-memory node with the
+ * compatible string "u-boot,console-ring". @head and @tail are free-running
+ * byte counters: the last min(@head, @size) bytes before @head are the most
+ * recent U-Boot output, and the bytes from @tail to @head never reached the
+ * serial port.
+ *
+ * @magic:	CONSOLE_RING_MAGIC
+ * @size:	Size of the data area following the header, a power of two
+ * @head:	Number of bytes written by U-Boot
+ * @tail:	Number of bytes sent to the serial port
+ */
+struct console_ring_hdr {
+	u32 magic;
+	u32 size;
+	u32 head;
+	u32 tail;
+};
+
+#define CONSOLE_RING_MAGIC	0x52434255	/* "UBCR" */
+
+#if CONFIG_IS_ENABLED(CONSOLE_RING)
+/**
+ * console_ring_init() - set up the deferred console output buffer
+ *
+ * This should be called as soon as malloc() is available. From then on,
+ * output to the serial console is appended to the buffer and sent out as
+ * the UART can take it, instead of waiting for each character.
+ *
+ * @return 0 if OK, -ENOMEM if the buffer cannot be allocated
+ */
+int console_ring_init(void);
+
+/**
+ * console_ring_active() - check whether serial output goes through the buffer
+ *
+ * @return true if console_ring_putc() should be used for the serial port
+ */
+bool console_ring_active(void);
+
+/**
+ * console_ring_putc() - queue a character for the serial console
+ *
+ * Sends out whatever the UART can take without waiting. If the buffer is
+ * full, waits until there is room, so no output is dropped. With the
+ * 'consolesync' environment variable set, waits until the character has
+ * been sent.
+ *
+ * @c:		Character to queue
+ */
+void console_ring_putc(const char c);
+
+/**
+ * console_ring_drain() - send pending output without waiting for the UART
+ *
+ * Called at idle points, such as while polling for console input.
+ */
+void console_ring_drain(void);
+
+/**
+ * console_ring_flush() - send all pending output, waiting for the UART
+ */
+void console_ring_flush(void);
+
+/**
+ * console_ring_handoff() - stop deferring output before starting the OS
+ *
+ * Sends out all pending output unless CONFIG_CONSOLE_RING_FLUSH_ON_BOOT is
+ * disabled, in which case it is left in the buffer for the OS. Output after
+ * this call goes straight to the serial port.
+ */
+void console_ring_handoff(void);
+
+/**
+ * console_ring_fdt_fixup() - hand the buffer over to the OS
+ *
+ * Adds a no-map node for the buffer under /reserved-memory so that the OS
+ * can pick up U-Boot's output, including anything not yet sent out.
+ *
+ * @blob:	Device tree to update
+ * @return 0 if OK, -ve FDT error code on error
+ */
+int console_ring_fdt_fixup(void *blob);
+#else
+static inline int console_ring_init(void)
+{
+	return 0;
+}
+
+static inline bool console_ring_active(void)
+{
+	return false;
+}
+
+static inline void console_ring_putc(const char c) {}
+static inline void console_ring_drain(void) {}
+static inline void console_ring_flush(void) {}
+static inline void console_ring_handoff(void) {}
+
+static inline int console_ring_fdt_fixup(void *blob)
+{
+	return 0;
+}
+#endif
+
 /*
  * CONSOLE multiplexing.
  */
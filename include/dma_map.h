@@ -0,0 +1,102 @@
+/*
+ * Cache maintenance for DMA buffers
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __DMA_MAP_H
+#define __DMA_MAP_H
+
+#include <linux/dma-direction.h>
+
+/**
+ * struct dma_map_stats - cache maintenance done for DMA since boot
+ *
+ * @flush_bytes:	Bytes cleaned and invalidated by address
+ * @inval_bytes:	Bytes invalidated by address
+ * @skip_bytes:		Bytes needing no maintenance (uncached or D-cache off)
+ * @flush_ops:		Number of flush_dcache_range() calls
+ * @inval_ops:		Number of invalidate_dcache_range() calls
+ * @setway_ops:		Number of ranges handled with flush_dcache_all()
+ */
+struct dma_map_stats {
+	u64 flush_bytes;
+	u64 inval_bytes;
+	u64 skip_bytes;
+	ulong flush_ops;
+	ulong inval_ops;
+	ulong setway_ops;
+};
+
+/**
+ * dcache_range_cached() - check whether a range may be held in the D-cache
+ *
+ * The default says yes whenever the D-cache is on. Architectures which know
+ * the attributes of each region override it.
+ *
+ * @start:	Start address
+ * @end:	End address (exclusive)
+ * @return true if any part of the range may be cached
+ */
+bool dcache_range_cached(ulong start, ulong end);
+
+#if CONFIG_IS_ENABLED(DMA_MAP)
+/**
+ * dma_map_range() - hand a buffer to a device
+ *
+ * Writes back the buffer for DMA_TO_DEVICE and DMA_BIDIRECTIONAL and drops
+ * it from the D-cache for DMA_FROM_DEVICE, so that the device sees what the
+ * CPU wrote and later CPU writebacks cannot overwrite what the device
+ * writes. The range is widened to whole cache lines.
+ *
+ * @start:	Start address of the buffer
+ * @len:	Length in bytes
+ * @dir:	Which way the data goes
+ */
+void dma_map_range(ulong start, size_t len, enum dma_data_direction dir);
+
+/**
+ * dma_unmap_range() - take a buffer back from a device
+ *
+ * Drops the buffer from the D-cache for DMA_FROM_DEVICE and
+ * DMA_BIDIRECTIONAL, since lines may have been fetched while the device was
+ * writing.
+ *
+ * @start:	Start address of the buffer
+ * @len:	Length in bytes
+ * @dir:	Direction given to dma_map_range()
+ */
+void dma_unmap_range(ulong start, size_t len, enum dma_data_direction dir);
+
+/**
+ * dma_map_get_stats() - get the maintenance done since boot
+ *
+ * @return pointer to the counters
+ */
+const struct dma_map_stats *dma_map_get_stats(void);
+
+/**
+ * dma_map_print_stats() - show the maintenance done since boot
+ */
+void dma_map_print_stats(void);
+#else
+static inline void dma_map_range(ulong start, size_t len,
+				 enum dma_data_direction dir)
+{
+	flush_dcache_range(rounddown(start, ARCH_DMA_MINALIGN),
+			   roundup(start + len, ARCH_DMA_MINALIGN));
+}
+
+static inline void dma_unmap_range(ulong start, size_t len,
+				   enum dma_data_direction dir)
+{
+	if (dir != DMA_TO_DEVICE)
+		invalidate_dcache_range(rounddown(start, ARCH_DMA_MINALIGN),
+					roundup(start + len,
+						ARCH_DMA_MINALIGN));
+}
+
+static inline void dma_map_print_stats(void) {}
+#endif
+
+#endif /* __DMA_MAP_H */
@@ -25,6 +25,12 @@
 #define SILENT_CALLBACK
 #endif
 
+#ifdef CONFIG_CONSOLE_RING
+#define CONSOLE_RING_CALLBACK "consolesync:consolesync,"
+#else
+#define CONSOLE_RING_CALLBACK
+#endif
+
 #ifdef CONFIG_SPLASHIMAGE_GUARD
 #define SPLASHIMAGE_CALLBACK "splashimage:splashimage,"
 #else
@@ -70,6 +76,7 @@
 	NET_CALLBACKS \
 	"loadaddr:loadaddr," \
 	SILENT_CALLBACK \
+	CONSOLE_RING_CALLBACK \
 	SPLASHIMAGE_CALLBACK \
 	"stdin:console,stdout:console,stderr:console," \
 	"serial#:serialno," \
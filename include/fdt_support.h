@@ -105,6 +105,22 @@ static inline int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[],
 
 int fdt_update_reserved_memory(void *blob, char *name, u64 start, u64 size);
 
+/**
+ * fdt_add_reserved_memory_node() - describe a no-map region to the OS
+ *
+ * Adds a <name>@<addr> node under /reserved-memory, creating that node if
+ * needed, or updates the node if it is already there.
+ *
+ * @blob:	Device tree to update
+ * @name:	Base name of the node, e.g. "console-ring"
+ * @compatible:	Compatible string for the node
+ * @addr:	Start of the region
+ * @size:	Size of the region
+ * @return 0 if OK, -ve FDT error code on error
+ */
+int fdt_add_reserved_memory_node(void *blob, const char *name,
+				 const char *compatible, u64 addr, u64 size);
+
 void fdt_fixup_ethernet(void *fdt);
 int fdt_find_and_setprop(void *fdt, const char *node, const char *prop,
 			 const void *val, int len, int create);
@@ -0,0 +1,138 @@
+/*
+ * Fixed size-class pool allocator in front of dlmalloc
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __MALLOC_POOL_H
+#define __MALLOC_POOL_H
+
+#include <errno.h>
+#include <linux/types.h>
+
+/* Size classes are powers of two from 512 bytes up to 64KiB */
+#define MALLOC_POOL_MIN_SHIFT	9
+#define MALLOC_POOL_MAX_SHIFT	16
+#define MALLOC_POOL_CLASSES	(MALLOC_POOL_MAX_SHIFT - \
+				 MALLOC_POOL_MIN_SHIFT + 1)
+
+/**
+ * struct malloc_pool_class_stats - usage counters of one size class
+ *
+ * @size:	Size of each slot in bytes
+ * @slots:	Number of slots in the class
+ * @used:	Slots currently handed out
+ * @peak:	Highest value of @used since the last reset
+ * @hits:	Requests served from this class
+ * @misses:	Requests that fitted this class but fell back to dlmalloc
+ *		because every slot was in use
+ * @req_bytes:	Sum of the requested sizes of the slots in use, used to
+ *		work out internal fragmentation
+ */
+struct malloc_pool_class_stats {
+	ulong size;
+	uint slots;
+	uint used;
+	uint peak;
+	ulong hits;
+	ulong misses;
+	u64 req_bytes;
+};
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_POOL)
+/**
+ * malloc_pool_alloc() - allocate a buffer from the size-class pool
+ *
+ * @bytes:	Number of bytes requested
+ * @align:	Required alignment, or 0 for the default malloc alignment
+ * @return pointer to the buffer, or NULL if the request does not fit a
+ * size class or the class is exhausted (the caller then falls back to
+ * dlmalloc)
+ */
+void *malloc_pool_alloc(size_t bytes, size_t align);
+
+/**
+ * malloc_pool_free() - return a buffer to the pool
+ *
+ * @mem:	Buffer to release
+ * A pointer into the pool which is not the start of an allocated slot is
+ * reported and otherwise ignored.
+ *
+ * @return true if @mem points into the pool, false if it is not a pool
+ * buffer and must be freed by dlmalloc
+ */
+bool malloc_pool_free(void *mem);
+
+/**
+ * malloc_pool_usable_size() - get the usable size of a pool buffer
+ *
+ * @mem:	Buffer to check
+ * @return size of the slot holding @mem, or 0 if it is not a pool buffer
+ */
+size_t malloc_pool_usable_size(void *mem);
+
+/**
+ * malloc_pool_realloc() - resize a pool buffer
+ *
+ * The buffer is kept in place when the new size still fits its slot,
+ * otherwise a new buffer is allocated and the old one released.
+ *
+ * @mem:	Pool buffer to resize
+ * @bytes:	New size in bytes
+ * @return pointer to the resized buffer, or NULL if out of memory
+ */
+void *malloc_pool_realloc(void *mem, size_t bytes);
+
+/**
+ * malloc_pool_get_stats() - read the counters of one size class
+ *
+ * @idx:	Size class, 0 for the smallest
+ * @stats:	Returns the counters
+ * @return 0 if OK, -EINVAL if @idx is out of range, -ENOENT if the pool
+ * has not been set up
+ */
+int malloc_pool_get_stats(int idx, struct malloc_pool_class_stats *stats);
+
+/**
+ * malloc_pool_print_stats() - print peak usage, fragmentation and hit rate
+ * of each size class
+ */
+void malloc_pool_print_stats(void);
+
+/**
+ * malloc_pool_reset_stats() - clear the hit/miss counters and set the peak
+ * usage of each class to its current usage
+ */
+void malloc_pool_reset_stats(void);
+#else
+static inline void *malloc_pool_alloc(size_t bytes, size_t align)
+{
+	return NULL;
+}
+
+static inline bool malloc_pool_free(void *mem)
+{
+	return false;
+}
+
+static inline size_t malloc_pool_usable_size(void *mem)
+{
+	return 0;
+}
+
+static inline void *malloc_pool_realloc(void *mem, size_t bytes)
+{
+	return NULL;
+}
+
+static inline int malloc_pool_get_stats(int idx,
+					struct malloc_pool_class_stats *stats)
+{
+	return -ENOSYS;
+}
+
+static inline void malloc_pool_print_stats(void) {}
+static inline void malloc_pool_reset_stats(void) {}
+#endif
+
+#endif
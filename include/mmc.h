@@ -194,6 +194,7 @@
 #define EXT_CSD_CARD_TYPE		196	/* RO */
 #define EXT_CSD_SEC_CNT			212	/* RO, 4 bytes */
 #define EXT_CSD_HC_WP_GRP_SIZE		221	/* RO */
+#define EXT_CSD_ERASE_TIMEOUT_MULT	223	/* RO */
 #define EXT_CSD_HC_ERASE_GRP_SIZE	224	/* RO */
 #define EXT_CSD_BOOT_MULT		226	/* RO */
 #define EXT_CSD_SEC_FEATURE_SUPPORT     231     /* RO */
@@ -359,6 +360,7 @@ struct mmc_uclass_priv {
 
 struct emmc_esr {
 	unsigned int mmc_can_trim;
+	unsigned int erase_timeout;	/* Per erase group, in milliseconds */
 };
 
 /**
@@ -0,0 +1,70 @@
+/*
+ * RAM-backed NAND flash simulator
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __NANDSIM_H
+#define __NANDSIM_H
+
+struct mtd_info;
+
+/**
+ * struct nandsim_stats - operations seen by a simulated NAND
+ *
+ * @reads:	Number of read calls
+ * @read_bytes:	Bytes read
+ * @writes:	Number of write calls
+ * @erases:	Number of blocks erased
+ */
+struct nandsim_stats {
+	uint reads;
+	uint read_bytes;
+	uint writes;
+	uint erases;
+};
+
+/**
+ * nandsim_create() - create and register a simulated NAND
+ *
+ * The flash starts out erased with no bad blocks. Like real NAND, writes
+ * must cover whole pages and can only clear bits.
+ *
+ * @name:	MTD device name
+ * @size:	Size of the flash in bytes
+ * @erasesize:	Size of an erase block in bytes, a power of two
+ * @writesize:	Size of a page in bytes, a power of two
+ * @return the new MTD device, or NULL if out of memory
+ */
+struct mtd_info *nandsim_create(const char *name, uint size, uint erasesize,
+				uint writesize);
+
+/**
+ * nandsim_destroy() - unregister a simulated NAND and free its memory
+ *
+ * @mtd:	MTD device returned by nandsim_create()
+ */
+void nandsim_destroy(struct mtd_info *mtd);
+
+/**
+ * nandsim_set_read_error() - make reads of an erase block fail
+ *
+ * Until the block is next erased, reads from it return @err: -EUCLEAN for
+ * a corrected bitflip (the data is still returned) or -EBADMSG for an
+ * uncorrectable ECC error.
+ *
+ * @mtd:	MTD device returned by nandsim_create()
+ * @block:	Erase block number
+ * @err:	Error to return, or 0 to read normally again
+ */
+void nandsim_set_read_error(struct mtd_info *mtd, int block, int err);
+
+/**
+ * nandsim_get_stats() - get the operations seen since creation
+ *
+ * @mtd:	MTD device returned by nandsim_create()
+ * @return pointer to the counters
+ */
+const struct nandsim_stats *nandsim_get_stats(struct mtd_info *mtd);
+
+#endif /* __NANDSIM_H */
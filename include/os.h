@@ -163,6 +163,38 @@ void *os_realloc(void *ptr, size_t length);
  */
 void os_usleep(unsigned long usec);
 
+/**
+ * Start a detached host thread
+ *
+ * The thread shares all U-Boot memory with the caller, so it must not use
+ * anything that is not safe to run on two threads at once.
+ *
+ * \param func	Function to run in the thread
+ * \param arg	Argument passed to \p func
+ * \return 0 if OK, -ve error number on error
+ */
+int os_thread_create(void *(*func)(void *), void *arg);
+
+/**
+ * Let other host threads run
+ */
+void os_thread_yield(void);
+
+/**
+ * Sleep until another host thread calls os_thread_wake()
+ *
+ * Returns at once if there was a call since this thread last returned from
+ * here, so a caller can check its condition and then wait without missing
+ * a wake in between. It may also return early, so the condition must be
+ * checked again.
+ */
+void os_thread_wait(void);
+
+/**
+ * Wake all host threads sleeping in os_thread_wait()
+ */
+void os_thread_wake(void);
+
 /**
  * Gets a monotonic increasing number of nano seconds from the OS
  *
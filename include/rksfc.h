@@ -17,4 +17,12 @@
  * @return:	0 on success, -ve on error
  */
 int rksfc_scan_namespace(void);
+
+/**
+ * rksfc_nor_print_stats - show what SPI Nor writes have done since boot
+ *
+ * This prints the bytes asked to be written, those skipped because the
+ * flash already held them, those programmed, and the erases of each size.
+ */
+void rksfc_nor_print_stats(void);
 #endif
@@ -40,6 +40,7 @@ enum rkusb_cmd {
 	RKUSB_VS_WRITE		= 0x26,
 	RKUSB_VS_READ		= 0x27,
 	RKUSB_SESSION		= 0x30,
+	RKUSB_XFER_STATS	= 0x32,
 	RKUSB_READ_CAPACITY	= 0xAA,
 	RKUSB_RESET		= 0xFF,
 };
@@ -47,6 +47,16 @@ extern void serial_stdio_init(void);
 extern int serial_assign(const char *name);
 extern void serial_reinit_all(void);
 
+/**
+ * serial_tryputc() - write a character to the console UART without waiting
+ *
+ * Unlike serial_putc(), no carriage return is added before a newline.
+ *
+ * @ch:		Character to write
+ * @return 0 if written, -EAGAIN if the UART cannot take it yet
+ */
+int serial_tryputc(char ch);
+
 /* For usbtty */
 #ifdef CONFIG_USB_TTY
 
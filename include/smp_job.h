@@ -0,0 +1,168 @@
+/*
+ * Running boot-time jobs on secondary cores
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __SMP_JOB_H
+#define __SMP_JOB_H
+
+/* Highest number of secondary cores that can take jobs */
+#define SMP_JOB_MAX_WORKERS	8
+
+/**
+ * struct smp_job - a piece of work that can run on another core
+ *
+ * Jobs must only touch the memory they are given: they cannot print,
+ * allocate memory, use driver model or submit other jobs, since none of
+ * that is safe to do from two cores at once.
+ *
+ * @fn:		Function to run, returning 0 or a -ve error code
+ * @arg:	Argument passed to @fn
+ * @ret:	Return value of @fn, valid once the job is done
+ * @done:	Set when the job has finished (internal)
+ */
+struct smp_job {
+	int (*fn)(void *arg);
+	void *arg;
+	int ret;
+	int done;
+};
+
+/**
+ * smp_job_init_one() - set up a job
+ *
+ * @job:	Job to set up
+ * @fn:		Function to run
+ * @arg:	Argument passed to @fn
+ */
+static inline void smp_job_init_one(struct smp_job *job,
+				    int (*fn)(void *arg), void *arg)
+{
+	job->fn = fn;
+	job->arg = arg;
+	job->ret = 0;
+	job->done = 0;
+}
+
+#if CONFIG_IS_ENABLED(SMP_JOB)
+/**
+ * smp_job_init() - bring up the secondary cores as job workers
+ *
+ * Cores which fail to start are left off and their share of the work runs
+ * on the boot core instead.
+ *
+ * @return 0 (always, so that it can be used in an init sequence)
+ */
+int smp_job_init(void);
+
+/**
+ * smp_job_workers() - get the number of secondary cores taking jobs
+ *
+ * @return number of running workers, 0 if jobs run on the boot core only
+ */
+int smp_job_workers(void);
+
+/**
+ * smp_job_submit() - start a job
+ *
+ * The job is handed to an idle secondary core. If there is none, it runs
+ * on the calling core before this function returns. Jobs can only be
+ * submitted from the boot core.
+ *
+ * @job:	Job to start, set up with smp_job_init_one()
+ */
+void smp_job_submit(struct smp_job *job);
+
+/**
+ * smp_job_wait() - wait for a job to finish
+ *
+ * @job:	Job to wait for
+ * @return the value returned by the job's function
+ */
+int smp_job_wait(struct smp_job *job);
+
+/**
+ * smp_job_park() - stop all workers and power down their cores
+ *
+ * This must be called before starting an OS, which expects the secondary
+ * cores to be off. It waits for running jobs to finish.
+ */
+void smp_job_park(void);
+
+/**
+ * smp_job_worker() - job loop of a secondary core
+ *
+ * Called by the architecture code on each secondary core once it can run
+ * C code with caches enabled. Returns when smp_job_park() is called, after
+ * which the core should be taken offline.
+ *
+ * @cpu:	Worker number, from 0 to arch_smp_job_cpus() - 1
+ */
+void smp_job_worker(uint cpu);
+
+/* Architecture hooks, all with weak defaults that keep jobs on one core */
+
+/**
+ * arch_smp_job_cpus() - get the number of secondary cores that can be used
+ *
+ * @return number of cores, at most SMP_JOB_MAX_WORKERS
+ */
+int arch_smp_job_cpus(void);
+
+/**
+ * arch_smp_job_start() - start a secondary core
+ *
+ * The core must end up calling smp_job_worker() with @cpu.
+ *
+ * @cpu:	Worker number to start
+ * @return 0 if OK, -ve on error
+ */
+int arch_smp_job_start(uint cpu);
+
+/**
+ * arch_smp_job_stop() - take a secondary core offline
+ *
+ * Called once the core has been asked to leave smp_job_worker(). This waits
+ * for it to do so and powers it down.
+ *
+ * @cpu:	Worker number to stop
+ * @return 0 if OK, -ETIMEDOUT if the core did not stop
+ */
+int arch_smp_job_stop(uint cpu);
+
+/**
+ * arch_smp_job_idle() - wait a little for other cores to make progress
+ */
+void arch_smp_job_idle(void);
+
+/**
+ * arch_smp_job_wake() - wake cores waiting in arch_smp_job_idle()
+ */
+void arch_smp_job_wake(void);
+#else
+static inline int smp_job_init(void)
+{
+	return 0;
+}
+
+static inline int smp_job_workers(void)
+{
+	return 0;
+}
+
+static inline void smp_job_submit(struct smp_job *job)
+{
+	job->ret = job->fn(job->arg);
+	job->done = 1;
+}
+
+static inline int smp_job_wait(struct smp_job *job)
+{
+	return job->ret;
+}
+
+static inline void smp_job_park(void) {}
+#endif
+
+#endif
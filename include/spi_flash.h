@@ -190,6 +190,16 @@ int sandbox_sf_bind_emul(struct sandbox_state *state, int busnum, int cs,
 
 void sandbox_sf_unbind_emul(struct sandbox_state *state, int busnum, int cs);
 
+/**
+ * sandbox_sf_get_reads() - get the number of read commands an emulated
+ * SPI flash has seen, so that tests can tell reads which went through a
+ * memory-mapped window from those which did not
+ *
+ * @emul:	SPI flash emulator device
+ * @return number of read commands since the emulator was probed
+ */
+uint sandbox_sf_get_reads(struct udevice *emul);
+
 #else
 struct spi_flash *spi_flash_probe(unsigned int bus, unsigned int cs,
 		unsigned int max_hz, unsigned int spi_mode);
@@ -25,7 +25,7 @@ struct spl_image_info {
 	u8 os;
 	uintptr_t load_addr;
 	uintptr_t entry_point;
-#if CONFIG_IS_ENABLED(LOAD_FIT)
+#if CONFIG_IS_ENABLED(LOAD_FIT) || defined(CONFIG_UT_SPL_FIT)
 	void *fdt_addr;
 #endif
 	u32 size;
@@ -65,6 +65,16 @@ struct spl_load_info {
 int spl_load_simple_fit(struct spl_image_info *spl_image,
 			struct spl_load_info *info, ulong sector, void *fdt);
 
+/**
+ * board_spl_fit_buffer_end() - get where the FIT header must end
+ *
+ * spl_load_simple_fit() reads the FIT header to just below this address.
+ * The default is CONFIG_SYS_TEXT_BASE.
+ *
+ * @return address the FIT header ends before
+ */
+ulong board_spl_fit_buffer_end(void);
+
 #define SPL_COPY_PAYLOAD_ONLY	1
 
 /* SPL common functions */
@@ -10,7 +10,14 @@
 
 int do_ut_dm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 int do_ut_env(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_mem(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 int do_ut_overlay(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_rksfc(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_smp(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_spl_fit(cmd_tbl_t *cmdtp, int flag, int argc,
+		  char * const argv[]);
+int do_ut_ubi(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
+int do_ut_ubifs(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 int do_ut_time(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 
 #endif /* __TEST_SUITES_H__ */
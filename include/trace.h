@@ -91,6 +91,35 @@ void trace_set_enabled(int enabled);
 
 int trace_early_init(void);
 
+#if defined(CONFIG_TRACE_EARLY) && defined(CONFIG_TRACE_HANDOFF)
+/**
+ * trace_handoff() - stop tracing and leave the calls for the OS
+ *
+ * Writes the call records in the format read by tools/proftool (a
+ * TRACE_CHUNK_CALLS header followed by struct trace_call records) to the
+ * start of the early trace buffer.
+ */
+void trace_handoff(void);
+
+/**
+ * trace_fdt_fixup() - hand the trace buffer over to the OS
+ *
+ * Adds a no-map node for the early trace buffer under /reserved-memory,
+ * with the compatible string "u-boot,trace".
+ *
+ * @blob:	Device tree to update
+ * @return 0 if OK, -ve FDT error code on error
+ */
+int trace_fdt_fixup(void *blob);
+#else
+static inline void trace_handoff(void) {}
+
+static inline int trace_fdt_fixup(void *blob)
+{
+	return 0;
+}
+#endif
+
 /**
  * Init the trace system
  *
@@ -724,6 +724,9 @@ ZEXTERN int ZEXPORT inflateInit2_ OF((z_streamp strm, int  windowBits,
 extern void *gzalloc(void *, unsigned, unsigned);
 extern void gzfree(void *, void *, unsigned);
 
+/* Use the wide inflate loop (CONFIG_ZLIB_INFLATE_WIDE); on by default */
+extern int zlib_inflate_wide;
+
 #ifdef __cplusplus
 }
 #endif
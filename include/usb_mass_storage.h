@@ -29,7 +29,27 @@ struct ums {
 	struct blk_desc block_dev;
 };
 
+/* Transfer statistics collected by the mass storage function */
+struct ums_stats {
+	u64 read_bytes;		/* Data sent to the host */
+	u64 write_bytes;	/* Data received from the host */
+	u64 read_us;		/* Time spent in READ commands */
+	u64 write_us;		/* Time spent in WRITE commands */
+	u64 dev_read_us;	/* Time spent in ->read_sector() */
+	u64 dev_write_us;	/* Time spent in ->write_sector() */
+	u64 erase_bytes;	/* Data erased on request of the host */
+	u64 erase_us;		/* Time spent in ->erase_sector() */
+	u32 dev_reads;		/* Number of ->read_sector() calls */
+	u32 dev_writes;		/* Number of ->write_sector() calls */
+	u32 ra_hits;		/* READs served from the read-ahead buffer */
+	u32 ra_misses;		/* Read-ahead data that was never used */
+	u32 wb_deferred;	/* Writes overlapped with the next transfer */
+};
+
 int fsg_init(struct ums *ums_devs, int count);
+void fsg_get_stats(struct ums_stats *stats);
+void fsg_print_stats(void);
+void fsg_reset_stats(void);
 void fsg_cleanup(void);
 int fsg_main_thread(void *);
 int fsg_add(struct usb_configuration *c);
@@ -6,6 +6,8 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <malloc.h>
+#include <smp_job.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 
@@ -77,35 +79,52 @@ bool lz4_is_valid_header(const unsigned char *h)
 	return true;
 }
 
+/*
+ * Check the frame header at @src and return the offset of the first block,
+ * or a -ve error. The header is parsed before anything is written, since with
+ * in-place decompression it may become invalid later.
+ */
+static int ulz4_frame_start(const void *src, size_t srcn,
+			    int *has_block_checksum, size_t *block_max)
+{
+	const struct lz4_frame_header *h = src;
+	int len;
+
+	if (srcn < sizeof(*h) + sizeof(u64) + sizeof(u8))
+		return -EINVAL;	/* input overrun */
+
+	/* We assume there's always only a single, standard frame. */
+	if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
+		return -EPROTONOSUPPORT;	/* unknown format */
+	if (h->reserved0 || h->reserved1 || h->reserved2)
+		return -EINVAL;	/* reserved must be zero */
+	if (!h->independent_blocks)
+		return -EPROTONOSUPPORT; /* we can't support this yet */
+	*has_block_checksum = h->has_block_checksum;
+	*block_max = 1 << (8 + 2 * h->max_block_size);
+
+	len = sizeof(*h);
+	if (h->has_content_size)
+		len += sizeof(u64);
+	len += sizeof(u8);
+
+	return len;
+}
+
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 {
 	const void *end = dst + *dstn;
 	const void *in = src;
 	void *out = dst;
 	int has_block_checksum;
+	size_t block_max;
 	int ret;
 	*dstn = 0;
 
-	{ /* With in-place decompression the header may become invalid later. */
-		const struct lz4_frame_header *h = in;
-
-		if (srcn < sizeof(*h) + sizeof(u64) + sizeof(u8))
-			return -EINVAL;	/* input overrun */
-
-		/* We assume there's always only a single, standard frame. */
-		if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
-			return -EPROTONOSUPPORT;	/* unknown format */
-		if (h->reserved0 || h->reserved1 || h->reserved2)
-			return -EINVAL;	/* reserved must be zero */
-		if (!h->independent_blocks)
-			return -EPROTONOSUPPORT; /* we can't support this yet */
-		has_block_checksum = h->has_block_checksum;
-
-		in += sizeof(*h);
-		if (h->has_content_size)
-			in += sizeof(u64);
-		in += sizeof(u8);
-	}
+	ret = ulz4_frame_start(src, srcn, &has_block_checksum, &block_max);
+	if (ret < 0)
+		return ret;
+	in += ret;
 
 	while (1) {
 		struct lz4_block_header b;
@@ -151,3 +170,291 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 	*dstn = out - dst;
 	return ret;
 }
+
+/* A block of an LZ4 frame and where its output goes */
+struct ulz4_block {
+	const u8 *in;
+	u8 *out;
+	size_t out_max;
+	u32 raw;
+	int ret;	/* bytes written or -ve error */
+};
+
+/* A run of consecutive blocks decoded by one core */
+struct ulz4_batch {
+	struct smp_job job;
+	struct ulz4_block *blocks;
+	int count;
+};
+
+static int ulz4_batch_run(void *arg)
+{
+	struct ulz4_batch *batch = arg;
+	struct ulz4_block *blk;
+	struct lz4_block_header b;
+	int i;
+
+	for (i = 0; i < batch->count; i++) {
+		blk = &batch->blocks[i];
+		b.raw = blk->raw;
+		if (b.not_compressed) {
+			if (b.size > blk->out_max)
+				return -ENOBUFS;
+			memcpy(blk->out, blk->in, b.size);
+			blk->ret = b.size;
+		} else {
+			blk->ret = LZ4_decompress_generic((const char *)blk->in,
+					(char *)blk->out, b.size, blk->out_max,
+					endOnInputSize, full, 0, noDict,
+					blk->out, NULL, 0);
+			if (blk->ret < 0)
+				return -EPROTO;
+		}
+	}
+
+	return 0;
+}
+
+int ulz4fn_parallel(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	struct ulz4_batch batches[SMP_JOB_MAX_WORKERS + 1];
+	struct ulz4_block *blocks = NULL;
+	const u8 *in, *src_end = src + srcn;
+	u8 *out, *end = dst + *dstn;
+	int has_block_checksum;
+	size_t block_max;
+	int count, nbatch, per, i, ret;
+	struct lz4_block_header b;
+	bool ended;
+
+	/* Blocks are decoded out of order, so the input must stay intact */
+	if (!smp_job_workers() || (src < (void *)end && dst < (void *)src_end))
+		return ulz4fn(src, srcn, dst, dstn);
+
+	ret = ulz4_frame_start(src, srcn, &has_block_checksum, &block_max);
+	if (ret < 0)
+		return ret;
+
+	/* Count the blocks, then note where each one starts and ends up */
+	for (i = 0; i < 2; i++) {
+		in = src + ret;
+		out = dst;
+		count = 0;
+		ended = false;
+		while (in + sizeof(b) <= src_end) {
+			b.raw = le32_to_cpu(*(u32 *)in);
+			in += sizeof(b);
+			if (!b.size) {
+				ended = true;
+				break;
+			}
+			if (b.size > (size_t)(src_end - in))
+				break;
+			if (blocks) {
+				blocks[count].in = in;
+				blocks[count].out = out;
+				blocks[count].out_max = min_t(size_t, block_max,
+							      end - out);
+				blocks[count].raw = b.raw;
+			}
+			count++;
+			/*
+			 * Every block but the last decompresses to block_max
+			 * bytes; this is checked below.
+			 */
+			out += b.not_compressed ? b.size : block_max;
+			if (out > end)
+				out = end;
+			in += b.size;
+			if (has_block_checksum)
+				in += sizeof(u32);
+		}
+		/* Leave errors in the frame to the sequential decoder */
+		if (count < 2 || !ended) {
+			free(blocks);
+			return ulz4fn(src, srcn, dst, dstn);
+		}
+		if (!blocks) {
+			blocks = malloc(count * sizeof(*blocks));
+			if (!blocks)
+				return ulz4fn(src, srcn, dst, dstn);
+		}
+	}
+
+	nbatch = min(smp_job_workers() + 1, count);
+	per = DIV_ROUND_UP(count, nbatch);
+	for (i = 0; i < nbatch; i++) {
+		struct ulz4_batch *batch = &batches[i];
+
+		batch->blocks = blocks + i * per;
+		batch->count = min(per, count - i * per);
+		if (batch->count <= 0) {
+			nbatch = i;
+			break;
+		}
+		smp_job_init_one(&batch->job, ulz4_batch_run, batch);
+		smp_job_submit(&batch->job);
+	}
+
+	ret = 0;
+	for (i = 0; i < nbatch; i++) {
+		if (smp_job_wait(&batches[i].job))
+			ret = -EPROTO;
+	}
+
+	/* Check that no block came up short of where the next one starts */
+	for (i = 0; !ret && i < count - 1; i++) {
+		if (blocks[i].out + blocks[i].ret != blocks[i + 1].out)
+			ret = -EPROTO;
+	}
+	if (!ret)
+		*dstn = blocks[count - 1].out + blocks[count - 1].ret -
+			(u8 *)dst;
+	free(blocks);
+
+	/* Let the sequential decoder sort out anything unusual */
+	if (ret)
+		return ulz4fn(src, srcn, dst, dstn);
+
+	return 0;
+}
+
+enum {
+	ULZ4_FRAME_HDR,
+	ULZ4_FRAME_HDR_REST,
+	ULZ4_BLOCK_HDR,
+	ULZ4_BLOCK_DATA,
+	ULZ4_BLOCK_CHECKSUM,
+	ULZ4_DONE,
+};
+
+int ulz4_stream_init(struct ulz4_stream *s, const void *head, size_t headn,
+		     void *dst, size_t dstn)
+{
+	const struct lz4_frame_header *h = head;
+	size_t block_max = 4 << 20;
+
+	/* Size the carry buffer from the frame header if we have it */
+	if (headn >= sizeof(*h) && lz4_is_valid_header(head))
+		block_max = 1 << (8 + 2 * h->max_block_size);
+
+	memset(s, '\0', sizeof(*s));
+	s->carry = malloc(block_max);
+	if (!s->carry)
+		return -ENOMEM;
+	s->carry_size = block_max;
+	s->dst = dst;
+	s->out = dst;
+	s->end = dst + dstn;
+	s->state = ULZ4_FRAME_HDR;
+	s->need = sizeof(*h);
+
+	return 0;
+}
+
+/* Handle one complete header, block or checksum */
+static int ulz4_stream_item(struct ulz4_stream *s, const u8 *in)
+{
+	const struct lz4_frame_header *h;
+	struct lz4_block_header b;
+	int ret;
+
+	switch (s->state) {
+	case ULZ4_FRAME_HDR:
+		h = (const struct lz4_frame_header *)in;
+		if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
+			return -EPROTONOSUPPORT;
+		if (h->reserved0 || h->reserved1 || h->reserved2)
+			return -EINVAL;
+		if (!h->independent_blocks)
+			return -EPROTONOSUPPORT;
+		s->has_block_checksum = h->has_block_checksum;
+		s->state = ULZ4_FRAME_HDR_REST;
+		s->need = (h->has_content_size ? sizeof(u64) : 0) + sizeof(u8);
+		break;
+	case ULZ4_FRAME_HDR_REST:
+		s->state = ULZ4_BLOCK_HDR;
+		s->need = sizeof(struct lz4_block_header);
+		break;
+	case ULZ4_BLOCK_HDR:
+		b.raw = le32_to_cpu(*(u32 *)in);
+		if (!b.size) {
+			s->state = ULZ4_DONE;
+			break;
+		}
+		if (b.size > s->carry_size)
+			return -EINVAL;
+		s->block = b.raw;
+		s->state = ULZ4_BLOCK_DATA;
+		s->need = b.size;
+		break;
+	case ULZ4_BLOCK_DATA:
+		b.raw = s->block;
+		if (b.not_compressed) {
+			if (b.size > (size_t)(s->end - s->out))
+				return -ENOBUFS;
+			memcpy(s->out, in, b.size);
+			s->out += b.size;
+		} else {
+			ret = LZ4_decompress_generic((const char *)in,
+					(char *)s->out, b.size,
+					s->end - s->out, endOnInputSize,
+					full, 0, noDict, s->out, NULL, 0);
+			if (ret < 0)
+				return -EPROTO;
+			s->out += ret;
+		}
+		if (s->has_block_checksum) {
+			s->state = ULZ4_BLOCK_CHECKSUM;
+			s->need = sizeof(u32);
+		} else {
+			s->state = ULZ4_BLOCK_HDR;
+			s->need = sizeof(struct lz4_block_header);
+		}
+		break;
+	case ULZ4_BLOCK_CHECKSUM:
+		s->state = ULZ4_BLOCK_HDR;
+		s->need = sizeof(struct lz4_block_header);
+		break;
+	}
+
+	return 0;
+}
+
+int ulz4_stream_feed(struct ulz4_stream *s, const void *src, size_t srcn)
+{
+	const u8 *in = src;
+	size_t len;
+	int ret;
+
+	while (srcn && s->state != ULZ4_DONE) {
+		if (!s->have && srcn >= s->need) {
+			/* The whole item is here, use it in place */
+			len = s->need;
+			ret = ulz4_stream_item(s, in);
+		} else {
+			len = min(s->need - s->have, srcn);
+			memcpy(s->carry + s->have, in, len);
+			s->have += len;
+			if (s->have < s->need)
+				return 0;
+			s->have = 0;
+			ret = ulz4_stream_item(s, s->carry);
+		}
+		if (ret)
+			return ret;
+		in += len;
+		srcn -= len;
+	}
+
+	return 0;
+}
+
+int ulz4_stream_end(struct ulz4_stream *s, size_t *dstn)
+{
+	*dstn = s->out - s->dst;
+	free(s->carry);
+	s->carry = NULL;
+
+	return s->state == ULZ4_DONE ? 0 : -EINVAL;
+}
@@ -5,6 +5,7 @@
  */
 
 #include <common.h>
+#include <fdt_support.h>
 #include <mapmem.h>
 #include <trace.h>
 #include <asm/io.h>
@@ -297,10 +298,13 @@ int __attribute__((no_instrument_function)) trace_init(void *buff,
 				 CONFIG_TRACE_EARLY_SIZE);
 		end = (char *)&hdr->ftrace[hdr->ftrace_count];
 		used = end - (char *)hdr;
-		printf("trace: copying %08lx bytes of early data from %x to %08lx\n",
-		       used, CONFIG_TRACE_EARLY_ADDR,
-		       (ulong)map_to_sysmem(buff));
-		memcpy(buff, hdr, used);
+		/* With TRACE_HANDOFF we carry on in the early buffer */
+		if (buff != hdr) {
+			printf("trace: copying %08lx bytes of early data from %x to %08lx\n",
+			       used, CONFIG_TRACE_EARLY_ADDR,
+			       (ulong)map_to_sysmem(buff));
+			memcpy(buff, hdr, used);
+		}
 #else
 		puts("trace: already enabled\n");
 		return -1;
@@ -331,6 +335,44 @@ int __attribute__((no_instrument_function)) trace_init(void *buff,
 	return 0;
 }
 
+#if defined(CONFIG_TRACE_EARLY) && defined(CONFIG_TRACE_HANDOFF)
+/**
+ * Stop tracing and leave the call list in the proftool format
+ *
+ * The call records are written over the start of the early trace buffer,
+ * which the OS finds through trace_fdt_fixup(). Each output record is no
+ * larger than the live record it comes from and lies below it, so they can
+ * be converted in place once the header is out of the way.
+ */
+void __attribute__((no_instrument_function)) trace_handoff(void)
+{
+	struct trace_hdr live;
+	void *buff;
+	unsigned int needed;
+
+	if (!trace_inited)
+		return;
+	trace_enabled = 0;
+	trace_inited = 0;
+
+	buff = hdr;
+	live = *hdr;
+	hdr = &live;
+	if (trace_list_calls(buff, CONFIG_TRACE_EARLY_SIZE, &needed))
+		printf("trace: truncated (%#x bytes needed)\n", needed);
+	else
+		printf("trace: %#x bytes of call records left at %08x\n",
+		       needed, CONFIG_TRACE_EARLY_ADDR);
+}
+
+int trace_fdt_fixup(void *blob)
+{
+	return fdt_add_reserved_memory_node(blob, "trace", "u-boot,trace",
+					    CONFIG_TRACE_EARLY_ADDR,
+					    CONFIG_TRACE_EARLY_SIZE);
+}
+#endif
+
 #ifdef CONFIG_TRACE_EARLY
 int __attribute__((no_instrument_function)) trace_early_init(void)
 {
@@ -0,0 +1,290 @@
+/* inffast_wide.c -- fast decoding with a 64-bit bit buffer
+ *
+ * U-Boot: a variant of inflate_fast() for 32-bit and 64-bit CPUs which
+ * spends less time refilling the bit buffer and copying matches:
+ *
+ *  - the bit buffer is 64 bits wide and refilled four bytes at a time with
+ *    an aligned word load, so a whole length/distance pair (at most 48
+ *    bits) needs at most two refills instead of up to six byte loads. The
+ *    load is aligned because alignment faults are enabled on ARMv7 and the
+ *    code is built with -mno-unaligned-access;
+ *  - matches inside the output buffer are copied 16 bytes at a time with
+ *    NEON, or 8 bytes at a time elsewhere, when the distance allows it, and
+ *    runs of one repeated byte use memset();
+ *  - matches from the window use memcpy(), since the window never
+ *    overlaps the output.
+ *
+ * The chunked copies may write up to 15 bytes past the end of a match,
+ * which is allowed because the loop stops well before the end of the
+ * output buffer. The output is identical to inflate_fast().
+ */
+
+#ifdef CONFIG_ZLIB_INFLATE_WIDE
+
+int zlib_inflate_wide = 1;
+
+#ifdef CONFIG_ARM_NEON
+#define WIDE_CHUNK	16
+u8 *inflate_copy_neon(u8 *dst, const u8 *src, unsigned len);
+#else
+#define WIDE_CHUNK	8
+#endif
+
+/* Input bytes read by one loop iteration: two refills */
+#define WIDE_IN_SLACK	8
+/* Output bytes written by one loop iteration: a match and its overshoot */
+#define WIDE_OUT_SLACK	(258 + WIDE_CHUNK)
+
+/* Copy a match of @len bytes from @dist bytes back in the output */
+static inline unsigned char *wide_copy(unsigned char *out, unsigned dist,
+				       unsigned len)
+{
+	const unsigned char *from = out - dist;
+
+	if (dist >= WIDE_CHUNK) {
+#ifdef CONFIG_ARM_NEON
+		return inflate_copy_neon(out, from, len);
+#else
+		unsigned char *end = out + len;
+
+		do {
+			put_unaligned(get_unaligned((u64 *)from), (u64 *)out);
+			out += 8;
+			from += 8;
+		} while (out < end);
+
+		return end;
+#endif
+	}
+	if (dist == 1) {
+		memset(out, out[-1], len);
+		return out + len;
+	}
+	do {
+		*out++ = *from++;
+	} while (--len);
+
+	return out;
+}
+
+/* Limit a buffer length so that the end pointer does not wrap */
+static inline unsigned wide_clamp(const unsigned char *p, unsigned n)
+{
+	uintptr_t room = (uintptr_t)-1 - (uintptr_t)p;
+
+	return n > room ? room : n;
+}
+
+/*
+   Same entry and exit conditions as inflate_fast(). If there is not enough
+   input or output for the wide loop to be worthwhile, inflate_fast() is used
+   instead.
+ */
+void inflate_fast_wide(z_streamp strm, unsigned start)
+{
+    struct inflate_state FAR *state;
+    unsigned char FAR *in;      /* local strm->next_in */
+    unsigned char FAR *last;    /* while in < last, enough input available */
+    unsigned char FAR *out;     /* local strm->next_out */
+    unsigned char FAR *beg;     /* inflate()'s initial strm->next_out */
+    unsigned char FAR *end;     /* while out < end, enough space available */
+#ifdef INFLATE_STRICT
+    unsigned dmax;              /* maximum distance from zlib header */
+#endif
+    unsigned wsize;             /* window size or zero if not using window */
+    unsigned whave;             /* valid bytes in the window */
+    unsigned write;             /* window write index */
+    unsigned char FAR *window;  /* allocated sliding window, if wsize != 0 */
+    u64 hold;                   /* local strm->hold, widened */
+    unsigned bits;              /* local strm->bits */
+    code const FAR *lcode;      /* local strm->lencode */
+    code const FAR *dcode;      /* local strm->distcode */
+    unsigned lmask;             /* mask for first level of length codes */
+    unsigned dmask;             /* mask for first level of distance codes */
+    code this;                  /* retrieved table entry */
+    unsigned op;                /* code bits, operation, extra bits, or */
+                                /*  window position, window bytes to copy */
+    unsigned len;               /* match length, unused bytes */
+    unsigned dist;              /* match distance */
+    unsigned char FAR *from;    /* where to copy match from */
+    unsigned avail_in, avail_out;
+
+    in = strm->next_in;
+    out = strm->next_out;
+    avail_in = wide_clamp(in, strm->avail_in);
+    avail_out = wide_clamp(out, strm->avail_out);
+    if (!zlib_inflate_wide || avail_in < 2 * WIDE_IN_SLACK ||
+        avail_out < 2 * WIDE_OUT_SLACK) {
+        inflate_fast(strm, start);
+        return;
+    }
+
+    /* copy state to local variables */
+    state = (struct inflate_state FAR *)strm->state;
+    last = in + (avail_in - WIDE_IN_SLACK);
+    beg = out - (start - strm->avail_out);
+    end = out + (avail_out - WIDE_OUT_SLACK);
+#ifdef INFLATE_STRICT
+    dmax = state->dmax;
+#endif
+    wsize = state->wsize;
+    whave = state->whave;
+    write = state->write;
+    window = state->window;
+    hold = state->hold;
+    bits = state->bits;
+    lcode = state->lencode;
+    dcode = state->distcode;
+    lmask = (1U << state->lenbits) - 1;
+    dmask = (1U << state->distbits) - 1;
+
+    /* take single bytes until the input is word-aligned */
+    while ((uintptr_t)in & 3) {
+        hold |= (u64)*in++ << bits;
+        bits += 8;
+    }
+
+#define WIDE_REFILL() \
+    do { \
+        if (bits < 32) { \
+            hold |= (u64)le32_to_cpu(*(u32 *)in) << bits; \
+            in += 4; \
+            bits += 32; \
+        } \
+    } while (0)
+
+    /* decode literals and length/distances until end-of-block or not enough
+       input data or output space */
+    do {
+        WIDE_REFILL();
+        this = lcode[hold & lmask];
+      dolen:
+        op = (unsigned)(this.bits);
+        hold >>= op;
+        bits -= op;
+        op = (unsigned)(this.op);
+        if (op == 0) {                          /* literal */
+            Tracevv((stderr, this.val >= 0x20 && this.val < 0x7f ?
+                    "inflate:         literal '%c'\n" :
+                    "inflate:         literal 0x%02x\n", this.val));
+            *out++ = (unsigned char)(this.val);
+        }
+        else if (op & 16) {                     /* length base */
+            len = (unsigned)(this.val);
+            op &= 15;                           /* number of extra bits */
+            if (op) {
+                len += (unsigned)hold & ((1U << op) - 1);
+                hold >>= op;
+                bits -= op;
+            }
+            Tracevv((stderr, "inflate:         length %u\n", len));
+            WIDE_REFILL();
+            this = dcode[hold & dmask];
+          dodist:
+            op = (unsigned)(this.bits);
+            hold >>= op;
+            bits -= op;
+            op = (unsigned)(this.op);
+            if (op & 16) {                      /* distance base */
+                dist = (unsigned)(this.val);
+                op &= 15;                       /* number of extra bits */
+                dist += (unsigned)hold & ((1U << op) - 1);
+#ifdef INFLATE_STRICT
+                if (dist > dmax) {
+                    strm->msg = (char *)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+#endif
+                hold >>= op;
+                bits -= op;
+                Tracevv((stderr, "inflate:         distance %u\n", dist));
+                op = (unsigned)(out - beg);     /* max distance in output */
+                if (dist > op) {                /* see if copy from window */
+                    op = dist - op;             /* distance back in window */
+                    if (op > whave) {
+                        strm->msg = (char *)"invalid distance too far back";
+                        state->mode = BAD;
+                        break;
+                    }
+                    from = window;
+                    if (write == 0) {           /* very common case */
+                        from += wsize - op;
+                    }
+                    else if (write < op) {      /* wrap around window */
+                        from += wsize + write - op;
+                        op -= write;
+                        if (op < len) {         /* some from end of window */
+                            memcpy(out, from, op);
+                            out += op;
+                            len -= op;
+                            from = window;
+                            op = write;
+                        }
+                    }
+                    else {                      /* contiguous in window */
+                        from += write - op;
+                    }
+                    if (op >= len) {            /* all from window */
+                        memcpy(out, from, len);
+                        out += len;
+                    }
+                    else {                      /* rest from output */
+                        memcpy(out, from, op);
+                        out += op;
+                        out = wide_copy(out, dist, len - op);
+                    }
+                }
+                else {                          /* copy direct from output */
+                    out = wide_copy(out, dist, len);
+                }
+            }
+            else if ((op & 64) == 0) {          /* 2nd level distance code */
+                this = dcode[this.val + (hold & ((1U << op) - 1))];
+                goto dodist;
+            }
+            else {
+                strm->msg = (char *)"invalid distance code";
+                state->mode = BAD;
+                break;
+            }
+        }
+        else if ((op & 64) == 0) {              /* 2nd level length code */
+            this = lcode[this.val + (hold & ((1U << op) - 1))];
+            goto dolen;
+        }
+        else if (op & 32) {                     /* end-of-block */
+            Tracevv((stderr, "inflate:         end of block\n"));
+            state->mode = TYPE;
+            break;
+        }
+        else {
+            strm->msg = (char *)"invalid literal/length code";
+            state->mode = BAD;
+            break;
+        }
+    } while (in < last && out < end);
+
+#undef WIDE_REFILL
+
+    /*
+     * return unused bytes; bits read before this call stay in hold, so never
+     * go back past strm->next_in
+     */
+    len = bits >> 3;
+    if (len > (unsigned)(in - strm->next_in))
+        len = (unsigned)(in - strm->next_in);
+    in -= len;
+    bits -= len << 3;
+    hold &= ((u64)1 << bits) - 1;
+
+    /* update state and return */
+    strm->avail_in -= (unsigned)(in - strm->next_in);
+    strm->avail_out -= (unsigned)(out - strm->next_out);
+    strm->next_in = in;
+    strm->next_out = out;
+    state->hold = (unsigned long)hold;
+    state->bits = bits;
+}
+
+#endif /* CONFIG_ZLIB_INFLATE_WIDE */
@@ -724,7 +724,11 @@ int ZEXPORT inflate(z_streamp strm, int flush)
 	    WATCHDOG_RESET();
             if (have >= 6 && left >= 258) {
                 RESTORE();
+#ifdef CONFIG_ZLIB_INFLATE_WIDE
+                inflate_fast_wide(strm, out);
+#else
                 inflate_fast(strm, out);
+#endif
                 LOAD();
                 break;
             }
@@ -26,6 +26,7 @@
 #include "inffast.h"
 #include "inffixed.h"
 #include "inffast.c"
+#include "inffast_wide.c"
 #include "inftrees.c"
 #include "inflate.c"
 #include "zutil.c"
@@ -0,0 +1,988 @@
+/*
+ * Zstandard decompression
+ *
+ * A compact decoder for the Zstandard frame format (RFC 8878), for boot
+ * images which are decompressed in one go into a flat buffer. Since the
+ * whole frame ends up in memory, all of the frame's earlier output is in
+ * the window and no separate window buffer is needed. Dictionaries are not
+ * supported. As with LZ4, the optional content checksum is skipped, since
+ * FIT and Android images carry their own hashes.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <asm/unaligned.h>
+#include <linux/bitops.h>
+#include <linux/kernel.h>
+
+#define ZSTD_MAGIC		0xfd2fb528
+#define ZSTD_SKIP_MAGIC		0x184d2a50	/* low 4 bits are free */
+#define ZSTD_SKIP_MASK		0xfffffff0
+
+#define ZSTD_BLOCK_MAX		(128 << 10)
+
+enum {
+	ZSTD_BLOCK_RAW,
+	ZSTD_BLOCK_RLE,
+	ZSTD_BLOCK_COMPRESSED,
+};
+
+enum {
+	ZSTD_LIT_RAW,
+	ZSTD_LIT_RLE,
+	ZSTD_LIT_COMPRESSED,
+	ZSTD_LIT_TREELESS,
+};
+
+enum {
+	ZSTD_SEQ_PREDEFINED,
+	ZSTD_SEQ_RLE,
+	ZSTD_SEQ_FSE,
+	ZSTD_SEQ_REPEAT,
+};
+
+#define ZSTD_HUF_MAX_BITS	11
+#define ZSTD_HUF_WEIGHT_LOG	6
+
+#define ZSTD_LL_MAX_LOG		9
+#define ZSTD_ML_MAX_LOG		9
+#define ZSTD_OF_MAX_LOG		8
+#define ZSTD_LL_SYMBOLS		36
+#define ZSTD_ML_SYMBOLS		53
+#define ZSTD_OF_SYMBOLS		32
+
+static const s16 zstd_ll_default[ZSTD_LL_SYMBOLS] = {
+	4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1,
+	-1, -1, -1, -1,
+};
+
+static const s16 zstd_ml_default[ZSTD_ML_SYMBOLS] = {
+	1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1,
+	-1, -1, -1, -1, -1,
+};
+
+static const s16 zstd_of_default[] = {
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1,
+};
+
+static const u32 zstd_ll_base[ZSTD_LL_SYMBOLS] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048,
+	4096, 8192, 16384, 32768, 65536,
+};
+
+static const u8 zstd_ll_bits[ZSTD_LL_SYMBOLS] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12,
+	13, 14, 15, 16,
+};
+
+static const u32 zstd_ml_base[ZSTD_ML_SYMBOLS] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+	19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+	35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027, 2051,
+	4099, 8195, 16387, 32771, 65539,
+};
+
+static const u8 zstd_ml_bits[ZSTD_ML_SYMBOLS] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11,
+	12, 13, 14, 15, 16,
+};
+
+struct zstd_fse_entry {
+	u8 symbol;
+	u8 bits;
+	u16 base;
+};
+
+/* FSE decoding table; RLE mode is a table with a single entry */
+struct zstd_fse {
+	int log;
+	struct zstd_fse_entry table[1 << ZSTD_LL_MAX_LOG];
+};
+
+struct zstd_huf_entry {
+	u8 symbol;
+	u8 bits;
+};
+
+struct zstd_huf {
+	int max_bits;
+	struct zstd_huf_entry table[1 << ZSTD_HUF_MAX_BITS];
+};
+
+/*
+ * Decoder state for one call. The entropy tables and repeat offsets carry
+ * over from one block to the next within a frame.
+ */
+struct zstd_ctx {
+	const u8 *frame;		/* start of the frame's output */
+	u32 rep[3];
+	bool has_huf;
+	const struct zstd_fse *ll, *of, *ml;
+	struct zstd_huf huf;
+	struct zstd_fse ll_tab, of_tab, ml_tab;
+	struct zstd_fse ll_def, of_def, ml_def;
+	u8 lit[ZSTD_BLOCK_MAX];
+};
+
+/*
+ * Backward bit stream, as used by the Huffman and FSE coded parts. The
+ * stream is read from its last byte towards its first; @bits holds the
+ * eight bytes at @ptr and @used counts the bits read from its top.
+ */
+struct zstd_bits {
+	const u8 *start;
+	const u8 *ptr;
+	u64 bits;
+	uint used;
+};
+
+static int zstd_bits_init(struct zstd_bits *b, const u8 *src, size_t len)
+{
+	u8 last;
+	size_t i;
+
+	if (!len)
+		return -EPROTO;
+	last = src[len - 1];
+	if (!last)
+		return -EPROTO;	/* no end marker */
+
+	b->start = src;
+	if (len >= sizeof(u64)) {
+		b->ptr = src + len - sizeof(u64);
+		b->bits = get_unaligned_le64(b->ptr);
+		b->used = 0;
+	} else {
+		b->ptr = src;
+		b->bits = 0;
+		for (i = 0; i < len; i++)
+			b->bits |= (u64)src[i] << (8 * i);
+		b->used = 64 - 8 * len;	/* the missing top bytes */
+	}
+	/* Skip the padding down to and including the end marker */
+	b->used += 9 - fls(last);
+
+	return 0;
+}
+
+/* At most 56 bits can be read between two reloads */
+static inline u32 zstd_bits_read(struct zstd_bits *b, uint n)
+{
+	u64 v;
+
+	if (!n)
+		return 0;
+	v = (b->bits << (b->used & 63)) >> (64 - n);
+	b->used += n;
+
+	return v;
+}
+
+static inline uint zstd_bits_peek(struct zstd_bits *b, uint n)
+{
+	return (b->bits << (b->used & 63)) >> (64 - n);
+}
+
+static inline void zstd_bits_reload(struct zstd_bits *b)
+{
+	size_t n;
+
+	if (b->used > 64)
+		return;		/* overrun, reported by zstd_bits_done() */
+	if (b->ptr >= b->start + sizeof(u64)) {
+		n = b->used >> 3;
+	} else {
+		n = min_t(size_t, b->used >> 3, b->ptr - b->start);
+		if (!n)
+			return;
+	}
+	b->ptr -= n;
+	b->used -= n * 8;
+	b->bits = get_unaligned_le64(b->ptr);
+}
+
+/* Number of bits left, negative if more were read than were there */
+static inline long zstd_bits_left(const struct zstd_bits *b)
+{
+	return (long)(b->ptr - b->start) * 8 + 64 - b->used;
+}
+
+static inline bool zstd_bits_done(const struct zstd_bits *b)
+{
+	return b->ptr == b->start && b->used == 64;
+}
+
+/* Read @n bits at bit @pos of a forward bit stream, zeros past the end */
+static u32 zstd_fwd_bits(const u8 *src, size_t len, size_t pos, uint n)
+{
+	size_t i = pos >> 3;
+	u32 v = 0;
+	int k;
+
+	for (k = 0; k < 4 && i + k < len; k++)
+		v |= (u32)src[i + k] << (8 * k);
+
+	return (v >> (pos & 7)) & ((1U << n) - 1);
+}
+
+/* Spread the symbols of a normalised distribution into a decoding table */
+static int zstd_fse_build(struct zstd_fse *fse, const s16 *norm, int count,
+			  int log)
+{
+	u16 next[256];
+	uint size = 1 << log, mask = size - 1;
+	uint high = size, pos = 0, step, i;
+	int s, j;
+
+	for (s = 0; s < count; s++) {
+		if (norm[s] == -1) {
+			fse->table[--high].symbol = s;
+			next[s] = 1;
+		} else {
+			next[s] = norm[s];
+		}
+	}
+
+	step = (size >> 1) + (size >> 3) + 3;
+	for (s = 0; s < count; s++) {
+		for (j = 0; j < norm[s]; j++) {
+			fse->table[pos].symbol = s;
+			do {
+				pos = (pos + step) & mask;
+			} while (pos >= high);
+		}
+	}
+	if (pos)
+		return -EPROTO;
+
+	for (i = 0; i < size; i++) {
+		struct zstd_fse_entry *e = &fse->table[i];
+		uint state = next[e->symbol]++;
+
+		e->bits = log - (fls(state) - 1);
+		e->base = (state << e->bits) - size;
+	}
+	fse->log = log;
+
+	return 0;
+}
+
+static void zstd_fse_rle(struct zstd_fse *fse, u8 symbol)
+{
+	fse->log = 0;
+	fse->table[0].symbol = symbol;
+	fse->table[0].bits = 0;
+	fse->table[0].base = 0;
+}
+
+/* Read an FSE table description; returns its size in bytes */
+static int zstd_fse_read(struct zstd_fse *fse, const u8 *src, size_t len,
+			 int max_log, int max_symbols)
+{
+	s16 norm[256];
+	int log, remaining, count = 0, ret;
+	size_t pos = 4;
+
+	if (!len)
+		return -EINVAL;
+	log = zstd_fwd_bits(src, len, 0, 4) + 5;
+	if (log > max_log)
+		return -EPROTO;
+
+	remaining = 1 << log;
+	while (remaining > 0 && count < max_symbols) {
+		int bits = fls(remaining + 1);
+		u32 val = zstd_fwd_bits(src, len, pos, bits);
+		u32 lower = (1U << (bits - 1)) - 1;
+		u32 threshold = (1U << bits) - 1 - (remaining + 1);
+		int prob;
+
+		if ((val & lower) < threshold) {
+			val &= lower;
+			pos += bits - 1;
+		} else {
+			if (val > lower)
+				val -= threshold;
+			pos += bits;
+		}
+		prob = (int)val - 1;
+		remaining -= prob < 0 ? -prob : prob;
+		norm[count++] = prob;
+
+		if (!prob) {
+			uint repeat, i;
+
+			do {
+				repeat = zstd_fwd_bits(src, len, pos, 2);
+				pos += 2;
+				for (i = 0; i < repeat && count < max_symbols;
+				     i++)
+					norm[count++] = 0;
+			} while (repeat == 3 && count < max_symbols);
+		}
+	}
+	if (remaining || pos > len * 8)
+		return -EPROTO;
+
+	ret = zstd_fse_build(fse, norm, count, log);
+	if (ret)
+		return ret;
+
+	return (pos + 7) >> 3;
+}
+
+/* Read a Huffman tree description; returns its size in bytes */
+static int zstd_huf_read(struct zstd_huf *huf, const u8 *src, size_t len)
+{
+	u8 weight[258];
+	uint count[ZSTD_HUF_MAX_BITS + 1] = { 0 };
+	uint rank[ZSTD_HUF_MAX_BITS + 1];
+	uint hdr, total = 0, rest, max_bits, i;
+	int n = 0, size, ret;
+
+	if (!len)
+		return -EINVAL;
+	hdr = src[0];
+	if (hdr >= 128) {
+		/* Weights stored directly, four bits each */
+		n = hdr - 127;
+		size = 1 + (n + 1) / 2;
+		if (size > len)
+			return -EINVAL;
+		for (i = 0; i < n; i++) {
+			u8 b = src[1 + i / 2];
+
+			weight[i] = i & 1 ? b & 15 : b >> 4;
+		}
+	} else {
+		/* FSE-compressed weights, with two interleaved states */
+		struct zstd_fse fse;
+		struct zstd_bits b;
+		uint s1, s2;
+
+		size = 1 + hdr;
+		if (size > len)
+			return -EINVAL;
+		ret = zstd_fse_read(&fse, src + 1, hdr, ZSTD_HUF_WEIGHT_LOG,
+				    ZSTD_HUF_MAX_BITS + 1);
+		if (ret < 0)
+			return ret;
+		ret = zstd_bits_init(&b, src + 1 + ret, hdr - ret);
+		if (ret)
+			return ret;
+		s1 = zstd_bits_read(&b, fse.log);
+		s2 = zstd_bits_read(&b, fse.log);
+		for (;;) {
+			struct zstd_fse_entry *e;
+
+			if (n > 253)
+				return -EPROTO;
+			e = &fse.table[s1];
+			weight[n++] = e->symbol;
+			zstd_bits_reload(&b);
+			s1 = e->base + zstd_bits_read(&b, e->bits);
+			if (zstd_bits_left(&b) < 0) {
+				weight[n++] = fse.table[s2].symbol;
+				break;
+			}
+			e = &fse.table[s2];
+			weight[n++] = e->symbol;
+			zstd_bits_reload(&b);
+			s2 = e->base + zstd_bits_read(&b, e->bits);
+			if (zstd_bits_left(&b) < 0) {
+				weight[n++] = fse.table[s1].symbol;
+				break;
+			}
+		}
+		if (n > 255)
+			return -EPROTO;
+	}
+
+	/* The last weight is implied by the others adding to a power of 2 */
+	for (i = 0; i < n; i++) {
+		if (weight[i] > ZSTD_HUF_MAX_BITS)
+			return -EPROTO;
+		if (weight[i])
+			total += 1 << (weight[i] - 1);
+	}
+	if (!total)
+		return -EPROTO;
+	max_bits = fls(total);
+	if (max_bits > ZSTD_HUF_MAX_BITS)
+		return -EPROTO;
+	rest = (1 << max_bits) - total;
+	if (rest & (rest - 1))
+		return -EPROTO;
+	weight[n++] = fls(rest);
+
+	/* Longest codes first, each symbol filling 2^(max_bits - bits) */
+	for (i = 0; i < n; i++) {
+		if (weight[i])
+			count[max_bits + 1 - weight[i]]++;
+	}
+	rank[max_bits] = 0;
+	for (i = max_bits; i > 1; i--)
+		rank[i - 1] = rank[i] + (count[i] << (max_bits - i));
+	for (i = 0; i < n; i++) {
+		uint bits, code, fill;
+
+		if (!weight[i])
+			continue;
+		bits = max_bits + 1 - weight[i];
+		code = rank[bits];
+		fill = 1 << (max_bits - bits);
+		rank[bits] += fill;
+		while (fill--) {
+			huf->table[code].symbol = i;
+			huf->table[code].bits = bits;
+			code++;
+		}
+	}
+	huf->max_bits = max_bits;
+
+	return size;
+}
+
+static int zstd_huf_stream(const struct zstd_huf *huf, u8 *out, size_t n,
+			   const u8 *src, size_t len)
+{
+	const struct zstd_huf_entry *e;
+	uint max_bits = huf->max_bits;
+	struct zstd_bits b;
+	u8 *end = out + n;
+	int ret;
+
+	ret = zstd_bits_init(&b, src, len);
+	if (ret)
+		return ret;
+
+	/* Four symbols of at most 11 bits fit between reloads */
+	while (end - out >= 4) {
+		zstd_bits_reload(&b);
+		e = &huf->table[zstd_bits_peek(&b, max_bits)];
+		*out++ = e->symbol;
+		b.used += e->bits;
+		e = &huf->table[zstd_bits_peek(&b, max_bits)];
+		*out++ = e->symbol;
+		b.used += e->bits;
+		e = &huf->table[zstd_bits_peek(&b, max_bits)];
+		*out++ = e->symbol;
+		b.used += e->bits;
+		e = &huf->table[zstd_bits_peek(&b, max_bits)];
+		*out++ = e->symbol;
+		b.used += e->bits;
+	}
+	zstd_bits_reload(&b);
+	while (out < end) {
+		e = &huf->table[zstd_bits_peek(&b, max_bits)];
+		*out++ = e->symbol;
+		b.used += e->bits;
+	}
+
+	return zstd_bits_done(&b) ? 0 : -EPROTO;
+}
+
+/* Decode the literals section; returns its size in bytes */
+static int zstd_literals(struct zstd_ctx *ctx, const u8 *src, size_t len,
+			 const u8 **litp, size_t *nlitp)
+{
+	uint type = src[0] & 3, fmt = (src[0] >> 2) & 3;
+	size_t hs, regen, comp, seg;
+	const u8 *p;
+	int ret, i;
+
+	if (type == ZSTD_LIT_RAW || type == ZSTD_LIT_RLE) {
+		switch (fmt) {
+		case 1:
+			hs = 2;
+			break;
+		case 3:
+			hs = 3;
+			break;
+		default:
+			hs = 1;
+			break;
+		}
+		if (len < hs)
+			return -EINVAL;
+		if (hs == 1)
+			regen = src[0] >> 3;
+		else if (hs == 2)
+			regen = (src[0] >> 4) + (src[1] << 4);
+		else
+			regen = (src[0] >> 4) + (src[1] << 4) + (src[2] << 12);
+		if (regen > ZSTD_BLOCK_MAX)
+			return -EPROTO;
+		*nlitp = regen;
+		if (type == ZSTD_LIT_RAW) {
+			if (len < hs + regen)
+				return -EINVAL;
+			*litp = src + hs;
+			return hs + regen;
+		}
+		if (len < hs + 1)
+			return -EINVAL;
+		memset(ctx->lit, src[hs], regen);
+		*litp = ctx->lit;
+		return hs + 1;
+	}
+
+	switch (fmt) {
+	case 0:
+	case 1:
+		hs = 3;
+		if (len < hs)
+			return -EINVAL;
+		regen = ((src[0] >> 4) | (src[1] << 4)) & 0x3ff;
+		comp = (src[1] >> 6) | (src[2] << 2);
+		break;
+	case 2:
+		hs = 4;
+		if (len < hs)
+			return -EINVAL;
+		regen = (get_unaligned_le32(src) >> 4) & 0x3fff;
+		comp = get_unaligned_le32(src) >> 18;
+		break;
+	default:
+		hs = 5;
+		if (len < hs)
+			return -EINVAL;
+		regen = (get_unaligned_le32(src) >> 4) & 0x3ffff;
+		comp = (get_unaligned_le32(src) >> 22) | (src[4] << 10);
+		break;
+	}
+	if (regen > ZSTD_BLOCK_MAX)
+		return -EPROTO;
+	if (len < hs + comp)
+		return -EINVAL;
+
+	p = src + hs;
+	len = comp;
+	if (type == ZSTD_LIT_COMPRESSED) {
+		ret = zstd_huf_read(&ctx->huf, p, len);
+		if (ret < 0)
+			return ret;
+		p += ret;
+		len -= ret;
+		ctx->has_huf = true;
+	} else if (!ctx->has_huf) {
+		return -EPROTO;
+	}
+
+	if (!fmt) {
+		ret = zstd_huf_stream(&ctx->huf, ctx->lit, regen, p, len);
+		if (ret)
+			return ret;
+	} else {
+		size_t size[4];
+
+		if (len < 6)
+			return -EINVAL;
+		size[0] = get_unaligned_le16(p);
+		size[1] = get_unaligned_le16(p + 2);
+		size[2] = get_unaligned_le16(p + 4);
+		p += 6;
+		len -= 6;
+		if (size[0] + size[1] + size[2] > len)
+			return -EINVAL;
+		size[3] = len - size[0] - size[1] - size[2];
+		seg = (regen + 3) / 4;
+		if (3 * seg > regen)
+			return -EPROTO;
+		for (i = 0; i < 4; i++) {
+			size_t n = i < 3 ? seg : regen - 3 * seg;
+
+			ret = zstd_huf_stream(&ctx->huf, ctx->lit + i * seg, n,
+					      p, size[i]);
+			if (ret)
+				return ret;
+			p += size[i];
+		}
+	}
+	*litp = ctx->lit;
+	*nlitp = regen;
+
+	return hs + comp;
+}
+
+/* Set up one of the three sequence tables; returns the bytes used */
+static int zstd_seq_table(const struct zstd_fse **fsep, struct zstd_fse *tab,
+			  const struct zstd_fse *def, uint mode, const u8 *src,
+			  size_t len, int max_log, int max_symbols)
+{
+	int ret;
+
+	switch (mode) {
+	case ZSTD_SEQ_PREDEFINED:
+		*fsep = def;
+		return 0;
+	case ZSTD_SEQ_RLE:
+		if (!len)
+			return -EINVAL;
+		if (src[0] >= max_symbols)
+			return -EPROTO;
+		zstd_fse_rle(tab, src[0]);
+		*fsep = tab;
+		return 1;
+	case ZSTD_SEQ_FSE:
+		ret = zstd_fse_read(tab, src, len, max_log, max_symbols);
+		if (ret < 0)
+			return ret;
+		*fsep = tab;
+		return ret;
+	default:
+		return *fsep ? 0 : -EPROTO;
+	}
+}
+
+static inline void zstd_copy_match(u8 *out, uint offset, size_t len)
+{
+	const u8 *from = out - offset;
+
+	if (offset >= len) {
+		memcpy(out, from, len);
+		return;
+	}
+	while (len--)
+		*out++ = *from++;
+}
+
+/* Decode the sequences section and build the block's output */
+static int zstd_sequences(struct zstd_ctx *ctx, const u8 *src, size_t len,
+			  const u8 *lit, size_t nlit, u8 **outp, u8 *oend)
+{
+	const u8 *lend = lit + nlit;
+	u8 *out = *outp;
+	uint nseq, modes, lls = 0, ofs = 0, mls = 0;
+	const u8 *p = src, *end = src + len;
+	struct zstd_bits b = { 0 };
+	bool full = false;
+	int ret;
+
+	if (!len)
+		return -EINVAL;
+	nseq = *p++;
+	if (nseq >= 128) {
+		if (nseq == 255) {
+			if (end - p < 2)
+				return -EINVAL;
+			nseq = get_unaligned_le16(p) + 0x7f00;
+			p += 2;
+		} else {
+			if (end - p < 1)
+				return -EINVAL;
+			nseq = ((nseq - 128) << 8) + *p++;
+		}
+	}
+
+	if (nseq) {
+		if (end - p < 1)
+			return -EINVAL;
+		modes = *p++;
+		if (modes & 3)
+			return -EPROTO;
+		ret = zstd_seq_table(&ctx->ll, &ctx->ll_tab, &ctx->ll_def,
+				     modes >> 6, p, end - p, ZSTD_LL_MAX_LOG,
+				     ZSTD_LL_SYMBOLS);
+		if (ret < 0)
+			return ret;
+		p += ret;
+		ret = zstd_seq_table(&ctx->of, &ctx->of_tab, &ctx->of_def,
+				     (modes >> 4) & 3, p, end - p,
+				     ZSTD_OF_MAX_LOG, ZSTD_OF_SYMBOLS);
+		if (ret < 0)
+			return ret;
+		p += ret;
+		ret = zstd_seq_table(&ctx->ml, &ctx->ml_tab, &ctx->ml_def,
+				     (modes >> 2) & 3, p, end - p,
+				     ZSTD_ML_MAX_LOG, ZSTD_ML_SYMBOLS);
+		if (ret < 0)
+			return ret;
+		p += ret;
+
+		ret = zstd_bits_init(&b, p, end - p);
+		if (ret)
+			return ret;
+		lls = zstd_bits_read(&b, ctx->ll->log);
+		ofs = zstd_bits_read(&b, ctx->of->log);
+		mls = zstd_bits_read(&b, ctx->ml->log);
+	} else if (p != end) {
+		return -EPROTO;
+	}
+
+	while (nseq--) {
+		const struct zstd_fse_entry *lle = &ctx->ll->table[lls];
+		const struct zstd_fse_entry *ofe = &ctx->of->table[ofs];
+		const struct zstd_fse_entry *mle = &ctx->ml->table[mls];
+		size_t ll, ml;
+		u32 ofv, offset;
+
+		zstd_bits_reload(&b);
+		ofv = (1U << ofe->symbol) + zstd_bits_read(&b, ofe->symbol);
+		zstd_bits_reload(&b);
+		ml = zstd_ml_base[mle->symbol] +
+			zstd_bits_read(&b, zstd_ml_bits[mle->symbol]);
+		ll = zstd_ll_base[lle->symbol] +
+			zstd_bits_read(&b, zstd_ll_bits[lle->symbol]);
+		zstd_bits_reload(&b);
+
+		if (ofv > 3) {
+			offset = ofv - 3;
+			ctx->rep[2] = ctx->rep[1];
+			ctx->rep[1] = ctx->rep[0];
+			ctx->rep[0] = offset;
+		} else {
+			uint idx = ofv - 1 + !ll;
+
+			if (!idx) {
+				offset = ctx->rep[0];
+			} else {
+				offset = idx == 3 ? ctx->rep[0] - 1 :
+					ctx->rep[idx];
+				if (idx != 1)
+					ctx->rep[2] = ctx->rep[1];
+				ctx->rep[1] = ctx->rep[0];
+				ctx->rep[0] = offset;
+			}
+		}
+
+		if (nseq) {
+			lls = lle->base + zstd_bits_read(&b, lle->bits);
+			mls = mle->base + zstd_bits_read(&b, mle->bits);
+			ofs = ofe->base + zstd_bits_read(&b, ofe->bits);
+		}
+
+		if (ll > lend - lit)
+			return -EPROTO;
+		/* Fill what is left of the buffer if it is too small */
+		if (ll + ml > oend - out) {
+			ll = min_t(size_t, ll, oend - out);
+			ml = oend - out - ll;
+			full = true;
+		}
+		memcpy(out, lit, ll);
+		out += ll;
+		lit += ll;
+		if (ml && (!offset || offset > out - ctx->frame))
+			return -EPROTO;
+		zstd_copy_match(out, offset, ml);
+		out += ml;
+		if (full) {
+			*outp = out;
+			return -ENOBUFS;
+		}
+	}
+	if (b.start && !zstd_bits_done(&b))
+		return -EPROTO;
+
+	if (lend - lit > oend - out) {
+		memcpy(out, lit, oend - out);
+		*outp = oend;
+		return -ENOBUFS;
+	}
+	memcpy(out, lit, lend - lit);
+	out += lend - lit;
+	*outp = out;
+
+	return 0;
+}
+
+static int zstd_block(struct zstd_ctx *ctx, const u8 *src, size_t len,
+		      u8 **outp, u8 *oend)
+{
+	const u8 *lit = NULL;
+	size_t nlit = 0;
+	u8 *start = *outp;
+	int ret;
+
+	if (len > ZSTD_BLOCK_MAX)
+		return -EPROTO;
+	if (!len)
+		return -EINVAL;
+	ret = zstd_literals(ctx, src, len, &lit, &nlit);
+	if (ret < 0)
+		return ret;
+	ret = zstd_sequences(ctx, src + ret, len - ret, lit, nlit, outp,
+			     oend);
+	if (ret)
+		return ret;
+	if (*outp - start > ZSTD_BLOCK_MAX)
+		return -EPROTO;
+
+	return 0;
+}
+
+/* Decode one frame; returns the number of input bytes used */
+static long zstd_frame(struct zstd_ctx *ctx, const u8 *src, size_t srcn,
+		       u8 **outp, u8 *oend)
+{
+	static const u8 fcs_size[4] = { 0, 2, 4, 8 };
+	static const u8 did_size[4] = { 0, 1, 2, 4 };
+	const u8 *p = src + 4, *end = src + srcn;
+	u8 *out = *outp;
+	uint fhd, single, fcs_len, did_len;
+	u64 fcs = 0;
+	bool checksum, has_fcs;
+	int ret = 0, i;
+
+	if (srcn < 5)
+		return -EINVAL;
+	fhd = *p++;
+	if (fhd & 0x08)
+		return -EPROTO;		/* reserved bit */
+	single = fhd & 0x20;
+	checksum = fhd & 0x04;
+	did_len = did_size[fhd & 3];
+	fcs_len = fcs_size[fhd >> 6];
+	if (!fcs_len && single)
+		fcs_len = 1;
+	has_fcs = fcs_len;
+	if (end - p < !single + did_len + fcs_len)
+		return -EINVAL;
+	p += !single;			/* window descriptor */
+	for (i = 0; i < did_len; i++) {
+		if (p[i])
+			return -EPROTONOSUPPORT;	/* dictionary */
+	}
+	p += did_len;
+	for (i = 0; i < fcs_len; i++)
+		fcs |= (u64)p[i] << (8 * i);
+	if (fcs_len == 2)
+		fcs += 256;
+	p += fcs_len;
+
+	ctx->frame = out;
+	ctx->rep[0] = 1;
+	ctx->rep[1] = 4;
+	ctx->rep[2] = 8;
+	ctx->has_huf = false;
+	ctx->ll = NULL;
+	ctx->of = NULL;
+	ctx->ml = NULL;
+
+	for (;;) {
+		u32 hdr;
+		size_t size;
+
+		if (end - p < 3)
+			return -EINVAL;
+		hdr = p[0] | (p[1] << 8) | (p[2] << 16);
+		p += 3;
+		size = hdr >> 3;
+
+		switch ((hdr >> 1) & 3) {
+		case ZSTD_BLOCK_RAW:
+			if (end - p < size)
+				return -EINVAL;
+			if (oend - out < size) {
+				memcpy(out, p, oend - out);
+				*outp = oend;
+				return -ENOBUFS;
+			}
+			memcpy(out, p, size);
+			out += size;
+			p += size;
+			break;
+		case ZSTD_BLOCK_RLE:
+			if (end - p < 1)
+				return -EINVAL;
+			if (oend - out < size) {
+				memset(out, *p, oend - out);
+				*outp = oend;
+				return -ENOBUFS;
+			}
+			memset(out, *p, size);
+			out += size;
+			p++;
+			break;
+		case ZSTD_BLOCK_COMPRESSED:
+			if (end - p < size)
+				return -EINVAL;
+			ret = zstd_block(ctx, p, size, &out, oend);
+			if (ret) {
+				*outp = out;
+				return ret;
+			}
+			p += size;
+			break;
+		default:
+			return -EPROTO;
+		}
+		if (hdr & 1)
+			break;
+	}
+
+	if (checksum) {
+		if (end - p < 4)
+			return -EINVAL;
+		p += 4;
+	}
+	if (has_fcs && out - *outp != fcs)
+		return -EPROTO;
+	*outp = out;
+
+	return p - src;
+}
+
+bool zstd_is_valid_header(const unsigned char *h)
+{
+	return get_unaligned_le32(h) == ZSTD_MAGIC;
+}
+
+int zstd_decompress(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	const u8 *in = src;
+	u8 *out = dst, *oend;
+	struct zstd_ctx *ctx;
+	size_t left;
+	long ret = 0;
+
+	/* Callers may pass ~0 for 'as much as there is' */
+	srcn = min_t(size_t, srcn, (uintptr_t)-1 - (uintptr_t)src);
+	oend = out + min_t(size_t, *dstn, (uintptr_t)-1 - (uintptr_t)dst);
+	*dstn = 0;
+
+	if (srcn < 4 || !zstd_is_valid_header(src))
+		return -EPROTONOSUPPORT;
+
+	ctx = malloc(sizeof(*ctx));
+	if (!ctx)
+		return -ENOMEM;
+	zstd_fse_build(&ctx->ll_def, zstd_ll_default, ZSTD_LL_SYMBOLS, 6);
+	zstd_fse_build(&ctx->ml_def, zstd_ml_default, ZSTD_ML_SYMBOLS, 6);
+	zstd_fse_build(&ctx->of_def, zstd_of_default,
+		       ARRAY_SIZE(zstd_of_default), 5);
+
+	/* Decode frames until the data stops looking like one */
+	for (left = srcn; left >= 4; left = srcn - (in - (const u8 *)src)) {
+		u32 magic = get_unaligned_le32(in);
+
+		if ((magic & ZSTD_SKIP_MASK) == ZSTD_SKIP_MAGIC) {
+			if (left < 8 || left - 8 < get_unaligned_le32(in + 4))
+				break;
+			in += 8 + get_unaligned_le32(in + 4);
+			continue;
+		}
+		if (magic != ZSTD_MAGIC)
+			break;
+		ret = zstd_frame(ctx, in, left, &out, oend);
+		if (ret < 0)
+			break;
+		in += ret;
+		ret = 0;
+	}
+	free(ctx);
+	*dstn = out - (u8 *)dst;
+
+	return ret;
+}
@@ -19,9 +19,27 @@ static cmd_tbl_t cmd_ut_sub[] = {
 #if defined(CONFIG_UT_ENV)
 	U_BOOT_CMD_MKENT(env, CONFIG_SYS_MAXARGS, 1, do_ut_env, "", ""),
 #endif
+#ifdef CONFIG_UT_MEM
+	U_BOOT_CMD_MKENT(mem, CONFIG_SYS_MAXARGS, 1, do_ut_mem, "", ""),
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	U_BOOT_CMD_MKENT(overlay, CONFIG_SYS_MAXARGS, 1, do_ut_overlay, "", ""),
 #endif
+#ifdef CONFIG_UT_RKSFC
+	U_BOOT_CMD_MKENT(rksfc, CONFIG_SYS_MAXARGS, 1, do_ut_rksfc, "", ""),
+#endif
+#ifdef CONFIG_UT_SMP_JOB
+	U_BOOT_CMD_MKENT(smp, CONFIG_SYS_MAXARGS, 1, do_ut_smp, "", ""),
+#endif
+#ifdef CONFIG_UT_SPL_FIT
+	U_BOOT_CMD_MKENT(spl_fit, CONFIG_SYS_MAXARGS, 1, do_ut_spl_fit, "", ""),
+#endif
+#ifdef CONFIG_UT_UBI
+	U_BOOT_CMD_MKENT(ubi, CONFIG_SYS_MAXARGS, 1, do_ut_ubi, "", ""),
+#endif
+#ifdef CONFIG_UT_UBIFS
+	U_BOOT_CMD_MKENT(ubifs, CONFIG_SYS_MAXARGS, 1, do_ut_ubifs, "", ""),
+#endif
 #ifdef CONFIG_UT_TIME
 	U_BOOT_CMD_MKENT(time, CONFIG_SYS_MAXARGS, 1, do_ut_time, "", ""),
 #endif
@@ -71,9 +89,27 @@ static char ut_help_text[] =
 #ifdef CONFIG_UT_ENV
 	"ut env [test-name]\n"
 #endif
+#ifdef CONFIG_UT_MEM
+	"ut mem - Test memcpy, memmove and memset\n"
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	"ut overlay [test-name]\n"
 #endif
+#ifdef CONFIG_UT_RKSFC
+	"ut rksfc - Test the SFC SPI Nor and Nand drivers on emulated flash\n"
+#endif
+#ifdef CONFIG_UT_SMP_JOB
+	"ut smp - Test jobs on secondary cores\n"
+#endif
+#ifdef CONFIG_UT_SPL_FIT
+	"ut spl_fit - Test loading a FIT in SPL\n"
+#endif
+#ifdef CONFIG_UT_UBI
+	"ut ubi - Test attaching UBI by fastmap and by scanning\n"
+#endif
+#ifdef CONFIG_UT_UBIFS
+	"ut ubifs - Test reading files and looking up names in UBIFS\n"
+#endif
 #ifdef CONFIG_UT_TIME
 	"ut time - Very basic test of time functions\n"
 #endif
@@ -9,9 +9,12 @@
 #include <common.h>
 #include <bootm.h>
 #include <command.h>
+#include <div64.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <smp_job.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 
 #include <u-boot/zlib.h>
 #include <bzlib.h>
@@ -22,6 +25,8 @@
 
 #include <linux/lzo.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static const char plain[] =
 	"I am a highly compressable bit of text.\n"
 	"I am a highly compressable bit of text.\n"
@@ -117,6 +122,25 @@ static const char lz4_compressed[] =
 	"\x9d\x12\x8c\x9d";
 static const unsigned long lz4_compressed_size = 276;
 
+#ifdef CONFIG_ZSTD
+/* zstd -19 /tmp/plain.txt -o /tmp/plain.zst */
+static const char zstd_compressed[] =
+	"\x28\xb5\x2f\xfd\x64\x5e\x00\xad\x05\x00\x42\x4e\x26\x17\x90\x3b"
+	"\x07\x04\x5a\x13\x8b\xa7\x65\x34\x12\x21\x6d\xb0\x39\xbb\xae\xe8"
+	"\xba\xc9\xcd\x5e\x02\x49\xd0\x2b\xa9\xfa\x96\x92\xe7\x1f\x19\x19"
+	"\x7c\x8f\xf1\x9d\x54\x37\xfc\xd6\x0a\xf3\x0c\x93\x56\xc7\x52\x4f"
+	"\x0a\x62\x3e\xd1\xa5\x83\x17\x31\xab\x5d\x8f\x57\xf3\xcc\x3b\x58"
+	"\xf8\x91\x8c\xf1\x2a\x5c\x89\xdd\xf2\x9b\x15\xb7\x92\x5b\xbe\xba"
+	"\xab\xd5\xd1\x34\xdf\xf0\x02\x0e\x61\xcd\x7b\xd6\x01\xfc\xc2\xa7"
+	"\xd4\xd1\x3d\x26\x9c\x10\x49\xb8\x5b\xcd\xba\x7c\xf7\xac\x4b\xad"
+	"\xb7\x31\x1c\xbc\xf9\xcb\x62\x8e\x2e\x9b\x0f\xd3\x87\x57\x45\x12"
+	"\x16\xfa\x3a\x79\xde\x65\xf8\xcc\x48\xd5\x43\xa6\xbd\xc3\x91\x29"
+	"\x65\x29\xa7\x5b\x9a\x08\x08\x00\x60\x13\x00\x63\xa3\x8e\x28\x94"
+	"\x79\x41\x2a\x78\xc2\x91\x70\x9f\xaa\x6a\x21\x7a\xa1\xaa\x0c\xe4"
+	"\xf4\x6e\xfa";
+static const unsigned long zstd_compressed_size = 195;
+#endif
+
 
 #define TEST_BUFFER_SIZE	512
 
@@ -282,6 +306,40 @@ static int uncompress_using_lz4(void *in, unsigned long in_size,
 	return (ret != 0);
 }
 
+#ifdef CONFIG_ZSTD
+static int compress_using_zstd(void *in, unsigned long in_size,
+			       void *out, unsigned long out_max,
+			       unsigned long *out_size)
+{
+	/* There is no zstd compression in u-boot, so fake it. */
+	assert(in_size == strlen(plain));
+	assert(memcmp(plain, in, in_size) == 0);
+
+	if (zstd_compressed_size > out_max)
+		return -1;
+
+	memcpy(out, zstd_compressed, zstd_compressed_size);
+	if (out_size)
+		*out_size = zstd_compressed_size;
+
+	return 0;
+}
+
+static int uncompress_using_zstd(void *in, unsigned long in_size,
+				 void *out, unsigned long out_max,
+				 unsigned long *out_size)
+{
+	int ret;
+	size_t output_size = out_max;
+
+	ret = zstd_decompress(in, in_size, out, &output_size);
+	if (out_size)
+		*out_size = output_size;
+
+	return (ret != 0);
+}
+#endif
+
 #define errcheck(statement) if (!(statement)) { \
 	fprintf(stderr, "\tFailed: %s\n", #statement); \
 	ret = 1; \
@@ -371,6 +429,210 @@ out:
 	return ret;
 }
 
+#define LZ4_TEST_BLOCK		(64 << 10)
+#define LZ4_TEST_BLOCKS		5
+
+/*
+ * Build an LZ4 frame of 64KiB independent blocks by hand, since there is no
+ * LZ4 compressor here. Odd blocks are stored, even ones are a single run of
+ * literals. The last block is short.
+ */
+static ulong make_lz4_frame(u8 *frame, const u8 *data, ulong size)
+{
+	u8 *p = frame;
+	ulong pos, len, ext;
+	u8 *hdr;
+	int i;
+
+	put_unaligned_le32(0x184d2204, p);
+	p[4] = 0x60;		/* version 1, independent blocks */
+	p[5] = 0x40;		/* 64KiB blocks */
+	p[6] = 0;		/* header checksum, not checked */
+	p += 7;
+
+	for (i = 0, pos = 0; pos < size; i++, pos += len) {
+		len = min_t(ulong, LZ4_TEST_BLOCK, size - pos);
+		if (i & 1) {
+			put_unaligned_le32(len | 0x80000000, p);
+			memcpy(p + 4, data + pos, len);
+			p += 4 + len;
+			continue;
+		}
+		hdr = p;
+		p += 4;
+		*p++ = 0xf0;
+		for (ext = len - 15; ext >= 255; ext -= 255)
+			*p++ = 255;
+		*p++ = ext;
+		memcpy(p, data + pos, len);
+		p += len;
+		put_unaligned_le32(p - hdr - 4, hdr);
+	}
+	put_unaligned_le32(0, p);
+	p += 4;
+
+	return p - frame;
+}
+
+static int run_lz4_parallel_test(void)
+{
+	ulong size = LZ4_TEST_BLOCK * (LZ4_TEST_BLOCKS - 1) + 1000;
+	u8 *data, *frame, *out;
+	size_t out_size;
+	ulong frame_size, i;
+	int ret;
+
+	printf(" testing lz4 parallel ...\n");
+	data = malloc(size);
+	frame = malloc(size + 4096);
+	out = malloc(size + 1);
+	errcheck(data && frame && out);
+	for (i = 0; i < size; i++)
+		data[i] = i * 7 + (i >> 9);
+	frame_size = make_lz4_frame(frame, data, size);
+
+	/* Each of the sequential and parallel decoders gives the same data */
+	out_size = size + 1;
+	errcheck(ulz4fn(frame, frame_size, out, &out_size) == 0);
+	errcheck(out_size == size && !memcmp(out, data, size));
+
+	memset(out, 'A', size + 1);
+	out_size = size + 1;
+	errcheck(ulz4fn_parallel(frame, frame_size, out, &out_size) == 0);
+	errcheck(out_size == size && !memcmp(out, data, size));
+	errcheck(out[size] == 'A');
+
+	/* An output overrun is still reported */
+	out_size = size - 1;
+	errcheck(ulz4fn_parallel(frame, frame_size, out, &out_size) != 0);
+
+	/* So is a truncated frame */
+	out_size = size + 1;
+	errcheck(ulz4fn_parallel(frame, frame_size / 2, out, &out_size) != 0);
+
+	ret = 0;
+out:
+	printf(" lz4 parallel: %s (%d workers)\n", ret == 0 ? "ok" : "FAILED",
+	       smp_job_workers());
+	free(out);
+	free(frame);
+	free(data);
+
+	return ret;
+}
+
+#ifdef CONFIG_ZLIB_INFLATE_WIDE
+#define GZIP_TEST_SIZE		(256 << 10)
+
+/* Inflate @in in steps of @step output bytes, so that the window is used */
+static int gunzip_steps(u8 *in, ulong in_size, u8 *out, ulong out_max,
+			ulong step, ulong *out_size)
+{
+	z_stream s;
+	int r;
+
+	memset(&s, '\0', sizeof(s));
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+	if (inflateInit2(&s, 16 + MAX_WBITS) != Z_OK)
+		return -1;
+	s.next_in = in;
+	s.avail_in = in_size;
+	s.next_out = out;
+	do {
+		s.avail_out = min(step, out_max - (s.next_out - out));
+		r = inflate(&s, Z_SYNC_FLUSH);
+	} while (r == Z_OK && s.avail_out == 0);
+	*out_size = s.next_out - out;
+	inflateEnd(&s);
+
+	return r == Z_STREAM_END ? 0 : -1;
+}
+
+static int run_gzip_wide_test(void)
+{
+	ulong size = GZIP_TEST_SIZE, comp_size, out_size, i;
+	u8 *data, *comp, *out;
+	int wide;
+	int ret;
+
+	printf(" testing gzip wide inflate ...\n");
+	data = malloc(size);
+	comp = malloc(size + 4096);
+	out = malloc(size + 1);
+	errcheck(data && comp && out);
+
+	/* Text with short and long distances, byte runs and noise */
+	for (i = 0; i < size; i++) {
+		if ((i >> 12) % 5 == 3)
+			data[i] = (i >> 14) & 1 ? 0 : 'z';
+		else if ((i >> 12) % 5 == 4)
+			data[i] = (i * 2654435761u) >> 24;
+		else
+			data[i] = plain[(i + (i >> 10)) % (sizeof(plain) - 1)];
+	}
+	errcheck(compress_using_gzip(data, size, comp, size + 4096,
+				     &comp_size) == 0);
+
+	for (wide = 0; wide < 2; wide++) {
+		zlib_inflate_wide = wide;
+		memset(out, 'A', size + 1);
+		out_size = comp_size;
+		errcheck(gunzip(out, size, comp, &out_size) == 0);
+		errcheck(out_size == size && !memcmp(out, data, size));
+		errcheck(out[size] == 'A');
+
+		memset(out, 'A', size + 1);
+		errcheck(gunzip_steps(comp, comp_size, out, size, 1000,
+				      &out_size) == 0);
+		errcheck(out_size == size && !memcmp(out, data, size));
+	}
+
+	ret = 0;
+out:
+	printf(" gzip wide inflate: %s\n", ret == 0 ? "ok" : "FAILED");
+	zlib_inflate_wide = 1;
+	free(out);
+	free(comp);
+	free(data);
+
+	return ret;
+}
+#endif
+
+#ifdef CONFIG_ZSTD
+/*
+ * A buffer that is too small is filled, so that bootm can tell the image
+ * is too large rather than corrupt
+ */
+static int run_zstd_nobufs_test(void)
+{
+	ulong orig_size = strlen(plain);
+	size_t out_max, size;
+	char *out;
+	int ret = 0;
+
+	printf(" testing zstd short buffers ...\n");
+	out = malloc(orig_size + 1);
+	errcheck(out != NULL);
+	for (out_max = 0; out_max < orig_size; out_max++) {
+		memset(out, 'A', orig_size + 1);
+		size = out_max;
+		errcheck(zstd_decompress(zstd_compressed, zstd_compressed_size,
+					 out, &size) == -ENOBUFS);
+		errcheck(size == out_max);
+		errcheck(memcmp(out, plain, out_max) == 0);
+		errcheck(out[out_max] == 'A');
+	}
+
+out:
+	printf(" zstd short buffers: %s\n", ret == 0 ? "ok" : "FAILED");
+	free(out);
+
+	return ret;
+}
+#endif
+
 static int do_ut_compression(cmd_tbl_t *cmdtp, int flag, int argc,
 			     char *const argv[])
 {
@@ -381,6 +643,14 @@ static int do_ut_compression(cmd_tbl_t *cmdtp, int flag, int argc,
 	err += run_test("lzma", compress_using_lzma, uncompress_using_lzma);
 	err += run_test("lzo", compress_using_lzo, uncompress_using_lzo);
 	err += run_test("lz4", compress_using_lz4, uncompress_using_lz4);
+	err += run_lz4_parallel_test();
+#ifdef CONFIG_ZSTD
+	err += run_test("zstd", compress_using_zstd, uncompress_using_zstd);
+	err += run_zstd_nobufs_test();
+#endif
+#ifdef CONFIG_ZLIB_INFLATE_WIDE
+	err += run_gzip_wide_test();
+#endif
 
 	printf("ut_compression %s\n", err == 0 ? "ok" : "FAILED");
 
@@ -448,6 +718,67 @@ static int run_bootm_test(int comp_type, mutate_func compress)
 	return 0;
 }
 
+#ifdef CONFIG_BOOTM_STREAM
+/**
+ * run_bootm_stream_test() - Run tests on decompression fed in pieces
+ *
+ * @comp_type:	Compression type to test
+ * @compress:	Our function to compress data
+ * @return 0 if OK, non-zero on failure
+ */
+static int run_bootm_stream_test(int comp_type, mutate_func compress)
+{
+	static const ulong pieces[] = { 1, 7, 64, 4096 };
+	char compress_buff[1024], out[TEST_BUFFER_SIZE];
+	ulong compress_size = sizeof(compress_buff);
+	ulong unc_len = strlen(plain);
+	struct bootm_stream st;
+	ulong pos, len;
+	int i, err;
+
+	printf("Testing stream: %s\n", genimg_get_comp_name(comp_type));
+	compress((void *)plain, unc_len, compress_buff, compress_size,
+		 &compress_size);
+
+	for (i = 0; i < ARRAY_SIZE(pieces); i++) {
+		memset(out, 'A', sizeof(out));
+		err = bootm_decomp_stream_start(&st, comp_type, compress_buff,
+						compress_size, out, sizeof(out));
+		if (err)
+			return err;
+		for (pos = 0; !err && pos < compress_size; pos += len) {
+			len = min(pieces[i], compress_size - pos);
+			err = bootm_decomp_stream_feed(&st, compress_buff + pos,
+						       len);
+		}
+		err |= bootm_decomp_stream_end(&st, &len);
+		if (err || len != unc_len || memcmp(out, plain, unc_len) ||
+		    out[unc_len] != 'A') {
+			printf("\tpieces of %lu: err %d, len %lu\n", pieces[i],
+			       err, len);
+			return -EINVAL;
+		}
+	}
+
+	/* A stream cut short is an error */
+	bootm_decomp_stream_start(&st, comp_type, compress_buff, compress_size,
+				  out, sizeof(out));
+	bootm_decomp_stream_feed(&st, compress_buff, compress_size / 2);
+	if (!bootm_decomp_stream_end(&st, &len))
+		return -EINVAL;
+
+	/* So is running out of space */
+	bootm_decomp_stream_start(&st, comp_type, compress_buff, compress_size,
+				  out, unc_len - 1);
+	err = bootm_decomp_stream_feed(&st, compress_buff, compress_size);
+	err |= bootm_decomp_stream_end(&st, &len);
+	if (!err)
+		return -EINVAL;
+
+	return 0;
+}
+#endif
+
 static int do_ut_image_decomp(cmd_tbl_t *cmdtp, int flag, int argc,
 			      char *const argv[])
 {
@@ -458,13 +789,99 @@ static int do_ut_image_decomp(cmd_tbl_t *cmdtp, int flag, int argc,
 	err |= run_bootm_test(IH_COMP_LZMA, compress_using_lzma);
 	err |= run_bootm_test(IH_COMP_LZO, compress_using_lzo);
 	err |= run_bootm_test(IH_COMP_LZ4, compress_using_lz4);
+#ifdef CONFIG_ZSTD
+	err |= run_bootm_test(IH_COMP_ZSTD, compress_using_zstd);
+#endif
 	err |= run_bootm_test(IH_COMP_NONE, compress_using_none);
+#ifdef CONFIG_BOOTM_STREAM
+	err |= run_bootm_stream_test(IH_COMP_GZIP, compress_using_gzip);
+	err |= run_bootm_stream_test(IH_COMP_LZ4, compress_using_lz4);
+#endif
 
 	printf("ut_image_decomp %s\n", err == 0 ? "ok" : "FAILED");
 
 	return 0;
 }
 
+/*
+ * Compare the sequential and parallel LZ4 decoders on a real image, e.g.:
+ *
+ *    host load hostfs - 1000000 Image.lz4
+ *    ut_lz4_bench 1000000 $filesize 2000000
+ */
+static int do_ut_lz4_bench(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char *const argv[])
+{
+	ulong src_addr, len, dst_addr, unc_max, seq_us, par_us, start;
+	int iters = 5, i, ret;
+	size_t seq_len = 0, par_len = 0;
+	u32 seq_crc, par_crc;
+	void *src, *dst;
+
+	if (argc < 4)
+		return CMD_RET_USAGE;
+	src_addr = simple_strtoul(argv[1], NULL, 16);
+	len = simple_strtoul(argv[2], NULL, 16);
+	dst_addr = simple_strtoul(argv[3], NULL, 16);
+	if (argc > 4)
+		iters = simple_strtoul(argv[4], NULL, 10);
+	if (dst_addr >= gd->ram_top)
+		return CMD_RET_USAGE;
+	unc_max = gd->ram_top - dst_addr;
+	src = map_sysmem(src_addr, len);
+	dst = map_sysmem(dst_addr, unc_max);
+
+	start = timer_get_us();
+	for (i = 0; i < iters; i++) {
+		seq_len = unc_max;
+		ret = ulz4fn(src, len, dst, &seq_len);
+		if (ret) {
+			printf("ulz4fn() failed: %d\n", ret);
+			return CMD_RET_FAILURE;
+		}
+	}
+	seq_us = (timer_get_us() - start) / iters;
+	seq_crc = crc32(0, dst, seq_len);
+
+	memset(dst, '\0', seq_len);
+	start = timer_get_us();
+	for (i = 0; i < iters; i++) {
+		par_len = unc_max;
+		ret = ulz4fn_parallel(src, len, dst, &par_len);
+		if (ret) {
+			printf("ulz4fn_parallel() failed: %d\n", ret);
+			return CMD_RET_FAILURE;
+		}
+	}
+	par_us = (timer_get_us() - start) / iters;
+	par_crc = crc32(0, dst, par_len);
+
+	printf("%lu -> %zu bytes, %d workers\n", len, seq_len,
+	       smp_job_workers());
+	printf("sequential: %8lu us, %4lu MiB/s\n", seq_us,
+	       seq_us ? (ulong)(lldiv((u64)seq_len * 1000000, seq_us) >> 20) :
+	       0);
+	printf("parallel:   %8lu us, %4lu MiB/s\n", par_us,
+	       par_us ? (ulong)(lldiv((u64)par_len * 1000000, par_us) >> 20) :
+	       0);
+	if (par_us)
+		printf("speedup:    %lu.%02lux\n", seq_us / par_us,
+		       seq_us * 100 / par_us % 100);
+	if (seq_len != par_len || seq_crc != par_crc) {
+		printf("output differs: %zu/%08x vs %zu/%08x\n", seq_len,
+		       seq_crc, par_len, par_crc);
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	ut_lz4_bench,	5,	1,	do_ut_lz4_bench,
+	"Compare sequential and parallel LZ4 decompression",
+	"src len dst [iterations]"
+);
+
 U_BOOT_CMD(
 	ut_compression,	5,	1,	do_ut_compression,
 	"Basic test of compressors: gzip bzip2 lzma lzo", ""
@@ -0,0 +1,84 @@
+/*
+ * Tests for loading Android boot images, using the sandbox FTL stand-in as
+ * the disk
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <image.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <android_image.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+#define ANDROID_TEST_PAGE	2048
+#define ANDROID_TEST_KSIZE	(64 << 10)
+#define ANDROID_TEST_RDSIZE	1000
+#define ANDROID_TEST_LOAD	0x400000
+
+/* A compressed kernel is decompressed on load and bootm takes it as is */
+static int dm_test_android_stream(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	struct andr_img_hdr *hdr;
+	disk_partition_t part;
+	ulong comp_len, img_len, os_data, os_len, rd_data, rd_len, kload;
+	u8 *kernel, *img;
+	long addr;
+	int i;
+
+	ut_assertok(uclass_get_device(UCLASS_RKNAND, 0, &dev));
+	ut_assertok(blk_get_device_by_str("rknand", "0", &dev_desc));
+	kernel = malloc(ANDROID_TEST_KSIZE);
+	img = calloc(1, 1 << 20);
+	ut_assertnonnull(kernel);
+	ut_assertnonnull(img);
+	for (i = 0; i < ANDROID_TEST_KSIZE; i++)
+		kernel[i] = (i * 7) ^ (i >> 9);
+
+	/* Header page, gzipped kernel, then a ramdisk */
+	comp_len = (1 << 20) - 3 * ANDROID_TEST_PAGE;
+	ut_assertok(gzip(img + ANDROID_TEST_PAGE, &comp_len, kernel,
+			 ANDROID_TEST_KSIZE));
+	hdr = (struct andr_img_hdr *)img;
+	memcpy(hdr->magic, ANDR_BOOT_MAGIC, ANDR_BOOT_MAGIC_SIZE);
+	hdr->kernel_size = comp_len;
+	hdr->kernel_addr = 0x10008000;
+	hdr->ramdisk_size = ANDROID_TEST_RDSIZE;
+	hdr->page_size = ANDROID_TEST_PAGE;
+	rd_data = ANDROID_TEST_PAGE + ALIGN(comp_len, ANDROID_TEST_PAGE);
+	memset(img + rd_data, 0xa5, ANDROID_TEST_RDSIZE);
+	img_len = rd_data + ALIGN(ANDROID_TEST_RDSIZE, ANDROID_TEST_PAGE);
+	ut_asserteq(img_len / 512, blk_dwrite(dev_desc, 0, img_len / 512, img));
+
+	memset(&part, '\0', sizeof(part));
+	part.size = dev_desc->lba;
+	part.blksz = dev_desc->blksz;
+	addr = android_image_load(dev_desc, &part, ANDROID_TEST_LOAD,
+				  1 << 20);
+	ut_assert(addr > 0);
+
+	hdr = map_sysmem(addr, 0);
+	kload = env_get_ulong("kernel_addr_r", 16, 0x02080000);
+	ut_asserteq(IH_COMP_NONE, android_image_get_comp(hdr));
+	ut_assertok(android_image_get_kernel(hdr, 0, &os_data, &os_len));
+	ut_asserteq(kload, os_data);
+	ut_asserteq(ANDROID_TEST_KSIZE, os_len);
+	ut_assertok(memcmp(map_sysmem(kload, 0), kernel, ANDROID_TEST_KSIZE));
+
+	/* What follows the kernel is still read to its place in the image */
+	ut_assertok(android_image_get_ramdisk(hdr, &rd_data, &rd_len));
+	ut_asserteq(ANDROID_TEST_RDSIZE, rd_len);
+	for (i = 0; i < ANDROID_TEST_RDSIZE; i++)
+		ut_asserteq(0xa5, ((u8 *)rd_data)[i]);
+
+	free(img);
+	free(kernel);
+
+	return 0;
+}
+DM_TEST(dm_test_android_stream, DM_TESTF_SCAN_FDT);
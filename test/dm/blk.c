@@ -8,6 +8,7 @@
 #include <dm.h>
 #include <usb.h>
 #include <asm/state.h>
+#include <asm/test.h>
 #include <dm/test.h>
 #include <test/ut.h>
 
@@ -168,3 +169,63 @@ static int dm_test_blk_get_from_parent(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_get_from_parent, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_BLOCK_CACHE
+/* Test that reads smaller than a page are widened to cached pages */
+static int dm_test_blk_page_cache(struct unit_test_state *uts)
+{
+	struct block_cache_stats stats;
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	char buf[1024];
+	int i, base;
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	dev = dev_get_parent(dev_desc->bdev);
+	blkcache_invalidate(dev_desc->if_type, dev_desc->devnum);
+	blkcache_stats(&stats);
+
+	/* Without a page size, each new sector is a read of the device */
+	base = sandbox_mmc_read_count(dev);
+	for (i = 0; i < 16; i++)
+		ut_asserteq(1, blk_dread(dev_desc, 4 + i, 1, buf));
+	ut_asserteq(base + 16, sandbox_mmc_read_count(dev));
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.hits);
+	ut_asserteq(16, stats.misses);
+	ut_asserteq(0, stats.page_fills);
+
+	/* With 8-sector pages, sectors 28-43 are in three of them */
+	dev_desc->page_blks = 8;
+	base = sandbox_mmc_read_count(dev);
+	for (i = 0; i < 16; i++)
+		ut_asserteq(1, blk_dread(dev_desc, 28 + i, 1, buf));
+	ut_asserteq(base + 3, sandbox_mmc_read_count(dev));
+	blkcache_stats(&stats);
+	ut_asserteq(13, stats.hits);
+	ut_asserteq(3, stats.misses);
+	ut_asserteq(3, stats.page_fills);
+
+	/* A read across two pages fetches both at once */
+	blkcache_invalidate(dev_desc->if_type, dev_desc->devnum);
+	base = sandbox_mmc_read_count(dev);
+	ut_asserteq(2, blk_dread(dev_desc, 47, 2, buf));
+	ut_asserteq(1, blk_dread(dev_desc, 40, 1, buf));
+	ut_asserteq(1, blk_dread(dev_desc, 55, 1, buf));
+	ut_asserteq(base + 1, sandbox_mmc_read_count(dev));
+
+	/* Writes drop the cached pages */
+	ut_asserteq(1, blk_dwrite(dev_desc, 40, 1, buf));
+	ut_asserteq(1, blk_dread(dev_desc, 41, 1, buf));
+	ut_asserteq(base + 2, sandbox_mmc_read_count(dev));
+
+	/* A read running past the end of the device is not widened */
+	ut_asserteq(0, blk_dread(dev_desc, dev_desc->lba - 1, 2, buf));
+
+	dev_desc->page_blks = 0;
+	blkcache_invalidate(dev_desc->if_type, dev_desc->devnum);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_page_cache, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
@@ -7,6 +7,7 @@
 #include <common.h>
 #include <dm.h>
 #include <mmc.h>
+#include <asm/test.h>
 #include <dm/test.h>
 #include <test/ut.h>
 
@@ -44,3 +45,43 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Whole allocation units are erased with one command, the ends separately */
+static int dm_test_mmc_erase(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	struct blk_desc *dev_desc;
+	struct mmc *mmc;
+	ulong start, end;
+	lbaint_t au;
+	int base;
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	dev = dev_get_parent(dev_desc->bdev);
+	mmc = mmc_get_mmc_dev(dev);
+	au = mmc->ssr.au;
+	ut_assert(au > 1);
+
+	base = sandbox_mmc_erase_count(dev);
+	ut_asserteq(3 * au + au / 2 + 16,
+		    blk_derase(dev_desc, au / 2, 3 * au + au / 2 + 16));
+	ut_asserteq(base + 3, sandbox_mmc_erase_count(dev));
+
+	ut_assertok(sandbox_mmc_get_erase(dev, base, &start, &end));
+	ut_asserteq(au / 2, start);
+	ut_asserteq(au - 1, end);
+	ut_assertok(sandbox_mmc_get_erase(dev, base + 1, &start, &end));
+	ut_asserteq(au, start);
+	ut_asserteq(4 * au - 1, end);
+	ut_assertok(sandbox_mmc_get_erase(dev, base + 2, &start, &end));
+	ut_asserteq(4 * au, start);
+	ut_asserteq(4 * au + 15, end);
+
+	/* An aligned range is a single command */
+	base = sandbox_mmc_erase_count(dev);
+	ut_asserteq(2 * au, blk_derase(dev_desc, 8 * au, 2 * au));
+	ut_asserteq(base + 1, sandbox_mmc_erase_count(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_erase, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -0,0 +1,49 @@
+/*
+ * Tests for the Rockchip NAND driver, using the sandbox FTL stand-in
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <dm/device-internal.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+#include "../../drivers/rknand/rknand.h"
+
+/* The FTL tables are written back on OS prepare, only after a write */
+static int dm_test_rknand_flush(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	char buf[512];
+	int deinits;
+
+	ut_assertok(uclass_get_device(UCLASS_RKNAND, 0, &dev));
+	ut_assertok(blk_get_device_by_str("rknand", "0", &dev_desc));
+	deinits = sandbox_ftl_get_deinits();
+
+	ut_asserteq(1, blk_dread(dev_desc, 0, 1, buf));
+	ut_assertok(dm_remove_devices_flags(DM_REMOVE_OS_PREPARE));
+	ut_asserteq(deinits, sandbox_ftl_get_deinits());
+	ut_assert(!device_active(dev));
+
+	ut_assertok(device_probe(dev));
+	memset(buf, 0x5a, sizeof(buf));
+	ut_asserteq(1, blk_dwrite(dev_desc, 8, 1, buf));
+	ut_assertok(dm_remove_devices_flags(DM_REMOVE_OS_PREPARE));
+	ut_asserteq(deinits + 1, sandbox_ftl_get_deinits());
+
+	/* The flush clears the dirty state */
+	ut_assertok(device_probe(dev));
+	ut_assertok(dm_remove_devices_flags(DM_REMOVE_OS_PREPARE));
+	ut_asserteq(deinits + 1, sandbox_ftl_get_deinits());
+
+	/* The block device was left active, so bring its parent back */
+	ut_assertok(device_probe(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_rknand_flush, DM_TESTF_SCAN_FDT);
@@ -5,8 +5,11 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <dm.h>
 #include <fdtdec.h>
+#include <malloc.h>
+#include <mapmem.h>
 #include <spi.h>
 #include <spi_flash.h>
 #include <asm/state.h>
@@ -41,3 +44,60 @@ static int dm_test_spi_flash(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_spi_flash, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_SPI_FLASH_BLK
+/* Test that block reads from a memory-mapped SPI flash use no SPI commands */
+static int dm_test_spi_flash_blk(struct unit_test_state *uts)
+{
+	const int size = 0x200000, nblks = 16;
+	struct udevice *dev, *blk, *emul;
+	struct blk_desc *desc;
+	struct spi_flash *flash;
+	u8 *src, *buf;
+	uint reads;
+	int i;
+
+	src = map_sysmem(0, size);
+	for (i = 0; i < size; i++)
+		src[i] = i * 7 + (i >> 9);
+	ut_assertok(run_command("sb save hostfs - 0 spi.bin 200000", 0));
+
+	ut_assertok(uclass_get_device(UCLASS_SPI_FLASH, 0, &dev));
+	flash = dev_get_uclass_priv(dev);
+	ut_assertnonnull(flash->memory_map);
+	ut_assertok(blk_get_from_parent(dev, &blk));
+	desc = dev_get_uclass_platdata(blk);
+	ut_asserteq(IF_TYPE_SPINOR, desc->if_type);
+	ut_asserteq(size / 512, desc->lba);
+
+	buf = malloc(nblks << 9);
+	ut_assertnonnull(buf);
+	emul = state_get_current()->spi[0][0].emul;
+	reads = sandbox_sf_get_reads(emul);
+	ut_asserteq(nblks, blk_dread(desc, 0x10, nblks, buf));
+	ut_assertok(memcmp(buf, src + (0x10 << 9), nblks << 9));
+	ut_asserteq(reads, sandbox_sf_get_reads(emul));
+
+	/* Nothing past the end of the flash */
+	ut_asserteq(0, blk_dread(desc, desc->lba - 1, 2, buf));
+
+	/* Changes made with commands are seen through the window */
+	ut_assertok(spi_flash_erase_dm(dev, 0x20000, 0x10000));
+	ut_assertok(spi_flash_write_dm(dev, 0x20000, 0x100, src));
+	ut_asserteq(2, blk_dread(desc, 0x20000 >> 9, 2, buf));
+	ut_assertok(memcmp(buf, src, 0x100));
+	for (i = 0x100; i < 2 << 9; i++)
+		ut_asserteq(0xff, buf[i]);
+	ut_asserteq(reads, sandbox_sf_get_reads(emul));
+	free(buf);
+
+	/*
+	 * Since we are about to destroy all devices, we must tell sandbox
+	 * to forget the emulation device
+	 */
+	sandbox_sf_unbind_emul(state_get_current(), 0, 0);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_blk, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
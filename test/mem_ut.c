@@ -0,0 +1,153 @@
+/*
+ * Tests for memcpy(), memmove() and memset()
+ *
+ * These cover every alignment of source and destination within 16 bytes and
+ * the lengths around the chunk sizes of the NEON versions, and check that
+ * nothing outside the destination is touched.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+
+#define TEST_BUF_SIZE	1024
+#define TEST_MAX_LEN	300
+
+static const int test_move_dist[] = {
+	-200, -65, -64, -63, -17, -16, -15, -1, 1, 15, 16, 17, 63, 64, 65, 200,
+};
+
+static u8 test_pattern(int i)
+{
+	return i * 7 + (i >> 8) + 1;
+}
+
+static void test_fill(u8 *buf)
+{
+	int i;
+
+	for (i = 0; i < TEST_BUF_SIZE; i++)
+		buf[i] = test_pattern(i);
+}
+
+/* Check @buf against @ref and say which call went wrong */
+static int test_check(const char *name, u8 *buf, u8 *ref, int dst, int src,
+		      int len)
+{
+	int i;
+
+	for (i = 0; i < TEST_BUF_SIZE; i++) {
+		if (buf[i] != ref[i]) {
+			printf("%s(%d, %d, %d): byte %d is %#x, expected %#x\n",
+			       name, dst, src, len, i, buf[i], ref[i]);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static int test_memcpy(u8 *buf, u8 *ref)
+{
+	int len, dst, src, i;
+	void *ret;
+
+	for (len = 0; len <= TEST_MAX_LEN; len++) {
+		for (dst = 64; dst < 64 + 16; dst++) {
+			for (src = 512; src < 512 + 16; src++) {
+				test_fill(buf);
+				test_fill(ref);
+				ret = memcpy(buf + dst, buf + src, len);
+				for (i = 0; i < len; i++)
+					ref[dst + i] = ref[src + i];
+				if (ret != buf + dst ||
+				    test_check("memcpy", buf, ref, dst, src,
+					       len))
+					return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int test_memmove(u8 *buf, u8 *ref)
+{
+	int len, src, dst, i, d;
+	void *ret;
+
+	for (len = 0; len <= TEST_MAX_LEN; len++) {
+		for (src = 400; src < 400 + 16; src++) {
+			for (d = 0; d < ARRAY_SIZE(test_move_dist); d++) {
+				dst = src + test_move_dist[d];
+				test_fill(buf);
+				test_fill(ref);
+				ret = memmove(buf + dst, buf + src, len);
+				if (dst < src) {
+					for (i = 0; i < len; i++)
+						ref[dst + i] = ref[src + i];
+				} else {
+					for (i = len - 1; i >= 0; i--)
+						ref[dst + i] = ref[src + i];
+				}
+				if (ret != buf + dst ||
+				    test_check("memmove", buf, ref, dst, src,
+					       len))
+					return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int test_memset(u8 *buf, u8 *ref)
+{
+	int len, dst, i;
+	void *ret;
+
+	for (len = 0; len <= TEST_MAX_LEN; len++) {
+		for (dst = 64; dst < 64 + 16; dst++) {
+			test_fill(buf);
+			test_fill(ref);
+			/* Only the low byte of the value counts */
+			ret = memset(buf + dst, 0x1200 + len, len);
+			for (i = 0; i < len; i++)
+				ref[dst + i] = len;
+			if (ret != buf + dst ||
+			    test_check("memset", buf, ref, dst, 0x1200 + len,
+				       len))
+				return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+int do_ut_mem(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	u8 *buf, *ref;
+	int ret = 0;
+
+	buf = malloc(TEST_BUF_SIZE);
+	ref = malloc(TEST_BUF_SIZE);
+	if (!buf || !ref) {
+		printf("%s: out of memory\n", __func__);
+		free(buf);
+		free(ref);
+		return CMD_RET_FAILURE;
+	}
+
+	ret |= test_memcpy(buf, ref);
+	ret |= test_memmove(buf, ref);
+	ret |= test_memset(buf, ref);
+	free(buf);
+	free(ref);
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -0,0 +1,421 @@
+/*
+ * Tests for the Rockchip SFC SPI Nor and SPI Nand drivers, using the sandbox
+ * SFC model
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <linux/compat.h>
+
+#include "../drivers/rkflash/sfc_nor.h"
+#include "../drivers/rkflash/flash_com.h"
+#include "../drivers/rkflash/sfc_nand.h"
+
+#define TEST_READ_SECS	128
+
+#define TEST_NAND_BLOCKS	8
+#define TEST_NAND_PAGE_SIZE	2048
+#define TEST_NAND_PAGES		(TEST_READ_SECS / 4)
+
+struct test_chip {
+	const char *name;
+	u32 id;
+	u32 size;
+	int qe_bit;
+	enum SNOR_ADDR_MODE addr_mode;
+};
+
+static const struct test_chip test_chips[] = {
+	{ "GD25Q128C", 0xc84018, 16 << 20, 9, ADDR_MODE_3BYTE },
+	{ "GD25Q256B", 0xc84019, 32 << 20, 6, ADDR_MODE_4BYTE },
+};
+
+struct test_nand_chip {
+	const char *name;
+	u32 id;
+	int qe_bit;
+	bool cache_read;
+};
+
+static const struct test_nand_chip test_nand_chips[] = {
+	{ "MT29F1G01ZAC", 0x2c12, -1, true },
+	{ "GD5F1GQ4U", 0xc8d1, 0, false },
+};
+
+static u8 test_pattern(u32 offset)
+{
+	return offset * 7 + (offset >> 9) + (offset >> 20);
+}
+
+static bool test_dma_into(ulong dma_addr, void *buf, u32 len)
+{
+	ulong start = map_to_sysmem(buf);
+
+	return dma_addr >= start && dma_addr < start + len;
+}
+
+#define test_assert(chip, cond) ({					\
+	bool __ok = cond;						\
+	if (!__ok)							\
+		printf("%s: %s:%d: %s\n", (chip)->name, __func__,	\
+		       __LINE__, #cond);				\
+	__ok;								\
+})
+
+/* A whole-block read into an aligned buffer goes by DMA with no bounce */
+static int test_read_aligned(const struct test_chip *chip,
+			     struct SFNOR_DEV *dev, u8 *flash, u8 *buf)
+{
+	struct sandbox_sfc_stats *stats = sandbox_sfc_get_stats();
+	struct sandbox_sfc_stats before = *stats;
+	u32 len = TEST_READ_SECS << 9;
+	/* Above 16MB on the larger chip, so the top address byte matters */
+	u32 sec = dev->capacity - TEST_READ_SECS - 64;
+
+	memset(buf, 0, len);
+	if (!test_assert(chip, snor_read(dev, sec, TEST_READ_SECS, buf) ==
+			 TEST_READ_SECS) ||
+	    !test_assert(chip, !memcmp(buf, flash + (sec << 9), len)) ||
+	    !test_assert(chip, stats->dma_xfers - before.dma_xfers ==
+			 DIV_ROUND_UP(len, SFC_MAX_XFER_SIZE)) ||
+	    !test_assert(chip, stats->dma_bytes - before.dma_bytes == len) ||
+	    !test_assert(chip, stats->pio_words == before.pio_words) ||
+	    !test_assert(chip, test_dma_into(stats->last_dma_addr, buf, len)))
+		return -EINVAL;
+
+	return 0;
+}
+
+/* An unaligned buffer still gets the right data, through a bounce buffer */
+static int test_read_unaligned(const struct test_chip *chip,
+			       struct SFNOR_DEV *dev, u8 *flash, u8 *buf)
+{
+	struct sandbox_sfc_stats *stats = sandbox_sfc_get_stats();
+	struct sandbox_sfc_stats before = *stats;
+	u32 sec = 3, n_sec = 3;
+
+	if (!test_assert(chip, snor_read(dev, sec, n_sec, buf + 4) == n_sec) ||
+	    !test_assert(chip, !memcmp(buf + 4, flash + (sec << 9),
+				       n_sec << 9)) ||
+	    !test_assert(chip, stats->dma_xfers - before.dma_xfers == 1) ||
+	    !test_assert(chip, !test_dma_into(stats->last_dma_addr, buf,
+					      (n_sec << 9) + 4)))
+		return -EINVAL;
+
+	return 0;
+}
+
+/* A write which needs an erase keeps the rest of the sectors it erases */
+static int test_write_partial(const struct test_chip *chip,
+			      struct SFNOR_DEV *dev, u8 *flash, u8 *buf)
+{
+	const struct snor_write_stats *ws = snor_get_write_stats();
+	struct snor_write_stats before = *ws;
+	u32 sec = dev->blk_size * 8, n_sec = 8, len = n_sec << 9;
+	u32 i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = ~test_pattern(i);
+	/* Sectors 2-9 of the block cover parts of two 4K sectors */
+	if (!test_assert(chip, snor_write(dev, sec + 2, n_sec, buf) == n_sec) ||
+	    !test_assert(chip, ws->erase_4k - before.erase_4k == 2) ||
+	    !test_assert(chip, ws->erase_32k == before.erase_32k) ||
+	    !test_assert(chip, ws->erase_64k == before.erase_64k))
+		return -EINVAL;
+
+	memset(buf, 0, 16 << 9);
+	if (!test_assert(chip, snor_read(dev, sec, 16, buf) == 16))
+		return -EINVAL;
+	for (i = 0; i < 16 << 9; i++) {
+		u8 expect = test_pattern((sec << 9) + i);
+
+		if (i >= 2 << 9 && i < (2 << 9) + len)
+			expect = ~test_pattern(i - (2 << 9));
+		if (!test_assert(chip, buf[i] == expect))
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+/*
+ * Data the flash already holds is not written again, blank flash is not
+ * erased first and whole aligned runs of sectors are erased together
+ */
+static int test_write_skip(const struct test_chip *chip,
+			   struct SFNOR_DEV *dev, u8 *flash, u8 *buf)
+{
+	const struct snor_write_stats *ws = snor_get_write_stats();
+	struct snor_write_stats before = *ws;
+	u32 blk = dev->blk_size * 16, len = TEST_READ_SECS << 9;
+	u32 addr = blk << 9;
+	u32 i;
+
+	/* Unchanged */
+	memcpy(buf, flash + addr, len);
+	if (!test_assert(chip, snor_write(dev, blk, TEST_READ_SECS, buf) ==
+			 TEST_READ_SECS) ||
+	    !test_assert(chip, ws->skip_bytes - before.skip_bytes == len) ||
+	    !test_assert(chip, ws->prog_bytes == before.prog_bytes) ||
+	    !test_assert(chip, ws->erase_64k == before.erase_64k))
+		return -EINVAL;
+
+	/* Changed everywhere: one 64K erase */
+	before = *ws;
+	for (i = 0; i < len; i++)
+		buf[i] = ~flash[addr + i];
+	if (!test_assert(chip, snor_write(dev, blk, TEST_READ_SECS, buf) ==
+			 TEST_READ_SECS) ||
+	    !test_assert(chip, !memcmp(flash + addr, buf, len)) ||
+	    !test_assert(chip, ws->erase_64k - before.erase_64k == 1) ||
+	    !test_assert(chip, ws->erase_32k == before.erase_32k) ||
+	    !test_assert(chip, ws->erase_4k == before.erase_4k))
+		return -EINVAL;
+
+	/* Changed in the second half of the next block: one 32K erase */
+	before = *ws;
+	addr += len + len / 2;
+	for (i = 0; i < len / 2; i++)
+		buf[i] = ~flash[addr + i];
+	if (!test_assert(chip, snor_write(dev, addr >> 9, TEST_READ_SECS / 2,
+					  buf) == TEST_READ_SECS / 2) ||
+	    !test_assert(chip, !memcmp(flash + addr, buf, len / 2)) ||
+	    !test_assert(chip, ws->erase_32k - before.erase_32k == 1) ||
+	    !test_assert(chip, ws->erase_64k == before.erase_64k) ||
+	    !test_assert(chip, ws->erase_4k == before.erase_4k))
+		return -EINVAL;
+
+	/* Blank: programmed without an erase */
+	before = *ws;
+	addr += len / 2;
+	memset(flash + addr, 0xff, len);
+	for (i = 0; i < len; i++)
+		buf[i] = test_pattern(i);
+	if (!test_assert(chip, snor_write(dev, addr >> 9, TEST_READ_SECS,
+					  buf) == TEST_READ_SECS) ||
+	    !test_assert(chip, !memcmp(flash + addr, buf, len)) ||
+	    !test_assert(chip, ws->prog_bytes - before.prog_bytes == len) ||
+	    !test_assert(chip, ws->erase_64k == before.erase_64k) ||
+	    !test_assert(chip, ws->erase_32k == before.erase_32k) ||
+	    !test_assert(chip, ws->erase_4k == before.erase_4k))
+		return -EINVAL;
+
+	return 0;
+}
+
+static int test_one_chip(const struct test_chip *chip, u8 *buf)
+{
+	struct SFNOR_DEV dev;
+	u8 *flash;
+	u32 i;
+	int ret = 0;
+
+	flash = sandbox_sfc_set_chip(chip->id, chip->size, chip->qe_bit);
+	if (!flash) {
+		printf("%s: out of memory\n", chip->name);
+		return -ENOMEM;
+	}
+	for (i = 0; i < chip->size; i++)
+		flash[i] = test_pattern(i);
+
+	sfc_init(NULL);
+	if (!test_assert(chip, snor_init(&dev) == SFC_OK) ||
+	    !test_assert(chip, dev.capacity == chip->size >> 9) ||
+	    !test_assert(chip, dev.read_lines == DATA_LINES_X4) ||
+	    !test_assert(chip, dev.addr_mode == chip->addr_mode))
+		return -EINVAL;
+
+	ret |= test_read_aligned(chip, &dev, flash, buf);
+	ret |= test_read_unaligned(chip, &dev, flash, buf);
+	ret |= test_write_partial(chip, &dev, flash, buf);
+	ret |= test_write_skip(chip, &dev, flash, buf);
+	if (!test_assert(chip, !sandbox_sfc_get_stats()->errors))
+		ret = -EINVAL;
+
+	return ret;
+}
+
+/* Check a page read back against what the model holds */
+static int test_nand_check(const struct test_nand_chip *chip, u8 *flash,
+			   u32 page, u8 *data, u32 *spare)
+{
+	u8 *src = flash + page * SFC_NAND_PAGE_MAX_SIZE;
+
+	if (!test_assert(chip, !memcmp(data, src, TEST_NAND_PAGE_SIZE)) ||
+	    (spare && !test_assert(chip, !memcmp(spare,
+						 src + TEST_NAND_PAGE_SIZE + 4,
+						 8))))
+		return -EINVAL;
+
+	return 0;
+}
+
+/*
+ * A run of pages costs one page read per block it touches, the rest being
+ * cache reads, and the ECC results of the run are gathered up
+ */
+static int test_nand_read_pages(const struct test_nand_chip *chip, u8 *flash,
+				u8 *buf)
+{
+	struct sandbox_sfc_stats *stats = sandbox_sfc_get_stats();
+	struct sandbox_sfc_stats before = *stats;
+	struct sfc_nand_batch_ecc ecc;
+	u32 spare[TEST_NAND_PAGES * 2];
+	u32 page = 60, i, ret;
+
+	/* The run crosses from block 0 into block 1 */
+	ret = sfc_nand_read_pages(page, TEST_NAND_PAGES, (u32 *)buf, spare,
+				  &ecc);
+	if (!test_assert(chip, ret == SFC_NAND_ECC_OK) ||
+	    !test_assert(chip, !ecc.refresh && !ecc.failed))
+		return -EINVAL;
+	for (i = 0; i < TEST_NAND_PAGES; i++) {
+		if (test_nand_check(chip, flash, page + i,
+				    buf + i * TEST_NAND_PAGE_SIZE,
+				    spare + i * 2))
+			return -EINVAL;
+	}
+	if (chip->cache_read) {
+		if (!test_assert(chip, stats->nand_page_reads -
+				 before.nand_page_reads == 2) ||
+		    !test_assert(chip, stats->nand_cache_reads -
+				 before.nand_cache_reads == TEST_NAND_PAGES))
+			return -EINVAL;
+	} else if (!test_assert(chip, stats->nand_page_reads -
+				before.nand_page_reads == TEST_NAND_PAGES) ||
+		   !test_assert(chip, stats->nand_cache_reads ==
+				before.nand_cache_reads)) {
+		return -EINVAL;
+	}
+
+	/* One page to rewrite and two lost: the worst result wins */
+	sandbox_sfc_nand_set_ecc(page + 2, chip->cache_read ? 1 : 3);
+	sandbox_sfc_nand_set_ecc(page + 9, 2);
+	sandbox_sfc_nand_set_ecc(page + 10, 2);
+	ret = sfc_nand_read_pages(page, TEST_NAND_PAGES, (u32 *)buf, NULL,
+				  &ecc);
+	sandbox_sfc_nand_set_ecc(page + 2, 0);
+	sandbox_sfc_nand_set_ecc(page + 9, 0);
+	sandbox_sfc_nand_set_ecc(page + 10, 0);
+	if (!test_assert(chip, ret == SFC_NAND_ECC_ERROR) ||
+	    !test_assert(chip, ecc.refresh == 1) ||
+	    !test_assert(chip, ecc.failed == 2) ||
+	    !test_assert(chip, ecc.first_failed == page + 9))
+		return -EINVAL;
+
+	/* Just a page to rewrite */
+	sandbox_sfc_nand_set_ecc(page + 3, chip->cache_read ? 1 : 3);
+	ret = sfc_nand_read_pages(page, 8, (u32 *)buf, NULL, &ecc);
+	sandbox_sfc_nand_set_ecc(page + 3, 0);
+	if (!test_assert(chip, ret == SFC_NAND_ECC_REFRESH) ||
+	    !test_assert(chip, ecc.refresh == 1 && !ecc.failed))
+		return -EINVAL;
+
+	return 0;
+}
+
+/*
+ * Page reads from the FTL load ahead once they are sequential, and a
+ * program in between does not leave a stale page behind
+ */
+static int test_nand_ftl_read(const struct test_nand_chip *chip, u8 *flash,
+			      u8 *buf)
+{
+	struct sandbox_sfc_stats *stats = sandbox_sfc_get_stats();
+	struct sandbox_sfc_stats before = *stats;
+	u32 page = 3 * 64 + 8, spare[2], i;
+
+	for (i = 0; i < 4; i++) {
+		if (!test_assert(chip, g_nand_ops.read_page(0, page + i,
+							    (u32 *)buf,
+							    spare) ==
+				 SFC_NAND_ECC_OK) ||
+		    test_nand_check(chip, flash, page + i, buf, spare))
+			return -EINVAL;
+	}
+	if (chip->cache_read &&
+	    (!test_assert(chip, stats->nand_page_reads -
+			  before.nand_page_reads == 2) ||
+	     !test_assert(chip, stats->nand_cache_reads -
+			  before.nand_cache_reads == 3)))
+		return -EINVAL;
+
+	/* Load the next page ahead, then program it before reading it */
+	if (!test_assert(chip, g_nand_ops.erase_blk(0, page & ~63) ==
+			 SFC_OK))
+		return -EINVAL;
+	for (i = 0; i < 4; i++)
+		g_nand_ops.read_page(0, page + i, (u32 *)buf, spare);
+	for (i = 0; i < TEST_NAND_PAGE_SIZE; i++)
+		buf[i] = ~test_pattern(i);
+	spare[0] = 0x12345678;
+	spare[1] = 0x9abcdef0;
+	if (!test_assert(chip, g_nand_ops.prog_page(0, page + 4, (u32 *)buf,
+						    spare) == SFC_OK))
+		return -EINVAL;
+	memset(buf, 0, TEST_NAND_PAGE_SIZE);
+	memset(spare, 0, sizeof(spare));
+	if (!test_assert(chip, g_nand_ops.read_page(0, page + 4, (u32 *)buf,
+						    spare) == SFC_NAND_ECC_OK) ||
+	    test_nand_check(chip, flash, page + 4, buf, spare) ||
+	    !test_assert(chip, buf[0] == (u8)~test_pattern(0)) ||
+	    !test_assert(chip, spare[0] == 0x12345678))
+		return -EINVAL;
+
+	return 0;
+}
+
+static int test_one_nand(const struct test_nand_chip *chip, u8 *buf)
+{
+	u32 size = TEST_NAND_BLOCKS * 64 * SFC_NAND_PAGE_MAX_SIZE;
+	u8 *flash;
+	u32 i;
+	int ret = 0;
+
+	flash = sandbox_sfc_set_nand(chip->id, TEST_NAND_BLOCKS, chip->qe_bit);
+	if (!flash) {
+		printf("%s: out of memory\n", chip->name);
+		return -ENOMEM;
+	}
+	for (i = 0; i < size; i++)
+		flash[i] = test_pattern(i);
+
+	sfc_init(NULL);
+	if (!test_assert(chip, sfc_nand_init() == SFC_OK))
+		return -EINVAL;
+
+	ret |= test_nand_read_pages(chip, flash, buf);
+	ret |= test_nand_ftl_read(chip, flash, buf);
+	if (!test_assert(chip, !sandbox_sfc_get_stats()->errors))
+		ret = -EINVAL;
+
+	return ret;
+}
+
+int do_ut_rksfc(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	u8 *buf;
+	int ret = 0;
+	int i;
+
+	buf = memalign(ARCH_DMA_MINALIGN, (TEST_READ_SECS << 9) + 64);
+	if (!buf) {
+		printf("%s: out of memory\n", __func__);
+		return CMD_RET_FAILURE;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(test_chips); i++)
+		ret |= test_one_chip(&test_chips[i], buf);
+	for (i = 0; i < ARRAY_SIZE(test_nand_chips); i++)
+		ret |= test_one_nand(&test_nand_chips[i], buf);
+	free(buf);
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -5,10 +5,136 @@
  */
 
 #include <common.h>
+#include <malloc.h>
 #include <asm/io.h>
 #include <asm/arch/vendor.h>
 
+/* Ids well away from the ones in use, size of one updated item */
+#define APPEND_TEST_ID		0x100
+#define APPEND_TEST_KEEP_ID	0x101
+#define APPEND_TEST_SIZE	512
+/* Enough updates to fill even the 64KB emmc copy several times */
+#define APPEND_TEST_ROUNDS	400
+/* Rounds between rewrites of the other item */
+#define APPEND_TEST_KEEP_EVERY	7
+
+static int vendor_append_check(u16 id, u8 *buffer, u16 size, u8 val)
+{
+	int ret;
+	u16 j;
+
+	memset(buffer, 0, size);
+	ret = vendor_storage_read(id, buffer, size);
+	if (ret != size) {
+		printf("[Vendor Test]:vendor read failed(id=%d, ret=%d)!\n",
+		       id, ret);
+		return -EIO;
+	}
+	for (j = 0; j < size; j++) {
+		if (buffer[j] != val) {
+			printf("[Vendor Test]:Unexpected data(id=%d, offset=%d)\n",
+			       id, j);
+			print_buffer(0, buffer, 1, size, 16);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Update one item over and over with varying sizes, so that the appended
+ * versions fill the data area and force compaction, and check that the
+ * other item survives. The other item is rewritten now and then, so both
+ * of them move to the end of the table, which must stay in data order.
+ * Then reload from flash to check the copy written last is complete and
+ * the id index is rebuilt.
+ */
+static int vendor_append_test(void)
+{
+	u16 round, size;
+	u8 *buffer;
+	int ret;
+
+	printf("[Vendor Test]:<Append Update> Test Start...\n");
+	buffer = malloc(APPEND_TEST_SIZE);
+	if (!buffer)
+		return -ENOMEM;
+
+	vendor_test_reset();
+	memset(buffer, 0x5a, 100);
+	ret = vendor_storage_write(APPEND_TEST_KEEP_ID, buffer, 100);
+	if (ret != 100)
+		goto fail;
+
+	for (round = 0; round < APPEND_TEST_ROUNDS; round++) {
+		size = APPEND_TEST_SIZE - (round % 8) * 48;
+		memset(buffer, round, size);
+		ret = vendor_storage_write(APPEND_TEST_ID, buffer, size);
+		if (ret != size) {
+			printf("[Vendor Test]:vendor write failed(round=%d, ret=%d)!\n",
+			       round, ret);
+			goto fail;
+		}
+		ret = vendor_append_check(APPEND_TEST_ID, buffer, size,
+					  round & 0xff);
+		if (ret)
+			goto fail;
+		if (round % APPEND_TEST_KEEP_EVERY == 0) {
+			memset(buffer, 0x5a, 100);
+			ret = vendor_storage_write(APPEND_TEST_KEEP_ID, buffer,
+						   100);
+			if (ret != 100)
+				goto fail;
+		}
+		ret = vendor_test_check_order();
+		if (ret)
+			goto fail;
+	}
+	ret = vendor_append_check(APPEND_TEST_KEEP_ID, buffer, 100, 0x5a);
+	if (ret)
+		goto fail;
+
+	ret = vendor_storage_init();
+	if (ret)
+		goto fail;
+	round--;
+	ret = vendor_append_check(APPEND_TEST_ID, buffer,
+				  APPEND_TEST_SIZE - (round % 8) * 48,
+				  round & 0xff);
+	if (!ret)
+		ret = vendor_append_check(APPEND_TEST_KEEP_ID, buffer, 100,
+					  0x5a);
+	if (!ret)
+		ret = vendor_test_check_order();
+	if (ret)
+		goto fail;
+	if (vendor_storage_read(APPEND_TEST_ID + 2, buffer, 1) != -EINVAL) {
+		ret = -EINVAL;
+		goto fail;
+	}
+
+	vendor_test_reset();
+	free(buffer);
+	printf("[Vendor Test]:<Append Update> Test End,States:OK\n");
+
+	return 0;
+
+fail:
+	vendor_test_reset();
+	free(buffer);
+	printf("[Vendor Test]:<Append Update> Test End,States:Failed\n");
+
+	return ret < 0 ? ret : -EIO;
+}
+
 int board_vendor_storage_test(int argc, char * const argv[])
 {
-	return vendor_storage_test();
+	int ret;
+
+	ret = vendor_storage_test();
+	if (ret)
+		return ret;
+
+	return vendor_append_test();
 }
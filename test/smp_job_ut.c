@@ -0,0 +1,112 @@
+/*
+ * Tests for running jobs on secondary cores
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <smp_job.h>
+
+#define TEST_JOBS	16
+#define TEST_WORDS	4096
+
+struct test_job {
+	struct smp_job job;
+	ulong first;
+	ulong sum;
+};
+
+static int test_job_sum(void *arg)
+{
+	struct test_job *t = arg;
+	ulong i;
+
+	t->sum = 0;
+	for (i = 0; i < TEST_WORDS; i++)
+		t->sum += t->first + i;
+
+	return t->first ? 0 : -EINVAL;
+}
+
+static ulong test_job_expect(ulong first)
+{
+	return TEST_WORDS * first + TEST_WORDS * (TEST_WORDS - 1) / 2;
+}
+
+static int test_smp_submit(void)
+{
+	struct test_job jobs[TEST_JOBS];
+	int i, ret;
+
+	for (i = 0; i < TEST_JOBS; i++) {
+		jobs[i].first = i;
+		smp_job_init_one(&jobs[i].job, test_job_sum, &jobs[i]);
+		smp_job_submit(&jobs[i].job);
+	}
+
+	for (i = 0; i < TEST_JOBS; i++) {
+		ret = smp_job_wait(&jobs[i].job);
+		if (ret != (i ? 0 : -EINVAL)) {
+			printf("%s: job %d returned %d\n", __func__, i, ret);
+			return -EINVAL;
+		}
+		if (jobs[i].sum != test_job_expect(i)) {
+			printf("%s: job %d sum %lu, expected %lu\n", __func__,
+			       i, jobs[i].sum, test_job_expect(i));
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static int test_smp_workers(void)
+{
+	if (IS_ENABLED(CONFIG_SANDBOX) && !smp_job_workers()) {
+		printf("%s: no workers running\n", __func__);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int test_smp_park(void)
+{
+	int workers = smp_job_workers();
+
+	smp_job_park();
+	if (smp_job_workers()) {
+		printf("%s: %d workers left after park\n", __func__,
+		       smp_job_workers());
+		return -EINVAL;
+	}
+
+	/* Jobs still run, on this core */
+	if (test_smp_submit())
+		return -EINVAL;
+
+	smp_job_init();
+	if (smp_job_workers() != workers) {
+		printf("%s: %d workers after restart, expected %d\n", __func__,
+		       smp_job_workers(), workers);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int do_ut_smp(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret = 0;
+
+	ret |= test_smp_workers();
+	ret |= test_smp_submit();
+	ret |= test_smp_park();
+	ret |= test_smp_submit();
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -0,0 +1,290 @@
+/*
+ * Tests for loading a FIT in SPL, with SPL's FIT loader built into U-Boot
+ *
+ * A FIT with U-Boot, its device tree and a loadable is put on a simulated
+ * boot device, once with external data, which is loaded through the read
+ * plan, and once with embedded data, which makes SPL load the images one
+ * at a time. Each image carries a hash and is then corrupted in turn, and
+ * the load must fail whichever way it is done.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <image.h>
+#include <libfdt.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <spl.h>
+
+#define TEST_BLKSZ		512
+#define TEST_DISK_SIZE		(256 << 10)
+#define TEST_FIT_END		0x1000000
+#define TEST_UBOOT_ADDR		0x1100000
+#define TEST_UBOOT_SIZE		20000
+#define TEST_ATF_ADDR		0x1200000
+#define TEST_ATF_SIZE		6000
+
+#define test_assert(cond) ({						\
+	bool __ok = cond;						\
+	if (!__ok)							\
+		printf("%s:%d: %s\n", __func__, __LINE__, #cond);	\
+	__ok;								\
+})
+
+/**
+ * struct test_image - an image in the test FIT
+ *
+ * @name:	name of the image node
+ * @type:	image type
+ * @os:		operating system, NULL if none
+ * @load:	load address, 0 to let SPL place it
+ * @algo:	hash algorithm used to check it
+ * @data:	image data
+ * @size:	size of the image data
+ */
+struct test_image {
+	const char *name;
+	const char *type;
+	const char *os;
+	ulong load;
+	const char *algo;
+	u8 *data;
+	int size;
+};
+
+enum {
+	TEST_UBOOT,
+	TEST_FDT,
+	TEST_ATF,
+
+	TEST_IMAGES,
+};
+
+static u8 *test_disk;
+static int test_reads;
+
+/* The images are loaded well above where the FIT header is read to */
+ulong board_spl_fit_buffer_end(void)
+{
+	return TEST_FIT_END;
+}
+
+int board_fit_config_name_match(const char *name)
+{
+	return 0;
+}
+
+static ulong test_read(struct spl_load_info *load, ulong sector, ulong count,
+		       void *buf)
+{
+	if ((sector + count) * TEST_BLKSZ > TEST_DISK_SIZE)
+		return 0;
+	memcpy(buf, test_disk + sector * TEST_BLKSZ, count * TEST_BLKSZ);
+	test_reads++;
+
+	return count;
+}
+
+static int test_add_image(void *fit, int images, struct test_image *img,
+			  bool embed, ulong *offset)
+{
+	u8 value[FIT_MAX_HASH_LEN];
+	int node, hash, len;
+
+	node = fdt_add_subnode(fit, images, img->name);
+	if (node < 0)
+		return node;
+	if (embed) {
+		fdt_setprop(fit, node, FIT_DATA_PROP, img->data, img->size);
+	} else {
+		fdt_setprop_u32(fit, node, FIT_DATA_OFFSET_PROP, *offset);
+		fdt_setprop_u32(fit, node, FIT_DATA_SIZE_PROP, img->size);
+		*offset += ALIGN(img->size, 4);
+	}
+	fdt_setprop_string(fit, node, FIT_TYPE_PROP, img->type);
+	if (img->os)
+		fdt_setprop_string(fit, node, FIT_OS_PROP, img->os);
+	if (img->load) {
+		fdt_setprop_u32(fit, node, FIT_LOAD_PROP, img->load);
+		fdt_setprop_u32(fit, node, FIT_ENTRY_PROP, img->load);
+	}
+
+	hash = fdt_add_subnode(fit, node, FIT_HASH_NODENAME "-1");
+	if (hash < 0)
+		return hash;
+	if (calculate_hash(img->data, img->size, img->algo, value, &len))
+		return -EINVAL;
+	fdt_setprop_string(fit, hash, FIT_ALGO_PROP, img->algo);
+
+	return fdt_setprop(fit, hash, FIT_VALUE_PROP, value, len);
+}
+
+/*
+ * Write a FIT holding the images to the start of the disk, with the data
+ * of each image after the FIT header unless it is embedded
+ */
+static int test_write_fit(struct test_image *img, bool embed)
+{
+	void *fit = test_disk;
+	ulong offset = 0, base;
+	int images, conf, i;
+
+	memset(test_disk, '\0', TEST_DISK_SIZE);
+	if (fdt_create_empty_tree(fit, TEST_DISK_SIZE / 2))
+		return -1;
+	images = fdt_add_subnode(fit, 0, "images");
+	for (i = 0; i < TEST_IMAGES; i++) {
+		if (test_add_image(fit, images, &img[i], embed, &offset))
+			return -1;
+	}
+
+	conf = fdt_add_subnode(fit, 0, "configurations");
+	fdt_setprop_string(fit, conf, "default", "conf-1");
+	conf = fdt_add_subnode(fit, conf, "conf-1");
+	fdt_setprop_string(fit, conf, "description", "test");
+	fdt_setprop_string(fit, conf, "firmware", img[TEST_UBOOT].name);
+	fdt_setprop_string(fit, conf, FIT_FDT_PROP, img[TEST_FDT].name);
+	if (fdt_setprop_string(fit, conf, FIT_LOADABLE_PROP,
+			       img[TEST_ATF].name) ||
+	    fdt_pack(fit))
+		return -1;
+
+	base = ALIGN(fdt_totalsize(fit), 4);
+	if (base + offset > TEST_DISK_SIZE)
+		return -1;
+	for (i = 0, offset = 0; !embed && i < TEST_IMAGES; i++) {
+		memcpy(test_disk + base + offset, img[i].data, img[i].size);
+		offset += ALIGN(img[i].size, 4);
+	}
+
+	return 0;
+}
+
+/* Find the data of an image on the disk, wherever the FIT keeps it */
+static u8 *test_find_data(struct test_image *img)
+{
+	const void *fit = test_disk;
+	const void *data;
+	size_t size;
+	int node, offset;
+
+	node = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	node = fdt_subnode_offset(fit, node, img->name);
+	if (!fit_image_get_data_offset(fit, node, &offset))
+		return test_disk + ALIGN(fdt_totalsize(fit), 4) + offset;
+	if (fit_image_get_data(fit, node, &data, &size))
+		return NULL;
+
+	return (u8 *)data;
+}
+
+static int test_load(struct spl_image_info *spl_image)
+{
+	struct spl_load_info info;
+
+	memset(&info, '\0', sizeof(info));
+	info.bl_len = TEST_BLKSZ;
+	info.read = test_read;
+	memset(spl_image, '\0', sizeof(*spl_image));
+	test_reads = 0;
+
+	return spl_load_simple_fit(spl_image, &info, 0, test_disk);
+}
+
+/*
+ * Load the FIT and check that every image arrived, then corrupt each image
+ * on the disk in turn and check that the load fails
+ */
+static int test_fit(struct test_image *img, bool embed, int reads)
+{
+	struct spl_image_info spl_image;
+	const void *fdt;
+	u8 *data;
+	int i, ret;
+
+	printf("%s data\n", embed ? "embedded" : "external");
+	if (!test_assert(!test_write_fit(img, embed)))
+		return -1;
+
+	ret = test_load(&spl_image);
+	if (!test_assert(ret == 0) ||
+	    !test_assert(test_reads == reads) ||
+	    !test_assert(spl_image.load_addr == TEST_UBOOT_ADDR) ||
+	    !test_assert(spl_image.entry_point == TEST_UBOOT_ADDR) ||
+	    !test_assert(!memcmp(map_sysmem(TEST_UBOOT_ADDR, 0),
+				 img[TEST_UBOOT].data, TEST_UBOOT_SIZE)) ||
+	    !test_assert(!memcmp(map_sysmem(TEST_ATF_ADDR, 0),
+				 img[TEST_ATF].data, TEST_ATF_SIZE)))
+		return -1;
+
+	/* The device tree follows U-Boot and lists the loadable */
+	fdt = map_sysmem(TEST_UBOOT_ADDR + TEST_UBOOT_SIZE, 0);
+	if (!test_assert(spl_image.fdt_addr == fdt) ||
+	    !test_assert(!fdt_check_header(fdt)) ||
+	    !test_assert(fdt_path_offset(fdt, "/fit-images/atf") >= 0))
+		return -1;
+
+	for (i = 0; i < TEST_IMAGES; i++) {
+		data = test_find_data(&img[i]);
+		if (!test_assert(data))
+			return -1;
+		data[img[i].size / 2] ^= 0x10;
+		ret = test_load(&spl_image);
+		data[img[i].size / 2] ^= 0x10;
+		if (!test_assert(ret == -EBADMSG)) {
+			printf("corrupt %s loaded: %d\n", img[i].name, ret);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int do_ut_spl_fit(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct test_image img[TEST_IMAGES] = {
+		[TEST_UBOOT] = { "uboot", "firmware", "u-boot",
+				 TEST_UBOOT_ADDR, "sha256", NULL,
+				 TEST_UBOOT_SIZE },
+		[TEST_FDT] = { "fdt-1", "flat_dt", NULL, 0, "crc32", NULL, 0 },
+		[TEST_ATF] = { "atf", "firmware", NULL, TEST_ATF_ADDR, "sha1",
+			       NULL, TEST_ATF_SIZE },
+	};
+	int ret = -1;
+	int i, j;
+
+	test_disk = malloc(TEST_DISK_SIZE);
+	for (i = 0; i < TEST_IMAGES; i++)
+		img[i].data = malloc(max(img[i].size, 1024));
+	if (!test_disk || !img[TEST_UBOOT].data || !img[TEST_FDT].data ||
+	    !img[TEST_ATF].data) {
+		printf("%s: out of memory\n", __func__);
+		goto out;
+	}
+
+	for (i = 0; i < TEST_IMAGES; i++) {
+		for (j = 0; j < img[i].size; j++)
+			img[i].data[j] = i * 131 + j * 7 + (j >> 8);
+	}
+	fdt_create_empty_tree(img[TEST_FDT].data, 1024);
+	fdt_setprop_string(img[TEST_FDT].data, 0, "model", "test");
+	fdt_pack(img[TEST_FDT].data);
+	img[TEST_FDT].size = fdt_totalsize(img[TEST_FDT].data);
+
+	/* U-Boot and its device tree are read together, then the loadable */
+	ret = test_fit(img, false, 3);
+	/* The images are inside the FIT header, which is read in one go */
+	if (!ret)
+		ret = test_fit(img, true, 1);
+
+out:
+	for (i = 0; i < TEST_IMAGES; i++)
+		free(img[i].data);
+	free(test_disk);
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
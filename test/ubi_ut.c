@@ -0,0 +1,355 @@
+/*
+ * Tests for attaching UBI by fastmap and by scanning, using a simulated NAND
+ *
+ * Each attach is checked for how it was done, how many reads it took and
+ * that a volume written at the start reads back intact. The fastmap is
+ * damaged in between, both so that its CRC fails and so that it passes the
+ * CRC but describes PEBs the flash does not have, and the scan must then
+ * take over. Bad blocks and bitflips are also injected to check that the
+ * batched scan handles them like the per-PEB one did.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+#include <nandsim.h>
+#include <ubi_uboot.h>
+
+#define TEST_SIZE	(4 << 20)
+#define TEST_PEB_SIZE	(16 << 10)
+#define TEST_PAGE_SIZE	512
+#define TEST_PEBS	(TEST_SIZE / TEST_PEB_SIZE)
+
+#define TEST_VOL_ID	0
+#define TEST_LEBS	64
+
+#define test_assert(cond) ({						\
+	bool __ok = cond;						\
+	if (!__ok)							\
+		printf("%s:%d: %s\n", __func__, __LINE__, #cond);	\
+	__ok;								\
+})
+
+static u8 test_pattern(int lnum, int i)
+{
+	return lnum * 131 + i * 7 + (i >> 8);
+}
+
+/*
+ * Attach UBI to the simulated NAND, counting the reads it takes. Returns the
+ * UBI device, or NULL if it failed to attach.
+ */
+static struct ubi_device *test_attach(struct mtd_info *mtd, uint *reads)
+{
+	uint before = nandsim_get_stats(mtd)->reads;
+
+	if (ubi_mtd_param_parse(mtd->name, NULL) || ubi_init())
+		return NULL;
+	*reads = nandsim_get_stats(mtd)->reads - before;
+	if (!ubi_devices[0]) {
+		ubi_exit();
+		return NULL;
+	}
+
+	return ubi_devices[0];
+}
+
+static int test_write_volume(struct ubi_device *ubi, u8 *buf)
+{
+	struct ubi_mkvol_req req = {
+		.vol_id = TEST_VOL_ID,
+		.alignment = 1,
+		.vol_type = UBI_DYNAMIC_VOLUME,
+		.name = "test",
+	};
+	struct ubi_volume_desc *desc;
+	int lnum, i;
+	int ret;
+
+	req.bytes = (s64)TEST_LEBS * ubi->leb_size;
+	req.name_len = strlen(req.name);
+	ret = ubi_create_volume(ubi, &req);
+	if (!test_assert(!ret))
+		return -1;
+
+	desc = ubi_open_volume(ubi->ubi_num, TEST_VOL_ID, UBI_READWRITE);
+	if (!test_assert(!IS_ERR(desc)))
+		return -1;
+	for (lnum = 0; lnum < TEST_LEBS && !ret; lnum++) {
+		for (i = 0; i < ubi->leb_size; i++)
+			buf[i] = test_pattern(lnum, i);
+		ret = ubi_leb_write(desc, lnum, buf, 0, ubi->leb_size);
+	}
+	ubi_close_volume(desc);
+
+	return test_assert(!ret) ? 0 : -1;
+}
+
+static int test_check_volume(struct ubi_device *ubi, u8 *buf)
+{
+	struct ubi_volume_desc *desc;
+	int lnum, i;
+	int ret = 0;
+
+	desc = ubi_open_volume(ubi->ubi_num, TEST_VOL_ID, UBI_READONLY);
+	if (!test_assert(!IS_ERR(desc)))
+		return -1;
+	for (lnum = 0; lnum < TEST_LEBS && !ret; lnum++) {
+		ret = ubi_leb_read(desc, lnum, (char *)buf, 0, ubi->leb_size, 1);
+		for (i = 0; i < ubi->leb_size && !ret; i++) {
+			if (buf[i] != test_pattern(lnum, i)) {
+				printf("LEB %d differs at %#x\n", lnum, i);
+				ret = -1;
+			}
+		}
+	}
+	ubi_close_volume(desc);
+
+	return test_assert(!ret) ? 0 : -1;
+}
+
+static int test_read_peb(struct mtd_info *mtd, int pnum, u8 *buf, size_t len)
+{
+	size_t retlen;
+	int ret;
+
+	ret = mtd_read(mtd, (loff_t)pnum * TEST_PEB_SIZE, len, &retlen, buf);
+
+	return ret == -EUCLEAN ? 0 : ret;
+}
+
+static int test_write_peb(struct mtd_info *mtd, int pnum, const u8 *buf)
+{
+	struct erase_info instr = {
+		.mtd = mtd,
+		.addr = (loff_t)pnum * TEST_PEB_SIZE,
+		.len = TEST_PEB_SIZE,
+	};
+	size_t retlen;
+	int ret;
+
+	ret = mtd_erase(mtd, &instr);
+	if (ret)
+		return ret;
+
+	return mtd_write(mtd, instr.addr, TEST_PEB_SIZE, &retlen, buf);
+}
+
+/*
+ * Find a PEB by its VID header: the newest fastmap anchor if @vol_id is
+ * UBI_FM_SB_VOLUME_ID, the first PEB of a volume, or the last free PEB if
+ * @vol_id is -1. Returns the PEB number, or -1 if there is none.
+ */
+static int test_find_peb(struct mtd_info *mtd, int vol_id, u8 *buf)
+{
+	struct ubi_vid_hdr *vid_hdr = (void *)buf + TEST_PAGE_SIZE;
+	unsigned long long max_sqnum = 0;
+	int found = -1;
+	int pnum;
+
+	for (pnum = 0; pnum < TEST_PEBS; pnum++) {
+		if (mtd_block_isbad(mtd, (loff_t)pnum * TEST_PEB_SIZE) ||
+		    test_read_peb(mtd, pnum, buf, 2 * TEST_PAGE_SIZE))
+			continue;
+		if (vol_id == -1) {
+			if (be32_to_cpu(vid_hdr->magic) == 0xffffffff)
+				found = pnum;
+			continue;
+		}
+		if (be32_to_cpu(vid_hdr->magic) != UBI_VID_HDR_MAGIC ||
+		    be32_to_cpu(vid_hdr->vol_id) != vol_id)
+			continue;
+		if (vol_id != UBI_FM_SB_VOLUME_ID)
+			return pnum;
+		if (be64_to_cpu(vid_hdr->sqnum) >= max_sqnum) {
+			max_sqnum = be64_to_cpu(vid_hdr->sqnum);
+			found = pnum;
+		}
+	}
+
+	return found;
+}
+
+/*
+ * Rewrite the fastmap so that it claims a PEB past the end of the flash is
+ * free. With @fix_crc the CRC is updated to match, so only checking the
+ * contents catches it; otherwise the CRC catches it.
+ */
+static int test_damage_fastmap(struct mtd_info *mtd, u8 *buf, bool fix_crc)
+{
+	struct ubi_ec_hdr *ec_hdr = (void *)buf;
+	struct ubi_fm_sb *fmsb;
+	struct ubi_fm_hdr *fmhdr;
+	struct ubi_fm_ec *fmec;
+	int leb_start, anchor;
+	u32 crc;
+
+	anchor = test_find_peb(mtd, UBI_FM_SB_VOLUME_ID, buf);
+	if (!test_assert(anchor >= 0) ||
+	    !test_assert(!test_read_peb(mtd, anchor, buf, TEST_PEB_SIZE)))
+		return -1;
+
+	leb_start = be32_to_cpu(ec_hdr->data_offset);
+	fmsb = (void *)buf + leb_start;
+	fmhdr = (void *)(fmsb + 1);
+	fmec = (void *)fmhdr + sizeof(*fmhdr) +
+		2 * sizeof(struct ubi_fm_scan_pool);
+	/* The whole fastmap fits in the anchor on a flash this small */
+	if (!test_assert(be32_to_cpu(fmsb->used_blocks) == 1) ||
+	    !test_assert(be32_to_cpu(fmhdr->free_peb_count) > 0))
+		return -1;
+
+	fmec->pnum = cpu_to_be32(TEST_PEBS + 10);
+	if (fix_crc) {
+		fmsb->data_crc = 0;
+		crc = crc32(UBI_CRC32_INIT, (void *)fmsb,
+			    TEST_PEB_SIZE - leb_start);
+		fmsb->data_crc = cpu_to_be32(crc);
+	}
+
+	return test_assert(!test_write_peb(mtd, anchor, buf)) ? 0 : -1;
+}
+
+/* The empty flash is formatted by scanning, and detaching writes a fastmap */
+static int test_format(struct mtd_info *mtd, u8 *buf)
+{
+	struct ubi_device *ubi;
+	uint reads;
+	int ret;
+
+	ubi = test_attach(mtd, &reads);
+	if (!test_assert(ubi) || !test_assert(!ubi->fm_attached)) {
+		if (ubi)
+			ubi_exit();
+		return -1;
+	}
+
+	ret = test_write_volume(ubi, buf);
+	if (!ret)
+		ret = test_check_volume(ubi, buf);
+	ubi_exit();
+
+	if (ret || !test_assert(test_find_peb(mtd, UBI_FM_SB_VOLUME_ID,
+					      buf) >= 0))
+		return -1;
+
+	return 0;
+}
+
+/*
+ * Attach and check the volume. Returns the number of reads the attach took,
+ * or -1 on error.
+ */
+static int test_reattach(struct mtd_info *mtd, u8 *buf, bool by_fastmap,
+			 int bad_pebs)
+{
+	struct ubi_device *ubi;
+	uint reads;
+	int ret;
+
+	ubi = test_attach(mtd, &reads);
+	if (!test_assert(ubi))
+		return -1;
+
+	ret = test_check_volume(ubi, buf);
+	if (!test_assert(ubi->fm_attached == by_fastmap) ||
+	    !test_assert(ubi->bad_peb_count == bad_pebs))
+		ret = -1;
+	ubi_exit();
+
+	return ret ? -1 : reads;
+}
+
+/*
+ * The fastmap only needs the first UBI_FM_MAX_START PEBs scanned to find the
+ * anchor, while a full scan reads the headers of every PEB in one go
+ */
+static int test_fastmap_and_scan(struct mtd_info *mtd, u8 *buf)
+{
+	int fm_reads, scan_reads;
+
+	fm_reads = test_reattach(mtd, buf, true, 0);
+	if (fm_reads < 0 || !test_assert(fm_reads < TEST_PEBS / 2))
+		return -1;
+
+	if (test_damage_fastmap(mtd, buf, false))
+		return -1;
+	scan_reads = test_reattach(mtd, buf, false, 0);
+	if (scan_reads < 0)
+		return -1;
+	printf("attach reads: fastmap %d, scan %d for %d PEBs\n", fm_reads,
+	       scan_reads, TEST_PEBS);
+	/* The failed fastmap plus one read per PEB */
+	if (!test_assert(scan_reads < fm_reads + TEST_PEBS + TEST_PEBS / 8))
+		return -1;
+
+	/* Detaching after the scan wrote a fresh fastmap */
+	return test_reattach(mtd, buf, true, 0) < 0 ? -1 : 0;
+}
+
+/* A fastmap whose CRC is right but whose contents are not is not trusted */
+static int test_bad_fastmap(struct mtd_info *mtd, u8 *buf)
+{
+	if (test_damage_fastmap(mtd, buf, true) ||
+	    test_reattach(mtd, buf, false, 0) < 0)
+		return -1;
+
+	return test_reattach(mtd, buf, true, 0) < 0 ? -1 : 0;
+}
+
+/*
+ * A bad block and a PEB with bitflips in the same scan: the first is counted
+ * and skipped, the second has its headers read again on their own and still
+ * attaches
+ */
+static int test_bad_blocks(struct mtd_info *mtd, u8 *buf)
+{
+	int free_peb, data_peb;
+
+	free_peb = test_find_peb(mtd, -1, buf);
+	data_peb = test_find_peb(mtd, TEST_VOL_ID, buf);
+	if (!test_assert(free_peb >= 0) || !test_assert(data_peb >= 0))
+		return -1;
+
+	if (test_damage_fastmap(mtd, buf, false))
+		return -1;
+	mtd_block_markbad(mtd, (loff_t)free_peb * TEST_PEB_SIZE);
+	nandsim_set_read_error(mtd, data_peb, -EUCLEAN);
+
+	return test_reattach(mtd, buf, false, 1) < 0 ? -1 : 0;
+}
+
+int do_ut_ubi(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct mtd_info *mtd;
+	u8 *buf;
+	int ret;
+
+	mtd = nandsim_create("nandsim0", TEST_SIZE, TEST_PEB_SIZE,
+			     TEST_PAGE_SIZE);
+	buf = malloc(TEST_PEB_SIZE);
+	if (!mtd || !buf) {
+		printf("%s: out of memory\n", __func__);
+		ret = -1;
+		goto out;
+	}
+
+	ret = test_format(mtd, buf);
+	if (!ret)
+		ret = test_fastmap_and_scan(mtd, buf);
+	if (!ret)
+		ret = test_bad_fastmap(mtd, buf);
+	if (!ret)
+		ret = test_bad_blocks(mtd, buf);
+
+out:
+	free(buf);
+	if (mtd)
+		nandsim_destroy(mtd);
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -0,0 +1,229 @@
+/*
+ * Tests for reading UBIFS, using a pre-built image on a simulated NAND
+ *
+ * test-ubifs.gz is made by make_image.py. It holds a file of many blocks,
+ * some compressed, some not and one a hole, which is read with bulk-read,
+ * and a directory of many files, in which names are looked up by their
+ * hash. Both are checked for what they return and for how many flash reads
+ * they take.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <malloc.h>
+#include <nandsim.h>
+#include <ubi_uboot.h>
+#include <ubifs_uboot.h>
+
+#define TEST_SIZE	(4 << 20)
+#define TEST_PEB_SIZE	(16 << 10)
+#define TEST_PAGE_SIZE	512
+
+/* The image, as make_image.py lays it out */
+#define TEST_LEB_SIZE	15360
+#define TEST_LEBS	24
+#define TEST_BLOCK	4096
+#define TEST_BLOCKS	17
+#define TEST_FILE_SIZE	(16 * TEST_BLOCK + 1000)
+#define TEST_HOLE	5
+#define TEST_DIR_FILES	200
+
+#define test_assert(cond) ({						\
+	bool __ok = cond;						\
+	if (!__ok)							\
+		printf("%s:%d: %s\n", __func__, __LINE__, #cond);	\
+	__ok;								\
+})
+
+extern u8 __test_ubifs_begin[];
+extern u8 __test_ubifs_end[];
+
+/* What make_image.py puts in /data.bin: odd blocks compress, even do not */
+static u8 test_pattern(int offs)
+{
+	if (offs / TEST_BLOCK == TEST_HOLE)
+		return 0;
+	if ((offs / TEST_BLOCK) & 1)
+		return offs % 251;
+
+	return offs * 7 + (offs >> 8);
+}
+
+static uint test_reads(struct mtd_info *mtd)
+{
+	return nandsim_get_stats(mtd)->reads;
+}
+
+/*
+ * Make a volume of the image's size and write each LEB of the image to it,
+ * leaving out the erased space at the end of each like ubiformat does
+ */
+static int test_write_image(struct ubi_device *ubi, u8 *img)
+{
+	struct ubi_mkvol_req req = {
+		.vol_id = 0,
+		.alignment = 1,
+		.vol_type = UBI_DYNAMIC_VOLUME,
+		.name = "test",
+	};
+	struct ubi_volume_desc *desc;
+	u8 *leb;
+	int lnum, len;
+	int ret;
+
+	if (!test_assert(ubi->leb_size == TEST_LEB_SIZE))
+		return -1;
+	req.bytes = (s64)TEST_LEBS * ubi->leb_size;
+	req.name_len = strlen(req.name);
+	ret = ubi_create_volume(ubi, &req);
+	if (!test_assert(!ret))
+		return -1;
+
+	desc = ubi_open_volume(ubi->ubi_num, req.vol_id, UBI_READWRITE);
+	if (!test_assert(!IS_ERR(desc)))
+		return -1;
+	for (lnum = 0; lnum < TEST_LEBS && !ret; lnum++) {
+		leb = img + lnum * TEST_LEB_SIZE;
+		for (len = TEST_LEB_SIZE; len && leb[len - 1] == 0xff; len--)
+			;
+		len = ALIGN(len, ubi->min_io_size);
+		if (len)
+			ret = ubi_leb_write(desc, lnum, leb, 0, len);
+	}
+	ubi_close_volume(desc);
+
+	return test_assert(!ret) ? 0 : -1;
+}
+
+/*
+ * Look names up in a directory of TEST_DIR_FILES entries. Going by the hash
+ * takes a few index nodes, the entry and the inode, where reading through
+ * the directory would take a read for every entry before the name.
+ */
+static int test_lookup(struct mtd_info *mtd)
+{
+	loff_t size = 0;
+	uint reads;
+
+	reads = test_reads(mtd);
+	if (!test_assert(!ubifs_size("/dir/file-150", &size)) ||
+	    !test_assert(size == 150))
+		return -1;
+	reads = test_reads(mtd) - reads;
+	printf("lookup: %u reads in a directory of %d\n", reads,
+	       TEST_DIR_FILES);
+	if (!test_assert(reads < TEST_DIR_FILES / 10))
+		return -1;
+
+	if (!test_assert(ubifs_exists("/dir/file-0")) ||
+	    !test_assert(ubifs_exists("/dir/file-199")) ||
+	    !test_assert(ubifs_exists("/data.bin")) ||
+	    !test_assert(!ubifs_exists("/dir/file-200")) ||
+	    !test_assert(!ubifs_exists("/dir/file-")) ||
+	    !test_assert(!ubifs_exists("/dir/data.bin")))
+		return -1;
+
+	return 0;
+}
+
+static int test_check_data(u8 *buf, int offs, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++) {
+		if (buf[i] != test_pattern(offs + i)) {
+			printf("data differs at %#x\n", offs + i);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Read the whole file, then part of it starting after the first blocks and
+ * ending inside a block. Bulk-read takes one flash read for all the data
+ * nodes in a LEB, rather than one for each block.
+ */
+static int test_read(struct mtd_info *mtd, u8 *buf)
+{
+	loff_t actread;
+	uint reads;
+	int offs, len;
+
+	memset(buf, 0xa5, TEST_FILE_SIZE + TEST_BLOCK);
+	reads = test_reads(mtd);
+	if (!test_assert(!ubifs_read("/data.bin", buf, 0, 0, &actread)) ||
+	    !test_assert(actread == TEST_FILE_SIZE) ||
+	    !test_assert(!test_check_data(buf, 0, TEST_FILE_SIZE)) ||
+	    !test_assert(buf[TEST_FILE_SIZE] == 0xa5))
+		return -1;
+	reads = test_reads(mtd) - reads;
+	printf("read: %u reads for %d blocks\n", reads, TEST_BLOCKS);
+	if (!test_assert(reads < TEST_BLOCKS / 2))
+		return -1;
+
+	offs = 4 * TEST_BLOCK;
+	len = 3 * TEST_BLOCK + 100;
+	memset(buf, 0xa5, len + TEST_BLOCK);
+	if (!test_assert(!ubifs_read("/data.bin", buf, offs, len,
+				     &actread)) ||
+	    !test_assert(actread == len) ||
+	    !test_assert(!test_check_data(buf, offs, len)))
+		return -1;
+
+	return 0;
+}
+
+int do_ut_ubifs(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	unsigned long len = __test_ubifs_end - __test_ubifs_begin;
+	struct mtd_info *mtd;
+	u8 *img, *buf;
+	int ret = -1;
+
+	mtd = nandsim_create("nandsim0", TEST_SIZE, TEST_PEB_SIZE,
+			     TEST_PAGE_SIZE);
+	img = malloc(TEST_LEBS * TEST_LEB_SIZE);
+	buf = malloc(TEST_FILE_SIZE + TEST_BLOCK);
+	if (!mtd || !img || !buf) {
+		printf("%s: out of memory\n", __func__);
+		goto out;
+	}
+
+	if (!test_assert(!gunzip(img, TEST_LEBS * TEST_LEB_SIZE,
+				 __test_ubifs_begin, &len)) ||
+	    !test_assert(len == TEST_LEBS * TEST_LEB_SIZE))
+		goto out;
+
+	if (!test_assert(!ubi_mtd_param_parse(mtd->name, NULL)) ||
+	    !test_assert(!ubi_init()))
+		goto out;
+	if (!test_assert(ubi_devices[0]))
+		goto out_ubi;
+
+	if (test_write_image(ubi_devices[0], img))
+		goto out_ubi;
+
+	ubifs_init();
+	if (!test_assert(!uboot_ubifs_mount("ubi:test")))
+		goto out_ubi;
+	ret = test_lookup(mtd);
+	if (!ret)
+		ret = test_read(mtd, buf);
+	uboot_ubifs_umount();
+
+out_ubi:
+	ubi_exit();
+out:
+	free(buf);
+	free(img);
+	if (mtd)
+		nandsim_destroy(mtd);
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
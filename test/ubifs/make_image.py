@@ -0,0 +1,593 @@
+#!/usr/bin/env python
+#
+# SPDX-License-Identifier:      GPL-2.0+
+#
+# Make the UBIFS image used by 'ut ubifs'
+#
+# mkfs.ubifs is not needed: this lays out the superblock, master nodes, log,
+# LPT and index the same way fs/ubifs/sb.c and fs/ubifs/lpt.c format an empty
+# volume, and adds the nodes of these files to the main area:
+#
+#   /data.bin         DATA_BLOCKS blocks and DATA_TAIL bytes, with a hole at
+#                     block DATA_HOLE, alternating uncompressed and zlib
+#                     compressed blocks so that they sit next to each other
+#                     in the same LEBs for bulk-read
+#   /dir/file-<n>     DIR_FILES empty files of size <n>, so that looking one
+#                     up reads the index rather than every entry
+#
+# The geometry matches the UBI volume 'ut ubifs' makes on the simulated NAND:
+# 16KiB PEBs with 512 byte pages, which leaves 15KiB LEBs. The output is the
+# whole volume, LEB after LEB, gzipped. Run it again after changing it and
+# check in the new image.
+
+from optparse import OptionParser
+import gzip
+import os
+import struct
+import sys
+import zlib
+
+LEB_SIZE = 15360
+MIN_IO_SIZE = 512
+LEB_CNT = 24
+
+DATA_BLOCKS = 16
+DATA_TAIL = 1000
+DATA_HOLE = 5
+DIR_FILES = 200
+
+# A fixed time and UUID keep the image the same from run to run
+TIME = 1514764800
+UUID = b'ut-ubifs-image-0'
+
+UBIFS_NODE_MAGIC = 0x06101831
+UBIFS_FORMAT_VERSION = 4
+UBIFS_BLOCK_SIZE = 4096
+UBIFS_ROOT_INO = 1
+UBIFS_FIRST_INO = 64
+UBIFS_MIN_COMPRESS_DIFF = 64
+UBIFS_MIN_COMPR_LEN = 128
+
+UBIFS_SB_LNUM = 0
+UBIFS_MST_LNUM = 1
+UBIFS_LOG_LNUM = 3
+UBIFS_MIN_LEB_CNT = 17
+UBIFS_MIN_JNL_LEBS = 5
+UBIFS_MIN_BUD_LEBS = 3
+UBIFS_MIN_LPT_LEBS = 2
+UBIFS_MIN_ORPH_LEBS = 1
+
+UBIFS_INO_NODE, UBIFS_DATA_NODE, UBIFS_DENT_NODE = 0, 1, 2
+UBIFS_PAD_NODE, UBIFS_SB_NODE, UBIFS_MST_NODE = 5, 6, 7
+UBIFS_IDX_NODE, UBIFS_CS_NODE = 9, 10
+
+UBIFS_INO_KEY, UBIFS_DATA_KEY, UBIFS_DENT_KEY = 0, 1, 2
+UBIFS_S_KEY_BLOCK_BITS = 29
+UBIFS_S_KEY_HASH_MASK = 0x1fffffff
+
+UBIFS_ITYPE_REG, UBIFS_ITYPE_DIR = 0, 1
+UBIFS_COMPR_NONE, UBIFS_COMPR_ZLIB = 0, 2
+UBIFS_COMPR_FL = 0x01
+
+UBIFS_CH_SZ = 24
+UBIFS_INO_NODE_SZ = 160
+UBIFS_DATA_NODE_SZ = 48
+UBIFS_DENT_NODE_SZ = 56
+UBIFS_PAD_NODE_SZ = 28
+UBIFS_SB_NODE_SZ = 4096
+UBIFS_MST_NODE_SZ = 512
+UBIFS_IDX_NODE_SZ = 28
+UBIFS_CS_NODE_SZ = 32
+UBIFS_REF_NODE_SZ = 64
+UBIFS_SK_LEN = 8
+UBIFS_BRANCH_SZ = 12 + UBIFS_SK_LEN
+UBIFS_MAX_NODE_SZ = UBIFS_INO_NODE_SZ + UBIFS_BLOCK_SIZE
+MIN_WRITE_SZ = UBIFS_DATA_NODE_SZ + 8
+
+UBIFS_LPT_FANOUT = 4
+UBIFS_LPT_FANOUT_SHIFT = 2
+UBIFS_LPT_CRC_BITS = 16
+UBIFS_LPT_TYPE_BITS = 4
+UBIFS_LPT_PNODE, UBIFS_LPT_NNODE, UBIFS_LPT_LTAB = 0, 1, 2
+
+DEFAULT_JNL_PERCENT = 5
+DEFAULT_FANOUT = 8
+DEFAULT_JHEADS_CNT = 1
+DEFAULT_LSAVE_CNT = 256
+DEFAULT_RP_PERCENT = 5
+DEFAULT_MAX_RP_SIZE = 5 * 1024 * 1024
+DEFAULT_TIME_GRAN = 1000000000
+
+S_IFDIR = 0o040000
+S_IFREG = 0o100000
+
+
+def align(val, to):
+    return (val + to - 1) & ~(to - 1)
+
+
+def fls(val):
+    return val.bit_length()
+
+
+def crc32(data):
+    """UBIFS node CRC: crc32_le() seeded with ~0 and not inverted after"""
+    return (zlib.crc32(bytes(data)) ^ 0xffffffff) & 0xffffffff
+
+
+def crc16(data):
+    """The CRC-16 in fs/ubifs/crc16.c, seeded with ~0 as the LPT does"""
+    crc = 0xffff
+    for byte in bytearray(data):
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ (0xa001 if crc & 1 else 0)
+    return crc
+
+
+def r5_hash(name):
+    """key_r5_hash() from fs/ubifs/key.h"""
+    a = 0
+    for ch in bytearray(name):
+        if ch >= 0x80:
+            ch -= 0x100
+        a = (a + (ch << 4)) & 0xffffffff
+        a = (a + (ch >> 4)) & 0xffffffff
+        a = (a * 11) & 0xffffffff
+    a &= UBIFS_S_KEY_HASH_MASK
+    if a <= 2:
+        a += 3
+    return a
+
+
+def make_key(inum, key_type, val=0):
+    return (inum, (key_type << UBIFS_S_KEY_BLOCK_BITS) | val)
+
+
+def pack_key(key):
+    return struct.pack('<II', key[0], key[1])
+
+
+def pattern(offs):
+    """The contents of /data.bin, which 'ut ubifs' checks byte by byte"""
+    if (offs // UBIFS_BLOCK_SIZE) & 1:
+        return offs % 251
+    return (offs * 7 + (offs >> 8)) & 0xff
+
+
+class BitWriter:
+    """pack_bits() from fs/ubifs/lpt.c: fields are packed from bit 0 up"""
+    def __init__(self, size):
+        self.buf = bytearray(size)
+        self.pos = 0
+
+    def pack(self, val, nrbits):
+        assert val >> nrbits == 0
+        for i in range(nrbits):
+            if val & (1 << i):
+                self.buf[(self.pos + i) // 8] |= 1 << ((self.pos + i) % 8)
+        self.pos += nrbits
+
+
+class Image:
+    def __init__(self):
+        self.lebs = [bytearray(b'\xff' * LEB_SIZE) for _ in range(LEB_CNT)]
+        self.sqnum = 0
+
+    def node(self, node_type, body, sqnum=None):
+        """Return a node with its common header filled in"""
+        if sqnum is None:
+            self.sqnum += 1
+            sqnum = self.sqnum
+        length = UBIFS_CH_SZ + len(body)
+        node = bytearray(struct.pack('<IIQIBBxx', UBIFS_NODE_MAGIC, 0, sqnum,
+                                     length, node_type, 0))
+        node += body
+        struct.pack_into('<I', node, 4, crc32(node[8:]))
+        return node
+
+    def write(self, lnum, offs, data):
+        self.lebs[lnum][offs:offs + len(data)] = data
+
+    def pad(self, lnum, offs):
+        """Pad to the next min. I/O unit like ubifs_pad() does"""
+        pad = align(offs, MIN_IO_SIZE) - offs
+        if pad >= UBIFS_PAD_NODE_SZ:
+            body = struct.pack('<I', pad - UBIFS_PAD_NODE_SZ)
+            node = self.node(UBIFS_PAD_NODE, body, sqnum=0)
+            node += bytearray(pad - UBIFS_PAD_NODE_SZ)
+            self.write(lnum, offs, node)
+        elif pad:
+            self.write(lnum, offs, bytearray(b'\xce' * pad))
+        return pad
+
+
+class Layout:
+    """The geometry create_default_filesystem() picks for LEB_CNT LEBs"""
+    def __init__(self):
+        jnl_lebs = max(LEB_CNT * DEFAULT_JNL_PERCENT // 100,
+                       UBIFS_MIN_JNL_LEBS)
+        ref_node_alsz = align(UBIFS_REF_NODE_SZ, 8)
+        tmp = 2 * (ref_node_alsz * jnl_lebs) + LEB_SIZE - 1
+        self.log_lebs = tmp // LEB_SIZE + 1
+        min_leb_cnt = UBIFS_MIN_LEB_CNT
+        if LEB_CNT - min_leb_cnt > 8:
+            self.log_lebs += 1
+            min_leb_cnt += 1
+        self.max_buds = max(jnl_lebs - self.log_lebs, UBIFS_MIN_BUD_LEBS)
+        self.orph_lebs = UBIFS_MIN_ORPH_LEBS
+        if LEB_CNT - min_leb_cnt > 1:
+            self.orph_lebs += 1
+        main_lebs = LEB_CNT - 1 - 2 - self.log_lebs - self.orph_lebs
+        self.lpt_first = UBIFS_LOG_LNUM + self.log_lebs
+        self.calc_lpt_geom(main_lebs)
+        self.main_first = LEB_CNT - self.main_lebs
+
+    def do_calc_lpt_geom(self):
+        max_pnode_cnt = -(-self.main_lebs // UBIFS_LPT_FANOUT)
+        self.lpt_hght = 1
+        n = UBIFS_LPT_FANOUT
+        while n < max_pnode_cnt:
+            self.lpt_hght += 1
+            n <<= UBIFS_LPT_FANOUT_SHIFT
+        self.pnode_cnt = -(-self.main_lebs // UBIFS_LPT_FANOUT)
+        n = -(-self.pnode_cnt // UBIFS_LPT_FANOUT)
+        self.nnode_cnt = n
+        for _ in range(1, self.lpt_hght):
+            n = -(-n // UBIFS_LPT_FANOUT)
+            self.nnode_cnt += n
+
+        self.space_bits = fls(LEB_SIZE) - 3
+        self.lpt_lnum_bits = fls(self.lpt_lebs)
+        self.lpt_offs_bits = fls(LEB_SIZE - 1)
+        self.lpt_spc_bits = fls(LEB_SIZE)
+
+        hdr_bits = UBIFS_LPT_CRC_BITS + UBIFS_LPT_TYPE_BITS
+        bits = hdr_bits + (self.space_bits * 2 + 1) * UBIFS_LPT_FANOUT
+        self.pnode_sz = (bits + 7) // 8
+        bits = hdr_bits + ((self.lpt_lnum_bits + self.lpt_offs_bits) *
+                           UBIFS_LPT_FANOUT)
+        self.nnode_sz = (bits + 7) // 8
+        bits = hdr_bits + self.lpt_lebs * self.lpt_spc_bits * 2
+        self.ltab_sz = (bits + 7) // 8
+
+        self.lpt_sz = self.pnode_cnt * self.pnode_sz
+        self.lpt_sz += self.nnode_cnt * self.nnode_sz
+        self.lpt_sz += self.ltab_sz
+        sz = self.lpt_sz
+        per_leb_wastage = max(self.pnode_sz, self.nnode_sz)
+        sz += per_leb_wastage
+        tot_wastage = per_leb_wastage
+        while sz > LEB_SIZE:
+            sz += per_leb_wastage - LEB_SIZE
+            tot_wastage += per_leb_wastage
+        tot_wastage += align(sz, MIN_IO_SIZE) - sz
+        self.lpt_sz += tot_wastage
+
+    def calc_lpt_geom(self, main_lebs):
+        self.lpt_lebs = UBIFS_MIN_LPT_LEBS
+        self.main_lebs = main_lebs - self.lpt_lebs
+        self.do_calc_lpt_geom()
+        # Only the small LPT model, which is all a volume this size needs
+        if self.lpt_sz > LEB_SIZE:
+            sys.exit('LPT too big for the small model')
+        lebs_needed = -(-self.lpt_sz * 4 // LEB_SIZE)
+        if lebs_needed > self.lpt_lebs:
+            sys.exit('LPT needs more LEBs')
+
+
+class Main:
+    """Writes nodes into the main area one LEB after the other"""
+    def __init__(self, img, lnum):
+        self.img = img
+        self.lnum = lnum
+        self.offs = 0
+        self.used = {}
+
+    def next_leb(self):
+        self.finish()
+        self.lnum += 1
+        self.offs = 0
+
+    def finish(self):
+        if self.offs:
+            dirty = self.img.pad(self.lnum, self.offs)
+            self.used[self.lnum] = (self.offs + dirty, dirty)
+
+    def add(self, node):
+        if self.offs + len(node) > LEB_SIZE:
+            self.next_leb()
+        lnum, offs = self.lnum, self.offs
+        self.img.write(lnum, offs, node)
+        self.offs = align(offs + len(node), 8)
+        if self.offs > LEB_SIZE:
+            self.offs = LEB_SIZE
+        return lnum, offs, len(node)
+
+
+def ino_node(img, inum, mode, nlink, size):
+    body = pack_key(make_key(inum, UBIFS_INO_KEY)) + bytearray(8)
+    body += struct.pack('<QQQQQIIIIIIIIII', img.sqnum + 1, size, TIME, TIME,
+                        TIME, 0, 0, 0, nlink, 0, 0, mode, UBIFS_COMPR_FL, 0,
+                        0)
+    body += struct.pack('<I4xIH26x', 0, 0, UBIFS_COMPR_ZLIB)
+    return img.node(UBIFS_INO_NODE, body)
+
+
+def dent_node(img, parent, name, inum, itype):
+    key = make_key(parent, UBIFS_DENT_KEY, r5_hash(name))
+    body = pack_key(key) + bytearray(8)
+    body += struct.pack('<QxBH4x', inum, itype, len(name))
+    body += bytearray(name) + b'\0'
+    return key, img.node(UBIFS_DENT_NODE, body)
+
+
+def data_node(img, inum, block, data):
+    compr_type = UBIFS_COMPR_NONE
+    out = data
+    if len(data) >= UBIFS_MIN_COMPR_LEN:
+        comp = zlib.compressobj(9, zlib.DEFLATED, -15)
+        packed = comp.compress(bytes(data)) + comp.flush()
+        if len(data) - len(packed) >= UBIFS_MIN_COMPRESS_DIFF:
+            compr_type = UBIFS_COMPR_ZLIB
+            out = packed
+    key = make_key(inum, UBIFS_DATA_KEY, block)
+    body = pack_key(key) + bytearray(8)
+    body += struct.pack('<IH2x', len(data), compr_type) + bytearray(out)
+    return key, img.node(UBIFS_DATA_NODE, body)
+
+
+def dent_size(name):
+    return align(UBIFS_DENT_NODE_SZ + len(name) + 1, 8)
+
+
+def add_files(img, main):
+    """Write the inode, directory entry and data nodes of every file"""
+    leaves = []
+    root_dents = [(b'data.bin', UBIFS_FIRST_INO, UBIFS_ITYPE_REG),
+                  (b'dir', UBIFS_FIRST_INO + 1, UBIFS_ITYPE_DIR)]
+    dir_dents = [(('file-%d' % i).encode(), UBIFS_FIRST_INO + 2 + i,
+                  UBIFS_ITYPE_REG) for i in range(DIR_FILES)]
+
+    def add(key, node):
+        leaves.append((key, main.add(node)))
+
+    size = UBIFS_INO_NODE_SZ + sum(dent_size(d[0]) for d in root_dents)
+    add(make_key(UBIFS_ROOT_INO, UBIFS_INO_KEY),
+        ino_node(img, UBIFS_ROOT_INO, S_IFDIR | 0o755, 3, size))
+
+    inum = UBIFS_FIRST_INO
+    size = DATA_BLOCKS * UBIFS_BLOCK_SIZE + DATA_TAIL
+    add(make_key(inum, UBIFS_INO_KEY),
+        ino_node(img, inum, S_IFREG | 0o644, 1, size))
+    for block in range(DATA_BLOCKS + 1):
+        if block == DATA_HOLE:
+            continue
+        start = block * UBIFS_BLOCK_SIZE
+        end = min(start + UBIFS_BLOCK_SIZE, size)
+        add(*data_node(img, inum, block,
+                       bytearray(pattern(i) for i in range(start, end))))
+
+    inum += 1
+    size = UBIFS_INO_NODE_SZ + sum(dent_size(d[0]) for d in dir_dents)
+    add(make_key(inum, UBIFS_INO_KEY),
+        ino_node(img, inum, S_IFDIR | 0o755, 2, size))
+
+    for parent, dents in ((UBIFS_ROOT_INO, root_dents), (inum, dir_dents)):
+        for name, child, itype in dents:
+            add(*dent_node(img, parent, name, child, itype))
+
+    for i, (name, child, itype) in enumerate(dir_dents):
+        add(make_key(child, UBIFS_INO_KEY),
+            ino_node(img, child, S_IFREG | 0o644, 1, i))
+
+    main.finish()
+    keys = sorted(key for key, _ in leaves)
+    if len(set(keys)) != len(keys):
+        sys.exit('Two names in one directory hash the same, rename them')
+
+    return UBIFS_FIRST_INO + 1 + DIR_FILES, sorted(leaves)
+
+
+def idx_node(img, level, branches):
+    body = struct.pack('<HH', len(branches), level)
+    for key, (lnum, offs, length) in branches:
+        body += struct.pack('<III', lnum, offs, length) + pack_key(key)
+    return img.node(UBIFS_IDX_NODE, body)
+
+
+def add_index(img, main, leaves):
+    """Build the index bottom-up, DEFAULT_FANOUT branches per node"""
+    level = 0
+    branches = leaves
+    idx_size = 0
+    while True:
+        upper = []
+        for i in range(0, len(branches), DEFAULT_FANOUT):
+            group = branches[i:i + DEFAULT_FANOUT]
+            node = idx_node(img, level, group)
+            idx_size += align(len(node), 8)
+            upper.append((group[0][0], main.add(node)))
+        if len(upper) == 1:
+            break
+        branches = upper
+        level += 1
+
+    main.finish()
+    return upper[0][1], idx_size
+
+
+def pack_pnode(lay, lprops):
+    bits = BitWriter(lay.pnode_sz)
+    bits.pos = UBIFS_LPT_CRC_BITS
+    bits.pack(UBIFS_LPT_PNODE, UBIFS_LPT_TYPE_BITS)
+    for free, dirty, idx in lprops:
+        bits.pack(free >> 3, lay.space_bits)
+        bits.pack(dirty >> 3, lay.space_bits)
+        bits.pack(1 if idx else 0, 1)
+    struct.pack_into('<H', bits.buf, 0, crc16(bits.buf[2:]))
+    return bits.buf
+
+
+def pack_nnode(lay, nbranch):
+    bits = BitWriter(lay.nnode_sz)
+    bits.pos = UBIFS_LPT_CRC_BITS
+    bits.pack(UBIFS_LPT_NNODE, UBIFS_LPT_TYPE_BITS)
+    lpt_last = lay.lpt_first + lay.lpt_lebs - 1
+    for lnum, offs in nbranch:
+        if lnum == 0:
+            lnum = lpt_last + 1
+        bits.pack(lnum - lay.lpt_first, lay.lpt_lnum_bits)
+        bits.pack(offs, lay.lpt_offs_bits)
+    struct.pack_into('<H', bits.buf, 0, crc16(bits.buf[2:]))
+    return bits.buf
+
+
+def pack_ltab(lay, ltab):
+    bits = BitWriter(lay.ltab_sz)
+    bits.pos = UBIFS_LPT_CRC_BITS
+    bits.pack(UBIFS_LPT_LTAB, UBIFS_LPT_TYPE_BITS)
+    for free, dirty in ltab:
+        bits.pack(free, lay.lpt_spc_bits)
+        bits.pack(dirty, lay.lpt_spc_bits)
+    struct.pack_into('<H', bits.buf, 0, crc16(bits.buf[2:]))
+    return bits.buf
+
+
+def add_lpt(img, lay, lprops):
+    """Write the LPT into its first LEB like ubifs_create_dflt_lpt() does"""
+    lnum = lay.lpt_first
+    buf = bytearray()
+    for i in range(lay.pnode_cnt):
+        group = lprops[i * UBIFS_LPT_FANOUT:(i + 1) * UBIFS_LPT_FANOUT]
+        group += [(LEB_SIZE, 0, False)] * (UBIFS_LPT_FANOUT - len(group))
+        buf += pack_pnode(lay, group)
+
+    cnt = lay.pnode_cnt
+    boffs, bsz = 0, lay.pnode_sz
+    while True:
+        bcnt = cnt
+        cnt = -(-cnt // UBIFS_LPT_FANOUT)
+        start = len(buf)
+        for i in range(cnt):
+            if cnt == 1:
+                root = len(buf)
+            nbranch = []
+            for j in range(UBIFS_LPT_FANOUT):
+                if bcnt:
+                    nbranch.append((lnum, boffs))
+                    boffs += bsz
+                    bcnt -= 1
+                else:
+                    nbranch.append((0, 0))
+            buf += pack_nnode(lay, nbranch)
+        if cnt == 1:
+            break
+        boffs, bsz = start, lay.nnode_sz
+
+    ltab_offs = len(buf)
+    length = ltab_offs + lay.ltab_sz
+    alen = align(length, MIN_IO_SIZE)
+    ltab = [(LEB_SIZE, 0)] * lay.lpt_lebs
+    ltab[0] = (LEB_SIZE - alen, alen - length)
+    buf += pack_ltab(lay, ltab)
+    if len(buf) > LEB_SIZE:
+        sys.exit('LPT does not fit in one LEB')
+    img.write(lnum, 0, buf)
+
+    return {'lpt': (lnum, root), 'nhead': (lnum, alen),
+            'ltab': (lnum, ltab_offs)}
+
+
+def main():
+    parser = OptionParser(usage='%prog [-o <file>]')
+    parser.add_option('-o', '--output', default=os.path.join(
+        os.path.dirname(os.path.abspath(__file__)), 'test-ubifs.gz'),
+        help='where to write the gzipped image')
+    (options, args) = parser.parse_args()
+
+    lay = Layout()
+    img = Image()
+
+    # Superblock, written first as mkfs does
+    main_bytes = lay.main_lebs * LEB_SIZE
+    body = struct.pack('<2xBBIIIIIQIIIIIIIH2xIIQI16sI', 0, 0, 0, MIN_IO_SIZE,
+                       LEB_SIZE, LEB_CNT, LEB_CNT, lay.max_buds * LEB_SIZE,
+                       lay.log_lebs, lay.lpt_lebs, lay.orph_lebs,
+                       DEFAULT_JHEADS_CNT, DEFAULT_FANOUT, DEFAULT_LSAVE_CNT,
+                       UBIFS_FORMAT_VERSION, UBIFS_COMPR_ZLIB, 0, 0,
+                       min(main_bytes * DEFAULT_RP_PERCENT // 100,
+                           DEFAULT_MAX_RP_SIZE),
+                       DEFAULT_TIME_GRAN, UUID, 0)
+    body += bytearray(UBIFS_SB_NODE_SZ - UBIFS_CH_SZ - len(body))
+    img.write(UBIFS_SB_LNUM, 0, img.node(UBIFS_SB_NODE, body))
+
+    # Files first, then the index in the LEB after them, then the GC LEB
+    main = Main(img, lay.main_first)
+    highest_inum, leaves = add_files(img, main)
+    main.next_leb()
+    ihead_lnum = main.lnum
+    root, idx_size = add_index(img, main, leaves)
+    ihead_offs = main.used[ihead_lnum][0]
+    if main.lnum != ihead_lnum:
+        sys.exit('The index does not fit in one LEB')
+    gc_lnum = ihead_lnum + 1
+
+    lprops = []
+    for lnum in range(lay.main_first, LEB_CNT):
+        used, dirty = main.used.get(lnum, (0, 0))
+        lprops.append((LEB_SIZE - used, dirty, lnum == ihead_lnum))
+    lpt = add_lpt(img, lay, lprops)
+
+    # The log holds just the commit start node of commit 0
+    cs = img.node(UBIFS_CS_NODE, struct.pack('<Q', 0))
+    img.write(UBIFS_LOG_LNUM, 0, cs)
+    img.pad(UBIFS_LOG_LNUM, len(cs))
+
+    dead_wm = align(MIN_WRITE_SZ, MIN_IO_SIZE)
+    dark_wm = align(UBIFS_MAX_NODE_SZ, MIN_IO_SIZE)
+    tot = {'free': 0, 'dirty': 0, 'used': 0, 'dead': 0, 'dark': 0}
+    for free, dirty, idx in lprops:
+        tot['free'] += free
+        tot['dirty'] += dirty
+        if idx:
+            continue
+        tot['used'] += LEB_SIZE - free - dirty
+        spc = free + dirty
+        if spc < dead_wm:
+            tot['dead'] += spc
+        elif spc < dark_wm:
+            tot['dark'] += spc
+        elif spc - dark_wm < MIN_WRITE_SZ:
+            tot['dark'] += spc - MIN_WRITE_SZ
+        else:
+            tot['dark'] += dark_wm
+
+    body = struct.pack('<QQIIIIIIIIQQQQQQIIIIIIIIIIII', highest_inum, 0, 0,
+                       UBIFS_LOG_LNUM, root[0], root[1], root[2], gc_lnum,
+                       ihead_lnum, ihead_offs, idx_size, tot['free'],
+                       tot['dirty'], tot['used'], tot['dead'], tot['dark'],
+                       lpt['lpt'][0], lpt['lpt'][1], lpt['nhead'][0],
+                       lpt['nhead'][1], lpt['ltab'][0], lpt['ltab'][1], 0, 0,
+                       lay.main_first,
+                       sum(1 for lp in lprops if lp[0] == LEB_SIZE), 1,
+                       LEB_CNT)
+    body += bytearray(UBIFS_MST_NODE_SZ - UBIFS_CH_SZ - len(body))
+    mst = img.node(UBIFS_MST_NODE, body)
+    for lnum in (UBIFS_MST_LNUM, UBIFS_MST_LNUM + 1):
+        img.write(lnum, 0, mst)
+        img.pad(lnum, len(mst))
+
+    with open(options.output, 'wb') as fd:
+        with gzip.GzipFile(fileobj=fd, mode='wb', filename='', mtime=0) as gz:
+            for leb in img.lebs:
+                gz.write(bytes(leb))
+
+    print('%s: %d LEBs, main area from LEB %d, %d nodes in LEBs %d-%d, '
+          'index in LEB %d' % (options.output, LEB_CNT, lay.main_first,
+                               len(leaves), lay.main_first, ihead_lnum - 1,
+                               ihead_lnum))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,328 @@
+#!/usr/bin/env python
+#
+# SPDX-License-Identifier:      GPL-2.0+
+#
+# Convert a bootstage timeline into Chrome trace JSON
+#
+# The timeline can come from any of the places U-Boot leaves it:
+#
+#   - the /bootstage node written with CONFIG_BOOTSTAGE_FDT, either as a
+#     device tree blob or as /proc/device-tree/bootstage on the target
+#   - a bootstage_stash() blob, e.g. the CONFIG_BOOTSTAGE_STASH_ADDR region
+#     or a dump of the Rockchip atags holding an ATAG_BOOTSTAGE tag
+#   - the console output of 'bootstage report'
+#
+# Load the result with chrome://tracing or https://ui.perfetto.dev. Marks are
+# shown as instants and as spans lasting until the next mark, grouped by boot
+# phase (TPL, SPL, U-Boot). Accumulated times are shown on their own row at
+# the time they were last started; if they were started more than once the
+# span covers only the total, not each interval.
+
+from optparse import OptionParser
+import json
+import os
+import re
+import struct
+import sys
+
+BOOTSTAGE_MAGIC = 0xb00757a3
+ATAG_BOOTSTAGE = 0x54410054
+FDT_MAGIC = 0xd00dfeed
+
+# Marks which start each boot phase, see bootstage.h
+PHASES = [('tpl', 'TPL'), ('spl', 'SPL'), ('board_init_f', 'U-Boot')]
+
+
+class Record:
+    """A single bootstage record
+
+    Attributes:
+        name: Name of the record
+        time_us: Mark time, or accumulated time, in microseconds
+        start_us: Time an accumulated record was last started, 0 if unknown,
+            None for a mark
+    """
+    def __init__(self, name, time_us, start_us=None):
+        self.name = name
+        self.time_us = time_us
+        self.start_us = start_us
+
+    def is_mark(self):
+        return self.start_us is None
+
+
+def ParseStash(data, offset=0):
+    """Parse the output of bootstage_stash()
+
+    The record layout depends on the word size of the phase that wrote it, so
+    try 32-bit and 64-bit layouts and keep the one whose name strings fill
+    the stash exactly.
+
+    Args:
+        data: Binary data containing the stash
+        offset: Offset of the stash header in data
+
+    Returns:
+        List of Record
+    """
+    version, count, size, magic = struct.unpack_from('<IIII', data, offset)
+    if magic != BOOTSTAGE_MAGIC or version != 0:
+        raise ValueError('No bootstage stash at offset %#x' % offset)
+    if offset + size > len(data):
+        raise ValueError('Bootstage stash is truncated')
+
+    # time_us, start_us, name, flags, id
+    layouts = [('<IIIiI', 20), ('<QI4xQiI', 32)]
+    for fmt, rec_size in layouts:
+        names_start = offset + 16 + count * rec_size
+        if names_start > offset + size:
+            continue
+        names = data[names_start:offset + size].split(b'\0')
+        if len(names) != count + 1 or names[-1]:
+            continue
+        records = []
+        for i in range(count):
+            time_us, start_us, _, _, _ = struct.unpack_from(
+                fmt, data, offset + 16 + i * rec_size)
+            name = names[i].decode('utf-8', 'replace')
+            records.append(Record(name, time_us, start_us or None))
+        return records
+    raise ValueError('Cannot work out the bootstage record layout')
+
+
+def ParseAtags(data):
+    """Find the ATAG_BOOTSTAGE tag in a dump of the Rockchip atags
+
+    Args:
+        data: Binary data starting with the atags
+
+    Returns:
+        List of Record
+    """
+    pos = 0
+    while pos + 8 <= len(data):
+        size, magic = struct.unpack_from('<II', data, pos)
+        if not size:
+            break
+        if magic == ATAG_BOOTSTAGE:
+            # Skip the header, version and size words
+            return ParseStash(data, pos + 16)
+        pos += size * 4
+    raise ValueError('No ATAG_BOOTSTAGE tag found')
+
+
+def ParseFdt(data):
+    """Read the /bootstage node from a device tree blob
+
+    Args:
+        data: Device tree blob
+
+    Returns:
+        List of Record
+    """
+    (magic, _, off_struct, off_strings, _, _, _, _, _,
+     size_struct) = struct.unpack_from('>10I', data, 0)
+    if magic != FDT_MAGIC:
+        raise ValueError('Not a device tree blob')
+
+    def GetString(offset):
+        end = data.index(b'\0', off_strings + offset)
+        return data[off_strings + offset:end].decode('utf-8')
+
+    nodes = []
+    path = []
+    props = None
+    pos = off_struct
+    end = off_struct + size_struct
+    while pos < end:
+        token, = struct.unpack_from('>I', data, pos)
+        pos += 4
+        if token == 1:          # FDT_BEGIN_NODE
+            name_end = data.index(b'\0', pos)
+            path.append(data[pos:name_end].decode('utf-8'))
+            pos = (name_end + 4) & ~3
+            props = {}
+            if len(path) == 3 and path[1] == 'bootstage':
+                nodes.append(props)
+        elif token == 2:        # FDT_END_NODE
+            path.pop()
+        elif token == 3:        # FDT_PROP
+            length, nameoff = struct.unpack_from('>II', data, pos)
+            pos += 8
+            props[GetString(nameoff)] = data[pos:pos + length]
+            pos = (pos + length + 3) & ~3
+        elif token == 9:        # FDT_END
+            break
+    return RecordsFromProps(reversed(nodes))
+
+
+def ParseProcDir(dirname):
+    """Read /proc/device-tree/bootstage, or a copy of it
+
+    Args:
+        dirname: Directory holding a subdirectory for each record
+
+    Returns:
+        List of Record
+    """
+    nodes = []
+    for sub in sorted(os.listdir(dirname), key=lambda x: int(x, 0)):
+        props = {}
+        subdir = os.path.join(dirname, sub)
+        for prop in os.listdir(subdir):
+            with open(os.path.join(subdir, prop), 'rb') as fd:
+                props[prop] = fd.read()
+        nodes.append(props)
+    return RecordsFromProps(reversed(nodes))
+
+
+def RecordsFromProps(nodes):
+    """Convert the properties of /bootstage subnodes into records
+
+    Nodes are written in reverse order, so callers pass them reversed.
+    """
+    records = []
+    for props in nodes:
+        name = props['name'].rstrip(b'\0').decode('utf-8', 'replace')
+        if 'mark' in props:
+            records.append(Record(name, struct.unpack('>I', props['mark'])[0]))
+        elif 'accum' in props:
+            start = 0
+            if 'start' in props:
+                start = struct.unpack('>I', props['start'])[0]
+            records.append(Record(name, struct.unpack('>I', props['accum'])[0],
+                                  start))
+    return records
+
+
+def ParseReport(text):
+    """Parse the console output of 'bootstage report'
+
+    Args:
+        text: Report text
+
+    Returns:
+        List of Record
+    """
+    records = []
+    accum = False
+    for line in text.splitlines():
+        if line.startswith('Accumulated time'):
+            accum = True
+            continue
+        fields = line.split(None, 2 if not accum else 1)
+        if accum and len(fields) == 2 and re.match('^[0-9,]+$', fields[0]):
+            records.append(Record(fields[1],
+                                  int(fields[0].replace(',', '')), 0))
+        elif (not accum and len(fields) == 3 and
+              re.match('^[0-9,]+$', fields[0]) and
+              re.match('^[0-9,]+$', fields[1])):
+            records.append(Record(fields[2],
+                                  int(fields[0].replace(',', ''))))
+    return records
+
+
+def ReadRecords(fname, fmt):
+    """Read records from a file, working out its format if not given"""
+    if os.path.isdir(fname):
+        return ParseProcDir(fname)
+    with open(fname, 'rb') as fd:
+        data = fd.read()
+    if not fmt:
+        if len(data) >= 4 and struct.unpack('>I', data[:4])[0] == FDT_MAGIC:
+            fmt = 'fdt'
+        elif (len(data) >= 16 and
+              struct.unpack('<I', data[12:16])[0] == BOOTSTAGE_MAGIC):
+            fmt = 'stash'
+        elif len(data) >= 8 and struct.unpack('<I', data[4:8])[0] == 0x54410001:
+            fmt = 'atags'
+        else:
+            fmt = 'report'
+    if fmt == 'fdt':
+        return ParseFdt(data)
+    elif fmt == 'stash':
+        return ParseStash(data)
+    elif fmt == 'atags':
+        return ParseAtags(data)
+    return ParseReport(data.decode('utf-8', 'replace'))
+
+
+def MakeTrace(records):
+    """Build a Chrome trace from a list of records
+
+    Returns:
+        Dict ready to be written out as JSON
+    """
+    events = []
+    phase_names = dict(PHASES)
+    marks = sorted([rec for rec in records if rec.is_mark()],
+                   key=lambda rec: rec.time_us)
+    tids = {}
+
+    def Tid(thread):
+        if thread not in tids:
+            tids[thread] = len(tids) + 1
+            events.append({'name': 'thread_name', 'ph': 'M', 'pid': 1,
+                           'tid': tids[thread], 'args': {'name': thread}})
+        return tids[thread]
+
+    events.append({'name': 'process_name', 'ph': 'M', 'pid': 1,
+                   'args': {'name': 'boot'}})
+    phase = 'Boot ROM'
+    for i, rec in enumerate(marks):
+        phase = phase_names.get(rec.name, phase)
+        tid = Tid(phase)
+        events.append({'name': rec.name, 'ph': 'i', 's': 't', 'pid': 1,
+                       'tid': tid, 'ts': rec.time_us})
+        if i + 1 < len(marks):
+            events.append({'name': rec.name, 'ph': 'X', 'pid': 1,
+                           'tid': tid, 'ts': rec.time_us,
+                           'dur': marks[i + 1].time_us - rec.time_us})
+
+    for rec in records:
+        if rec.is_mark():
+            continue
+        args = {'total_us': rec.time_us}
+        if not rec.start_us:
+            args['start'] = 'unknown'
+        events.append({'name': rec.name, 'ph': 'X', 'pid': 1,
+                       'tid': Tid('accumulated'), 'ts': rec.start_us or 0,
+                       'dur': rec.time_us, 'args': args})
+
+    return {'traceEvents': events, 'displayTimeUnit': 'ms'}
+
+
+def main():
+    parser = OptionParser(usage='%prog [options] <timeline>\n\n'
+            'Convert a bootstage timeline into Chrome trace JSON. The\n'
+            'timeline is a device tree blob, a /bootstage directory, a\n'
+            'bootstage stash, an atags dump or a bootstage report.')
+    parser.add_option('-f', '--format', type='choice',
+                      choices=['fdt', 'stash', 'atags', 'report'],
+                      help='Input format (default: detect)')
+    parser.add_option('-o', '--output', type='string',
+                      help='Output file (default: stdout)')
+    (options, args) = parser.parse_args()
+    if len(args) != 1:
+        parser.error('Please give one timeline file')
+
+    try:
+        records = ReadRecords(args[0], options.format)
+    except (ValueError, IOError, OSError, KeyError, struct.error) as e:
+        sys.stderr.write('%s: %s\n' % (args[0], e))
+        return 1
+    if not records:
+        sys.stderr.write('%s: No bootstage records found\n' % args[0])
+        return 1
+
+    trace = json.dumps(MakeTrace(records), indent=1)
+    if options.output:
+        with open(options.output, 'w') as fd:
+            fd.write(trace)
+    else:
+        print(trace)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -22,6 +22,8 @@
 #include <trace.h>
 
 #define MAX_LINE_LEN 500
+#define MAX_STACK_DEPTH 256
+#define MAX_STACK_LEN 8192
 
 enum {
 	FUNCF_TRACE	= 1 << 0,	/* Include this function in trace */
@@ -86,6 +88,7 @@ static void usage(void)
 		"\n"
 		"Commands\n"
 		"   dump-ftrace\t\tDump out textual data in ftrace format\n"
+		"   dump-flamegraph\tDump out folded stacks for flamegraph.pl\n"
 		"\n"
 		"Options:\n"
 		"   -m <map>\tSpecify Systen.map file\n"
@@ -533,6 +536,146 @@ static int make_ftrace(void)
 	return 0;
 }
 
+/* A function call in progress while replaying the call list */
+struct flame_frame {
+	struct func_info *func;
+	uint32_t func_offset;
+	ulong entry;		/* timestamp of entry */
+	ulong child_us;		/* time spent in traced callees */
+};
+
+/* Time spent in a call stack, excluding callees */
+struct flame_stack {
+	char *stack;
+	ulong self_us;
+};
+
+static int h_cmp_flame_stack(const void *v1, const void *v2)
+{
+	const struct flame_stack *s1 = v1, *s2 = v2;
+
+	return strcmp(s1->stack, s2->stack);
+}
+
+/* Write the names of the traced functions on the stack, root first */
+static void flame_stack_name(char *buff, int size, struct flame_frame *frames,
+			     int depth)
+{
+	char *ptr = buff, *end = buff + size;
+	int i;
+
+	*ptr = '\0';
+	for (i = 0; i < depth && ptr < end; i++) {
+		struct flame_frame *frame = &frames[i];
+
+		if (frame->func && !(frame->func->flags & FUNCF_TRACE))
+			continue;
+		if (frame->func)
+			ptr += snprintf(ptr, end - ptr, "%s%s",
+					ptr == buff ? "" : ";",
+					frame->func->name);
+		else
+			ptr += snprintf(ptr, end - ptr, "%s%lx",
+					ptr == buff ? "" : ";",
+					text_offset + frame->func_offset);
+	}
+}
+
+/*
+ * Output in the 'folded' format used by flamegraph.pl and speedscope: one
+ * line per call stack, with the functions separated by semicolons, followed
+ * by the time in microseconds spent in the last function of the stack
+ * itself. Excluded functions are left out of the stacks and their time is
+ * given to their caller.
+ */
+static int make_flamegraph(void)
+{
+	struct flame_frame frames[MAX_STACK_DEPTH];
+	struct flame_stack *stacks, *stack;
+	struct trace_call *call;
+	char name[MAX_STACK_LEN];
+	int stack_count = 0, unmatched = 0, too_deep = 0;
+	int depth = 0;
+	int i, j;
+
+	stacks = calloc(call_count, sizeof(*stacks));
+	if (!stacks) {
+		error("Cannot allocate stack list\n");
+		return -1;
+	}
+
+	for (i = 0, call = call_list; i < call_count; i++, call++) {
+		ulong time = call->flags & FUNCF_TIMESTAMP_MASK;
+		struct flame_frame *frame;
+		ulong total_us;
+
+		if (TRACE_CALL_TYPE(call) == FUNCF_ENTRY) {
+			if (depth == MAX_STACK_DEPTH) {
+				too_deep++;
+				continue;
+			}
+			frame = &frames[depth++];
+			frame->func = find_func_by_offset(call->func);
+			frame->func_offset = call->func;
+			frame->entry = time;
+			frame->child_us = 0;
+			continue;
+		}
+		if (TRACE_CALL_TYPE(call) != FUNCF_EXIT)
+			continue;
+
+		/*
+		 * Drop frames with no exit, which can only happen if records
+		 * were lost. Exits from before tracing started have no entry.
+		 */
+		for (j = depth - 1; j >= 0; j--) {
+			if (frames[j].func_offset == call->func)
+				break;
+		}
+		if (j < 0) {
+			unmatched++;
+			continue;
+		}
+		unmatched += depth - 1 - j;
+		depth = j + 1;
+
+		frame = &frames[j];
+		/* The timestamp wraps, but a call is never that long */
+		total_us = (time - frame->entry) & FUNCF_TIMESTAMP_MASK;
+		if (!frame->func || (frame->func->flags & FUNCF_TRACE)) {
+			flame_stack_name(name, sizeof(name), frames, depth);
+			stack = &stacks[stack_count++];
+			stack->stack = strdup(name);
+			stack->self_us = total_us > frame->child_us ?
+					 total_us - frame->child_us : 0;
+			if (j)
+				frames[j - 1].child_us += total_us;
+		} else if (j) {
+			/* Only the callees' time counts against the caller */
+			frames[j - 1].child_us += frame->child_us;
+		}
+		depth--;
+	}
+
+	qsort(stacks, stack_count, sizeof(*stacks), h_cmp_flame_stack);
+	for (i = 0; i < stack_count; i = j) {
+		ulong self_us = 0;
+
+		for (j = i; j < stack_count &&
+		     !strcmp(stacks[i].stack, stacks[j].stack); j++)
+			self_us += stacks[j].self_us;
+		if (*stacks[i].stack)
+			printf("%s %lu\n", stacks[i].stack, self_us);
+	}
+	for (i = 0; i < stack_count; i++)
+		free(stacks[i].stack);
+	free(stacks);
+	info("flamegraph: %d unmatched calls, %d too deep\n", unmatched,
+	     too_deep);
+
+	return 0;
+}
+
 static int prof_tool(int argc, char * const argv[],
 		     const char *prof_fname, const char *map_fname,
 		     const char *trace_config_fname)
@@ -553,6 +696,8 @@ static int prof_tool(int argc, char * const argv[],
 
 		if (0 == strcmp(cmd, "dump-ftrace"))
 			err = make_ftrace();
+		else if (0 == strcmp(cmd, "dump-flamegraph"))
+			err = make_flamegraph();
 		else
 			warn("Unknown command '%s'\n", cmd);
 	}